@@ -69,6 +69,7 @@ void DialogPreferences::SetValues(const Preferences &prefs)
     m_ui->checkBoxActivationColours->setChecked(prefs.DisplayActivation);
     m_ui->checkBoxOpenCL->setChecked(prefs.OpenCLUseOpenCL);
     m_ui->checkBoxOpenCLLog->setChecked(prefs.OpenCLUseOpenCLLog);
+    m_ui->checkBoxMeshCacheFiles->setChecked(prefs.MeshCacheFiles);
 
     m_ui->radioButtonPPM->setChecked(static_cast<GLWidget::MovieFormat>(prefs.MovieFormat == GLWidget::PPM));
     m_ui->radioButtonTIFF->setChecked(static_cast<GLWidget::MovieFormat>(prefs.MovieFormat == GLWidget::TIFF));
@@ -102,6 +103,7 @@ void DialogPreferences::GetValues(Preferences *prefs)
     prefs->DisplayActivation = m_ui->checkBoxActivationColours->isChecked();
     prefs->OpenCLUseOpenCL = m_ui->checkBoxOpenCL->isChecked();
     prefs->OpenCLUseOpenCLLog = m_ui->checkBoxOpenCLLog->isChecked();
+    prefs->MeshCacheFiles = m_ui->checkBoxMeshCacheFiles->isChecked();
 
     if (m_ui->radioButtonPPM->isChecked()) prefs->MovieFormat = static_cast<int>(GLWidget::PPM);
     if (m_ui->radioButtonTIFF->isChecked()) prefs->MovieFormat = static_cast<int>(GLWidget::TIFF);
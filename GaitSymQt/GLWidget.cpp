@@ -77,6 +77,11 @@ GLWidget::GLWidget(QWidget *parent)
 
     timer.start();
     displayFrameRate = false;
+    drawTime = 0;
+    gpuDrawTime = 0;
+    m_drawTimerQueryIssued[0] = m_drawTimerQueryIssued[1] = false;
+    m_drawTimerQueryIndex = 0;
+    m_facetedObjectInstancedShader = 0;
 
     bitmap = new QImage(256, 32, QImage::Format_Mono);
     painter = new QPainter(bitmap);
@@ -109,6 +114,14 @@ void GLWidget::cleanup()
     m_facetedObjectShader = 0;
     delete m_fixedColourObjectShader;
     m_fixedColourObjectShader = 0;
+    delete m_facetedObjectInstancedShader;
+    m_facetedObjectInstancedShader = 0;
+    m_instanceVbo.destroy();
+    for (int i = 0; i < 2; i++)
+    {
+        m_drawTimerQuery[i].destroy();
+        m_drawTimerQueryIssued[i] = false;
+    }
     doneCurrent();
 }
 
@@ -192,6 +205,30 @@ void GLWidget::initializeGL()
     m_mvpMatrixLoc2 = m_fixedColourObjectShader->uniformLocation("mvpMatrix");
     m_fixedColourObjectShader->release();
 
+    // the instanced shader takes the model matrix from attributes 2 to 5 and the colour from attribute 6
+    m_facetedObjectInstancedShader = new QOpenGLShaderProgram;
+    m_facetedObjectInstancedShader->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/opengl/vertex_shader_instanced.glsl");
+    m_facetedObjectInstancedShader->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/opengl/fragment_shader_instanced.glsl");
+    m_facetedObjectInstancedShader->bindAttributeLocation("vertex", 0);
+    m_facetedObjectInstancedShader->bindAttributeLocation("vertexNormal", 1);
+    m_facetedObjectInstancedShader->bindAttributeLocation("instanceModel", 2);
+    m_facetedObjectInstancedShader->bindAttributeLocation("instanceColour", 6);
+    m_facetedObjectInstancedShader->link();
+
+    m_facetedObjectInstancedShader->bind();
+    m_viewMatrixLocInstanced = m_facetedObjectInstancedShader->uniformLocation("viewMatrix");
+    m_projMatrixLocInstanced = m_facetedObjectInstancedShader->uniformLocation("projMatrix");
+    m_materialProportionsLocInstanced = m_facetedObjectInstancedShader->uniformLocation("materialProportions");
+    m_shininessLocInstanced = m_facetedObjectInstancedShader->uniformLocation("shininess");
+    m_facetedObjectInstancedShader->setUniformValue(m_facetedObjectInstancedShader->uniformLocation("lightPosition"), QVector4D(100, 100, 100, 1) );
+    m_facetedObjectInstancedShader->release();
+
+    m_instanceVbo.create();
+    m_instanceVbo.setUsagePattern(QOpenGLBuffer::StreamDraw);
+
+    // timer queries need OpenGL 3.3 or GL_ARB_timer_query and are simply not used if they fail
+    for (int i = 0; i < 2; i++) m_drawTimerQuery[i].create();
+
 //    glGenBuffers(1, &m_LineBuffer);
 //    glGenBuffers(1, &m_LineColourBuffer);
 
@@ -297,8 +334,32 @@ void GLWidget::paintGL()
         modelStrokeFont.setGlWidget(this);
         modelStrokeFont.setVpMatrix(m_proj * m_view);
         GLUtils::setStrokeFont(&modelStrokeFont);
+        // drawTime is the CPU time taken to issue the draw calls and gpuDrawTime is the GPU time taken to execute them
+        // the GPU time is read from the queries issued in earlier frames once their results are available
+        // so that waiting for a result never stalls the pipeline (the older query is checked first)
+        for (int i = 0; i < 2; i++)
+        {
+            int query = (m_drawTimerQueryIndex + i) % 2;
+            if (m_drawTimerQueryIssued[query] && m_drawTimerQuery[query].isResultAvailable())
+            {
+                gpuDrawTime = m_drawTimerQuery[query].waitForResult() / 1e6;
+                m_drawTimerQueryIssued[query] = false;
+            }
+        }
+        QOpenGLTimerQuery *drawTimerQuery = &m_drawTimerQuery[m_drawTimerQueryIndex];
+        bool timeGPU = drawTimerQuery->isCreated() && m_drawTimerQueryIssued[m_drawTimerQueryIndex] == false;
+        if (timeGPU) drawTimerQuery->begin();
+        QElapsedTimer drawTimer;
+        drawTimer.start();
         gSimulation->Draw(this);
         modelStrokeFont.Draw();
+        drawTime = drawTimer.nsecsElapsed() / 1e6;
+        if (timeGPU)
+        {
+            drawTimerQuery->end();
+            m_drawTimerQueryIssued[m_drawTimerQueryIndex] = true;
+            m_drawTimerQueryIndex = 1 - m_drawTimerQueryIndex;
+        }
         // modelStrokeFont.Debug();
     }
 
@@ -347,7 +408,7 @@ void GLWidget::paintGL()
     else frameRate = 0;
     if (displayFrameRate)
     {
-        QString framesPerSecond = QString("Framerate: %1").arg(frameRate, 6, 'f', 2);
+        QString framesPerSecond = QString("Framerate: %1 Draw calls (CPU): %2 ms Draw (GPU): %3 ms").arg(frameRate, 6, 'f', 2).arg(drawTime, 6, 'f', 2).arg(gpuDrawTime, 6, 'f', 2);
         strokeFont.StrokeString(framesPerSecond.toLatin1(), framesPerSecond.size(), 20, 20, 10, 10, 0, 0, 0, 0);
     }
 
@@ -889,6 +950,36 @@ int GLWidget::mvpMatrixLoc2() const
     return m_mvpMatrixLoc2;
 }
 
+QOpenGLShaderProgram *GLWidget::facetedObjectInstancedShader() const
+{
+    return m_facetedObjectInstancedShader;
+}
+
+int GLWidget::viewMatrixLocInstanced() const
+{
+    return m_viewMatrixLocInstanced;
+}
+
+int GLWidget::projMatrixLocInstanced() const
+{
+    return m_projMatrixLocInstanced;
+}
+
+int GLWidget::materialProportionsLocInstanced() const
+{
+    return m_materialProportionsLocInstanced;
+}
+
+int GLWidget::shininessLocInstanced() const
+{
+    return m_shininessLocInstanced;
+}
+
+QOpenGLBuffer *GLWidget::instanceVbo()
+{
+    return &m_instanceVbo;
+}
+
 int GLWidget::shininessLoc() const
 {
     return m_shininessLoc;
@@ -13,6 +13,7 @@
 #include <QMatrix4x4>
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLBuffer>
+#include <QOpenGLTimerQuery>
 
 class Trackball;
 class RayGeom;
@@ -91,6 +92,12 @@ public:
     int specularLoc() const;
     int shininessLoc() const;
     int mvpMatrixLoc2() const;
+    QOpenGLShaderProgram *facetedObjectInstancedShader() const;
+    int viewMatrixLocInstanced() const;
+    int projMatrixLocInstanced() const;
+    int materialProportionsLocInstanced() const;
+    int shininessLocInstanced() const;
+    QOpenGLBuffer *instanceVbo();
 
 public slots:
     void SetCameraVec(double x, double y, double z);
@@ -167,6 +174,11 @@ private:
 
     QElapsedTimer timer;
     bool displayFrameRate;
+    double drawTime; // CPU time in ms spent issuing the draw calls in the last frame
+    double gpuDrawTime; // GPU time in ms taken by the same draw calls
+    QOpenGLTimerQuery m_drawTimerQuery[2];
+    bool m_drawTimerQueryIssued[2];
+    int m_drawTimerQueryIndex;
     QImage *bitmap;
     QPainter *painter;
     QFont *font;
@@ -192,6 +204,12 @@ private:
     int m_specularLoc;
     int m_shininessLoc;
     int m_mvpMatrixLoc2;
+    QOpenGLShaderProgram *m_facetedObjectInstancedShader;
+    int m_viewMatrixLocInstanced;
+    int m_projMatrixLocInstanced;
+    int m_materialProportionsLocInstanced;
+    int m_shininessLocInstanced;
+    QOpenGLBuffer m_instanceVbo;
     QMatrix4x4 m_proj;
     QMatrix4x4 m_view;
     QMatrix4x4 m_model;
@@ -13,7 +13,7 @@ macx {
         /usr/include/libxml2 \
         ${HOME}/Unix/include \
         /System/Library/Frameworks/OpenCL.framework/Versions/A/Headers
-    LIBS += -lxml2 \
+    LIBS += -lxml2 -lz \
         ${HOME}/Unix/lib/libode.a ${HOME}/Unix/lib/libtiff.a ${HOME}/Unix/lib/libANN.a \
 #        -framework OpenCL \
         -framework QTKit \
@@ -65,6 +65,7 @@ else:win32 {
         c:/Users/wis/Documents/Unix/include/libxml2
     LIBS += c:/Users/wis/Documents/Unix/lib/libxml2_a.lib \
         c:/Users/wis/Documents/Unix/lib/ode.lib \
+        c:/Users/wis/Documents/Unix/lib/zlib.lib \
         -L"C:\Program Files (x86)\Windows Kits\8.1\Lib\winv6.3\um\x64" \
         -L"C:\Program Files (x86)\Microsoft Visual Studio 12.0\VC\lib\amd64" \
         wsock32.lib ws2_32.lib
@@ -82,8 +83,9 @@ else:unix {
         ${HOME}/Unix/include \
         /usr/include/GL
 #    LIBS += -lxml2 -ltiff -lGLU \
-    LIBS += -lxml2 -lGLU \
+    LIBS += -lxml2 -lGLU -lpthread -lz \
         ${HOME}/Unix/lib/libode.a
+    QMAKE_CXXFLAGS += -std=c++11
 }
 
 QMAKE_CXXFLAGS_RELEASE += -O0 \ #turned off optimisation because of the sincos undefined symbol error
@@ -186,6 +188,18 @@ SOURCES += \
     ../src/Warehouse.cpp \
     ../src/PCA.cpp \
     ../src/FixedDriver.cpp \
+    ../src/DriverEngine.cpp \
+    ../src/AsyncOutputStream.cpp \
+    ../src/DumpContainer.cpp \
+    ../src/FastDouble.cpp \
+    ../src/ParseArena.cpp \
+    ../src/StepThreadPool.cpp \
+    ../src/FitnessCache.cpp \
+    ../src/LimitChecker.cpp \
+    ../src/Checkpoint.cpp \
+    ../src/PlaneCollider.cpp \
+    ../src/MeshCache.cpp \
+    ../src/SimulationBatch.cpp \
     ../src/StrokeFont.cpp \
     Logo.cpp
 HEADERS += \
@@ -286,6 +300,18 @@ HEADERS += \
     ../src/Warehouse.h \
     ../src/PCA.h \
     ../src/FixedDriver.h \
+    ../src/DriverEngine.h \
+    ../src/AsyncOutputStream.h \
+    ../src/DumpContainer.h \
+    ../src/FastDouble.h \
+    ../src/ParseArena.h \
+    ../src/StepThreadPool.h \
+    ../src/FitnessCache.h \
+    ../src/LimitChecker.h \
+    ../src/Checkpoint.h \
+    ../src/PlaneCollider.h \
+    ../src/MeshCache.h \
+    ../src/SimulationBatch.h \
     ../src/StrokeFont.h \
     Logo.h
 FORMS += \
@@ -36,6 +36,7 @@
 #include "Driver.h"
 #include "DataTarget.h"
 #include "FacetedObject.h"
+#include "MeshCache.h"
 #include "Reporter.h"
 #include "Warehouse.h"
 #include "preferences.h"
@@ -74,6 +75,7 @@ MainWindow::MainWindow(QWidget *parent)
     // read in the preferences file
     preferences = new Preferences();
     preferences->Read();
+    MeshCache::GetCache()->SetUseCacheFiles(preferences->MeshCacheFiles);
 
     // create the window elements
     ui->setupUi(this);
@@ -991,6 +993,7 @@ void MainWindow::menuPreferences()
         ui->widgetGLWidget->Set3DCursorNudge(preferences->Nudge);
         ui->widgetGLWidget->SetCameraFrontClip(preferences->CameraFrontClip);
         ui->widgetGLWidget->SetCameraBackClip(preferences->CameraBackClip);
+        MeshCache::GetCache()->SetUseCacheFiles(preferences->MeshCacheFiles);
 
         updateGL();
 
@@ -83,6 +83,7 @@ void Preferences::Read()
 
     OpenCLUseOpenCL = settings.value("OpenCLUseOpenCL", false).toBool();
     OpenCLUseOpenCLLog = settings.value("OpenCLUseOpenCLLog", false).toBool();
+    MeshCacheFiles = settings.value("MeshCacheFiles", true).toBool();
     OpenCLDeviceDeviceNumber = settings.value("OpenCLDeviceDeviceNumber", 0).toInt();
     OpenCLTargetPlatform = settings.value("OpenCLTargetPlatform", 0).toInt();
     OpenCLDeviceType = settings.value("OpenCLDeviceType", "").toByteArray();
@@ -212,6 +213,7 @@ void Preferences::Write()
 
     settings.setValue("OpenCLUseOpenCL", OpenCLUseOpenCL);
     settings.setValue("OpenCLUseOpenCLLog", OpenCLUseOpenCLLog);
+    settings.setValue("MeshCacheFiles", MeshCacheFiles);
     settings.setValue("OpenCLDeviceDeviceNumber", OpenCLDeviceDeviceNumber);
     settings.setValue("OpenCLTargetPlatform", OpenCLTargetPlatform);
     settings.setValue("OpenCLDeviceType", OpenCLDeviceType);
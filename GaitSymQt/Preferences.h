@@ -99,6 +99,7 @@ public:
     int OpenGLMultisample;
     bool OpenCLUseOpenCL;
     bool OpenCLUseOpenCLLog;
+    bool MeshCacheFiles; // write parsed OBJ meshes to .meshcache files next to the OBJ files
     int OpenCLDeviceDeviceNumber;
     int OpenCLTargetPlatform;
     QString OpenCLDeviceType;
@@ -0,0 +1,37 @@
+#version 330
+
+// this is the generic Phong shading model shader for instanced drawing
+// the material colours are the instance colour multiplied by fixed proportions
+
+out vec4 colorOut;
+
+uniform vec3 materialProportions; // ambient, diffuse, specular
+uniform float shininess;
+
+in vec3 normalFrag;
+in vec3 eyeFrag;
+in vec3 lightDirFrag;
+in vec4 colourFrag;
+
+void main()
+{
+    vec4 ambient = vec4(colourFrag.rgb * materialProportions.x, colourFrag.a);
+    vec4 diffuse = vec4(colourFrag.rgb * materialProportions.y, colourFrag.a);
+    vec4 specular = vec4(colourFrag.rgb * materialProportions.z, colourFrag.a);
+
+    vec4 spec = vec4(0.0);
+
+    vec3 n = normalize(normalFrag);
+    vec3 l = normalize(lightDirFrag);
+    vec3 e = normalize(eyeFrag);
+
+    float intensity = max(dot(n,l), 0.0);
+    if (intensity > 0.0)
+    {
+        vec3 h = normalize(l + e);
+        float intSpec = max(dot(h,n), 0.0);
+        spec = specular * pow(intSpec, shininess);
+    }
+
+    colorOut = max(intensity * diffuse + spec, ambient);
+}
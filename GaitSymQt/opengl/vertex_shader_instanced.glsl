@@ -0,0 +1,34 @@
+#version 330
+
+// this is the generic Phong shading model shader for instanced drawing
+// the model matrix and the colour come from per instance attributes
+
+uniform mat4 viewMatrix;
+uniform mat4 projMatrix;
+
+uniform vec4 lightPosition;
+
+in vec4 vertex;
+in vec3 vertexNormal;
+in mat4 instanceModel;
+in vec4 instanceColour;
+
+out vec3 normalFrag;
+out vec3 eyeFrag;
+out vec3 lightDirFrag;
+out vec4 colourFrag;
+
+void main ()
+{
+    mat4 mvMatrix = viewMatrix * instanceModel;
+    vec4 pos = mvMatrix * vertex;
+
+    // the instances can be scaled unevenly so the normal matrix is the inverse transpose
+    mat3 normalMatrix = transpose(inverse(mat3(mvMatrix)));
+    normalFrag = normalize(normalMatrix * vertexNormal);
+    lightDirFrag = vec3(lightPosition - pos);
+    eyeFrag = vec3(-pos);
+    colourFrag = instanceColour;
+
+    gl_Position = projMatrix * pos;
+}
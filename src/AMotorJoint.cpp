@@ -250,14 +250,12 @@ void AMotorJoint::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "AMotorJoint::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tFX1\tFY1\tFZ1\tTX1\tTY1\tTZ1\tFX2\tFY2\tFZ2\tTX2\tTY2\tTZ2\tARV\tAT\tPower\n";
+            m_DumpStream->SetUnits("s\tN\tN\tN\tNm\tNm\tNm\tN\tN\tN\tNm\tNm\tNm\trad/s\tNm\tW");
         }
     }
 
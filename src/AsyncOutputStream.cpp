@@ -0,0 +1,405 @@
+/*
+ *  AsyncOutputStream.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Output file stream that queues the raw values in a ring buffer
+ *  and leaves the formatting and file I/O to a background thread
+ *
+ */
+
+#include <iostream>
+#include <chrono>
+#include <stdlib.h>
+
+#include "AsyncOutputStream.h"
+#include "FastDouble.h"
+
+// each record is a header followed by length bytes of payload
+struct AsyncOutputRecordHeader
+{
+    uint32_t type;
+    uint32_t stream;
+    uint32_t length;
+};
+
+AsyncOutputWriter::AsyncOutputWriter(size_t capacity)
+{
+    m_Capacity = capacity;
+    m_Mask = capacity - 1;
+    m_Buffer = new char[m_Capacity];
+    m_Head = 0;
+    m_Tail = 0;
+    m_CachedTail = 0;
+    m_StallCount = 0;
+    m_NextStreamID = 0;
+    m_OpenStreamCount = 0;
+    m_Abandoned = false;
+    m_DumpContainerOpen = false;
+    m_Quit = false;
+    m_Thread = std::thread(&AsyncOutputWriter::Run, this);
+}
+
+AsyncOutputWriter::~AsyncOutputWriter()
+{
+    CloseDumpContainer();
+    Flush();
+    m_Quit = true;
+    m_Thread.join();
+    for (unsigned int i = 0; i < m_StreamList.size(); i++)
+    {
+        if (m_StreamList[i]) delete m_StreamList[i];
+    }
+    delete [] m_Buffer;
+}
+
+// the writer is created the first time it is needed and is shut down (with all the
+// pending output written) when the program exits
+static AsyncOutputWriter *gAsyncOutputWriter = 0;
+
+static void DeleteAsyncOutputWriter()
+{
+    delete gAsyncOutputWriter;
+    gAsyncOutputWriter = 0;
+}
+
+AsyncOutputWriter *AsyncOutputWriter::GetWriter()
+{
+    if (gAsyncOutputWriter == 0)
+    {
+        gAsyncOutputWriter = new AsyncOutputWriter(1 << 22);
+        atexit(DeleteAsyncOutputWriter);
+    }
+    return gAsyncOutputWriter;
+}
+
+// returns 0 if nothing has needed a writer yet
+AsyncOutputWriter *AsyncOutputWriter::GetExistingWriter()
+{
+    return gAsyncOutputWriter;
+}
+
+// a child process created with fork() gets a copy of the writer but not its thread
+// so the copy is abandoned (its pending output belongs to the parent) and the child
+// starts a new writer the next time one is needed
+// anything still sent to the copy by streams opened before the fork is thrown away
+// rather than waiting forever for a thread that is not there
+void AsyncOutputWriter::ResetAfterFork()
+{
+    if (gAsyncOutputWriter) gAsyncOutputWriter->m_Abandoned = true;
+    gAsyncOutputWriter = 0;
+}
+
+// writes all the pending output and stops the writer thread
+// this is needed before _exit() since that does not run the atexit functions
+void AsyncOutputWriter::Shutdown()
+{
+    DeleteAsyncOutputWriter();
+}
+
+// called from the simulation thread
+// if the ring buffer is full this waits for the writer thread to catch up
+void AsyncOutputWriter::Push(RecordType type, int stream, const void *data, uint32_t length)
+{
+    if (m_Abandoned) return;
+    AsyncOutputRecordHeader header;
+    header.type = type;
+    header.stream = stream;
+    header.length = length;
+    size_t needed = sizeof(header) + length;
+    size_t head = m_Head.load(std::memory_order_relaxed);
+    if (m_Capacity - (head - m_CachedTail) < needed)
+    {
+        m_CachedTail = m_Tail.load(std::memory_order_acquire);
+        while (m_Capacity - (head - m_CachedTail) < needed)
+        {
+            m_StallCount++;
+            std::this_thread::yield();
+            m_CachedTail = m_Tail.load(std::memory_order_acquire);
+        }
+    }
+    CopyIn(head, &header, sizeof(header));
+    if (length) CopyIn(head + sizeof(header), data, length);
+    m_Head.store(head + needed, std::memory_order_release);
+}
+
+// called from the simulation thread
+// this returns once everything queued so far has been written out
+void AsyncOutputWriter::Flush()
+{
+    if (m_Abandoned) return;
+    Push(FlushRecord, 0, 0, 0);
+    while (m_Tail.load(std::memory_order_acquire) != m_Head.load(std::memory_order_relaxed))
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+void AsyncOutputWriter::OpenDumpContainer(const char *filename, bool compress)
+{
+    std::vector<char> data(sizeof(uint32_t) + strlen(filename) + 1);
+    uint32_t flags = compress;
+    memcpy(&data[0], &flags, sizeof(flags));
+    strcpy(&data[sizeof(uint32_t)], filename);
+    Push(OpenContainerRecord, 0, &data[0], data.size());
+    m_DumpContainerOpen = true;
+}
+
+void AsyncOutputWriter::CloseDumpContainer()
+{
+    if (m_DumpContainerOpen == false) return;
+    Push(CloseContainerRecord, 0, 0, 0);
+    m_DumpContainerOpen = false;
+}
+
+void AsyncOutputWriter::Run()
+{
+    AsyncOutputRecordHeader header;
+    size_t head, tail;
+    while (true)
+    {
+        head = m_Head.load(std::memory_order_acquire);
+        tail = m_Tail.load(std::memory_order_relaxed);
+        if (head == tail)
+        {
+            if (m_Quit) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        while (tail != head)
+        {
+            CopyOut(tail, &header, sizeof(header));
+            if (m_Payload.size() < header.length + 1) m_Payload.resize(header.length + 1);
+            if (header.length) CopyOut(tail + sizeof(header), &m_Payload[0], header.length);
+            Process(header.type, header.stream, &m_Payload[0], header.length);
+            tail += sizeof(header) + header.length;
+            m_Tail.store(tail, std::memory_order_release);
+        }
+    }
+}
+
+// called from the writer thread
+// the formatting is the same as writing the values directly to a std::ofstream
+void AsyncOutputWriter::Process(uint32_t type, uint32_t stream, const char *data, uint32_t length)
+{
+    if (type == FlushRecord)
+    {
+        for (unsigned int i = 0; i < m_StreamList.size(); i++)
+            if (m_StreamList[i]) m_StreamList[i]->flush();
+        return;
+    }
+
+    if (type == OpenContainerRecord)
+    {
+        m_DumpContainer.Open(data + sizeof(uint32_t), *(uint32_t *)data != 0);
+        return;
+    }
+    if (type == CloseContainerRecord)
+    {
+        m_DumpContainer.Close();
+        return;
+    }
+
+    if (stream >= m_StreamList.size())
+    {
+        m_StreamList.resize(stream + 1, 0);
+        m_StreamIsDumpGroup.resize(stream + 1, false);
+    }
+    if (type == OpenDumpGroupRecord)
+    {
+        m_StreamIsDumpGroup[stream] = true;
+        m_DumpContainer.AddGroup(stream, std::string(data, length));
+        return;
+    }
+    if (m_StreamIsDumpGroup[stream])
+    {
+        ProcessDumpGroup(type, stream, data, length);
+        return;
+    }
+
+    std::ofstream *file = m_StreamList[stream];
+    char number[32];
+
+    switch (type)
+    {
+    case OpenRecord:
+        if (file) delete file;
+        file = new std::ofstream(data + sizeof(uint32_t), std::ios::out | (std::ios::openmode)(*(uint32_t *)data));
+        if (file->good() == false) std::cerr << "AsyncOutputWriter error: could not open \"" << data + sizeof(uint32_t) << "\"\n";
+        m_StreamList[stream] = file;
+        break;
+    case CloseRecord:
+        if (file) delete file;
+        m_StreamList[stream] = 0;
+        break;
+    case PrecisionRecord:
+        if (file) file->precision(*(int32_t *)data);
+        break;
+    case DoubleRecord:
+        if (file)
+        {
+            // full precision output uses the shortest string that reads back exactly
+            if (file->precision() >= 17) file->write(number, FastDouble::Format(*(double *)data, number));
+            else *file << *(double *)data;
+        }
+        break;
+    case IntRecord:
+        if (file) *file << *(long long *)data;
+        break;
+    case UnsignedRecord:
+        if (file) *file << *(unsigned long long *)data;
+        break;
+    case BoolRecord:
+        if (file) *file << *(bool *)data;
+        break;
+    case CharRecord:
+        if (file) *file << *data;
+        break;
+    case StringRecord:
+    case RawRecord:
+        if (file) file->write(data, length);
+        break;
+    }
+}
+
+// called from the writer thread
+// numbers stay as doubles and everything else is passed on as text
+void AsyncOutputWriter::ProcessDumpGroup(uint32_t type, uint32_t stream, const char *data, uint32_t length)
+{
+    switch (type)
+    {
+    case CloseRecord:
+        m_DumpContainer.CloseGroup(stream);
+        m_StreamIsDumpGroup[stream] = false;
+        break;
+    case UnitsRecord:
+        m_DumpContainer.SetUnits(stream, data, length);
+        break;
+    case DoubleRecord:
+        m_DumpContainer.AddValue(stream, *(double *)data);
+        break;
+    case IntRecord:
+        m_DumpContainer.AddValue(stream, (double)(*(long long *)data));
+        break;
+    case UnsignedRecord:
+        m_DumpContainer.AddValue(stream, (double)(*(unsigned long long *)data));
+        break;
+    case BoolRecord:
+        m_DumpContainer.AddValue(stream, *(bool *)data ? 1 : 0);
+        break;
+    case CharRecord:
+        m_DumpContainer.AddText(stream, data, 1);
+        break;
+    case StringRecord:
+    case RawRecord:
+        m_DumpContainer.AddText(stream, data, length);
+        break;
+    }
+}
+
+void AsyncOutputWriter::CopyIn(size_t position, const void *data, size_t length)
+{
+    size_t start = position & m_Mask;
+    size_t first = m_Capacity - start;
+    if (first >= length)
+    {
+        memcpy(m_Buffer + start, data, length);
+    }
+    else
+    {
+        memcpy(m_Buffer + start, data, first);
+        memcpy(m_Buffer, (const char *)data + first, length - first);
+    }
+}
+
+void AsyncOutputWriter::CopyOut(size_t position, void *data, size_t length)
+{
+    size_t start = position & m_Mask;
+    size_t first = m_Capacity - start;
+    if (first >= length)
+    {
+        memcpy(data, m_Buffer + start, length);
+    }
+    else
+    {
+        memcpy(data, m_Buffer + start, first);
+        memcpy((char *)data + first, m_Buffer, length - first);
+    }
+}
+
+// the writer is only started when a stream is actually opened
+AsyncOutputStream::AsyncOutputStream()
+{
+    m_Writer = 0;
+    m_Stream = -1;
+}
+
+AsyncOutputStream::AsyncOutputStream(const char *filename, std::ios::openmode mode)
+{
+    m_Writer = 0;
+    m_Stream = -1;
+    open(filename, mode);
+}
+
+AsyncOutputStream::~AsyncOutputStream()
+{
+    close();
+}
+
+void AsyncOutputStream::open(const char *filename, std::ios::openmode mode)
+{
+    close();
+    m_Writer = AsyncOutputWriter::GetWriter();
+    m_Stream = m_Writer->NewStreamID();
+    std::vector<char> data(sizeof(uint32_t) + strlen(filename) + 1);
+    uint32_t flags = (uint32_t)(mode & std::ios::binary);
+    memcpy(&data[0], &flags, sizeof(flags));
+    strcpy(&data[sizeof(uint32_t)], filename);
+    Push(AsyncOutputWriter::OpenRecord, &data[0], data.size());
+}
+
+// this sends the output to a group in the writer's dump container
+void AsyncOutputStream::openDumpGroup(const char *name)
+{
+    close();
+    m_Writer = AsyncOutputWriter::GetWriter();
+    m_Stream = m_Writer->NewStreamID();
+    Push(AsyncOutputWriter::OpenDumpGroupRecord, name, strlen(name));
+}
+
+void AsyncOutputStream::close()
+{
+    if (m_Stream < 0) return;
+    Push(AsyncOutputWriter::CloseRecord, 0, 0);
+    m_Writer->ReleaseStreamID();
+    m_Stream = -1;
+}
+
+void AsyncOutputStream::precision(int precision)
+{
+    int32_t v = precision;
+    Push(AsyncOutputWriter::PrecisionRecord, &v, sizeof(v));
+}
+
+void AsyncOutputStream::write(const char *data, size_t length)
+{
+    PushBytes(AsyncOutputWriter::RawRecord, data, length);
+}
+
+void AsyncOutputStream::SetUnits(const char *units)
+{
+    Push(AsyncOutputWriter::UnitsRecord, units, strlen(units));
+}
+
+// long strings are split so that no single record can fill the ring buffer
+void AsyncOutputStream::PushBytes(AsyncOutputWriter::RecordType type, const char *data, size_t length)
+{
+    const size_t maxChunk = 1 << 16;
+    while (length > maxChunk)
+    {
+        Push(type, data, maxChunk);
+        data += maxChunk;
+        length -= maxChunk;
+    }
+    Push(type, data, length);
+}
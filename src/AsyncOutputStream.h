@@ -0,0 +1,150 @@
+/*
+ *  AsyncOutputStream.h
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Output file stream that queues the raw values in a ring buffer
+ *  and leaves the formatting and file I/O to a background thread
+ *
+ */
+
+#ifndef ASYNCOUTPUTSTREAM_H
+#define ASYNCOUTPUTSTREAM_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include <stdint.h>
+#include <string.h>
+
+#include "DumpContainer.h"
+
+// there is only ever one producer (the simulation thread) and one consumer
+// (the writer thread) so the ring buffer needs no locks
+class AsyncOutputWriter
+{
+public:
+    ~AsyncOutputWriter();
+
+    static AsyncOutputWriter *GetWriter();
+    static AsyncOutputWriter *GetExistingWriter();
+    static void ResetAfterFork();
+    static void Shutdown();
+
+    enum RecordType
+    {
+        OpenRecord = 0,
+        CloseRecord,
+        PrecisionRecord,
+        FlushRecord,
+        DoubleRecord,
+        IntRecord,
+        UnsignedRecord,
+        BoolRecord,
+        CharRecord,
+        StringRecord,
+        RawRecord,
+        OpenDumpGroupRecord,
+        UnitsRecord,
+        OpenContainerRecord,
+        CloseContainerRecord
+    };
+
+    int NewStreamID() { m_OpenStreamCount++; return m_NextStreamID++; }
+    void ReleaseStreamID() { m_OpenStreamCount--; }
+    int GetOpenStreamCount() { return m_OpenStreamCount; }
+    void Push(RecordType type, int stream, const void *data, uint32_t length);
+    void Flush();
+
+    // while a dump container is open Dump() outputs are sent there rather than to separate files
+    void OpenDumpContainer(const char *filename, bool compress);
+    void CloseDumpContainer();
+    bool GetDumpContainerOpen() { return m_DumpContainerOpen; }
+
+    uint64_t GetStallCount() { return m_StallCount; }
+
+protected:
+    AsyncOutputWriter(size_t capacity);
+
+    void Run();
+    void Process(uint32_t type, uint32_t stream, const char *data, uint32_t length);
+    void ProcessDumpGroup(uint32_t type, uint32_t stream, const char *data, uint32_t length);
+    void CopyIn(size_t position, const void *data, size_t length);
+    void CopyOut(size_t position, void *data, size_t length);
+
+    char *m_Buffer;
+    size_t m_Capacity; // must be a power of 2
+    size_t m_Mask;
+    std::atomic<size_t> m_Head; // only written by the producer
+    std::atomic<size_t> m_Tail; // only written by the consumer
+    size_t m_CachedTail;
+    uint64_t m_StallCount;
+    int m_NextStreamID;
+    int m_OpenStreamCount;
+    bool m_DumpContainerOpen;
+    bool m_Abandoned; // set in a forked child where the writer thread does not exist
+
+    std::atomic<bool> m_Quit;
+    std::thread m_Thread;
+
+    // these are only touched by the writer thread
+    std::vector<std::ofstream *> m_StreamList;
+    std::vector<bool> m_StreamIsDumpGroup;
+    DumpContainer m_DumpContainer;
+    std::vector<char> m_Payload;
+};
+
+// this is a drop in replacement for the bits of std::ofstream that we use for output files
+class AsyncOutputStream
+{
+public:
+    AsyncOutputStream();
+    AsyncOutputStream(const char *filename, std::ios::openmode mode = std::ios::out);
+    ~AsyncOutputStream();
+
+    void open(const char *filename, std::ios::openmode mode = std::ios::out);
+    void openDumpGroup(const char *name);
+    void close();
+    bool is_open() { return m_Stream >= 0; }
+    void precision(int precision);
+    void write(const char *data, size_t length);
+    void SetUnits(const char *units); // tab separated, only used by dump groups
+
+    AsyncOutputWriter *GetWriter() { return m_Writer; }
+
+    AsyncOutputStream &operator<<(double v) { Push(AsyncOutputWriter::DoubleRecord, &v, sizeof(v)); return *this; }
+    AsyncOutputStream &operator<<(float v) { return *this << double(v); }
+    AsyncOutputStream &operator<<(int v) { return *this << (long long)v; }
+    AsyncOutputStream &operator<<(long v) { return *this << (long long)v; }
+    AsyncOutputStream &operator<<(long long v) { Push(AsyncOutputWriter::IntRecord, &v, sizeof(v)); return *this; }
+    AsyncOutputStream &operator<<(unsigned int v) { return *this << (unsigned long long)v; }
+    AsyncOutputStream &operator<<(unsigned long v) { return *this << (unsigned long long)v; }
+    AsyncOutputStream &operator<<(unsigned long long v) { Push(AsyncOutputWriter::UnsignedRecord, &v, sizeof(v)); return *this; }
+    AsyncOutputStream &operator<<(bool v) { Push(AsyncOutputWriter::BoolRecord, &v, sizeof(v)); return *this; }
+    AsyncOutputStream &operator<<(char v) { Push(AsyncOutputWriter::CharRecord, &v, sizeof(v)); return *this; }
+    AsyncOutputStream &operator<<(const char *v) { PushBytes(AsyncOutputWriter::StringRecord, v, strlen(v)); return *this; }
+    AsyncOutputStream &operator<<(const std::string &v) { PushBytes(AsyncOutputWriter::StringRecord, v.data(), v.size()); return *this; }
+
+    template <typename T> void BinaryOutput(T v) { write((const char *)&v, sizeof(v)); }
+    void BinaryOutput(const std::string &v) { BinaryOutput((uint32_t)v.size()); write(v.data(), v.size()); }
+
+protected:
+    void Push(AsyncOutputWriter::RecordType type, const void *data, uint32_t length)
+    {
+        if (m_Stream >= 0) m_Writer->Push(type, m_Stream, data, length);
+    }
+    void PushBytes(AsyncOutputWriter::RecordType type, const char *data, size_t length);
+
+    AsyncOutputWriter *m_Writer;
+    int m_Stream;
+
+private:
+    AsyncOutputStream(const AsyncOutputStream &);
+    AsyncOutputStream &operator=(const AsyncOutputStream &);
+};
+
+#endif // ASYNCOUTPUTSTREAM_H
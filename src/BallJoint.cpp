@@ -288,14 +288,12 @@ void BallJoint::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "NamedObject::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tXP\tYP\tZP\ttheta0\ttheta1\ttheta2\tFX1\tFY1\tFZ1\tTX1\tTY1\tTZ1\tFX2\tFY2\tFZ2\tTX2\tTY2\tTZ2\tMotorFX1\tMotorFY1\tMotorFZ1\tMotorTX1\tMotorTY1\tMotorTZ1\tMotorFX2\tMotorFY2\tMotorFZ2\tMotorTX2\tMotorTY2\tMotorTZ2\n";
+            m_DumpStream->SetUnits("s\tm\tm\tm\trad\trad\trad\tN\tN\tN\tNm\tNm\tNm\tN\tN\tN\tNm\tNm\tNm\tN\tN\tN\tNm\tNm\tNm\tN\tN\tN\tNm\tNm\tNm");
         }
     }
 
@@ -331,7 +329,7 @@ void BallJoint::Draw()
     if (m_FirstDraw)
     {
         m_FirstDraw = false;
-        m_PhysRep = new FacetedSphere(m_AxisSize[0] / 10, 4);
+        m_PhysRep = new FacetedSphere(m_AxisSize[0] / 10, 4, true); // drawn as an instance of the shared unit sphere
         m_PhysRep->SetColour(m_Colour);
     }
 
@@ -20,6 +20,7 @@
 #include <ode/ode.h>
 
 #include "Body.h"
+#include "Checkpoint.h"
 #include "Simulation.h"
 #include "PGDMath.h"
 #include "Util.h"
@@ -612,14 +613,12 @@ void Body::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "NamedObject::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tXP\tYP\tZP\tXV\tYV\tZV\tQW\tQX\tQY\tQZ\tRVX\tRVY\tRVZ\tLKEX\tLKEY\tLKEZ\tRKE\tGPE\n";
+            m_DumpStream->SetUnits("s\tm\tm\tm\tm/s\tm/s\tm/s\t\t\t\t\trad/s\trad/s\trad/s\tJ\tJ\tJ\tJ\tJ");
         }
     }
 
@@ -865,3 +864,50 @@ void Body::SetFacetedObject(FacetedObject *obj)
 }
 
 #endif
+
+void Body::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    const double *p = dBodyGetPosition(m_BodyID);
+    const double *q = dBodyGetQuaternion(m_BodyID);
+    const double *R = dBodyGetRotation(m_BodyID);
+    const double *v = dBodyGetLinearVel(m_BodyID);
+    const double *av = dBodyGetAngularVel(m_BodyID);
+    const double *f = dBodyGetForce(m_BodyID);
+    const double *t = dBodyGetTorque(m_BodyID);
+    checkpoint->Write(p, sizeof(double) * 3);
+    checkpoint->Write(q, sizeof(double) * 4);
+    checkpoint->Write(R, sizeof(double) * 12);
+    checkpoint->Write(v, sizeof(double) * 3);
+    checkpoint->Write(av, sizeof(double) * 3);
+    checkpoint->Write(f, sizeof(double) * 3);
+    checkpoint->Write(t, sizeof(double) * 3);
+    int enabled = dBodyIsEnabled(m_BodyID);
+    checkpoint->Write(enabled);
+}
+
+void Body::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    double p[3], q[4], R[12], v[3], av[3], f[3], t[3];
+    int enabled;
+    checkpoint->Read(p, sizeof(p));
+    checkpoint->Read(q, sizeof(q));
+    checkpoint->Read(R, sizeof(R));
+    checkpoint->Read(v, sizeof(v));
+    checkpoint->Read(av, sizeof(av));
+    checkpoint->Read(f, sizeof(f));
+    checkpoint->Read(t, sizeof(t));
+    checkpoint->Read(&enabled);
+    // dBodySetQuaternion renormalises the quaternion and recalculates the rotation matrix which can change
+    // the last bits so it is only used to tell the geoms that the body has moved and then the stored values
+    // are copied over the body's own values (the ODE getters return pointers to them)
+    dBodySetPosition(m_BodyID, p[0], p[1], p[2]);
+    dBodySetQuaternion(m_BodyID, q);
+    memcpy((double *)dBodyGetQuaternion(m_BodyID), q, sizeof(q));
+    memcpy((double *)dBodyGetRotation(m_BodyID), R, sizeof(R));
+    dBodySetLinearVel(m_BodyID, v[0], v[1], v[2]);
+    dBodySetAngularVel(m_BodyID, av[0], av[1], av[2]);
+    dBodySetForce(m_BodyID, f[0], f[1], f[2]);
+    dBodySetTorque(m_BodyID, t[0], t[1], t[2]);
+    if (enabled) dBodyEnable(m_BodyID);
+    else dBodyDisable(m_BodyID);
+}
@@ -65,6 +65,10 @@ public:
     void SetPositionHighBound(double x, double y, double z) { m_PositionHighBound[0] = x; m_PositionHighBound[1] = y; m_PositionHighBound[2] = z; };
     void SetLinearVelocityLowBound(double x, double y, double z) { m_LinearVelocityLowBound[0] = x; m_LinearVelocityLowBound[1] = y; m_LinearVelocityLowBound[2] = z; };
     void SetLinearVelocityHighBound(double x, double y, double z) { m_LinearVelocityHighBound[0] = x; m_LinearVelocityHighBound[1] = y; m_LinearVelocityHighBound[2] = z; };
+    const double *GetPositionLowBound() { return m_PositionLowBound; };
+    const double *GetPositionHighBound() { return m_PositionHighBound; };
+    const double *GetLinearVelocityLowBound() { return m_LinearVelocityLowBound; };
+    const double *GetLinearVelocityHighBound() { return m_LinearVelocityHighBound; };
 
     void SetLinearDamping(double scale);
     void SetAngularDamping(double scale);
@@ -109,6 +113,8 @@ public:
     const double *GetOffset() { return m_Offset; };
 
     virtual void Dump();
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
 
 #ifdef USE_QT
     void Draw();
@@ -0,0 +1,139 @@
+/*
+ *  Checkpoint.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Binary snapshot of the complete state of a running simulation
+ *  that can be kept in memory or written to a file
+ *
+ */
+
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+
+#include "Checkpoint.h"
+
+static const char kCheckpointMagic[8] = {'G', 'S', 'C', 'H', 'K', 'P', 'T', '2'};
+
+Checkpoint::Checkpoint()
+{
+    m_ReadPosition = 0;
+}
+
+Checkpoint::~Checkpoint()
+{
+}
+
+// the file is written to a temporary name and then renamed so that an interrupted run
+// always leaves a complete checkpoint behind
+bool Checkpoint::WriteFile(const char *filename)
+{
+    std::string tempFilename = std::string(filename) + ".tmp";
+    std::ofstream out(tempFilename.c_str(), std::ios::out | std::ios::binary);
+    if (out.good() == false)
+    {
+        std::cerr << "Checkpoint error: could not open \"" << tempFilename << "\"\n";
+        return false;
+    }
+    uint64_t length = m_Data.size();
+    out.write(kCheckpointMagic, sizeof(kCheckpointMagic));
+    out.write((const char *)&length, sizeof(length));
+    if (length) out.write(&m_Data[0], length);
+    out.close();
+    if (out.fail())
+    {
+        std::cerr << "Checkpoint error: could not write \"" << tempFilename << "\"\n";
+        return false;
+    }
+    if (rename(tempFilename.c_str(), filename))
+    {
+        std::cerr << "Checkpoint error: could not rename \"" << tempFilename << "\" to \"" << filename << "\"\n";
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::ReadFile(const char *filename)
+{
+    Clear();
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    if (in.good() == false)
+    {
+        std::cerr << "Checkpoint error: could not open \"" << filename << "\"\n";
+        return false;
+    }
+    char magic[sizeof(kCheckpointMagic)];
+    uint64_t length = 0;
+    in.read(magic, sizeof(magic));
+    in.read((char *)&length, sizeof(length));
+    if (in.fail() || memcmp(magic, kCheckpointMagic, sizeof(magic)) != 0)
+    {
+        std::cerr << "Checkpoint error: \"" << filename << "\" is not a checkpoint file\n";
+        return false;
+    }
+    m_Data.resize(length);
+    if (length) in.read(&m_Data[0], length);
+    if ((uint64_t)in.gcount() != length)
+    {
+        std::cerr << "Checkpoint error: \"" << filename << "\" is truncated\n";
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+void Checkpoint::WriteString(const std::string &s)
+{
+    uint64_t length = s.size();
+    Write(length);
+    Write(s.data(), s.size());
+}
+
+void Checkpoint::Read(void *data, size_t length)
+{
+    if (length > m_Data.size() - m_ReadPosition) throw __LINE__;
+    if (length) memcpy(data, &m_Data[m_ReadPosition], length);
+    m_ReadPosition += length;
+}
+
+std::string Checkpoint::ReadString()
+{
+    uint64_t length;
+    Read(&length);
+    if (length > m_Data.size() - m_ReadPosition) throw __LINE__;
+    std::string s(m_Data.begin() + m_ReadPosition, m_Data.begin() + m_ReadPosition + length);
+    m_ReadPosition += length;
+    return s;
+}
+
+// returns the position of the length which is filled in by EndBlock
+size_t Checkpoint::BeginBlock()
+{
+    uint64_t length = 0;
+    size_t start = m_Data.size();
+    Write(length);
+    return start;
+}
+
+void Checkpoint::EndBlock(size_t start)
+{
+    uint64_t length = m_Data.size() - start - sizeof(length);
+    memcpy(&m_Data[start], &length, sizeof(length));
+}
+
+// returns the position where the block should end
+size_t Checkpoint::BeginReadBlock()
+{
+    uint64_t length;
+    Read(&length);
+    if (length > m_Data.size() - m_ReadPosition) throw __LINE__;
+    return m_ReadPosition + length;
+}
+
+void Checkpoint::EndReadBlock(size_t end)
+{
+    if (m_ReadPosition != end) throw __LINE__;
+}
@@ -0,0 +1,68 @@
+/*
+ *  Checkpoint.h
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Binary snapshot of the complete state of a running simulation
+ *  that can be kept in memory or written to a file
+ *
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* file format (all values in native byte order so files are not portable between architectures)
+ *
+ * char[8] "GSCHKPT2"
+ * uint64 length of the state data then the state data
+ *
+ * the state data is written by Simulation::WriteCheckpoint and is the model hash
+ * followed by the simulation values and then each object as name, uint64 length, object values
+ */
+
+class Checkpoint
+{
+public:
+    Checkpoint();
+    ~Checkpoint();
+
+    void Clear() { m_Data.clear(); m_ReadPosition = 0; }
+    void Rewind() { m_ReadPosition = 0; }
+
+    bool WriteFile(const char *filename);
+    bool ReadFile(const char *filename);
+
+    // values are copied bitwise so only plain data types can be used
+    void Write(const void *data, size_t length) { m_Data.insert(m_Data.end(), (const char *)data, (const char *)data + length); }
+    template <typename T> void Write(const T &value) { Write(&value, sizeof(T)); }
+    void WriteString(const std::string &s);
+
+    // reading past the end of the data throws
+    void Read(void *data, size_t length);
+    template <typename T> void Read(T *value) { Read(value, sizeof(T)); }
+    std::string ReadString();
+
+    // a block is length prefixed so the reader can check that each object reads back exactly what it wrote
+    size_t BeginBlock();
+    void EndBlock(size_t start);
+    size_t BeginReadBlock();
+    void EndReadBlock(size_t end);
+
+    size_t GetSize() { return m_Data.size(); }
+    bool Matches(const Checkpoint *other) { return m_Data == other->m_Data; }
+
+protected:
+
+    std::vector<char> m_Data;
+    size_t m_ReadPosition;
+};
+
+#endif // CHECKPOINT_H
@@ -42,14 +42,18 @@ void Contact::Draw()
         GLUtils::DrawAxes(m_AxisSize[0], m_AxisSize[1], m_AxisSize[2],
                 m_ContactPosition[0], m_ContactPosition[1], m_ContactPosition[2]);
 
-        std::vector<pgd::Vector> polyline;
-        pgd::Vector startPos(m_ContactPosition[0], m_ContactPosition[1], m_ContactPosition[2]);
+        // the force is drawn as an instance of the shared unit tube stretched along the force vector
         pgd::Vector length(m_ContactJointFeedback.f1[0] * m_ForceScale, m_ContactJointFeedback.f1[1] * m_ForceScale, m_ContactJointFeedback.f1[2] * m_ForceScale);
-        polyline.push_back(startPos);
-        polyline.push_back(startPos + length);
-        m_PhysRep = new FacetedPolyline(&polyline, m_ForceRadius, kSides);
-        m_PhysRep->SetColour(m_Colour);
-        m_PhysRep->Draw();
+        double magnitude = length.Magnitude();
+        if (magnitude > 0)
+        {
+            if (m_PhysRep == 0) m_PhysRep = new FacetedObject();
+            m_PhysRep->SetSharedMesh(FacetedPolyline::GetUnitTube(kSides), m_ForceRadius, m_ForceRadius, magnitude);
+            m_PhysRep->SetDisplayPosition(m_ContactPosition[0], m_ContactPosition[1], m_ContactPosition[2]);
+            m_PhysRep->SetDisplayRotationFromAxis(length.x, length.y, length.z, false);
+            m_PhysRep->SetColour(m_Colour);
+            m_PhysRep->Draw();
+        }
     }
 }
 #endif
@@ -14,6 +14,7 @@
 #include <ode/ode.h>
 
 #include "CyclicDriver.h"
+#include "Checkpoint.h"
 #include "Util.h"
 
 CyclicDriver::CyclicDriver()
@@ -113,3 +114,13 @@ double CyclicDriver::GetCycleTime()
 {
     return m_DurationList[m_ListLength];
 }
+
+void CyclicDriver::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Write(m_LastIndex);
+}
+
+void CyclicDriver::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Read(&m_LastIndex);
+}
@@ -24,6 +24,14 @@ public:
     void SetPhaseDelay(double phaseDelay) { m_PhaseDelay = phaseDelay; }; // 0 to 1
     double GetValue(double time);
     double GetCycleTime();
+
+    double *GetValueList() { return m_ValueList; }
+    double *GetDurationList() { return m_DurationList; }
+    double GetPhaseDelay() { return m_PhaseDelay; }
+    int GetListLength() { return m_ListLength; }
+
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
     
 protected:
         
@@ -13,6 +13,7 @@
 
 #include "Strap.h"
 #include "DampedSpringMuscle.h"
+#include "Checkpoint.h"
 #include "DebugControl.h"
 #include "Simulation.h"
 
@@ -96,14 +97,12 @@ void DampedSpringMuscle::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "NamedObject::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tact\ttension\tlength\tvelocity\tPMECH\n";
+            m_DumpStream->SetUnits("s\t\tN\tm\tm/s\tW");
         }
     }
 
@@ -117,4 +116,14 @@ void DampedSpringMuscle::Dump()
     }
 }
 
+void DampedSpringMuscle::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    Muscle::WriteCheckpoint(checkpoint);
+    checkpoint->Write(m_Activation);
+}
 
+void DampedSpringMuscle::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    Muscle::ReadCheckpoint(checkpoint);
+    checkpoint->Read(&m_Activation);
+}
@@ -33,11 +33,16 @@ public:
     double GetArea() { return m_Area; }; // value is in m2
     double GetElasticEnergy();
 
+    // used by SimulationBatch which calculates the tension itself
+    void SetActivationValue(double activation) { m_Activation = activation; }
+
     virtual void SetActivation(double activation, double duration);
     virtual double GetActivation() { return m_Activation; };
     virtual double GetMetabolicPower() { return 0; };
 
     virtual void Dump();
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
 
 protected:
 
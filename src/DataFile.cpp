@@ -18,6 +18,7 @@
 #include <iostream>
 
 #include "DataFile.h"
+#include "FastDouble.h"
 
 #if defined(_WIN32) || defined(WIN32)
 #define snprintf _snprintf
@@ -278,7 +279,7 @@ bool DataFile::RetrieveParameter(const char * const param, double *val, bool sea
 
     if (RetrieveParameter(param, buffer, sizeof(buffer), searchFromStart)) return true;
 
-    *val = strtod(buffer, 0);
+    *val = FastDouble::Parse(buffer);
 
     return false;
 }
@@ -546,7 +547,7 @@ bool DataFile::ReadNext(double *val)
 
     if (ReadNext(buffer, sizeof(buffer))) return true;
 
-    *val = strtod(buffer, 0);
+    *val = FastDouble::Parse(buffer);
 
     return false;
 }
@@ -1164,7 +1165,7 @@ bool DataFile::WriteParameter(const char * const param, double val)
 {
     char buffer[64];
 
-    sprintf(buffer, "%.17e", val);
+    FastDouble::Format(val, buffer);
     if (WriteParameter(param, buffer)) return true;
 
     return false;
@@ -1298,7 +1299,7 @@ bool DataFile::WriteNext(double val, char after)
 {
     char buffer[64];
 
-    sprintf(buffer, "%.17e", val);
+    FastDouble::Format(val, buffer);
     if (WriteNext(buffer, after)) return true;
 
     return false;
@@ -1484,15 +1485,15 @@ bool DataFile::StringEndsWith(const char * str, const char * suffix)
 // more handy statics
 double DataFile::Double(const char *buf)
 {
-    return strtod(buf, 0);
+    return FastDouble::Parse(buf);
 }
 
 void DataFile::Double(const char *buf, long n, double *d)
 {
     char *ptr;
-    d[0] = strtod(buf, &ptr);
+    d[0] = FastDouble::Parse(buf, &ptr);
     for (long i = 1; i < n; i++)
-        d[i] = strtod(ptr, &ptr);
+        d[i] = FastDouble::Parse(ptr, &ptr);
 }
 
 int DataFile::Int(const char *buf)
@@ -13,6 +13,7 @@
 #include <ode/ode.h>
 
 #include "DataTarget.h"
+#include "Checkpoint.h"
 #include "Util.h"
 
 // Simulation global
@@ -145,5 +146,12 @@ double DataTarget::GetMatchValue(int index)
     return matchScore;
 }
 
+void DataTarget::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Write(m_LastMatchIndex);
+}
 
-
+void DataTarget::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Read(&m_LastMatchIndex);
+}
@@ -45,6 +45,9 @@ public:
     virtual void Draw() = 0;
 #endif
 
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
+
 protected:
 
     int ProtectedTargetMatch(double time, double tolerance);
@@ -8,10 +8,12 @@
  */
 
 #include <vector>
+#include <algorithm>
 #include <ode/ode.h>
 
 #include "Driver.h"
 #include "Drivable.h"
+#include "Checkpoint.h"
 
 Drivable::Drivable()
 {
@@ -27,3 +29,28 @@ double Drivable::SumDrivers(double time)
     }
     return m_currentDriverSum;
 }
+
+void Drivable::RemoveDriver(Driver *driver)
+{
+    std::vector<Driver *>::iterator iter = std::find(m_driverList.begin(), m_driverList.end(), driver);
+    if (iter != m_driverList.end()) m_driverList.erase(iter);
+}
+
+// the new driver takes the place of the old one so that the drivers are still summed in the same order
+void Drivable::ReplaceDriver(Driver *oldDriver, Driver *newDriver)
+{
+    RemoveDriver(newDriver);
+    std::vector<Driver *>::iterator iter = std::find(m_driverList.begin(), m_driverList.end(), oldDriver);
+    if (iter != m_driverList.end()) *iter = newDriver;
+    else m_driverList.push_back(newDriver);
+}
+
+void Drivable::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Write(m_currentDriverSum);
+}
+
+void Drivable::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Read(&m_currentDriverSum);
+}
@@ -22,10 +22,16 @@ public:
     Drivable();
 
     void AddDriver(Driver *driver) { m_driverList.push_back(driver); }
+    void RemoveDriver(Driver *driver);
+    void ReplaceDriver(Driver *oldDriver, Driver *newDriver);
+    std::vector<Driver *> *GetDriverList() { return &m_driverList; }
     double GetCurrentDriverSum() { return m_currentDriverSum; }
     void SetCurrentDriverSum(double currentDriverSum) { m_currentDriverSum = currentDriverSum; }
     double SumDrivers(double time);
 
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
+
 protected:
     std::vector<Driver *> m_driverList;
     double m_currentDriverSum;
@@ -0,0 +1,417 @@
+/*
+ *  DriverEngine.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Compiles all the drivers into flat segment tables and
+ *  evaluates them together once per time step
+ *
+ */
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include <ode/ode.h>
+
+#include "DriverEngine.h"
+#include "Driver.h"
+#include "Drivable.h"
+#include "CyclicDriver.h"
+#include "StepDriver.h"
+#include "BoxCarDriver.h"
+#include "StackedBoxCarDriver.h"
+
+DriverEngine::DriverEngine()
+{
+    m_LastTime = -DBL_MAX;
+    m_NumCopies = 1;
+}
+
+DriverEngine::~DriverEngine()
+{
+}
+
+// this builds the lane and segment tables from the current driver settings
+// it needs to be called again if any of the driver parameters are changed
+void DriverEngine::Compile(std::map<std::string, Driver *> *driverList)
+{
+    m_LaneType.clear();
+    m_LaneChannel.clear();
+    m_LaneFirstSegment.clear();
+    m_LaneNumSegments.clear();
+    m_LaneCursor.clear();
+    m_LanePeriod.clear();
+    m_LaneOffset.clear();
+    m_SegmentStart.clear();
+    m_SegmentValue.clear();
+    m_SegmentDelta.clear();
+    m_SegmentWidth.clear();
+    m_ChannelValue.clear();
+    m_ChannelMin.clear();
+    m_ChannelMax.clear();
+    m_TargetList.clear();
+    m_TargetFirstChannel.clear();
+    m_TargetNumChannels.clear();
+    m_FallbackChannelList.clear();
+    m_FallbackDriverList.clear();
+    m_TargetSum.clear();
+    m_LaneX.clear();
+    m_LastTime = -DBL_MAX;
+    m_NumCopies = 1;
+
+    // the channels are ordered using the target's own driver list so that the sums
+    // are accumulated in exactly the same order as Drivable::SumDrivers
+    std::map<std::string, Driver *>::const_iterator iter;
+    for (iter = driverList->begin(); iter != driverList->end(); iter++)
+    {
+        Drivable *target = iter->second->GetTarget();
+        if (target == 0) continue;
+        if (std::find(m_TargetList.begin(), m_TargetList.end(), target) == m_TargetList.end()) m_TargetList.push_back(target);
+    }
+
+    for (unsigned int t = 0; t < m_TargetList.size(); t++)
+    {
+        std::vector<Driver *> *targetDriverList = m_TargetList[t]->GetDriverList();
+        m_TargetFirstChannel.push_back(m_ChannelValue.size());
+        m_TargetNumChannels.push_back(targetDriverList->size());
+
+        for (unsigned int d = 0; d < targetDriverList->size(); d++)
+        {
+            Driver *driver = (*targetDriverList)[d];
+            int channel = m_ChannelValue.size();
+            m_ChannelValue.push_back(0);
+            m_ChannelMin.push_back(driver->GetMinValue());
+            m_ChannelMax.push_back(driver->GetMaxValue());
+
+            CyclicDriver *cyclicDriver = dynamic_cast<CyclicDriver *>(driver);
+            StepDriver *stepDriver = dynamic_cast<StepDriver *>(driver);
+            BoxCarDriver *boxCarDriver = dynamic_cast<BoxCarDriver *>(driver);
+            StackedBoxCarDriver *stackedBoxCarDriver = dynamic_cast<StackedBoxCarDriver *>(driver);
+
+            if (cyclicDriver && cyclicDriver->GetListLength() > 0)
+            {
+                int n = cyclicDriver->GetListLength();
+                double *durationList = cyclicDriver->GetDurationList();
+                double *valueList = cyclicDriver->GetValueList();
+                double period = durationList[n];
+                // this is the same positive offset that CyclicDriver::GetValue uses
+                double offset = period - period * cyclicDriver->GetPhaseDelay();
+                AddLane(CyclicLane, channel, period, offset);
+                for (int i = 0; i < n; i++)
+                {
+                    if (driver->GetInterp()) AddSegment(durationList[i], valueList[i], valueList[i + 1] - valueList[i], durationList[i + 1] - durationList[i]);
+                    else AddSegment(durationList[i], valueList[i], 0, durationList[i + 1] - durationList[i]);
+                }
+            }
+            else if (stepDriver && stepDriver->GetListLength() > 0)
+            {
+                int n = stepDriver->GetListLength();
+                double *durationList = stepDriver->GetDurationList();
+                double *valueList = stepDriver->GetValueList();
+                AddLane(AbsoluteLane, channel, 0, 0);
+                for (int i = 0; i < n - 1; i++)
+                {
+                    if (driver->GetInterp()) AddSegment(durationList[i], valueList[i], valueList[i + 1] - valueList[i], durationList[i + 1] - durationList[i]);
+                    else AddSegment(durationList[i], valueList[i], 0, durationList[i + 1] - durationList[i]);
+                }
+                AddSegment(durationList[n - 1], valueList[n - 1], 0, 1); // the last value is held indefinitely
+            }
+            else if (boxCarDriver)
+            {
+                AddBoxCarLane(channel, boxCarDriver->GetCycleTime(), boxCarDriver->GetDelay(), boxCarDriver->GetWidth(), boxCarDriver->GetHeight());
+            }
+            else if (stackedBoxCarDriver)
+            {
+                for (unsigned int i = 0; i < stackedBoxCarDriver->GetCycleTimes()->size(); i++)
+                    AddBoxCarLane(channel, stackedBoxCarDriver->GetCycleTimes()->at(i), stackedBoxCarDriver->GetDelays()->at(i),
+                                  stackedBoxCarDriver->GetWidths()->at(i), stackedBoxCarDriver->GetHeights()->at(i));
+            }
+            else
+            {
+                // FixedDriver values can be altered during the simulation so these are always called directly
+                // and GetValue applies its own range limits (if any)
+                m_FallbackChannelList.push_back(channel);
+                m_FallbackDriverList.push_back(driver);
+                m_ChannelMin[channel] = -DBL_MAX;
+                m_ChannelMax[channel] = DBL_MAX;
+            }
+        }
+    }
+}
+
+// evaluates all the drivers at the current time and sets the driver sums of the targets
+void DriverEngine::Evaluate(double time)
+{
+    unsigned int i;
+    int c;
+
+    // the cursors only ever move forwards so restart them if time has gone backwards
+    if (time < m_LastTime) m_LaneCursor = m_LaneFirstSegment;
+    m_LastTime = time;
+
+    std::fill(m_ChannelValue.begin(), m_ChannelValue.end(), 0);
+
+    for (i = 0; i < m_FallbackChannelList.size(); i++)
+        m_ChannelValue[m_FallbackChannelList[i]] = m_FallbackDriverList[i]->GetValue(time);
+
+    const double *segmentStart = m_SegmentStart.size() ? &m_SegmentStart[0] : 0;
+    const double *segmentValue = m_SegmentValue.size() ? &m_SegmentValue[0] : 0;
+    const double *segmentDelta = m_SegmentDelta.size() ? &m_SegmentDelta[0] : 0;
+    const double *segmentWidth = m_SegmentWidth.size() ? &m_SegmentWidth[0] : 0;
+    double x, r;
+    int first, last;
+    for (i = 0; i < m_LaneType.size(); i++)
+    {
+        switch (m_LaneType[i])
+        {
+        case CyclicLane:
+            x = fmod(time + m_LaneOffset[i], m_LanePeriod[i]);
+            break;
+        case NormalisedLane:
+            r = time / m_LanePeriod[i];
+            x = r - floor(r);
+            break;
+        default:
+            x = time;
+        }
+
+        first = m_LaneFirstSegment[i];
+        last = first + m_LaneNumSegments[i] - 1;
+        c = m_LaneCursor[i];
+        if (x < segmentStart[c]) c = first; // cyclic wrap
+        while (c < last && x >= segmentStart[c + 1]) c++;
+        m_LaneCursor[i] = c;
+
+        m_ChannelValue[m_LaneChannel[i]] += ((x - segmentStart[c]) / segmentWidth[c]) * segmentDelta[c] + segmentValue[c];
+    }
+
+    for (i = 0; i < m_ChannelValue.size(); i++)
+    {
+        if (m_ChannelValue[i] < m_ChannelMin[i]) m_ChannelValue[i] = m_ChannelMin[i];
+        if (m_ChannelValue[i] > m_ChannelMax[i]) m_ChannelValue[i] = m_ChannelMax[i];
+    }
+
+    double sum;
+    for (i = 0; i < m_TargetList.size(); i++)
+    {
+        sum = 0;
+        for (c = m_TargetFirstChannel[i]; c < m_TargetFirstChannel[i] + m_TargetNumChannels[i]; c++) sum += m_ChannelValue[c];
+        m_TargetList[i]->SetCurrentDriverSum(sum);
+    }
+}
+
+// the genomes of the copies can change the segment values but not the number of segments
+// and the lane types, channels and targets have to match for the copies to be interleaved
+bool DriverEngine::CompileBatch(std::vector<DriverEngine *> *engineList)
+{
+    int numCopies = engineList->size();
+    if (numCopies == 0) return false;
+    DriverEngine *first = (*engineList)[0];
+    int k;
+    for (k = 0; k < numCopies; k++)
+    {
+        DriverEngine *engine = (*engineList)[k];
+        if (engine->m_NumCopies != 1) return false;
+        if (engine->m_LaneType != first->m_LaneType || engine->m_LaneChannel != first->m_LaneChannel ||
+                engine->m_LaneNumSegments != first->m_LaneNumSegments || engine->m_ChannelValue.size() != first->m_ChannelValue.size() ||
+                engine->m_TargetNumChannels != first->m_TargetNumChannels || engine->m_FallbackChannelList != first->m_FallbackChannelList)
+            return false;
+    }
+
+    m_NumCopies = numCopies;
+    m_LaneType = first->m_LaneType;
+    m_LaneChannel = first->m_LaneChannel;
+    m_LaneFirstSegment = first->m_LaneFirstSegment;
+    m_LaneNumSegments = first->m_LaneNumSegments;
+    m_TargetFirstChannel = first->m_TargetFirstChannel;
+    m_TargetNumChannels = first->m_TargetNumChannels;
+    m_FallbackChannelList = first->m_FallbackChannelList;
+
+    unsigned int numLanes = m_LaneType.size();
+    unsigned int numSegments = first->m_SegmentStart.size();
+    unsigned int numChannels = first->m_ChannelValue.size();
+    unsigned int numTargets = first->m_TargetList.size();
+    unsigned int numFallbacks = m_FallbackChannelList.size();
+    m_LaneCursor.resize(numLanes * numCopies);
+    m_LanePeriod.resize(numLanes * numCopies);
+    m_LaneOffset.resize(numLanes * numCopies);
+    m_SegmentStart.resize(numSegments * numCopies);
+    m_SegmentValue.resize(numSegments * numCopies);
+    m_SegmentDelta.resize(numSegments * numCopies);
+    m_SegmentWidth.resize(numSegments * numCopies);
+    m_ChannelValue.assign(numChannels * numCopies, 0);
+    m_ChannelMin.resize(numChannels * numCopies);
+    m_ChannelMax.resize(numChannels * numCopies);
+    m_TargetList.resize(numTargets * numCopies);
+    m_TargetSum.assign(numTargets * numCopies, 0);
+    m_FallbackDriverList.resize(numFallbacks * numCopies);
+    m_LaneX.resize(numCopies);
+
+    unsigned int i;
+    for (k = 0; k < numCopies; k++)
+    {
+        DriverEngine *engine = (*engineList)[k];
+        for (i = 0; i < numLanes; i++)
+        {
+            m_LaneCursor[i * numCopies + k] = m_LaneFirstSegment[i];
+            m_LanePeriod[i * numCopies + k] = engine->m_LanePeriod[i];
+            m_LaneOffset[i * numCopies + k] = engine->m_LaneOffset[i];
+        }
+        for (i = 0; i < numSegments; i++)
+        {
+            m_SegmentStart[i * numCopies + k] = engine->m_SegmentStart[i];
+            m_SegmentValue[i * numCopies + k] = engine->m_SegmentValue[i];
+            m_SegmentDelta[i * numCopies + k] = engine->m_SegmentDelta[i];
+            m_SegmentWidth[i * numCopies + k] = engine->m_SegmentWidth[i];
+        }
+        for (i = 0; i < numChannels; i++)
+        {
+            m_ChannelMin[i * numCopies + k] = engine->m_ChannelMin[i];
+            m_ChannelMax[i * numCopies + k] = engine->m_ChannelMax[i];
+        }
+        for (i = 0; i < numTargets; i++) m_TargetList[i * numCopies + k] = engine->m_TargetList[i];
+        for (i = 0; i < numFallbacks; i++) m_FallbackDriverList[i * numCopies + k] = engine->m_FallbackDriverList[i];
+    }
+    m_LastTime = -DBL_MAX;
+    return true;
+}
+
+// the same calculation as Evaluate done for every copy in turn so the results are identical
+// the copies are in the inner loops and the only per copy branch is the segment search
+// copies that are not active are still calculated but their drivers and targets are not touched
+void DriverEngine::EvaluateBatch(double time, const char *activeList)
+{
+    unsigned int i;
+    int c, k;
+    int n = m_NumCopies;
+
+    if (time < m_LastTime) for (i = 0; i < m_LaneType.size(); i++) for (k = 0; k < n; k++) m_LaneCursor[i * n + k] = m_LaneFirstSegment[i];
+    m_LastTime = time;
+
+    std::fill(m_ChannelValue.begin(), m_ChannelValue.end(), 0);
+
+    for (i = 0; i < m_FallbackChannelList.size(); i++)
+        for (k = 0; k < n; k++)
+            if (activeList[k]) m_ChannelValue[m_FallbackChannelList[i] * n + k] = m_FallbackDriverList[i * n + k]->GetValue(time);
+
+    const double *segmentStart = m_SegmentStart.size() ? &m_SegmentStart[0] : 0;
+    const double *segmentValue = m_SegmentValue.size() ? &m_SegmentValue[0] : 0;
+    const double *segmentDelta = m_SegmentDelta.size() ? &m_SegmentDelta[0] : 0;
+    const double *segmentWidth = m_SegmentWidth.size() ? &m_SegmentWidth[0] : 0;
+    double *x = &m_LaneX[0];
+    double r;
+    int first, last;
+    for (i = 0; i < m_LaneType.size(); i++)
+    {
+        const double *period = &m_LanePeriod[i * n];
+        const double *offset = &m_LaneOffset[i * n];
+        switch (m_LaneType[i])
+        {
+        case CyclicLane:
+            for (k = 0; k < n; k++) x[k] = fmod(time + offset[k], period[k]);
+            break;
+        case NormalisedLane:
+            for (k = 0; k < n; k++)
+            {
+                r = time / period[k];
+                x[k] = r - floor(r);
+            }
+            break;
+        default:
+            for (k = 0; k < n; k++) x[k] = time;
+        }
+
+        first = m_LaneFirstSegment[i];
+        last = first + m_LaneNumSegments[i] - 1;
+        int *cursor = &m_LaneCursor[i * n];
+        double *value = &m_ChannelValue[m_LaneChannel[i] * n];
+        for (k = 0; k < n; k++)
+        {
+            c = cursor[k];
+            if (x[k] < segmentStart[c * n + k]) c = first; // cyclic wrap
+            while (c < last && x[k] >= segmentStart[(c + 1) * n + k]) c++;
+            cursor[k] = c;
+            value[k] += ((x[k] - segmentStart[c * n + k]) / segmentWidth[c * n + k]) * segmentDelta[c * n + k] + segmentValue[c * n + k];
+        }
+    }
+
+    double *channelValue = m_ChannelValue.size() ? &m_ChannelValue[0] : 0;
+    const double *channelMin = m_ChannelMin.size() ? &m_ChannelMin[0] : 0;
+    const double *channelMax = m_ChannelMax.size() ? &m_ChannelMax[0] : 0;
+    for (i = 0; i < m_ChannelValue.size(); i++)
+    {
+        channelValue[i] = channelValue[i] < channelMin[i] ? channelMin[i] : channelValue[i];
+        channelValue[i] = channelValue[i] > channelMax[i] ? channelMax[i] : channelValue[i];
+    }
+
+    for (i = 0; i < m_TargetNumChannels.size(); i++)
+    {
+        double *sum = &m_TargetSum[i * n];
+        for (k = 0; k < n; k++) sum[k] = 0;
+        for (c = m_TargetFirstChannel[i]; c < m_TargetFirstChannel[i] + m_TargetNumChannels[i]; c++)
+        {
+            const double *value = &channelValue[c * n];
+            for (k = 0; k < n; k++) sum[k] += value[k];
+        }
+        for (k = 0; k < n; k++)
+            if (activeList[k]) m_TargetList[i * n + k]->SetCurrentDriverSum(sum[k]);
+    }
+}
+
+int DriverEngine::FindTarget(Drivable *target)
+{
+    for (unsigned int i = 0; i < m_TargetNumChannels.size(); i++)
+        if (m_TargetList[i * m_NumCopies] == target) return i;
+    return -1;
+}
+
+void DriverEngine::AddLane(LaneType type, int channel, double period, double offset)
+{
+    m_LaneType.push_back(type);
+    m_LaneChannel.push_back(channel);
+    m_LaneFirstSegment.push_back(m_SegmentStart.size());
+    m_LaneNumSegments.push_back(0);
+    m_LaneCursor.push_back(m_SegmentStart.size());
+    m_LanePeriod.push_back(period);
+    m_LaneOffset.push_back(offset);
+}
+
+// adds a segment to the last lane
+void DriverEngine::AddSegment(double start, double value, double delta, double width)
+{
+    if (width <= 0) // zero width segments are never selected but this stops any division by zero
+    {
+        width = 1;
+        delta = 0;
+    }
+    m_SegmentStart.push_back(start);
+    m_SegmentValue.push_back(value);
+    m_SegmentDelta.push_back(delta);
+    m_SegmentWidth.push_back(width);
+    m_LaneNumSegments.back()++;
+}
+
+// delay and width are already normalised to 0 to 1 by the boxcar drivers
+// the boxcar is only on when the phase is strictly greater than the delay
+// so that segment starts at the next representable value
+void DriverEngine::AddBoxCarLane(int channel, double cycleTime, double delay, double width, double height)
+{
+    double offTime = delay + width;
+    double onTime = nextafter(delay, 2.0);
+    AddLane(NormalisedLane, channel, cycleTime, 0);
+    if (offTime < 1) // no wrap case
+    {
+        AddSegment(0, 0, 0, onTime);
+        AddSegment(onTime, height, 0, offTime - onTime);
+        AddSegment(offTime, 0, 0, 1 - offTime);
+    }
+    else // wrap case
+    {
+        AddSegment(0, height, 0, offTime - 1);
+        AddSegment(offTime - 1, 0, 0, onTime - (offTime - 1));
+        AddSegment(onTime, height, 0, 1 - onTime);
+    }
+}
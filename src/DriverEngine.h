@@ -0,0 +1,98 @@
+/*
+ *  DriverEngine.h
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Compiles all the drivers into flat segment tables and
+ *  evaluates them together once per time step
+ *  (or the drivers of several copies of a model in lockstep)
+ *
+ */
+
+#ifndef DRIVERENGINE_H
+#define DRIVERENGINE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+class Driver;
+class Drivable;
+
+class DriverEngine
+{
+public:
+    DriverEngine();
+    ~DriverEngine();
+
+    void Compile(std::map<std::string, Driver *> *driverList);
+    void Evaluate(double time);
+
+    // interleaves the tables of engines that have been compiled from copies of the same model
+    // so that the values for each copy of a lane, segment, channel or target are next to each other
+    // returns false if the engines do not all have the same lanes, segment counts and targets
+    // an engine built this way is evaluated with EvaluateBatch and not Evaluate
+    bool CompileBatch(std::vector<DriverEngine *> *engineList);
+    void EvaluateBatch(double time, const char *activeList);
+
+    // the target index of a drivable in the first engine of the batch or -1
+    int FindTarget(Drivable *target);
+    const double *GetTargetSums(int target) { return &m_TargetSum[target * m_NumCopies]; }
+
+    int GetNumChannels() { return m_ChannelValue.size() / m_NumCopies; }
+    int GetNumLanes() { return m_LaneType.size(); }
+    int GetNumCopies() { return m_NumCopies; }
+
+protected:
+
+    enum LaneType
+    {
+        AbsoluteLane = 0,   // segment starts are absolute simulation times (StepDriver)
+        CyclicLane = 1,     // segment starts are times within the cycle (CyclicDriver)
+        NormalisedLane = 2  // segment starts are fractions of the cycle (BoxCarDriver, StackedBoxCarDriver)
+    };
+
+    void AddLane(LaneType type, int channel, double period, double offset);
+    void AddSegment(double start, double value, double delta, double width);
+    void AddBoxCarLane(int channel, double cycleTime, double delay, double width, double height);
+
+    // lanes - a driver is made up of one or more lanes that are summed
+    std::vector<int> m_LaneType;
+    std::vector<int> m_LaneChannel;
+    std::vector<int> m_LaneFirstSegment;
+    std::vector<int> m_LaneNumSegments;
+    std::vector<int> m_LaneCursor;
+    std::vector<double> m_LanePeriod;
+    std::vector<double> m_LaneOffset;
+
+    // segments - value = ((x - start) / width) * delta + value
+    std::vector<double> m_SegmentStart;
+    std::vector<double> m_SegmentValue;
+    std::vector<double> m_SegmentDelta;
+    std::vector<double> m_SegmentWidth;
+
+    // channels - one per driver, sorted so that each target's drivers are contiguous
+    std::vector<double> m_ChannelValue;
+    std::vector<double> m_ChannelMin;
+    std::vector<double> m_ChannelMax;
+
+    // targets
+    std::vector<Drivable *> m_TargetList;
+    std::vector<int> m_TargetFirstChannel;
+    std::vector<int> m_TargetNumChannels;
+
+    // drivers that cannot be compiled are called directly
+    std::vector<int> m_FallbackChannelList;
+    std::vector<Driver *> m_FallbackDriverList;
+
+    double m_LastTime;
+
+    // batches - the per copy values are at [index * m_NumCopies + copy]
+    int m_NumCopies;
+    std::vector<double> m_TargetSum;
+    std::vector<double> m_LaneX;
+};
+
+#endif // DRIVERENGINE_H
@@ -0,0 +1,380 @@
+/*
+ *  DumpContainer.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Collects all the Dump() outputs for a run into a single
+ *  chunked, column oriented binary file
+ *
+ */
+
+#include <iostream>
+#include <sstream>
+#include <limits>
+#include <string.h>
+
+#include <zlib.h>
+
+#include "DumpContainer.h"
+#include "FastDouble.h"
+
+enum CellType
+{
+    NumberCell = 0,
+    TextCell = 1,
+    EmptyCell = 2
+};
+
+static void Append(std::vector<char> *buffer, const void *data, size_t length)
+{
+    buffer->insert(buffer->end(), (const char *)data, (const char *)data + length);
+}
+
+static void AppendUInt32(std::vector<char> *buffer, uint32_t v)
+{
+    Append(buffer, &v, sizeof(v));
+}
+
+static void AppendString(std::vector<char> *buffer, const std::string &s)
+{
+    AppendUInt32(buffer, s.size());
+    Append(buffer, s.data(), s.size());
+}
+
+static std::string FormatNumber(double v)
+{
+    char buffer[32];
+    return std::string(buffer, FastDouble::Format(v, buffer));
+}
+
+DumpContainer::DumpContainer()
+{
+    m_Compress = false;
+    m_ChunkSize = 1 << 16;
+}
+
+DumpContainer::~DumpContainer()
+{
+    Close();
+}
+
+bool DumpContainer::Open(const char *filename, bool compress)
+{
+    Close();
+    m_Compress = compress;
+    m_File.open(filename, std::ios::out | std::ios::binary);
+    if (m_File.good() == false)
+    {
+        std::cerr << "DumpContainer error: could not open \"" << filename << "\"\n";
+        return false;
+    }
+    m_File.write("GSDUMP1\0", 8);
+    return true;
+}
+
+void DumpContainer::Close()
+{
+    std::map<int, Group *>::iterator iter;
+    for (iter = m_GroupList.begin(); iter != m_GroupList.end(); iter++)
+    {
+        if (iter->second->rowTypes.size() || iter->second->cellText.size() || iter->second->cellHasValue) EndRow(iter->second);
+        if (m_File.is_open()) WriteChunk(iter->second);
+        delete iter->second;
+    }
+    m_GroupList.clear();
+    if (m_File.is_open()) m_File.close();
+}
+
+void DumpContainer::AddGroup(int groupID, const std::string &name)
+{
+    Group *group = new Group();
+    group->id = groupID;
+    group->name = name;
+    group->stringsWritten = 0;
+    group->headerDone = false;
+    group->schemaWritten = false;
+    group->cellValue = 0;
+    group->cellHasValue = false;
+    group->chunkMaxColumns = 0;
+    m_GroupList[groupID] = group;
+
+    std::vector<char> payload;
+    Append(&payload, name.data(), name.size());
+    WriteRecord(GroupRecord, groupID, payload);
+}
+
+void DumpContainer::CloseGroup(int groupID)
+{
+    std::map<int, Group *>::iterator iter = m_GroupList.find(groupID);
+    if (iter == m_GroupList.end()) return;
+    Group *group = iter->second;
+    if (group->rowTypes.size() || group->cellText.size() || group->cellHasValue) EndRow(group);
+    WriteChunk(group);
+    delete group;
+    m_GroupList.erase(iter);
+}
+
+// units are tab separated in the same order as the header columns
+void DumpContainer::SetUnits(int groupID, const char *units, size_t length)
+{
+    std::map<int, Group *>::iterator iter = m_GroupList.find(groupID);
+    if (iter == m_GroupList.end()) return;
+    Group *group = iter->second;
+    group->columnUnits.clear();
+    std::string current;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (units[i] == '\t')
+        {
+            group->columnUnits.push_back(current);
+            current.clear();
+        }
+        else current += units[i];
+    }
+    group->columnUnits.push_back(current);
+    group->schemaWritten = false;
+}
+
+void DumpContainer::AddValue(int groupID, double value)
+{
+    std::map<int, Group *>::iterator iter = m_GroupList.find(groupID);
+    if (iter == m_GroupList.end()) return;
+    Group *group = iter->second;
+    if (group->cellText.size() || group->cellHasValue)
+    {
+        // a number run on to something else so the cell has to be text
+        if (group->cellHasValue) group->cellText += FormatNumber(group->cellValue);
+        group->cellText += FormatNumber(value);
+        group->cellHasValue = false;
+        return;
+    }
+    group->cellValue = value;
+    group->cellHasValue = true;
+}
+
+void DumpContainer::AddText(int groupID, const char *text, size_t length)
+{
+    std::map<int, Group *>::iterator iter = m_GroupList.find(groupID);
+    if (iter == m_GroupList.end()) return;
+    Group *group = iter->second;
+    for (size_t i = 0; i < length; i++)
+    {
+        switch (text[i])
+        {
+        case '\t':
+            EndCell(group);
+            break;
+        case '\n':
+            EndRow(group);
+            break;
+        default:
+            if (group->cellHasValue)
+            {
+                group->cellText += FormatNumber(group->cellValue);
+                group->cellHasValue = false;
+            }
+            group->cellText += text[i];
+        }
+    }
+}
+
+void DumpContainer::EndCell(Group *group)
+{
+    if (group->headerDone == false)
+    {
+        if (group->cellHasValue) group->columnNames.push_back(FormatNumber(group->cellValue));
+        else group->columnNames.push_back(group->cellText);
+        group->rowValues.push_back(0);
+        group->rowTypes.push_back(group->columnNames.back().size() ? TextCell : EmptyCell);
+    }
+    else if (group->cellHasValue)
+    {
+        group->rowValues.push_back(group->cellValue);
+        group->rowTypes.push_back(NumberCell);
+    }
+    else if (group->cellText.size())
+    {
+        group->rowValues.push_back(InternString(group, group->cellText));
+        group->rowTypes.push_back(TextCell);
+    }
+    else
+    {
+        group->rowValues.push_back(std::numeric_limits<double>::quiet_NaN());
+        group->rowTypes.push_back(EmptyCell);
+    }
+    group->cellText.clear();
+    group->cellHasValue = false;
+}
+
+void DumpContainer::EndRow(Group *group)
+{
+    EndCell(group);
+    if (group->rowTypes.size() == 1 && group->rowTypes[0] == EmptyCell) // blank line
+    {
+        if (group->headerDone == false) group->columnNames.clear();
+        group->rowValues.clear();
+        group->rowTypes.clear();
+        return;
+    }
+
+    if (group->headerDone == false)
+    {
+        group->headerDone = true;
+        group->schemaWritten = false;
+    }
+    else
+    {
+        group->chunkValues.insert(group->chunkValues.end(), group->rowValues.begin(), group->rowValues.end());
+        group->chunkTypes.insert(group->chunkTypes.end(), group->rowTypes.begin(), group->rowTypes.end());
+        group->chunkRowLengths.push_back(group->rowTypes.size());
+        if (group->rowTypes.size() > group->chunkMaxColumns) group->chunkMaxColumns = group->rowTypes.size();
+    }
+    group->rowValues.clear();
+    group->rowTypes.clear();
+
+    if (group->chunkValues.size() >= m_ChunkSize) WriteChunk(group);
+}
+
+// the buffered rows are written a column at a time so that similar values are adjacent
+// which makes reading a single column quick and helps the compression a great deal
+void DumpContainer::WriteChunk(Group *group)
+{
+    if (group->chunkRowLengths.size() == 0)
+    {
+        if (group->headerDone && group->schemaWritten == false) WriteSchema(group);
+        return;
+    }
+
+    uint32_t numRows = group->chunkRowLengths.size();
+    uint32_t numColumns = group->chunkMaxColumns;
+    size_t r, c;
+
+    std::vector<size_t> rowStart(numRows);
+    size_t offset = 0;
+    for (r = 0; r < numRows; r++)
+    {
+        rowStart[r] = offset;
+        offset += group->chunkRowLengths[r];
+    }
+
+    // a column holding any text at all is stored as a string column
+    std::vector<uint8_t> columnTypes(numColumns, DoubleColumn);
+    for (r = 0; r < numRows; r++)
+    {
+        for (c = 0; c < group->chunkRowLengths[r]; c++)
+            if (group->chunkTypes[rowStart[r] + c] == TextCell) columnTypes[c] = StringColumn;
+    }
+
+    std::vector<char> raw(numColumns + sizeof(double) * numColumns * numRows);
+    memcpy(&raw[0], &columnTypes[0], numColumns);
+    double *data = (double *)&raw[numColumns];
+    double v;
+    uint8_t cellType;
+    for (c = 0; c < numColumns; c++)
+    {
+        for (r = 0; r < numRows; r++)
+        {
+            if (c < group->chunkRowLengths[r])
+            {
+                v = group->chunkValues[rowStart[r] + c];
+                cellType = group->chunkTypes[rowStart[r] + c];
+                if (cellType == NumberCell && columnTypes[c] == StringColumn) v = InternString(group, FormatNumber(v));
+            }
+            else v = std::numeric_limits<double>::quiet_NaN();
+            memcpy(data + c * numRows + r, &v, sizeof(double)); // raw is not necessarily aligned
+        }
+    }
+
+    if (numColumns > group->columnNames.size())
+    {
+        for (c = group->columnNames.size(); c < numColumns; c++)
+        {
+            std::ostringstream ss;
+            ss << "Column" << c + 1;
+            group->columnNames.push_back(ss.str());
+        }
+        group->schemaWritten = false;
+    }
+    if (group->schemaWritten == false) WriteSchema(group);
+
+    if (group->stringsWritten < group->stringTable.size())
+    {
+        std::vector<char> payload;
+        AppendUInt32(&payload, group->stringsWritten);
+        AppendUInt32(&payload, group->stringTable.size() - group->stringsWritten);
+        for (size_t i = group->stringsWritten; i < group->stringTable.size(); i++) AppendString(&payload, group->stringTable[i]);
+        WriteRecord(StringTableRecord, group->id, payload);
+        group->stringsWritten = group->stringTable.size();
+    }
+
+    std::vector<char> payload;
+    AppendUInt32(&payload, numRows);
+    AppendUInt32(&payload, numColumns);
+    uint64_t rawLength = raw.size();
+    if (m_Compress)
+    {
+        uLongf compressedLength = compressBound(raw.size());
+        std::vector<char> compressed(compressedLength);
+        if (compress2((Bytef *)&compressed[0], &compressedLength, (const Bytef *)&raw[0], raw.size(), Z_BEST_SPEED) == Z_OK)
+        {
+            AppendUInt32(&payload, 1);
+            Append(&payload, &rawLength, sizeof(rawLength));
+            Append(&payload, &compressed[0], compressedLength);
+        }
+        else
+        {
+            std::cerr << "DumpContainer warning: compression failed for \"" << group->name << "\"\n";
+            AppendUInt32(&payload, 0);
+            Append(&payload, &rawLength, sizeof(rawLength));
+            Append(&payload, &raw[0], raw.size());
+        }
+    }
+    else
+    {
+        AppendUInt32(&payload, 0);
+        Append(&payload, &rawLength, sizeof(rawLength));
+        Append(&payload, &raw[0], raw.size());
+    }
+    WriteRecord(ChunkRecord, group->id, payload);
+
+    group->chunkValues.clear();
+    group->chunkTypes.clear();
+    group->chunkRowLengths.clear();
+    group->chunkMaxColumns = 0;
+}
+
+void DumpContainer::WriteSchema(Group *group)
+{
+    std::vector<char> payload;
+    AppendUInt32(&payload, group->columnNames.size());
+    for (size_t i = 0; i < group->columnNames.size(); i++)
+    {
+        AppendString(&payload, group->columnNames[i]);
+        if (i < group->columnUnits.size()) AppendString(&payload, group->columnUnits[i]);
+        else AppendString(&payload, std::string());
+    }
+    WriteRecord(SchemaRecord, group->id, payload);
+    group->schemaWritten = true;
+}
+
+void DumpContainer::WriteRecord(uint32_t type, uint32_t group, const std::vector<char> &payload)
+{
+    if (m_File.is_open() == false) return;
+    uint64_t length = payload.size();
+    m_File.write((const char *)&type, sizeof(type));
+    m_File.write((const char *)&group, sizeof(group));
+    m_File.write((const char *)&length, sizeof(length));
+    if (length) m_File.write(&payload[0], length);
+}
+
+uint32_t DumpContainer::InternString(Group *group, const std::string &text)
+{
+    std::map<std::string, uint32_t>::const_iterator iter = group->stringIndex.find(text);
+    if (iter != group->stringIndex.end()) return iter->second;
+    uint32_t index = group->stringTable.size();
+    group->stringTable.push_back(text);
+    group->stringIndex[text] = index;
+    return index;
+}
@@ -0,0 +1,112 @@
+/*
+ *  DumpContainer.h
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Collects all the Dump() outputs for a run into a single
+ *  chunked, column oriented binary file
+ *
+ */
+
+#ifndef DUMPCONTAINER_H
+#define DUMPCONTAINER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <stdint.h>
+
+/* file format (all values in native byte order)
+ *
+ * char[8] "GSDUMP1\0"
+ * then a sequence of records: uint32 type, uint32 group, uint64 payloadLength, payload
+ *
+ * GroupRecord       name of the object that owns the group
+ * SchemaRecord      uint32 numColumns, then per column uint32 nameLength, name, uint32 unitsLength, units
+ *                   (repeated if the number of columns grows - the last one is correct)
+ * StringTableRecord uint32 firstIndex, uint32 count, then per string uint32 length, string
+ * ChunkRecord       uint32 numRows, uint32 numColumns, uint32 compressed, uint64 rawLength, data
+ *                   data (zlib compressed if compressed != 0) is numColumns uint8 column types
+ *                   followed by numColumns * numRows doubles stored a column at a time
+ *                   missing values are NaN and string columns hold indices into the group string table
+ */
+
+class DumpContainer
+{
+public:
+    DumpContainer();
+    ~DumpContainer();
+
+    enum RecordType
+    {
+        GroupRecord = 1,
+        SchemaRecord = 2,
+        StringTableRecord = 3,
+        ChunkRecord = 4
+    };
+
+    enum ColumnType
+    {
+        DoubleColumn = 0,
+        StringColumn = 1
+    };
+
+    bool Open(const char *filename, bool compress);
+    void Close();
+    bool IsOpen() { return m_File.is_open(); }
+
+    // the Dump() text stream is split into cells at tabs and into rows at newlines
+    // and the first row is used for the column names
+    void AddGroup(int group, const std::string &name);
+    void CloseGroup(int group);
+    void SetUnits(int group, const char *units, size_t length);
+    void AddValue(int group, double value);
+    void AddText(int group, const char *text, size_t length);
+
+    void SetChunkSize(size_t chunkSize) { m_ChunkSize = chunkSize; }
+
+protected:
+
+    struct Group
+    {
+        int id;
+        std::string name;
+        std::vector<std::string> columnNames;
+        std::vector<std::string> columnUnits;
+        std::vector<std::string> stringTable;
+        std::map<std::string, uint32_t> stringIndex;
+        uint32_t stringsWritten;
+        bool headerDone;
+        bool schemaWritten;
+
+        // the cells of the row currently being assembled
+        std::vector<double> rowValues;
+        std::vector<uint8_t> rowTypes;
+        std::string cellText;
+        double cellValue;
+        bool cellHasValue;
+
+        // the rows waiting to be written (row major)
+        std::vector<double> chunkValues;
+        std::vector<uint8_t> chunkTypes;
+        std::vector<uint32_t> chunkRowLengths;
+        size_t chunkMaxColumns;
+    };
+
+    void EndCell(Group *group);
+    void EndRow(Group *group);
+    void WriteChunk(Group *group);
+    void WriteSchema(Group *group);
+    void WriteRecord(uint32_t type, uint32_t group, const std::vector<char> &payload);
+    uint32_t InternString(Group *group, const std::string &text);
+
+    std::ofstream m_File;
+    bool m_Compress;
+    size_t m_ChunkSize;
+    std::map<int, Group *> m_GroupList;
+};
+
+#endif // DUMPCONTAINER_H
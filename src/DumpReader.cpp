@@ -0,0 +1,279 @@
+/*
+ *  DumpReader.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Command line tool to list the contents of a dump container
+ *  and to extract selected columns as CSV
+ *
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <zlib.h>
+
+#include "DumpContainer.h"
+#include "FastDouble.h"
+
+struct ReaderGroup
+{
+    std::string name;
+    std::vector<std::string> columnNames;
+    std::vector<std::string> columnUnits;
+    std::vector<std::string> stringTable;
+    uint64_t numRows;
+};
+
+static uint32_t ReadUInt32(const char **ptr)
+{
+    uint32_t v;
+    memcpy(&v, *ptr, sizeof(v));
+    *ptr += sizeof(v);
+    return v;
+}
+
+static std::string ReadString(const char **ptr)
+{
+    uint32_t length = ReadUInt32(ptr);
+    std::string s(*ptr, length);
+    *ptr += length;
+    return s;
+}
+
+static void OutputCSVField(const std::string &s)
+{
+    if (s.find_first_of(",\"\n") == std::string::npos)
+    {
+        std::cout << s;
+        return;
+    }
+    std::cout << '"';
+    for (size_t i = 0; i < s.size(); i++)
+    {
+        if (s[i] == '"') std::cout << '"';
+        std::cout << s[i];
+    }
+    std::cout << '"';
+}
+
+static void Usage()
+{
+    std::cerr << "Usage:\n";
+    std::cerr << "gaitsym_dumpreader file\n";
+    std::cerr << "Lists the groups and columns in the dump container\n\n";
+    std::cerr << "gaitsym_dumpreader file group [column ...]\n";
+    std::cerr << "Writes the selected columns (default all) of group to stdout as CSV\n\n";
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0)
+    {
+        Usage();
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::in | std::ios::binary);
+    if (file.good() == false)
+    {
+        std::cerr << "Error opening \"" << argv[1] << "\"\n";
+        return 1;
+    }
+    char magic[8];
+    file.read(magic, sizeof(magic));
+    if (file.gcount() != sizeof(magic) || memcmp(magic, "GSDUMP1\0", sizeof(magic)) != 0)
+    {
+        std::cerr << "Error: \"" << argv[1] << "\" is not a dump container\n";
+        return 1;
+    }
+
+    bool listMode = (argc == 2);
+    std::string selectedName;
+    if (listMode == false) selectedName = argv[2];
+    std::vector<std::string> selectedColumns;
+    for (int i = 3; i < argc; i++) selectedColumns.push_back(argv[i]);
+
+    std::map<uint32_t, ReaderGroup> groupList;
+    std::vector<uint32_t> groupOrder;
+    bool found = false;
+    bool headerDone = false;
+    std::vector<int> columnIndices;
+    std::vector<char> payload;
+    std::vector<char> raw;
+    uint32_t type, group;
+    uint64_t length;
+
+    while (true)
+    {
+        file.read((char *)&type, sizeof(type));
+        file.read((char *)&group, sizeof(group));
+        file.read((char *)&length, sizeof(length));
+        if (file.eof() || file.fail()) break;
+        payload.resize(length + 1);
+        if (length) file.read(&payload[0], length);
+        if ((uint64_t)file.gcount() != length)
+        {
+            std::cerr << "Warning: file truncated\n";
+            break;
+        }
+        const char *ptr = &payload[0];
+
+        switch (type)
+        {
+        case DumpContainer::GroupRecord:
+        {
+            // a name can be reused if the object was recreated so this starts a new group
+            ReaderGroup newGroup;
+            newGroup.name = std::string(ptr, length);
+            newGroup.numRows = 0;
+            groupList[group] = newGroup;
+            groupOrder.push_back(group);
+            if (newGroup.name == selectedName) found = true;
+            break;
+        }
+
+        case DumpContainer::SchemaRecord:
+        {
+            ReaderGroup &g = groupList[group];
+            uint32_t numColumns = ReadUInt32(&ptr);
+            g.columnNames.clear();
+            g.columnUnits.clear();
+            for (uint32_t i = 0; i < numColumns; i++)
+            {
+                g.columnNames.push_back(ReadString(&ptr));
+                g.columnUnits.push_back(ReadString(&ptr));
+            }
+            break;
+        }
+
+        case DumpContainer::StringTableRecord:
+        {
+            ReaderGroup &g = groupList[group];
+            uint32_t firstIndex = ReadUInt32(&ptr);
+            uint32_t count = ReadUInt32(&ptr);
+            if (g.stringTable.size() < firstIndex + count) g.stringTable.resize(firstIndex + count);
+            for (uint32_t i = 0; i < count; i++) g.stringTable[firstIndex + i] = ReadString(&ptr);
+            break;
+        }
+
+        case DumpContainer::ChunkRecord:
+        {
+            ReaderGroup &g = groupList[group];
+            uint32_t numRows = ReadUInt32(&ptr);
+            uint32_t numColumns = ReadUInt32(&ptr);
+            g.numRows += numRows;
+            if (listMode || g.name != selectedName) break;
+
+            uint32_t compressed = ReadUInt32(&ptr);
+            uint64_t rawLength;
+            memcpy(&rawLength, ptr, sizeof(rawLength));
+            ptr += sizeof(rawLength);
+            const char *data = ptr;
+            if (compressed)
+            {
+                raw.resize(rawLength);
+                uLongf destLength = rawLength;
+                if (uncompress((Bytef *)&raw[0], &destLength, (const Bytef *)ptr, length - (ptr - &payload[0])) != Z_OK || destLength != rawLength)
+                {
+                    std::cerr << "Error decompressing chunk in \"" << g.name << "\"\n";
+                    return 1;
+                }
+                data = &raw[0];
+            }
+            const uint8_t *columnTypes = (const uint8_t *)data;
+            const char *values = data + numColumns;
+
+            if (headerDone == false)
+            {
+                if (selectedColumns.size() == 0)
+                {
+                    for (uint32_t c = 0; c < g.columnNames.size(); c++) columnIndices.push_back(c);
+                }
+                else
+                {
+                    for (unsigned int i = 0; i < selectedColumns.size(); i++)
+                    {
+                        uint32_t c;
+                        for (c = 0; c < g.columnNames.size(); c++)
+                            if (g.columnNames[c] == selectedColumns[i]) break;
+                        if (c == g.columnNames.size())
+                        {
+                            std::cerr << "Error: column \"" << selectedColumns[i] << "\" not found in \"" << g.name << "\"\n";
+                            return 1;
+                        }
+                        columnIndices.push_back(c);
+                    }
+                }
+                for (unsigned int i = 0; i < columnIndices.size(); i++)
+                {
+                    if (i) std::cout << ",";
+                    std::string heading = g.columnNames[columnIndices[i]];
+                    if (g.columnUnits[columnIndices[i]].size()) heading += " (" + g.columnUnits[columnIndices[i]] + ")";
+                    OutputCSVField(heading);
+                }
+                std::cout << "\n";
+                headerDone = true;
+            }
+
+            double v;
+            char number[32];
+            for (uint32_t r = 0; r < numRows; r++)
+            {
+                for (unsigned int i = 0; i < columnIndices.size(); i++)
+                {
+                    if (i) std::cout << ",";
+                    uint32_t c = columnIndices[i];
+                    if (c >= numColumns) continue;
+                    memcpy(&v, values + (c * numRows + r) * sizeof(double), sizeof(double));
+                    if (std::isnan(v)) continue;
+                    if (columnTypes[c] == DumpContainer::StringColumn)
+                    {
+                        uint32_t index = (uint32_t)v;
+                        if (index < g.stringTable.size()) OutputCSVField(g.stringTable[index]);
+                    }
+                    else std::cout.write(number, FastDouble::Format(v, number));
+                }
+                std::cout << "\n";
+            }
+            break;
+        }
+
+        default:
+            std::cerr << "Warning: skipping unknown record type " << type << "\n";
+        }
+    }
+
+    if (listMode)
+    {
+        for (unsigned int i = 0; i < groupOrder.size(); i++)
+        {
+            ReaderGroup &g = groupList[groupOrder[i]];
+            std::cout << g.name << " (" << g.numRows << " rows)\n";
+            for (unsigned int c = 0; c < g.columnNames.size(); c++)
+            {
+                std::cout << "    " << g.columnNames[c];
+                if (g.columnUnits[c].size()) std::cout << " (" << g.columnUnits[c] << ")";
+                std::cout << "\n";
+            }
+        }
+        return 0;
+    }
+
+    if (found == false)
+    {
+        std::cerr << "Error: group \"" << selectedName << "\" not found\n";
+        return 1;
+    }
+    return 0;
+}
@@ -29,6 +29,13 @@ bool IsMessage()
     return error;
 }
 
+void SetMessage(int messageNumber, const char *messageText)
+{
+    snprintf(gMessageText, sizeof(gMessageText), "%s", messageText);
+    gMessageNumber = messageNumber;
+    gMessageFlag = true;
+}
+
 const char *GetLastMessage(int *messageNumber)
 {
     if (messageNumber) *messageNumber = gMessageNumber;
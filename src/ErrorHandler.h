@@ -14,5 +14,6 @@ extern "C" void ODEMessageTrap(int num, const char *msg, va_list ap);
 
 bool IsMessage();
 const char *GetLastMessage(int *messageNumber);
+void SetMessage(int messageNumber, const char *messageText); // as if ODE had sent the message
 
 #endif
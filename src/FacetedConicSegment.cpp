@@ -26,7 +26,8 @@
 // radii are specified by r1 and r2 and the origin is the centre of r1
 // if r2 == 0 then draw a cone
 // if r1 == r2 then draw a cylinder
-FacetedConicSegment::FacetedConicSegment(double l, double r1, double r2, int sides, double ox, double oy, double oz): FacetedObject()
+// if sharedMesh is true no vertices are generated and the segment is drawn as a copy of a unit length segment scaled by l
+FacetedConicSegment::FacetedConicSegment(double l, double r1, double r2, int sides, double ox, double oy, double oz, bool sharedMesh): FacetedObject()
 {
     m_R1 = r1;
     m_R2 = r2;
@@ -36,6 +37,12 @@ FacetedConicSegment::FacetedConicSegment(double l, double r1, double r2, int sid
     m_OZ = oz;
     m_Sides = sides;
 
+    if (sharedMesh)
+    {
+        SetSharedMesh(GetUnitSegment(r1 / l, r2 / l, sides, ox / l, oy / l, oz / l), l, l, l);
+        return;
+    }
+
     int i;
     double theta = 2 * M_PI / sides;
     pgd::Vector vertex;
@@ -234,6 +241,23 @@ FacetedConicSegment::FacetedConicSegment(double l, double r1, double r2, int sid
     ReverseWinding();
 }
 
+// the unit length segments are created when they are first needed and are never deleted
+// the proportions are rounded for the lookup so that rounding errors in the callers still find the same segment
+FacetedConicSegment *FacetedConicSegment::GetUnitSegment(double r1, double r2, int sides, double ox, double oy, double oz)
+{
+    static std::map<std::vector<long long>, FacetedConicSegment *> unitSegments;
+    std::vector<long long> key(6);
+    key[0] = llround(r1 * 1e9);
+    key[1] = llround(r2 * 1e9);
+    key[2] = sides;
+    key[3] = llround(ox * 1e9);
+    key[4] = llround(oy * 1e9);
+    key[5] = llround(oz * 1e9);
+    FacetedConicSegment *&segment = unitSegments[key];
+    if (segment == 0) segment = new FacetedConicSegment(1, r1, r2, sides, ox, oy, oz);
+    return segment;
+}
+
 // write the object out as a POVRay string
 void FacetedConicSegment::WritePOVRay(std::ostringstream &theString)
 {
@@ -11,12 +11,16 @@
 #define FacetedConicSegment_h
 
 #include <sstream>
+#include <map>
+#include <vector>
 #include "FacetedObject.h"
 
 class FacetedConicSegment: public FacetedObject
 {
 public:
-    FacetedConicSegment(double length, double r1, double r2, int sides, double ox, double oy, double oz);
+    FacetedConicSegment(double length, double r1, double r2, int sides, double ox, double oy, double oz, bool sharedMesh = false);
+
+    static FacetedConicSegment *GetUnitSegment(double r1, double r2, int sides, double ox, double oy, double oz);
 
     virtual void WritePOVRay(std::ostringstream &theString);
 
@@ -13,6 +13,8 @@
 #include "DataFile.h"
 #include "DebugControl.h"
 #include "Util.h"
+#include "FastDouble.h"
+#include "MeshCache.h"
 
 #include <ode/ode.h>
 
@@ -27,10 +29,13 @@
 #include <list>
 #include <string>
 #include <sstream>
+#include <algorithm>
+#include <map>
 
 #if defined(USE_QT)
 #include "GLUtils.h"
 #include <GLWidget.h>
+#include <QOpenGLExtraFunctions>
 #endif
 
 bool gDestinationOpenGL = true;
@@ -44,7 +49,15 @@ int gVertexOffset = 0;
 
 // delayed draw control
 bool gDelayedDraw = false;
-std::list<FacetedObject *> gDelayedDrawList;
+std::vector<FacetedObject *> gDelayedDrawList;
+
+#ifdef USE_QT
+// material properties used for all the faceted objects
+static const GLfloat kAmbientProportion = 0.2f;
+static const GLfloat kDiffuseProportion = 0.8f;
+static const GLfloat kSpecularProportion = 0.3f;
+static const GLfloat kSpecularPower = 20;
+#endif
 
 //#define DEBUG_SPEED
 
@@ -54,8 +67,6 @@ FacetedObject::FacetedObject()
     mNumVertices = 0;
     mNumVerticesAllocated = 0;
     mVertexList = 0;
-    mNormalList = 0;
-    mIndexList = 0;
 
     memset(m_DisplayPosition, 0, sizeof(dVector3));
     dRSetIdentity(m_DisplayRotation);
@@ -66,24 +77,35 @@ FacetedObject::FacetedObject()
     m_AllocationIncrement = 8192;
     m_BadMesh = false;
 
+    m_SharedMesh = 0;
+    m_SharedMeshScale[0] = m_SharedMeshScale[1] = m_SharedMeshScale[2] = 1;
+
 #ifdef USE_QT
+    m_RenderVertexList = 0;
     m_glWidget = 0;
     m_BufferObjectsAllocated = false;
+    m_BufferObjectsNeedUpdate = false;
+    m_BufferObjectsSize = 0;
 #endif
 }
 
 // destroy object
 FacetedObject::~FacetedObject()
 {
-    if (mVertexList) delete mVertexList;
-    if (mNormalList) delete mNormalList;
-    if (mIndexList) delete mIndexList;
+    if (mVertexList) delete [] mVertexList;
+#ifdef USE_QT
+    if (m_RenderVertexList) delete [] m_RenderVertexList;
+#endif
 }
 
 // parse an OBJ file to a FacetedObject
 // returns true on error
 bool FacetedObject::ParseOBJFile(const char *filename)
 {
+    // a mesh that has been prefetched or has an up to date cache file does not need parsing
+    MeshCache *meshCache = MeshCache::GetCache();
+    if (mNumVertices == 0 && meshCache->Load(filename, m_BadMesh, m_VerticesAsSpheresRadius, this) == false) return false;
+
     DataFile theFile;
     if (theFile.ReadFile(filename)) return true;
 
@@ -95,6 +117,7 @@ bool FacetedObject::ParseOBJFile(const char *filename)
     double duration = Util::GetTime() - start;
     qDebug("%s %f\n", filename, duration);
 #endif
+    if (st == false && mNumVertices) meshCache->WriteCacheFile(filename, m_BadMesh, m_VerticesAsSpheresRadius, this);
     return st;
 }
 
@@ -130,9 +153,9 @@ bool FacetedObject::ParseOBJFile(DataFile *theFile)
             numTokens = DataFile::ReturnTokens(linePtrs[i], tokens, kBufferSize);
             if (numTokens > 3)
             {
-                vertex.x = atof(tokens[1]);
-                vertex.y = atof(tokens[2]);
-                vertex.z = atof(tokens[3]);
+                vertex.x = FastDouble::Parse(tokens[1]);
+                vertex.y = FastDouble::Parse(tokens[2]);
+                vertex.z = FastDouble::Parse(tokens[3]);
                 vertexList.push_back(vertex);
 
                 if (gDebug == FacetedObjectDebug)
@@ -278,6 +301,8 @@ void FacetedObject::WritePOVRay(std::ostringstream &theString)
     int i, j;
     double *vPtr;
     dVector3 prel, p, result;
+    // an object that shares a mesh writes out the scaled shared vertices
+    FacetedObject *mesh = m_SharedMesh ? m_SharedMesh : this;
 
     theString.precision(7); // should be plenty
 
@@ -285,15 +310,15 @@ void FacetedObject::WritePOVRay(std::ostringstream &theString)
     theString << "  mesh {\n";
 
     // first faces
-    for (i = 0; i < mNumVertices / 3; i++)
+    for (i = 0; i < mesh->mNumVertices / 3; i++)
     {
         theString << "    triangle {\n";
         for (j = 0; j < 3; j++)
         {
-            vPtr = mVertexList + i * 9 + j * 3;
-            prel[0] = *vPtr++;
-            prel[1] = *vPtr++;
-            prel[2] = *vPtr;
+            vPtr = mesh->mVertexList + i * 9 + j * 3;
+            prel[0] = vPtr[0] * m_SharedMeshScale[0];
+            prel[1] = vPtr[1] * m_SharedMeshScale[1];
+            prel[2] = vPtr[2] * m_SharedMeshScale[2];
             prel[3] = 0;
             dMULTIPLY0_331(p, m_DisplayRotation, prel);
             result[0] = p[0] + m_DisplayPosition[0];
@@ -321,6 +346,8 @@ void FacetedObject::WriteOBJFile(std::ostringstream &out)
     int i, j;
     double *vPtr;
     dVector3 prel, p, result;
+    // an object that shares a mesh writes out the scaled shared vertices
+    FacetedObject *mesh = m_SharedMesh ? m_SharedMesh : this;
     static unsigned long counter = 0;
 
     out.precision(7); // should be plenty
@@ -334,14 +361,14 @@ void FacetedObject::WriteOBJFile(std::ostringstream &out)
     {
         // write out the vertices, faces, groups and objects
         // this is the relative version - inefficient but allows concatenation of objects
-        for (i = 0; i < mNumVertices / 3; i++)
+        for (i = 0; i < mesh->mNumVertices / 3; i++)
         {
             for (j = 0; j < 3; j++)
             {
-                vPtr = mVertexList + i * 9 + j * 3;
-                prel[0] = *vPtr++;
-                prel[1] = *vPtr++;
-                prel[2] = *vPtr;
+                vPtr = mesh->mVertexList + i * 9 + j * 3;
+                prel[0] = vPtr[0] * m_SharedMeshScale[0];
+                prel[1] = vPtr[1] * m_SharedMeshScale[1];
+                prel[2] = vPtr[2] * m_SharedMeshScale[2];
                 prel[3] = 0;
                 dMULTIPLY0_331(p, m_DisplayRotation, prel);
                 result[0] = p[0] + m_DisplayPosition[0];
@@ -362,14 +389,14 @@ void FacetedObject::WriteOBJFile(std::ostringstream &out)
     }
     else
     {
-        for (i = 0; i < mNumVertices / 3; i++)
+        for (i = 0; i < mesh->mNumVertices / 3; i++)
         {
             for (j = 0; j < 3; j++)
             {
-                vPtr = mVertexList + i * 9 + j * 3;
-                prel[0] = *vPtr++;
-                prel[1] = *vPtr++;
-                prel[2] = *vPtr;
+                vPtr = mesh->mVertexList + i * 9 + j * 3;
+                prel[0] = vPtr[0] * m_SharedMeshScale[0];
+                prel[1] = vPtr[1] * m_SharedMeshScale[1];
+                prel[2] = vPtr[2] * m_SharedMeshScale[2];
                 prel[3] = 0;
                 dMULTIPLY0_331(p, m_DisplayRotation, prel);
                 result[0] = p[0] + m_DisplayPosition[0];
@@ -379,19 +406,19 @@ void FacetedObject::WriteOBJFile(std::ostringstream &out)
             }
         }
 
-        for (i = 0; i < mNumVertices / 3; i++)
+        for (i = 0; i < mesh->mNumVertices / 3; i++)
         {
             out << "f ";
             for (j = 0; j < 3; j++)
             {
                 // note this files vertex list start at 1 not zero
                 if (j == 2)
-                    out << *(mIndexList + i * 3 + j) + 1 + gVertexOffset << "\n";
+                    out << i * 3 + j + 1 + gVertexOffset << "\n";
                 else
-                    out << *(mIndexList + i * 3 + j) + 1 + gVertexOffset << " ";
+                    out << i * 3 + j + 1 + gVertexOffset << " ";
             }
         }
-        gVertexOffset += mNumVertices;
+        gVertexOffset += mesh->mNumVertices;
     }
 }
 
@@ -410,73 +437,9 @@ void FacetedObject::Draw()
 #ifdef USE_QT
         if (m_glWidget)
         {
-            if (m_BufferObjectsAllocated == false)
-            {
-                // order vertex data as x, y, z, xn, yn, zn
-                int vertBufSize = mNumVertices * 3 * 2;
-                GLfloat *vertBuf = new GLfloat[vertBufSize];
-                GLfloat *vertBufPtr = vertBuf;
-                double *vertexListPtr = mVertexList;
-                double *normalListPtr = mNormalList;
-                for (int i = 0; i < mNumVertices; i++)
-                {
-                    *vertBufPtr++ = *vertexListPtr++;
-                    *vertBufPtr++ = *vertexListPtr++;
-                    *vertBufPtr++ = *vertexListPtr++;
-                    *vertBufPtr++ = *normalListPtr++;
-                    *vertBufPtr++ = *normalListPtr++;
-                    *vertBufPtr++ = *normalListPtr++;
-                }
-
-                // Setup our vertex buffer object.
-                m_VBO.create();
-                m_VBO.bind();
-                m_VBO.allocate(vertBuf, vertBufSize * sizeof(GLfloat));
-
-                delete [] vertBuf;
-                m_BufferObjectsAllocated = true;
-            }
-
-            QMatrix4x4 model(
-                    m_DisplayRotation[0], m_DisplayRotation[1], m_DisplayRotation[2],  m_DisplayPosition[0],
-                    m_DisplayRotation[4], m_DisplayRotation[5], m_DisplayRotation[6],  m_DisplayPosition[1],
-                    m_DisplayRotation[8], m_DisplayRotation[9], m_DisplayRotation[10], m_DisplayPosition[2],
-                    0,                    0,                    0,                     1);
-
-            // Store the vertex attribute bindings for the program.
-            m_VBO.bind();
-            QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
-            f->glEnableVertexAttribArray(0);
-            f->glEnableVertexAttribArray(1);
-            f->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), 0);
-            f->glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), reinterpret_cast<void *>(3 * sizeof(GLfloat)));
-            m_VBO.release();
-
             m_glWidget->facetedObjectShader()->bind();
-            QMatrix4x4 modelView = m_glWidget->view() * model;
-            m_glWidget->facetedObjectShader()->setUniformValue(m_glWidget->mvMatrixLoc(), modelView);
-            QMatrix4x4 modelViewProjection = m_glWidget->proj() * modelView;
-            m_glWidget->facetedObjectShader()->setUniformValue(m_glWidget->mvpMatrixLoc(), modelViewProjection);
-            QMatrix3x3 normalMatrix = modelView.normalMatrix();
-            m_glWidget->facetedObjectShader()->setUniformValue(m_glWidget->normalMatrixLoc(), normalMatrix);
-
-            GLfloat r = m_Colour.r;
-            GLfloat g = m_Colour.g;
-            GLfloat b = m_Colour.b;
-            GLfloat alpha = m_Colour.alpha;
-            GLfloat ambientProportion = 0.2;
-            GLfloat diffuseProportion = 0.8;
-            GLfloat specularProportion = 0.3;
-            GLfloat specularPower = 20;
-            QVector4D ambient(r * ambientProportion, g * ambientProportion, b * ambientProportion, alpha);
-            QVector4D diffuse(r * diffuseProportion, g * diffuseProportion, b * diffuseProportion, alpha);
-            QVector4D specular(r * specularProportion, g * specularProportion, b * specularProportion, alpha);
-            m_glWidget->facetedObjectShader()->setUniformValue(m_glWidget->ambientLoc(), ambient);
-            m_glWidget->facetedObjectShader()->setUniformValue(m_glWidget->diffuseLoc(), diffuse);
-            m_glWidget->facetedObjectShader()->setUniformValue(m_glWidget->specularLoc(), specular);
-            m_glWidget->facetedObjectShader()->setUniformValue(m_glWidget->shininessLoc(), specularPower);
-
-            glDrawArrays(GL_TRIANGLES, 0, mNumVertices);
+            m_glWidget->facetedObjectShader()->setUniformValue(m_glWidget->shininessLoc(), GLfloat(kSpecularPower));
+            DrawOpenGL(true);
         }
 #endif
     }
@@ -498,6 +461,232 @@ void FacetedObject::Draw()
     }
 }
 
+#ifdef USE_QT
+// upload the render copy if the vertex buffer object does not exist yet or the geometry has changed
+void FacetedObject::UpdateBufferObject()
+{
+    if (m_BufferObjectsAllocated == false || m_BufferObjectsNeedUpdate)
+    {
+        // the render copy is already in x, y, z, xn, yn, zn order so it is uploaded as it is
+        int vertBufSize = mNumVertices * 3 * 2;
+        if (m_BufferObjectsAllocated == false)
+        {
+            // Setup our vertex buffer object.
+            m_VBO.create();
+            m_VBO.bind();
+            m_VBO.allocate(m_RenderVertexList, vertBufSize * sizeof(GLfloat));
+            m_BufferObjectsSize = vertBufSize;
+            m_BufferObjectsAllocated = true;
+        }
+        else
+        {
+            // reuse the existing buffer object and orphan the old storage so the driver does not stall
+            // the storage only ever grows so a strap that changes shape does not keep reallocating
+            m_VBO.bind();
+            if (vertBufSize > m_BufferObjectsSize) m_BufferObjectsSize = vertBufSize;
+            m_VBO.allocate(m_BufferObjectsSize * sizeof(GLfloat));
+            m_VBO.write(0, m_RenderVertexList, vertBufSize * sizeof(GLfloat));
+        }
+        m_BufferObjectsNeedUpdate = false;
+    }
+}
+
+// Store the vertex attribute bindings for the program.
+void FacetedObject::SetVertexAttributes()
+{
+    m_VBO.bind();
+    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+    f->glEnableVertexAttribArray(0);
+    f->glEnableVertexAttribArray(1);
+    f->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), 0);
+    f->glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), reinterpret_cast<void *>(3 * sizeof(GLfloat)));
+    m_VBO.release();
+}
+
+// the display position and rotation with the shared mesh scale applied first
+QMatrix4x4 FacetedObject::ModelMatrix()
+{
+    QMatrix4x4 model(
+            m_DisplayRotation[0], m_DisplayRotation[1], m_DisplayRotation[2],  m_DisplayPosition[0],
+            m_DisplayRotation[4], m_DisplayRotation[5], m_DisplayRotation[6],  m_DisplayPosition[1],
+            m_DisplayRotation[8], m_DisplayRotation[9], m_DisplayRotation[10], m_DisplayPosition[2],
+            0,                    0,                    0,                     1);
+    if (m_SharedMesh) model.scale(m_SharedMeshScale[0], m_SharedMeshScale[1], m_SharedMeshScale[2]);
+    return model;
+}
+
+// this does the actual OpenGL drawing and assumes that the faceted object shader is already bound
+// and that the shininess has been set. The colour uniforms are only set if setColour is true so
+// that a run of objects with the same colour can share them
+void FacetedObject::DrawOpenGL(bool setColour)
+{
+    FacetedObject *mesh = m_SharedMesh ? m_SharedMesh : this;
+    mesh->UpdateBufferObject();
+    mesh->SetVertexAttributes();
+
+    QOpenGLShaderProgram *shader = m_glWidget->facetedObjectShader();
+    QMatrix4x4 modelView = m_glWidget->view() * ModelMatrix();
+    shader->setUniformValue(m_glWidget->mvMatrixLoc(), modelView);
+    QMatrix4x4 modelViewProjection = m_glWidget->proj() * modelView;
+    shader->setUniformValue(m_glWidget->mvpMatrixLoc(), modelViewProjection);
+    QMatrix3x3 normalMatrix = modelView.normalMatrix();
+    shader->setUniformValue(m_glWidget->normalMatrixLoc(), normalMatrix);
+
+    if (setColour)
+    {
+        GLfloat r = m_Colour.r;
+        GLfloat g = m_Colour.g;
+        GLfloat b = m_Colour.b;
+        GLfloat alpha = m_Colour.alpha;
+        QVector4D ambient(r * kAmbientProportion, g * kAmbientProportion, b * kAmbientProportion, alpha);
+        QVector4D diffuse(r * kDiffuseProportion, g * kDiffuseProportion, b * kDiffuseProportion, alpha);
+        QVector4D specular(r * kSpecularProportion, g * kSpecularProportion, b * kSpecularProportion, alpha);
+        shader->setUniformValue(m_glWidget->ambientLoc(), ambient);
+        shader->setUniformValue(m_glWidget->diffuseLoc(), diffuse);
+        shader->setUniformValue(m_glWidget->specularLoc(), specular);
+    }
+
+    glDrawArrays(GL_TRIANGLES, 0, mesh->mNumVertices);
+}
+
+// draws every copy of a shared mesh with one instanced draw call
+// each instance has a model matrix in attributes 2 to 5 and a colour in attribute 6
+// and assumes that the instanced shader is already bound
+void FacetedObject::DrawInstances(GLWidget *glWidget, FacetedObject *mesh, const std::vector<FacetedObject *> &instances)
+{
+    const int kInstanceSize = 16 + 4;
+    static std::vector<GLfloat> instanceData;
+    instanceData.resize(instances.size() * kInstanceSize);
+    GLfloat *instancePtr = instanceData.data();
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        QMatrix4x4 model = instances[i]->ModelMatrix();
+        memcpy(instancePtr, model.constData(), 16 * sizeof(GLfloat)); // column major as OpenGL expects
+        instancePtr[16] = instances[i]->m_Colour.r;
+        instancePtr[17] = instances[i]->m_Colour.g;
+        instancePtr[18] = instances[i]->m_Colour.b;
+        instancePtr[19] = instances[i]->m_Colour.alpha;
+        instancePtr += kInstanceSize;
+    }
+
+    mesh->UpdateBufferObject();
+    mesh->SetVertexAttributes();
+
+    QOpenGLExtraFunctions *f = QOpenGLContext::currentContext()->extraFunctions();
+    QOpenGLBuffer *instanceVbo = glWidget->instanceVbo();
+    instanceVbo->bind();
+    instanceVbo->allocate(instanceData.data(), instanceData.size() * sizeof(GLfloat));
+    for (int column = 0; column < 5; column++)
+    {
+        f->glEnableVertexAttribArray(2 + column);
+        f->glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, kInstanceSize * sizeof(GLfloat), reinterpret_cast<void *>(column * 4 * sizeof(GLfloat)));
+        f->glVertexAttribDivisor(2 + column, 1);
+    }
+    instanceVbo->release();
+
+    f->glDrawArraysInstanced(GL_TRIANGLES, 0, mesh->mNumVertices, GLsizei(instances.size()));
+
+    // the vertex array object is shared with the non instanced drawing so the instance attributes are switched off again
+    for (int column = 0; column < 5; column++)
+    {
+        f->glVertexAttribDivisor(2 + column, 0);
+        f->glDisableVertexAttribArray(2 + column);
+    }
+}
+
+// the delayed draw list is sorted into a queue keyed by shader and mesh to cut down on state changes
+// opaque objects that share a mesh (contacts, markers and joint spheres and axes) are drawn with one instanced draw call per mesh
+// the other opaque objects are drawn grouped by colour so that the material uniforms only change when needed
+// and then the transparent objects are drawn from back to front so that they blend correctly
+void FacetedObject::DrawDelayedDrawList(GLWidget *glWidget)
+{
+    typedef std::pair<QOpenGLShaderProgram *, FacetedObject *> InstanceKey;
+    static std::map<InstanceKey, std::vector<FacetedObject *> > instanceQueue;
+    static std::vector<FacetedObject *> opaqueList;
+    static std::vector<std::pair<float, FacetedObject *> > transparentList;
+    std::map<InstanceKey, std::vector<FacetedObject *> >::iterator instanceIter;
+    for (instanceIter = instanceQueue.begin(); instanceIter != instanceQueue.end(); instanceIter++) instanceIter->second.clear();
+    opaqueList.clear();
+    transparentList.clear();
+
+    // POVRay and OBJ output do not need any sorting
+    if (gDestinationOpenGL == false)
+    {
+        for (size_t i = 0; i < gDelayedDrawList.size(); i++)
+        {
+            gDelayedDrawList[i]->setGlWidget(glWidget);
+            gDelayedDrawList[i]->Draw();
+        }
+        gDelayedDrawList.clear();
+        return;
+    }
+
+    QOpenGLShaderProgram *instancedShader = glWidget->facetedObjectInstancedShader();
+    QMatrix4x4 view = glWidget->view();
+    for (size_t i = 0; i < gDelayedDrawList.size(); i++)
+    {
+        FacetedObject *object = gDelayedDrawList[i];
+        object->setGlWidget(glWidget);
+        if (object->m_Colour.alpha >= 1)
+        {
+            if (object->m_SharedMesh) instanceQueue[InstanceKey(instancedShader, object->m_SharedMesh)].push_back(object);
+            else opaqueList.push_back(object);
+        }
+        else transparentList.push_back(std::make_pair(view.map(QVector3D(object->m_DisplayPosition[0], object->m_DisplayPosition[1], object->m_DisplayPosition[2])).z(), object));
+    }
+    gDelayedDrawList.clear();
+
+    std::stable_sort(opaqueList.begin(), opaqueList.end(), SortOnColour);
+    // the camera looks down -z so the most negative depth is the furthest away
+    std::stable_sort(transparentList.begin(), transparentList.end(), SortOnDepth);
+
+    QOpenGLShaderProgram *lastShader = 0;
+    for (instanceIter = instanceQueue.begin(); instanceIter != instanceQueue.end(); instanceIter++)
+    {
+        if (instanceIter->second.size() == 0) continue;
+        QOpenGLShaderProgram *shader = instanceIter->first.first;
+        if (shader != lastShader)
+        {
+            shader->bind();
+            shader->setUniformValue(glWidget->viewMatrixLocInstanced(), view);
+            shader->setUniformValue(glWidget->projMatrixLocInstanced(), glWidget->proj());
+            shader->setUniformValue(glWidget->materialProportionsLocInstanced(), QVector3D(kAmbientProportion, kDiffuseProportion, kSpecularProportion));
+            shader->setUniformValue(glWidget->shininessLocInstanced(), GLfloat(kSpecularPower));
+            lastShader = shader;
+        }
+        DrawInstances(glWidget, instanceIter->first.second, instanceIter->second);
+    }
+
+    QOpenGLShaderProgram *shader = glWidget->facetedObjectShader();
+    shader->bind();
+    shader->setUniformValue(glWidget->shininessLoc(), GLfloat(kSpecularPower));
+
+    const Colour *lastColour = 0;
+    for (size_t i = 0; i < opaqueList.size(); i++)
+    {
+        const Colour *colour = &opaqueList[i]->m_Colour;
+        bool setColour = (lastColour == 0 || colour->r != lastColour->r || colour->g != lastColour->g || colour->b != lastColour->b || colour->alpha != lastColour->alpha);
+        opaqueList[i]->DrawOpenGL(setColour);
+        lastColour = colour;
+    }
+    for (size_t i = 0; i < transparentList.size(); i++)
+        transparentList[i].second->DrawOpenGL(true);
+}
+
+bool FacetedObject::SortOnColour(const FacetedObject *d1, const FacetedObject *d2)
+{
+    if (d1->m_Colour.r != d2->m_Colour.r) return d1->m_Colour.r < d2->m_Colour.r;
+    if (d1->m_Colour.g != d2->m_Colour.g) return d1->m_Colour.g < d2->m_Colour.g;
+    if (d1->m_Colour.b != d2->m_Colour.b) return d1->m_Colour.b < d2->m_Colour.b;
+    return d1->m_Colour.alpha < d2->m_Colour.alpha;
+}
+
+bool FacetedObject::SortOnDepth(const std::pair<float, FacetedObject *> &d1, const std::pair<float, FacetedObject *> &d2)
+{
+    return d1.first < d2.first;
+}
+#endif
+
 void FacetedObject::SetDisplayPosition(double x, double y, double z)
 {
     m_DisplayPosition[0] = x;
@@ -595,6 +784,9 @@ void FacetedObject::Move(double x, double y, double z)
         mVertexList[i * 3 + 1] += y;
         mVertexList[i * 3 + 2] += z;
     }
+#ifdef USE_QT
+    FillRenderVertexList(0);
+#endif
 }
 
 // scale the object
@@ -607,6 +799,9 @@ void FacetedObject::Scale(double x, double y, double z)
         mVertexList[i * 3 + 1] *= y;
         mVertexList[i * 3 + 2] *= z;
     }
+#ifdef USE_QT
+    FillRenderVertexList(0);
+#endif
 }
 
 // this routine triangulates the polygon and calls AddTriangle to do the actual data adding
@@ -645,21 +840,42 @@ void FacetedObject::AddTriangle(const double *vertices)
         m_AllocationIncrement *= 2;
     }
     memcpy(mVertexList + mNumVertices * 3, vertices, sizeof(double) * 9);
+    mNumVertices += 3;
+#ifdef USE_QT
+    FillRenderVertexList(mNumVertices - 3);
+#endif
+}
 
-    // now calculate the normals
-    double normal[3];
-    ComputeFaceNormal(vertices, vertices + 3, vertices + 6, normal);
-    memcpy(mNormalList + mNumVertices * 3, normal, sizeof(double) * 3);
-    memcpy(mNormalList + mNumVertices * 3 + 3, normal, sizeof(double) * 3);
-    memcpy(mNormalList + mNumVertices * 3 + 6, normal, sizeof(double) * 3);
-
-    // and finally the indices
-    mIndexList[mNumVertices] = mNumVertices;
-    mNumVertices++;
-    mIndexList[mNumVertices] = mNumVertices;
-    mNumVertices++;
-    mIndexList[mNumVertices] = mNumVertices;
-    mNumVertices++;
+// add a packed list of triangle vertices in one go
+void FacetedObject::AddTriangles(const double *vertices, int numVertices)
+{
+    AllocateMemory(mNumVertices + numVertices);
+    memcpy(mVertexList + mNumVertices * 3, vertices, sizeof(double) * numVertices * 3);
+    mNumVertices += numVertices;
+#ifdef USE_QT
+    FillRenderVertexList(mNumVertices - numVertices);
+#endif
+}
+
+// this routine empties the object but keeps the memory allocation so that it can be regenerated cheaply
+// the vertex buffer object is also kept and is refilled the next time the object is drawn
+void FacetedObject::ClearGeometry()
+{
+    mNumVertices = 0;
+#ifdef USE_QT
+    m_VBO.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    m_BufferObjectsNeedUpdate = true;
+#endif
+}
+
+// the object is drawn as the shared mesh scaled by scaleX, scaleY, scaleZ before the display rotation
+// the shared mesh must outlive the object and the object should not have any vertices of its own
+void FacetedObject::SetSharedMesh(FacetedObject *sharedMesh, double scaleX, double scaleY, double scaleZ)
+{
+    m_SharedMesh = sharedMesh;
+    m_SharedMeshScale[0] = scaleX;
+    m_SharedMeshScale[1] = scaleY;
+    m_SharedMeshScale[2] = scaleZ;
 }
 
 // this routine handles the memory allocation
@@ -669,74 +885,150 @@ void FacetedObject::AllocateMemory(int allocation)
     {
         mNumVerticesAllocated = allocation;
         double *newVertexList = new double[mNumVerticesAllocated * 3];
-        double *newNormalList = new double[mNumVerticesAllocated * 3];
-        int *newIndexList = new int[mNumVerticesAllocated];
         if (mVertexList)
         {
             memcpy(newVertexList, mVertexList, sizeof(double) * mNumVertices * 3);
             delete [] mVertexList;
-            memcpy(newNormalList, mNormalList, sizeof(double) * mNumVertices * 3);
-            delete [] mNormalList;
-            memcpy(newIndexList, mIndexList, sizeof(int) * mNumVertices);
-            delete [] mIndexList;
         }
         mVertexList = newVertexList;
-        mNormalList = newNormalList;
-        mIndexList = newIndexList;
+#ifdef USE_QT
+        GLfloat *newRenderVertexList = new GLfloat[mNumVerticesAllocated * 6];
+        if (m_RenderVertexList)
+        {
+            memcpy(newRenderVertexList, m_RenderVertexList, sizeof(GLfloat) * mNumVertices * 6);
+            delete [] m_RenderVertexList;
+        }
+        m_RenderVertexList = newRenderVertexList;
+#endif
+    }
+}
+
+#ifdef USE_QT
+// this fills the render copy from firstVertex to the end of the vertex list
+// the face normal is calculated once here rather than every time the buffer is uploaded
+void FacetedObject::FillRenderVertexList(int firstVertex)
+{
+    double *vertexListPtr = mVertexList + firstVertex * 3;
+    GLfloat *renderPtr = m_RenderVertexList + firstVertex * 6;
+    double normal[3];
+    for (int i = firstVertex / 3; i < mNumVertices / 3; i++)
+    {
+        ComputeFaceNormal(vertexListPtr, vertexListPtr + 3, vertexListPtr + 6, normal);
+        for (int j = 0; j < 3; j++)
+        {
+            *renderPtr++ = *vertexListPtr++;
+            *renderPtr++ = *vertexListPtr++;
+            *renderPtr++ = *vertexListPtr++;
+            *renderPtr++ = normal[0];
+            *renderPtr++ = normal[1];
+            *renderPtr++ = normal[2];
+        }
     }
+    if (m_BufferObjectsAllocated) m_BufferObjectsNeedUpdate = true;
+}
+#endif
+
+// orders vertex indices by the vertex coordinates
+struct VertexLess
+{
+    VertexLess(const double *vertexList) { m_VertexList = vertexList; }
+    bool operator()(int a, int b) const
+    {
+        const double *va = m_VertexList + a * 3;
+        const double *vb = m_VertexList + b * 3;
+        if (va[0] != vb[0]) return va[0] < vb[0];
+        if (va[1] != vb[1]) return va[1] < vb[1];
+        return va[2] < vb[2];
+    }
+    const double *m_VertexList;
+};
+
+// find the vertices that are shared between triangles
+// vertexMap gets the index of the unique vertex for each of the mNumVertices vertices
+// and the unique vertices are numbered in the order that they first appear
+// returns the number of unique vertices
+int FacetedObject::CalculateSharedVertices(std::vector<int> *vertexMap)
+{
+    int i;
+    std::vector<int> order(mNumVertices);
+    for (i = 0; i < mNumVertices; i++) order[i] = i;
+    // only exactly matching vertices are shared so the geometry is unchanged
+    std::stable_sort(order.begin(), order.end(), VertexLess(mVertexList));
+
+    // after the stable sort the first vertex in each run of matches has the lowest index
+    std::vector<int> firstMatch(mNumVertices);
+    for (i = 0; i < mNumVertices; i++)
+    {
+        const double *v = mVertexList + order[i] * 3;
+        if (i > 0)
+        {
+            const double *last = mVertexList + order[i - 1] * 3;
+            if (v[0] == last[0] && v[1] == last[1] && v[2] == last[2])
+            {
+                firstMatch[order[i]] = firstMatch[order[i - 1]];
+                continue;
+            }
+        }
+        firstMatch[order[i]] = order[i];
+    }
+
+    vertexMap->resize(mNumVertices);
+    int numUnique = 0;
+    for (i = 0; i < mNumVertices; i++)
+    {
+        if (firstMatch[i] == i) (*vertexMap)[i] = numUnique++;
+        else (*vertexMap)[i] = (*vertexMap)[firstMatch[i]];
+    }
+    return numUnique;
 }
 
 // return an ODE style trimesh
+// the vertices are shared between triangles and the indices refer to the shared vertices
 // note memory is allocated by this routine and will need to be released elsewhere
 void FacetedObject::CalculateTrimesh(double **vertices, int *numVertices, int *vertexStride, dTriIndex **triIndexes, int *numTriIndexes, int *triStride)
 {
     int i;
+    std::vector<int> vertexMap;
     *vertexStride = 3 * sizeof(double);
     *triStride = 3 * sizeof(dTriIndex);
 
-    *numVertices = mNumVertices;
+    *numVertices = CalculateSharedVertices(&vertexMap);
     *numTriIndexes = mNumVertices;
 
-    *vertices = new double[mNumVertices * 3];
+    *vertices = new double[*numVertices * 3];
     *triIndexes = new dTriIndex[mNumVertices];
 
     for (i = 0; i < mNumVertices; i++)
     {
-        (*vertices)[i * 3] = mVertexList[i * 3];
-        (*vertices)[i * 3 + 1] = mVertexList[i * 3 + 1];
-        (*vertices)[i * 3 + 2] = mVertexList[i * 3 + 2];
-    }
-
-    for (i = 0; i < mNumVertices; i++)
-    {
-        (*triIndexes)[i] = mIndexList[i];
+        (*vertices)[vertexMap[i] * 3] = mVertexList[i * 3];
+        (*vertices)[vertexMap[i] * 3 + 1] = mVertexList[i * 3 + 1];
+        (*vertices)[vertexMap[i] * 3 + 2] = mVertexList[i * 3 + 2];
+        (*triIndexes)[i] = vertexMap[i];
     }
 }
 
 // return an ODE style trimesh
+// the vertices are shared between triangles and the indices refer to the shared vertices
 // note memory is allocated by this routine and will need to be released elsewhere
 void FacetedObject::CalculateTrimesh(float **vertices, int *numVertices, int *vertexStride, dTriIndex **triIndexes, int *numTriIndexes, int *triStride)
 {
     int i;
+    std::vector<int> vertexMap;
     *vertexStride = 3 * sizeof(float);
     *triStride = 3 * sizeof(dTriIndex);
 
-    *numVertices = mNumVertices;
+    *numVertices = CalculateSharedVertices(&vertexMap);
     *numTriIndexes = mNumVertices;
 
-    *vertices = new float[mNumVertices * 3];
+    *vertices = new float[*numVertices * 3];
     *triIndexes = new dTriIndex[mNumVertices];
 
     for (i = 0; i < mNumVertices; i++)
     {
-        (*vertices)[i * 3] = mVertexList[i * 3];
-        (*vertices)[i * 3 + 1] = mVertexList[i * 3 + 1];
-        (*vertices)[i * 3 + 2] = mVertexList[i * 3 + 2];
-    }
-
-    for (i = 0; i < mNumVertices; i++)
-    {
-        (*triIndexes)[i] = mIndexList[i];
+        (*vertices)[vertexMap[i] * 3] = mVertexList[i * 3];
+        (*vertices)[vertexMap[i] * 3 + 1] = mVertexList[i * 3 + 1];
+        (*vertices)[vertexMap[i] * 3 + 2] = mVertexList[i * 3 + 2];
+        (*triIndexes)[i] = vertexMap[i];
     }
 }
 
@@ -985,7 +1277,9 @@ void FacetedObject::ReverseWinding()
             mVertexList[i * 9 + 6 + j] = t;
         }
     }
-    for (i = 0; i < mNumVertices * 3; i++) mNormalList[i] = -mNormalList[i];
+#ifdef USE_QT
+    FillRenderVertexList(0);
+#endif
 }
 
 // add the faces from one faceted object to another
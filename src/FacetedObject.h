@@ -14,9 +14,13 @@
 
 #include <ode/ode.h>
 
+#include <vector>
+
 #ifdef USE_QT
 class GLWidget;
 #include <QOpenGLBuffer>
+#include <QMatrix4x4>
+#include <utility>
 #endif
 
 class DataFile;
@@ -37,13 +41,11 @@ public:
 
     int GetNumVertices() { return mNumVertices; }
     double *GetVertex(int i) { return mVertexList + (3 * i); }
-    double *GetNormal(int i) { return mNormalList + (3 * i); }
     double *GetVertexList() { return mVertexList; }
-    double *GetNormalList() { return mNormalList; }
-    int *GetIndexList() { return mIndexList; }
 
     void AddPolygon(const double *vertices, int nSides);
     void AddTriangle(const double *vertices);
+    void AddTriangles(const double *vertices, int numVertices);
     void AddFacetedObject(FacetedObject *object, bool useDisplayRotation);
 
     int GetNumTriangles() { return mNumVertices / 3; }
@@ -71,18 +73,28 @@ public:
     // utility
     void ReverseWinding();
     void AllocateMemory(int allocation);
+    void ClearGeometry();
     void SetVerticesAsSpheresRadius(double verticesAsSpheresRadius) { m_VerticesAsSpheresRadius = verticesAsSpheresRadius; }
 
     // ODE link
+    int CalculateSharedVertices(std::vector<int> *vertexMap);
     void CalculateTrimesh(double **vertices, int *numVertices, int *vertexStride, dTriIndex **triIndexes, int *numTriIndexes, int *triStride);
     void CalculateTrimesh(float **vertices, int *numVertices, int *vertexStride, dTriIndex **triIndexes, int *numTriIndexes, int *triStride);
     void CalculateMassProperties(dMass *m, double density, bool clockwise);
 
     void SetBadMesh(bool v) { m_BadMesh = v; }
 
+    // an object can be a scaled copy of a mesh that is shared with other objects in which case it has no vertices of its own
+    // and all the copies of the mesh in the delayed draw list are drawn with one instanced draw call
+    void SetSharedMesh(FacetedObject *sharedMesh, double scaleX, double scaleY, double scaleZ);
+    FacetedObject *GetSharedMesh() { return m_SharedMesh; }
+
 #ifdef USE_QT
     GLWidget *glWidget() const;
     void setGlWidget(GLWidget *glWidget);
+
+    void DrawOpenGL(bool setColour);
+    static void DrawDelayedDrawList(GLWidget *glWidget);
 #endif
 
 protected:
@@ -90,8 +102,6 @@ protected:
     int mNumVertices;
     int mNumVerticesAllocated;
     double *mVertexList;
-    double *mNormalList;
-    int *mIndexList;
 
     dVector3 m_DisplayPosition;
     dMatrix3 m_DisplayRotation;
@@ -102,10 +112,29 @@ protected:
 
     bool m_BadMesh;
 
+    FacetedObject *m_SharedMesh;
+    double m_SharedMeshScale[3];
+
 #ifdef USE_QT
+    void UpdateBufferObject();
+    void SetVertexAttributes();
+    QMatrix4x4 ModelMatrix();
+    static void DrawInstances(GLWidget *glWidget, FacetedObject *mesh, const std::vector<FacetedObject *> &instances);
+
+    static bool SortOnColour(const FacetedObject *d1, const FacetedObject *d2);
+    static bool SortOnDepth(const std::pair<float, FacetedObject *> &d1, const std::pair<float, FacetedObject *> &d2);
+
+    void FillRenderVertexList(int firstVertex);
+
+    // float copy of the vertices interleaved with their face normals as x, y, z, xn, yn, zn
+    // it is kept up to date as triangles are added so that uploading it is a straight copy
+    GLfloat *m_RenderVertexList;
+
     GLWidget *m_glWidget;
     QOpenGLBuffer m_VBO;
     bool m_BufferObjectsAllocated;
+    bool m_BufferObjectsNeedUpdate;
+    int m_BufferObjectsSize;
 #endif
 
     int m_AllocationIncrement;
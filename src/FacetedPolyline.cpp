@@ -14,38 +14,74 @@
 #include <ode/ode.h>
 #include <iostream>
 #include <cmath>
+#include <map>
 
 #include "FacetedPolyline.h"
 #include "Face.h"
 
+FacetedPolyline::FacetedPolyline()
+{
+    m_ProfileRadius = 0;
+    m_ProfileSides = 0;
+}
+
 FacetedPolyline::FacetedPolyline(std::vector<pgd::Vector> *polyline, double radius, int n)
 {
-    std::vector<pgd::Vector> profile;
+    m_ProfileRadius = 0;
+    m_ProfileSides = 0;
+    SetPolyline(polyline, radius, n);
+}
+
+void FacetedPolyline::SetPolyline(std::vector<pgd::Vector> *polyline, double radius, int n)
+{
+    ClearGeometry();
 
     // need to add extra tails to the polyline for direction padding
-    std::vector<pgd::Vector> newPolyline;
+    m_PaddedPolyline.clear();
     pgd::Vector v0 = (*polyline)[1] - (*polyline)[0];
     pgd::Vector v1 = (*polyline)[0] - v0;
-    newPolyline.push_back(v1);
-    for (unsigned int i = 0; i < polyline->size(); i++) newPolyline.push_back((*polyline)[i]);
+    m_PaddedPolyline.push_back(v1);
+    for (unsigned int i = 0; i < polyline->size(); i++) m_PaddedPolyline.push_back((*polyline)[i]);
     v0 = (*polyline)[polyline->size() - 1] - (*polyline)[polyline->size() - 2];
     v1 = (*polyline)[polyline->size() - 1] + v0;
-    newPolyline.push_back(v1);
+    m_PaddedPolyline.push_back(v1);
 
-    // create the profile
-    double delTheta = 2 * M_PI / n;
-    double theta = M_PI / 2;
-    for (int i = 0; i < n; i++)
+    // create the profile (only needs redoing if the size changes)
+    if (radius != m_ProfileRadius || n != m_ProfileSides)
     {
-        v0.x = cos(theta) * radius;
-        v0.y = sin(theta) * radius;
-        v0.z = 0;
-        theta -= delTheta;
-        profile.push_back(v0);
+        m_ProfileRadius = radius;
+        m_ProfileSides = n;
+        m_Profile.clear();
+        double delTheta = 2 * M_PI / n;
+        double theta = M_PI / 2;
+        for (int i = 0; i < n; i++)
+        {
+            v0.x = cos(theta) * radius;
+            v0.y = sin(theta) * radius;
+            v0.z = 0;
+            theta -= delTheta;
+            m_Profile.push_back(v0);
+        }
     }
 
-    Extrude(&newPolyline, &profile);
+    Extrude(&m_PaddedPolyline, &m_Profile);
+
+}
 
+// a tube of radius 1 from (0, 0, 0) to (0, 0, 1) with n sides that can be shared by straight tubes of any size
+// the tubes are created when they are first needed and are never deleted
+FacetedPolyline *FacetedPolyline::GetUnitTube(int n)
+{
+    static std::map<int, FacetedPolyline *> unitTubes;
+    FacetedPolyline *&tube = unitTubes[n];
+    if (tube == 0)
+    {
+        std::vector<pgd::Vector> polyline;
+        polyline.push_back(pgd::Vector(0, 0, 0));
+        polyline.push_back(pgd::Vector(0, 0, 1));
+        tube = new FacetedPolyline(&polyline, 1, n);
+    }
+    return tube;
 }
 
 /* this was an attempt at optimisation because the AddFace stage is slow
@@ -76,11 +76,23 @@ public:
 class FacetedPolyline: public FacetedObject
 {
 public:
+    FacetedPolyline();
     FacetedPolyline(std::vector<pgd::Vector> *polyline, double radius, int n);
 
+    // regenerates the tube in place reusing the memory and the vertex buffer object
+    void SetPolyline(std::vector<pgd::Vector> *polyline, double radius, int n);
+
+    static FacetedPolyline *GetUnitTube(int n);
+
     void Extrude(std::vector<pgd::Vector> *polyline, std::vector<pgd::Vector> *profile);
     static bool Intersection(Line3D *line, Plane3D *plane, pgd::Vector *intersection);
 
+protected:
+
+    std::vector<pgd::Vector> m_Profile;
+    double m_ProfileRadius;
+    int m_ProfileSides;
+    std::vector<pgd::Vector> m_PaddedPolyline;
 };
 
 
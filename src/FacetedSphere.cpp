@@ -79,7 +79,8 @@ static void print_triangle( triangle *t );
 static double sqr( double x );
 static double area_of_triangle( triangle *t );
 
-FacetedSphere::FacetedSphere(double radius, int maxlevels): FacetedObject()
+// if sharedMesh is true the sphere does not generate any vertices and is drawn as a scaled copy of the shared unit sphere
+FacetedSphere::FacetedSphere(double radius, int maxlevels, bool sharedMesh): FacetedObject()
 {
     /* Vertices of a unit octahedron */
     triangle octahedron[] =
@@ -108,6 +109,12 @@ FacetedSphere::FacetedSphere(double radius, int maxlevels): FacetedObject()
     m_Level = maxlevels;
     m_Radius = radius;
 
+    if (sharedMesh)
+    {
+        SetSharedMesh(GetUnitSphere(maxlevels), radius, radius, radius);
+        return;
+    }
+
 #ifdef COUNTERCLOCKWISE
     /* Reverse order of points in each triangle */
     for (i = 0; i < oct.npoly; i++) {
@@ -220,6 +227,16 @@ FacetedSphere::FacetedSphere(double radius, int maxlevels): FacetedObject()
     Scale(radius, radius, radius);
 }
 
+// the unit spheres are created when they are first needed and are never deleted
+FacetedSphere *FacetedSphere::GetUnitSphere(int level)
+{
+    static std::map<int, FacetedSphere *> unitSpheres;
+    if (level < 1) level = 1;
+    FacetedSphere *&sphere = unitSpheres[level];
+    if (sphere == 0) sphere = new FacetedSphere(1, level);
+    return sphere;
+}
+
 // write the object out as a POVRay string
 void FacetedSphere::WritePOVRay(std::ostringstream &theString)
 {
@@ -11,13 +11,16 @@
 #define FacetedSphere_h
 
 #include <sstream>
+#include <map>
 
 #include "FacetedObject.h"
 
 class FacetedSphere: public FacetedObject
 {
 public:
-    FacetedSphere(double radius, int level);
+    FacetedSphere(double radius, int level, bool sharedMesh = false);
+
+    static FacetedSphere *GetUnitSphere(int level);
 
     virtual void WritePOVRay(std::ostringstream &theString);
 
@@ -0,0 +1,43 @@
+/*
+ *  FastDouble.h
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Locale independent conversion between doubles and text that
+ *  writes the shortest string that reads back to the same value
+ *
+ */
+
+#ifndef FASTDOUBLE_H
+#define FASTDOUBLE_H
+
+class FastDouble
+{
+public:
+
+    // writes the value and a terminating 0 and returns the number of characters (not including the 0)
+    // buffer needs to be at least 32 characters
+    static int Format(double value, char *buffer);
+
+    // writes the prefix (if not 0) followed by n space separated values and returns the number of characters
+    static int FormatList(char *buffer, const char *prefix, const double *values, int n);
+    static int FormatList(char *buffer, const char *prefix, double v0)
+    { return FormatList(buffer, prefix, &v0, 1); }
+    static int FormatList(char *buffer, const char *prefix, double v0, double v1, double v2)
+    { double v[3] = {v0, v1, v2}; return FormatList(buffer, prefix, v, 3); }
+    static int FormatList(char *buffer, const char *prefix, double v0, double v1, double v2, double v3)
+    { double v[4] = {v0, v1, v2, v3}; return FormatList(buffer, prefix, v, 4); }
+    static int FormatList(char *buffer, const char *prefix, double v0, double v1, double v2, double v3, double v4, double v5)
+    { double v[6] = {v0, v1, v2, v3, v4, v5}; return FormatList(buffer, prefix, v, 6); }
+
+    // drop in replacement for strtod that always uses '.' as the decimal point
+    static double Parse(const char *text, char **end = 0);
+
+protected:
+
+    static double ParseSlow(const char *text, char **end);
+};
+
+#endif // FASTDOUBLE_H
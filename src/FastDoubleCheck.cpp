@@ -0,0 +1,225 @@
+/*
+ *  FastDoubleCheck.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Command line tool that checks that FastDouble round trips exactly
+ *  and times it against sprintf and strtod
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "FastDouble.h"
+
+static bool SameBits(double a, double b)
+{
+    if (std::isnan(a) && std::isnan(b)) return true;
+    return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+// leading and trailing zeros are not counted so that fixed and scientific notation can be compared
+static int SignificantDigits(const char *text)
+{
+    std::string digits;
+    for (const char *p = text; *p && *p != 'e'; p++) if (*p >= '0' && *p <= '9') digits += *p;
+    size_t first = digits.find_first_not_of('0');
+    if (first == std::string::npos) return 0;
+    size_t last = digits.find_last_not_of('0');
+    return int(last - first + 1);
+}
+
+static double Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// random bit patterns cover every exponent and the decimal values are the sort of numbers found in model files
+static void MakeValues(std::vector<double> *bitValues, std::vector<double> *decimalValues, size_t n, uint64_t seed)
+{
+    const double specials[] = { 0.0, -0.0, 1.0, -1.0, 0.1, 0.2, 0.3, 1.0 / 3.0, 2.0 / 3.0, 1e22, 1e23, -1e23,
+                                9007199254740991.0, 9007199254740992.0, 9007199254740993.0, 4.9406564584124654e-324,
+                                2.2250738585072009e-308, 2.2250738585072014e-308, 1.7976931348623157e308,
+                                5e-324, 1e-300, 1e300, 123456789012345678.0, 0.000001, 0.0000001, 1e16, 1e17, 1e21 };
+    bitValues->assign(specials, specials + sizeof(specials) / sizeof(specials[0]));
+    for (int i = -330; i <= 310; i++) bitValues->push_back(pow(10.0, i));
+
+    std::mt19937_64 random(seed);
+    std::uniform_int_distribution<int> digitsDistribution(1, 17);
+    std::uniform_int_distribution<int> exponentDistribution(-12, 12);
+    while (bitValues->size() < n)
+    {
+        uint64_t bits = random();
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        if (std::isfinite(d)) bitValues->push_back(d);
+    }
+    while (decimalValues->size() < n)
+    {
+        // a decimal with a random number of significant digits
+        uint64_t significand = random() % 100000000000000000ULL;
+        int digits = digitsDistribution(random);
+        for (int i = digits; i < 17; i++) significand /= 10;
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%s%llue%d", (random() & 1) ? "-" : "", (unsigned long long)significand, exponentDistribution(random) - digits);
+        decimalValues->push_back(strtod(buffer, 0));
+    }
+}
+
+// returns the number of failures
+static size_t Check(const std::vector<double> &values, const char *label)
+{
+    // Format -> Parse
+    char buffer[64];
+    char *end;
+    size_t formatFailures = 0, longer = 0;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        int length = FastDouble::Format(values[i], buffer);
+        double parsed = FastDouble::Parse(buffer, &end);
+        if (SameBits(parsed, values[i]) == false || end != buffer + length || strtod(buffer, 0) != values[i])
+        {
+            if (formatFailures < 10) std::cerr << "Format->Parse FAILED " << buffer << "\n";
+            formatFailures++;
+        }
+        // Grisu2 is not always the shortest so count how often %.*g finds fewer digits
+        int fastDigits = SignificantDigits(buffer);
+        for (int precision = 1; precision < fastDigits; precision++)
+        {
+            char shortest[400];
+            snprintf(shortest, sizeof(shortest), "%.*g", precision, values[i]);
+            if (strtod(shortest, 0) == values[i])
+            {
+                longer++;
+                break;
+            }
+        }
+    }
+
+    // Parse -> strtod for the %.17e strings that the old outputs wrote and for the shortest strings that are now written
+    std::vector<std::string> longStrings, shortStrings;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        snprintf(buffer, sizeof(buffer), "%.17e", values[i]);
+        longStrings.push_back(buffer);
+        FastDouble::Format(values[i], buffer);
+        shortStrings.push_back(buffer);
+    }
+    size_t parseFailures = 0;
+    for (int type = 0; type < 2; type++)
+    {
+        const std::vector<std::string> &strings = type ? shortStrings : longStrings;
+        for (size_t i = 0; i < strings.size(); i++)
+        {
+            char *strtodEnd;
+            double expected = strtod(strings[i].c_str(), &strtodEnd);
+            double parsed = FastDouble::Parse(strings[i].c_str(), &end);
+            if (SameBits(parsed, expected) == false || end != strtodEnd)
+            {
+                if (parseFailures < 10) std::cerr << "Parse->strtod FAILED " << strings[i] << "\n";
+                parseFailures++;
+            }
+        }
+    }
+
+    // timings
+    volatile int sink = 0;
+    volatile double dsink = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < values.size(); i++) sink += sprintf(buffer, "%.17e", values[i]);
+    double sprintfTime = Seconds(start);
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < values.size(); i++) sink += FastDouble::Format(values[i], buffer);
+    double formatTime = Seconds(start);
+    double strtodTime[2], parseTime[2];
+    for (int type = 0; type < 2; type++)
+    {
+        const std::vector<std::string> &strings = type ? shortStrings : longStrings;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < strings.size(); i++) dsink += strtod(strings[i].c_str(), 0);
+        strtodTime[type] = Seconds(start);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < strings.size(); i++) dsink += FastDouble::Parse(strings[i].c_str(), 0);
+        parseTime[type] = Seconds(start);
+    }
+
+    double n = double(values.size());
+    std::cerr << label << " values\n";
+    std::cerr << "Format->Parse: " << values.size() << " values " << formatFailures << " failures " <<
+                 longer << " not shortest" << (formatFailures ? " FAILED\n" : " passed\n");
+    std::cerr << "Parse->strtod: " << 2 * values.size() << " strings " << parseFailures << " failures" << (parseFailures ? " FAILED\n" : " passed\n");
+    std::cerr << "Format: sprintf(\"%.17e\") " << 1e9 * sprintfTime / n << " ns FastDouble::Format " << 1e9 * formatTime / n << " ns\n";
+    std::cerr << "Parse %.17e strings: strtod " << 1e9 * strtodTime[0] / n << " ns FastDouble::Parse " << 1e9 * parseTime[0] / n << " ns\n";
+    std::cerr << "Parse shortest strings: strtod " << 1e9 * strtodTime[1] / n << " ns FastDouble::Parse " << 1e9 * parseTime[1] / n << " ns\n\n";
+    return formatFailures + parseFailures;
+}
+
+// strings that are exactly half way between two doubles or close to the ends of the range
+static size_t CheckHardStrings()
+{
+    const char *hardStrings[] = { "9007199254740993", "9007199254740995", "9007199254740993.0000000001", "18014398509481990",
+                                  "7.2057594037927933e16", "2.2250738585072011e-308", "2.2250738585072012e-308",
+                                  "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324",
+                                  "1.7976931348623157e308", "1.7976931348623158e308", "1.7976931348623159e308",
+                                  "1e-400", "1e400", "0.1e-5", "123456789012345678901234567890", "1.00000000000000011102230246251565404236316680908203125",
+                                  "1.00000000000000011102230246251565404236316680908203124", "0.500000000000000166533453693773481063544750213623046875",
+                                  "3.0540412168028242e-05", "9.5e-1", "8.5", "1e23", "8.589973e9", "1.448997445238699", "0x1p3", "inf", "-nan", "+12", "-0",
+                                  "1e", "1e+", ".5", "5.", "." };
+    size_t failures = 0;
+    for (size_t i = 0; i < sizeof(hardStrings) / sizeof(hardStrings[0]); i++)
+    {
+        char *strtodEnd, *end;
+        double expected = strtod(hardStrings[i], &strtodEnd);
+        double parsed = FastDouble::Parse(hardStrings[i], &end);
+        if (SameBits(parsed, expected) == false || end != strtodEnd)
+        {
+            std::cerr << "Parse->strtod FAILED " << hardStrings[i] << "\n";
+            failures++;
+        }
+    }
+    std::cerr << "Hard strings: " << sizeof(hardStrings) / sizeof(hardStrings[0]) << " strings " << failures << " failures" << (failures ? " FAILED\n\n" : " passed\n\n");
+    return failures;
+}
+
+static void Usage()
+{
+    std::cerr << "Usage:\n";
+    std::cerr << "gaitsym_fastdoublecheck [n] [seed]\n";
+    std::cerr << "Checks that FastDouble::Format followed by FastDouble::Parse returns exactly the same value and that\n";
+    std::cerr << "FastDouble::Parse gives exactly the same value as strtod for n decimal values and n random bit patterns (default 1000000)\n";
+    std::cerr << "and then prints the time per call compared with sprintf(\"%.17e\") and strtod\n";
+    std::cerr << "Returns 0 if every value matched\n\n";
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = 1000000;
+    uint64_t seed = 1;
+    if (argc > 1 && (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0))
+    {
+        Usage();
+        return 1;
+    }
+    if (argc > 1) n = strtoul(argv[1], 0, 10);
+    if (argc > 2) seed = strtoull(argv[2], 0, 10);
+    if (n < 1000) n = 1000;
+
+    std::vector<double> bitValues, decimalValues;
+    MakeValues(&bitValues, &decimalValues, n, seed);
+    size_t failures = CheckHardStrings();
+    failures += Check(decimalValues, "Decimal");
+    failures += Check(bitValues, "Random bit pattern");
+    std::cerr << (failures ? "FastDouble check FAILED\n" : "FastDouble check passed\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+/*
+ *  FitnessCache.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Least recently used cache of simulation results that can be
+ *  kept between runs in an append only file
+ *
+ */
+
+#include <iostream>
+#include <string.h>
+
+#include "FitnessCache.h"
+
+// file format (native byte order)
+// char[8] "GSFCACHE" then records of uint64 key followed by a SimulationResult
+// later records replace earlier ones with the same key and a partial record at the end is ignored
+static const char kFitnessCacheMagic[8] = {'G', 'S', 'F', 'C', 'A', 'C', 'H', 'E'};
+
+FitnessCache::FitnessCache(size_t capacity)
+{
+    m_Capacity = capacity;
+    if (m_Capacity < 1) m_Capacity = 1;
+    m_Hits = 0;
+    m_Misses = 0;
+}
+
+FitnessCache::~FitnessCache()
+{
+    if (m_File.is_open()) m_File.close();
+}
+
+bool FitnessCache::Open(const char *filename)
+{
+    bool newFile = true;
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    if (in.good())
+    {
+        char magic[sizeof(kFitnessCacheMagic)];
+        in.read(magic, sizeof(magic));
+        if (in.gcount() == (std::streamsize)sizeof(magic))
+        {
+            if (memcmp(magic, kFitnessCacheMagic, sizeof(magic)) != 0)
+            {
+                std::cerr << "FitnessCache error: \"" << filename << "\" is not a fitness cache file\n";
+                return false;
+            }
+            newFile = false;
+            uint64_t key;
+            SimulationResult result;
+            while (true)
+            {
+                in.read((char *)&key, sizeof(key));
+                in.read((char *)&result, sizeof(result));
+                if (in.fail()) break;
+                Store(key, result);
+            }
+        }
+    }
+    in.close();
+
+    m_File.open(filename, std::ios::out | std::ios::binary | std::ios::app);
+    if (m_File.good() == false)
+    {
+        std::cerr << "FitnessCache error: could not open \"" << filename << "\"\n";
+        return false;
+    }
+    if (newFile)
+    {
+        m_File.write(kFitnessCacheMagic, sizeof(kFitnessCacheMagic));
+        m_File.flush();
+    }
+    return true;
+}
+
+bool FitnessCache::Find(uint64_t key, SimulationResult *result)
+{
+    std::map<uint64_t, std::list<std::pair<uint64_t, SimulationResult> >::iterator>::const_iterator iter = m_Index.find(key);
+    if (iter == m_Index.end())
+    {
+        m_Misses++;
+        return false;
+    }
+    m_LRUList.splice(m_LRUList.begin(), m_LRUList, iter->second);
+    *result = iter->second->second;
+    m_Hits++;
+    return true;
+}
+
+// each record is flushed straight away so that other clients sharing the file see it
+void FitnessCache::Insert(uint64_t key, const SimulationResult &result)
+{
+    Store(key, result);
+    if (m_File.is_open())
+    {
+        m_File.write((const char *)&key, sizeof(key));
+        m_File.write((const char *)&result, sizeof(result));
+        m_File.flush();
+    }
+}
+
+void FitnessCache::Store(uint64_t key, const SimulationResult &result)
+{
+    std::map<uint64_t, std::list<std::pair<uint64_t, SimulationResult> >::iterator>::iterator iter = m_Index.find(key);
+    if (iter != m_Index.end())
+    {
+        iter->second->second = result;
+        m_LRUList.splice(m_LRUList.begin(), m_LRUList, iter->second);
+        return;
+    }
+    m_LRUList.push_front(std::make_pair(key, result));
+    m_Index[key] = m_LRUList.begin();
+    if (m_LRUList.size() > m_Capacity)
+    {
+        m_Index.erase(m_LRUList.back().first);
+        m_LRUList.pop_back();
+    }
+}
+
+uint64_t FitnessCache::Hash(const void *data, size_t length, uint64_t hash)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,62 @@
+/*
+ *  FitnessCache.h
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Least recently used cache of simulation results that can be
+ *  kept between runs in an append only file
+ *
+ */
+
+#ifndef FITNESSCACHE_H
+#define FITNESSCACHE_H
+
+#include <list>
+#include <map>
+#include <fstream>
+#include <stdint.h>
+#include <stddef.h>
+
+// the values reported for a simulation run
+struct SimulationResult
+{
+    double score;
+    double simulationTime;
+    long long stepCount;
+    double mechanicalEnergy;
+    double metabolicEnergy;
+};
+
+class FitnessCache
+{
+public:
+    FitnessCache(size_t capacity);
+    ~FitnessCache();
+
+    // reads any results already in the file and appends new results to it
+    bool Open(const char *filename);
+
+    bool Find(uint64_t key, SimulationResult *result);
+    void Insert(uint64_t key, const SimulationResult &result);
+
+    uint64_t GetHits() { return m_Hits; }
+    uint64_t GetMisses() { return m_Misses; }
+
+    // 64 bit FNV-1a, pass the previous value as hash to continue a hash
+    static uint64_t Hash(const void *data, size_t length, uint64_t hash = 14695981039346656037ULL);
+
+protected:
+
+    void Store(uint64_t key, const SimulationResult &result);
+
+    size_t m_Capacity;
+    std::list<std::pair<uint64_t, SimulationResult> > m_LRUList; // most recently used first
+    std::map<uint64_t, std::list<std::pair<uint64_t, SimulationResult> >::iterator> m_Index;
+    std::ofstream m_File;
+    uint64_t m_Hits;
+    uint64_t m_Misses;
+};
+
+#endif // FITNESSCACHE_H
@@ -10,6 +10,7 @@
  */
 
 #include "FixedDriver.h"
+#include "Checkpoint.h"
 
 FixedDriver::FixedDriver()
 {
@@ -20,4 +21,12 @@ FixedDriver::~FixedDriver()
 {
 }
 
+void FixedDriver::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Write(mValue);
+}
 
+void FixedDriver::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Read(&mValue);
+}
@@ -25,6 +25,9 @@ public:
     void MultiplyValue(double mod) { mValue *= mod; }
     void AddValue(double mod) { mValue += mod; }
 
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
+
 protected:
     double mValue;
 };
@@ -145,7 +145,7 @@ void FloatingHingeJoint::Draw()
     if (m_FirstDraw)
     {
         m_FirstDraw = false;
-        m_PhysRep = new FacetedConicSegment(m_AxisSize[0] * 2, m_AxisSize[0] / 10, m_AxisSize[0] / 10, 128, 0, 0, -m_AxisSize[0]);
+        m_PhysRep = new FacetedConicSegment(m_AxisSize[0] * 2, m_AxisSize[0] / 10, m_AxisSize[0] / 10, 128, 0, 0, -m_AxisSize[0], true); // drawn as an instance of a shared segment
         m_PhysRep->SetColour(m_Colour);
     }
 
@@ -38,6 +38,7 @@ Geom::Geom()
     m_ERP = 2; // > 1 is not used
     m_Bounce = -1; // < 0 is not used
     m_Mu = dInfinity;
+    m_MaterialID = 0;
     m_Abort = false;
 }
 
@@ -244,14 +245,12 @@ void Geom::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "NamedObject::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tXP\tYP\tZP\tQW\tQX\tQY\tQZ\tNContacts\tBody1\tBody2\tXC\tYC\tZC\tFX1\tFY1\tFZ1\tTX1\tTY1\tTZ1\tFX2\tFY2\tFZ2\tTX2\tTY2\tTZ2\n";
+            m_DumpStream->SetUnits("s\tm\tm\tm\t\t\t\t\t\t\t\tm\tm\tm\tN\tN\tN\tNm\tNm\tNm\tN\tN\tN\tNm\tNm\tNm");
         }
     }
 
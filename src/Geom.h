@@ -63,6 +63,10 @@ public:
     void SetContactBounce(double bounce) { m_Bounce = bounce; };
     double GetContactBounce() { return m_Bounce; };
 
+    // index into the contact surface table built by Simulation::CompileContactMaterials
+    void SetMaterialID(int materialID) { m_MaterialID = materialID; };
+    int GetMaterialID() { return m_MaterialID; };
+
     void SetSpringDamp(double springConstant, double dampingConstant, double integrationStep);
     void SetSpringERP(double springConstant, double ERP, double integrationStep);
 
@@ -89,6 +93,7 @@ protected:
     double m_ERP;
     double m_Mu;
     double m_Bounce;
+    int m_MaterialID;
 
     bool m_Abort;
 
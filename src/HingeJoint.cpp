@@ -15,6 +15,7 @@
 #endif
 
 #include "HingeJoint.h"
+#include "Checkpoint.h"
 #include "DataFile.h"
 #include "Body.h"
 #include "Simulation.h"
@@ -335,13 +336,6 @@ void HingeJoint::CalculateStopTorque()
     }
 }
 
-int HingeJoint::TestLimits()
-{
-    if (m_axisTorqueMean < m_LoStopTorqueLimit) return -1;
-    if (m_axisTorqueMean > m_HiStopTorqueLimit) return 1;
-    return 0;
-}
-
 void HingeJoint::SetStopTorqueWindow(int window)
 {
     if (m_axisTorqueList) delete [] m_axisTorqueList;
@@ -407,14 +401,12 @@ void HingeJoint::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "HingeJoint::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tXP\tYP\tZP\tXA\tYA\tZA\tAngle\tAngleRate\tFX1\tFY1\tFZ1\tTX1\tTY1\tTZ1\tFX2\tFY2\tFZ2\tTX2\tTY2\tTZ2\tStopTorque\n";
+            m_DumpStream->SetUnits("s\tm\tm\tm\t\t\t\trad\trad/s\tN\tN\tN\tNm\tNm\tNm\tN\tN\tN\tNm\tNm\tNm\t");
         }
     }
 
@@ -445,7 +437,7 @@ void HingeJoint::Draw()
     if (m_FirstDraw)
     {
         m_FirstDraw = false;
-        m_PhysRep = new FacetedConicSegment(m_AxisSize[0] * 2, m_AxisSize[0] / 10, m_AxisSize[0] / 10, 128, 0, 0, -m_AxisSize[0]);
+        m_PhysRep = new FacetedConicSegment(m_AxisSize[0] * 2, m_AxisSize[0] / 10, m_AxisSize[0] / 10, 128, 0, 0, -m_AxisSize[0], true); // drawn as an instance of a shared segment
         m_PhysRep->SetColour(m_Colour);
     }
 
@@ -467,3 +459,26 @@ void HingeJoint::Draw()
 }
 #endif
 
+void HingeJoint::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    Joint::WriteCheckpoint(checkpoint);
+    checkpoint->Write(m_axisTorque);
+    checkpoint->Write(m_axisTorqueTotal);
+    checkpoint->Write(m_axisTorqueMean);
+    checkpoint->Write(m_axisTorqueIndex);
+    checkpoint->Write(m_axisTorqueWindow);
+    if (m_axisTorqueList) checkpoint->Write(m_axisTorqueList, sizeof(double) * m_axisTorqueWindow);
+}
+
+void HingeJoint::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    Joint::ReadCheckpoint(checkpoint);
+    int window;
+    checkpoint->Read(&m_axisTorque);
+    checkpoint->Read(&m_axisTorqueTotal);
+    checkpoint->Read(&m_axisTorqueMean);
+    checkpoint->Read(&m_axisTorqueIndex);
+    checkpoint->Read(&window);
+    if (window != m_axisTorqueWindow) throw __LINE__;
+    if (m_axisTorqueList) checkpoint->Read(m_axisTorqueList, sizeof(double) * m_axisTorqueWindow);
+}
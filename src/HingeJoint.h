@@ -44,11 +44,22 @@ public:
         m_LoStopTorqueLimit = loStopTorqueLimit;
         m_HiStopTorqueLimit = hiStopTorqueLimit;
     }
-    int TestLimits();
+    bool HasTorqueLimits() { return m_LoStopTorqueLimit != -dInfinity || m_HiStopTorqueLimit != dInfinity; }
+    int TestLimits()
+    {
+        if (m_axisTorqueMean < m_LoStopTorqueLimit) return -1;
+        if (m_axisTorqueMean > m_HiStopTorqueLimit) return 1;
+        return 0;
+    }
     void SetStopTorqueWindow(int window);
 
+    // called every step by LimitChecker::UpdateJoints rather than through Update
+    void CalculateStopTorque();
+
     virtual void Update();
     virtual void Dump();
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
 
 #ifdef USE_QT
     virtual void Draw();
@@ -56,8 +67,6 @@ public:
 
 protected:
 
-    void CalculateStopTorque();
-
     double m_StartAngleReference;
 
     double m_HiStopTorqueLimit;
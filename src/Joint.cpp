@@ -11,6 +11,7 @@
 #include <ode/ode.h>
 
 #include "Joint.h"
+#include "Checkpoint.h"
 #include "Body.h"
 
 Joint::Joint()
@@ -39,4 +40,12 @@ dJointFeedback *Joint::GetFeedback()
     return dJointGetFeedback(m_JointID);
 }
 
+void Joint::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Write(m_JointFeedback);
+}
 
+void Joint::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Read(&m_JointFeedback);
+}
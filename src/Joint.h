@@ -39,6 +39,9 @@ public:
     virtual void Draw() = 0;
 #endif
 
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
+
 protected:
 
     Body *m_Body1;
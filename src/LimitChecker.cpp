@@ -0,0 +1,138 @@
+/*
+ *  LimitChecker.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Gathers the body states and bounds into flat arrays so that
+ *  the per step limit tests are a single pass with no branches
+ *  and does the per step joint updates and hinge torque limit tests
+ *
+ */
+
+#include <cmath>
+#include <cfloat>
+#include <string.h>
+
+#include "LimitChecker.h"
+#include "Body.h"
+#include "Joint.h"
+#include "HingeJoint.h"
+#include "SliderJoint.h"
+#include "FixedJoint.h"
+#include "UniversalJoint.h"
+#include "FloatingHingeJoint.h"
+
+LimitChecker::LimitChecker()
+{
+    m_FailedHingeJoint = 0;
+    m_FailedHingeDirection = 0;
+}
+
+LimitChecker::~LimitChecker()
+{
+}
+
+void LimitChecker::Compile(std::map<std::string, Body *> *bodyList, std::map<std::string, Joint *> *jointList)
+{
+    m_BodyIDList.clear();
+    m_LowBound.clear();
+    m_HighBound.clear();
+    m_UpdateJointList.clear();
+    m_HingeJointList.clear();
+    m_HingeTorqueLimits.clear();
+    m_FailedHingeJoint = 0;
+    m_FailedHingeDirection = 0;
+
+    std::map<std::string, Body *>::const_iterator iter1;
+    for (iter1 = bodyList->begin(); iter1 != bodyList->end(); iter1++)
+    {
+        Body *body = iter1->second;
+        m_BodyIDList.push_back(body->GetBodyID());
+        m_LowBound.insert(m_LowBound.end(), body->GetPositionLowBound(), body->GetPositionLowBound() + 3);
+        m_LowBound.insert(m_LowBound.end(), body->GetLinearVelocityLowBound(), body->GetLinearVelocityLowBound() + 3);
+        m_HighBound.insert(m_HighBound.end(), body->GetPositionHighBound(), body->GetPositionHighBound() + 3);
+        m_HighBound.insert(m_HighBound.end(), body->GetLinearVelocityHighBound(), body->GetLinearVelocityHighBound() + 3);
+    }
+    m_State.resize(m_LowBound.size());
+
+    // the joint types are found once here rather than with a dynamic_cast every step
+    // hinges are handled directly and the joint types whose Update does nothing are left out
+    // so only the motor joints (and any new joint types) get the virtual call
+    std::map<std::string, Joint *>::const_iterator iter2;
+    for (iter2 = jointList->begin(); iter2 != jointList->end(); iter2++)
+    {
+        Joint *joint = iter2->second;
+        HingeJoint *hingeJoint = dynamic_cast<HingeJoint *>(joint);
+        if (hingeJoint)
+        {
+            m_HingeJointList.push_back(hingeJoint);
+            m_HingeTorqueLimits.push_back(hingeJoint->HasTorqueLimits());
+            continue;
+        }
+        if (dynamic_cast<SliderJoint *>(joint) || dynamic_cast<FixedJoint *>(joint) ||
+                dynamic_cast<UniversalJoint *>(joint) || dynamic_cast<FloatingHingeJoint *>(joint)) continue;
+        m_UpdateJointList.push_back(joint);
+    }
+}
+
+// the stop torque is only needed for the limit test and for the dump output
+// so hinges without torque limits are skipped unless they are being dumped
+void LimitChecker::UpdateJoints()
+{
+    unsigned int i;
+    for (i = 0; i < m_UpdateJointList.size(); i++) m_UpdateJointList[i]->Update();
+
+    m_FailedHingeJoint = 0;
+    m_FailedHingeDirection = 0;
+    HingeJoint *hingeJoint;
+    int t;
+    for (i = 0; i < m_HingeJointList.size(); i++)
+    {
+        hingeJoint = m_HingeJointList[i];
+        if (m_HingeTorqueLimits[i] == 0)
+        {
+            if (hingeJoint->GetDump()) hingeJoint->CalculateStopTorque();
+            continue;
+        }
+        hingeJoint->CalculateStopTorque();
+        if (m_FailedHingeJoint) continue;
+        t = hingeJoint->TestLimits();
+        if (t)
+        {
+            m_FailedHingeJoint = hingeJoint;
+            m_FailedHingeDirection = t;
+        }
+    }
+}
+
+int LimitChecker::HingeJointsOutsideLimits(HingeJoint **failedJoint)
+{
+    *failedJoint = m_FailedHingeJoint;
+    return m_FailedHingeDirection;
+}
+
+// the comparisons are combined with & rather than && so that the loop has no branches and can be vectorised
+// NaN fails every comparison and infinity fails the DBL_MAX test so these are caught as well
+bool LimitChecker::BodiesOutsideLimits()
+{
+    if (m_BodyIDList.size() == 0) return false;
+
+    unsigned int i;
+    double *state = &m_State[0];
+    for (i = 0; i < m_BodyIDList.size(); i++)
+    {
+        memcpy(state + i * 6, dBodyGetPosition(m_BodyIDList[i]), 3 * sizeof(double));
+        memcpy(state + i * 6 + 3, dBodyGetLinearVel(m_BodyIDList[i]), 3 * sizeof(double));
+    }
+
+    const double *lowBound = &m_LowBound[0];
+    const double *highBound = &m_HighBound[0];
+    unsigned int n = m_State.size();
+    int inside = 1;
+    for (i = 0; i < n; i++)
+        inside &= (state[i] >= lowBound[i]) & (state[i] <= highBound[i]) & (std::fabs(state[i]) <= DBL_MAX);
+
+    return (inside == 0);
+}
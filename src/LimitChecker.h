@@ -0,0 +1,63 @@
+/*
+ *  LimitChecker.h
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Gathers the body states and bounds into flat arrays so that
+ *  the per step limit tests are a single pass with no branches
+ *  and does the per step joint updates and hinge torque limit tests
+ *
+ */
+
+#ifndef LIMITCHECKER_H
+#define LIMITCHECKER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <ode/ode.h>
+
+class Body;
+class Joint;
+class HingeJoint;
+
+class LimitChecker
+{
+public:
+    LimitChecker();
+    ~LimitChecker();
+
+    // the bounds are copied so this needs to be called again if they are changed
+    void Compile(std::map<std::string, Body *> *bodyList, std::map<std::string, Joint *> *jointList);
+
+    // true if any body position or linear velocity is outside its bounds or is not finite
+    // Body::TestLimits gives the details
+    bool BodiesOutsideLimits();
+
+    // replaces calling Joint::Update for every joint
+    // the hinge stop torques are calculated and tested in the same pass
+    void UpdateJoints();
+
+    // result of the hinge torque limit tests from the last UpdateJoints
+    // returns -1 or 1 (as HingeJoint::TestLimits) for the first failing joint and 0 if none failed
+    int HingeJointsOutsideLimits(HingeJoint **failedJoint);
+
+protected:
+
+    // 6 values per body: position then linear velocity
+    std::vector<dBodyID> m_BodyIDList;
+    std::vector<double> m_State;
+    std::vector<double> m_LowBound;
+    std::vector<double> m_HighBound;
+
+    std::vector<Joint *> m_UpdateJointList;
+    std::vector<HingeJoint *> m_HingeJointList;
+    std::vector<char> m_HingeTorqueLimits;
+    HingeJoint *m_FailedHingeJoint;
+    int m_FailedHingeDirection;
+};
+
+#endif // LIMITCHECKER_H
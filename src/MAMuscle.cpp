@@ -16,6 +16,7 @@
 
 #include "Strap.h"
 #include "MAMuscle.h"
+#include "Checkpoint.h"
 #include "DebugControl.h"
 #include "Simulation.h"
 
@@ -30,6 +31,7 @@ MAMuscle::MAMuscle(Strap *strap): Muscle(strap)
     m_F0 = 0;
     m_K = 0;
     m_Alpha = 0;
+    m_EccentricSlope = 0;
 }
 
 // destructor
@@ -37,6 +39,13 @@ MAMuscle::~MAMuscle()
 {
 }
 
+// values that only depend on the parameters are calculated here rather than every step
+// and this needs calling whenever one of the parameters changes
+void MAMuscle::CompileParameters()
+{
+    m_EccentricSlope = 7.56 / m_K;
+}
+
 // set the proportion of muscle fibres that are active
 // calculates the tension in the strap
 
@@ -62,7 +71,7 @@ void MAMuscle::SetAlpha(double alpha)
 
     if (v < 0)
     {
-        fFull = m_F0 * (1.8 - 0.8 * ((m_VMax + v) / (m_VMax - (7.56 / m_K) * v)));
+        fFull = m_F0 * (1.8 - 0.8 * ((m_VMax + v) / (m_VMax - m_EccentricSlope * v)));
     }
     else
     {
@@ -129,14 +138,12 @@ void MAMuscle::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "NamedObject::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tVMax\tF0\tK\tAlpha\tFCE\tLCE\tVCE\tPMECH\tPMET\n";
+            m_DumpStream->SetUnits("s\t\tN\t\t\tN\tm\tm/s\tW\tW");
         }
     }
 
@@ -150,4 +157,14 @@ void MAMuscle::Dump()
     }
 }
 
+void MAMuscle::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    Muscle::WriteCheckpoint(checkpoint);
+    checkpoint->Write(m_Alpha);
+}
 
+void MAMuscle::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    Muscle::ReadCheckpoint(checkpoint);
+    checkpoint->Read(&m_Alpha);
+}
@@ -30,7 +30,14 @@ public:
 
     void SetVMax(double vMax) { m_VMax = vMax; }
     void SetF0(double f0) { m_F0 = f0; }
-    void SetK(double k) { m_K = k; }
+    void SetK(double k) { m_K = k; CompileParameters(); }
+    double GetVMax() { return m_VMax; }
+    double GetF0() { return m_F0; }
+    double GetK() { return m_K; }
+    double GetEccentricSlope() { return m_EccentricSlope; }
+
+    // used by SimulationBatch which calculates the tension itself
+    void SetAlphaValue(double alpha) { m_Alpha = alpha; }
 
     virtual double GetMetabolicPower();
 
@@ -39,15 +46,21 @@ public:
     virtual double GetElasticEnergy() { return 0; }
 
     virtual void Dump();
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
 
 protected:
 
     void SetAlpha(double alpha);
+    void CompileParameters();
 
     double m_VMax;
     double m_F0;
     double m_K;
     double m_Alpha;
+
+    // derived parameters
+    double m_EccentricSlope;
 };
 
 
@@ -22,6 +22,7 @@
 
 #include "Strap.h"
 #include "MAMuscleComplete.h"
+#include "Checkpoint.h"
 #include "DebugControl.h"
 #include "Simulation.h"
 
@@ -83,6 +84,13 @@ MAMuscleComplete::MAMuscleComplete(Strap *strap): Muscle(strap)
 
     m_SetActivationFirstTimeFlag = true;
 
+    // derived parameters
+    m_Params.kvmax = 0;
+    m_Params.eccentricK = 0;
+    m_t1 = 0;
+    m_t2 = 0;
+    m_MinLPE = 0;
+    m_MinLen = 0;
 }
 
 // destructor
@@ -115,6 +123,7 @@ void MAMuscleComplete::SetSerialElasticProperties(double serialStrainAtFmax, dou
         m_Params.ese = serialElasticConstant; // elastic constant serial element (N/m)
         m_Params.dse = serialDampingConstant; // damping constant serial element (Ns/m)
     }
+    CompileParameters();
 }
 
 void MAMuscleComplete::SetParallelElasticProperties(double parallelStrainAtFmax, double parallelStrainRateAtFmax, double parallelElementLength, MAMuscleComplete::StrainModel parallelStrainModel)
@@ -144,6 +153,7 @@ void MAMuscleComplete::SetParallelElasticProperties(double parallelStrainAtFmax,
     m_Params.epe = parallelElasticConstant; // elastic constant parallel element (N/m)
     m_Params.dpe = parallelDampingConstant; // damping constant serial element (Ns/m)
     m_Params.smpe = parallelStrainModel; // strain model for serial element
+    CompileParameters();
 }
 
 // set the muscle contractile properties
@@ -153,6 +163,7 @@ void MAMuscleComplete::SetMuscleProperties(double vMax, double Fmax, double K, d
     m_Params.vmax = vMax; // maximum shortening velocity (m/s)
     m_Params.fmax = Fmax; // isometric force
     m_Params.width = Width; // relative width of length/tension peak
+    CompileParameters();
 }
 
 // set the activation kinetics
@@ -171,6 +182,23 @@ void MAMuscleComplete::SetActivationKinetics(bool activationKinetics,
     m_ft = akFastTwitchProportion;
     m_tact = akTActivationA + akTActivationB * m_ft;
     m_tdeact = akTDeactivationA + akTDeactivationB * m_ft;
+    CompileParameters();
+}
+
+// values that only depend on the parameters are calculated here rather than every step
+// and this needs calling whenever one of the parameters changes
+void MAMuscleComplete::CompileParameters()
+{
+    // Nagano & Gerritsen 2001 A2
+    m_t2 = 1 / m_tdeact;
+    m_t1 = 1 / m_tact - m_t2;
+
+    m_Params.kvmax = m_Params.k * m_Params.vmax;
+    m_Params.eccentricK = 0.8 * m_Params.k;
+
+    m_MinLPE = m_Params.spe - (m_Params.spe * m_Params.width / 2);
+    if (m_MinLPE < 0) m_MinLPE = 0;
+    m_MinLen = m_Params.sse + m_MinLPE;
 }
 
 // do any intialisation that relies on the strap being set up properly
@@ -202,9 +230,9 @@ void MAMuscleComplete::LateInitialisation()
         m_Params.ese = serialElasticConstant; // elastic constant serial element (N/m)
         m_Params.dse = serialDampingConstant; // damping constant serial element (Ns/m)
     }
+    CompileParameters();
 
-    double minlpe = m_Params.spe - (m_Params.spe * m_Params.width / 2);
-    if (minlpe < 0) minlpe = 0;
+    double minlpe = m_MinLPE;
     double maxlpe = m_Params.len - m_Params.sse; // this would be right with no damping
     if (maxlpe < minlpe) maxlpe = minlpe;
     if (m_Params.lastlpe == -1)
@@ -222,6 +250,13 @@ void MAMuscleComplete::LateInitialisation()
 // calculates the tension in the strap
 
 void MAMuscleComplete::SetActivation(double activation, double timeIncrement)
+{
+    CalculateActivation(activation, timeIncrement);
+    CalculateTension();
+}
+
+// the activation kinetics
+void MAMuscleComplete::CalculateActivation(double activation, double timeIncrement)
 {
 /*
     if (m_Name == "RightSoleus")
@@ -250,10 +285,9 @@ void MAMuscleComplete::SetActivation(double activation, double timeIncrement)
             if (m_ActivationKinetics)
             {
                 // using activation kinetics from UGM model
-                double t2 = 1 / m_tdeact;
-                double t1 = 1 / m_tact - t2;
+
                 // Nagano & Gerritsen 2001 A2
-                double qdot = (m_Stim - m_Params.alpha) * (t1 * m_Stim + t2);
+                double qdot = (m_Stim - m_Params.alpha) * (m_t1 * m_Stim + m_t2);
                 m_Params.alpha += qdot * m_Params.timeIncrement;
                 // I think I should allow this to fall - it won't make any difference and it maintains
                 // continuity in the differentials
@@ -279,21 +313,22 @@ void MAMuscleComplete::SetActivation(double activation, double timeIncrement)
     {
         m_Params.alpha = m_Stim;
     }
+}
 
+// solves the contractile and elastic elements for the current activation and strap length
+void MAMuscleComplete::CalculateTension()
+{
     m_Params.len = m_Strap->GetLength();
     m_Params.v = m_Strap->GetVelocity();
 
-    double minlpe = m_Params.spe - (m_Params.spe * m_Params.width / 2);
-    if (minlpe < 0) minlpe = 0;
+    double minlpe = m_MinLPE;
     // double maxlpe = m_Params.len - m_Params.sse; // this would be right with no damping
     // if (maxlpe < minlpe) maxlpe = minlpe;
 
     // now calculate output parameters
 
     // need to do some checks here for being slack (and also silly extension/contraction rates???)
-    double minlen;
-    minlen = m_Params.sse + minlpe;
-    if (m_Params.len <= minlen)
+    if (m_Params.len <= m_MinLen)
     {
         m_Params.lastlpe = minlpe;
 
@@ -624,11 +659,11 @@ double CalculateForceError (double lce, void *params)
 
             if (localvce > 0) // eccentric
             {
-                p->fce = p->alpha * p->f0 * (1.8 + (0.8 * p->k*(localvce - 1.0 * p->vmax)) / (7.56 * localvce + p->k * p->vmax));
+                p->fce = p->alpha * p->f0 * (1.8 + (p->eccentricK*(localvce - 1.0 * p->vmax)) / (7.56 * localvce + p->kvmax));
             }
             else // concentric
             {
-                p->fce = (p->alpha * p->f0 * p->k * (localvce + p->vmax)) / (-localvce + p->k * p->vmax);
+                p->fce = (p->alpha * p->f0 * p->k * (localvce + p->vmax)) / (-localvce + p->kvmax);
             }
 
         }
@@ -650,14 +685,12 @@ void MAMuscleComplete::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "MAMuscleComplete::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tm_Stim\talpha\tlen\tv\tlastlpe\tfce\tlpe\tfpe\tlse\tfse\tvce\tvse\ttargetFce\tf0\terr\tESE\tEPE\tPSE\tPPE\tPCE\ttension\tlength\tvelocity\tPMECH\tPMET\n";
+            m_DumpStream->SetUnits("s\t\t\tm\tm/s\tm\tN\tm\tN\tm\tN\tm/s\tm/s\tN\tN\t\tJ\tJ\tW\tW\tW\tN\tm\tm/s\tW\tW");
         }
     }
 
@@ -955,5 +988,18 @@ L150:
     return ret_val;
 } /* zeroin_ */
 
+void MAMuscleComplete::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    Muscle::WriteCheckpoint(checkpoint);
+    checkpoint->Write(m_Stim);
+    checkpoint->Write(m_Params);
+    checkpoint->Write(m_SetActivationFirstTimeFlag);
+}
 
-
+void MAMuscleComplete::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    Muscle::ReadCheckpoint(checkpoint);
+    checkpoint->Read(&m_Stim);
+    checkpoint->Read(&m_Params);
+    checkpoint->Read(&m_SetActivationFirstTimeFlag);
+}
@@ -53,6 +53,10 @@ public:
         double fmax; // maximum isometric force (N)
         double width; // relative width of length/tension peak
 
+        // derived parameters
+        double kvmax; // k * vmax
+        double eccentricK; // 0.8 * k
+
         // variable input parameters
         double alpha; // proportion of muscle activated
         double timeIncrement; // inegration step size for simulation (s)
@@ -89,6 +93,17 @@ public:
 
     virtual void SetActivation(double activation, double timeIncrement);
     virtual double GetActivation() { return m_Params.alpha; }
+
+    // SetActivation is CalculateActivation followed by CalculateTension
+    // SimulationBatch does the activation part itself and sets the result with SetActivationValues
+    void CalculateActivation(double activation, double timeIncrement);
+    void CalculateTension();
+    void SetActivationValues(double stim, double alpha, double timeIncrement) { m_Stim = stim; m_Params.alpha = alpha; m_Params.timeIncrement = timeIncrement; }
+    bool GetActivationKinetics() { return m_ActivationKinetics; }
+    double GetActivationRate() { return m_ActivationRate; }
+    double GetMinimumActivation() { return m_MinimumActivation; }
+    double GetActivationKineticsT1() { return m_t1; }
+    double GetActivationKineticsT2() { return m_t2; }
     virtual double GetElasticEnergy() { return GetESE(); }
 
     double GetStimulation() { return m_Stim; };
@@ -110,10 +125,14 @@ public:
     double GetSPE() { return m_Params.spe; }
 
     virtual void Dump();
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
     virtual void LateInitialisation();
 
 protected:
 
+    void CompileParameters();
+
     double m_Stim;
     bool m_ActivationKinetics;
     double m_ft;
@@ -132,6 +151,12 @@ protected:
 
     int m_SetActivationFirstTimeFlag;
 
+    // derived parameters
+    double m_t1;
+    double m_t2;
+    double m_MinLPE;
+    double m_MinLen;
+
 };
 
 
@@ -14,8 +14,15 @@
 
 // Added extra terms to allow a parallel spring element
 
+#include <random>
+#include <algorithm>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
 #include "SimpleStrap.h"
 #include "MAMuscleExtended.h"
+#include "Checkpoint.h"
 #include "DebugControl.h"
 #include "Simulation.h"
 
@@ -57,6 +64,11 @@ MAMuscleExtended::MAMuscleExtended(Strap *strap): Muscle(strap)
 
     m_SetActivationFirstTimeFlag = true;
 
+    // derived parameters
+    m_ConcentricDenominator = 0;
+    m_EccentricDenominator = 0;
+    m_EccentricLengthTerm = 0;
+    m_EccentricRateTerm = 0;
 }
 
 // destructor
@@ -70,6 +82,7 @@ void MAMuscleExtended::SetSerialElasticProperties(double springConstant, double
 {
     sse = unloadedLength; // slack length serial element (m)
     ese = springConstant; // elastic constant serial element (N/m)
+    CompileParameters();
 }
 
 void MAMuscleExtended::SetParallelElasticProperties(double springConstant, double unloadedLength)
@@ -77,6 +90,7 @@ void MAMuscleExtended::SetParallelElasticProperties(double springConstant, doubl
     spe = unloadedLength; // slack length parallel element (m)
     epe = springConstant; // elastic constant parallel element (N/m)
     if (epe < 0) epe = 0; // set flag value to zero
+    CompileParameters();
 }
 
 // set the muscle contractile properties
@@ -85,6 +99,18 @@ void MAMuscleExtended::SetMuscleProperties(double vMax, double F0, double K)
     k = K; // shape constant
     vmax = vMax; // maximum shortening velocity (m/s)
     f0 = F0; // isometric force
+    CompileParameters();
+}
+
+// values that only depend on the parameters are calculated here rather than every step
+// and this needs calling whenever one of the parameters changes
+// (only complete leading terms are taken out so the results are unchanged)
+void MAMuscleExtended::CompileParameters()
+{
+    m_ConcentricDenominator = 2.*(epe + ese);
+    m_EccentricDenominator = 945.*epe + 945.*ese;
+    m_EccentricLengthTerm = 3.214890000000001e6 + 189000.00000000003*k;
+    m_EccentricRateTerm = -47250. + 24999.999999999993*k;
 }
 
 // do any intialisation that relies on the strap being set up properly
@@ -100,6 +126,7 @@ void MAMuscleExtended::LateInitialisation()
     {
         // handle sse < 0
         if (sse < 0) sse = len - spe;
+        CompileParameters();
 
         vce = 0;
         if (lastlpe < 0) lastlpe = ((m_Act*f0*k*(vce+vmax)+(epe*spe+ese*(len-sse))*(vce-k*vmax))/((epe+ese)*(vce-k*vmax)));
@@ -126,6 +153,7 @@ void MAMuscleExtended::LateInitialisation()
     {
         // handle sse < 0
         if (sse < 0) sse = len - spe;
+        CompileParameters();
 
         vce = 0;
         if (lastlpe < 0) Rule(lpe,-((m_Act*f0)/ese) + len - sse);
@@ -180,6 +208,280 @@ void MAMuscleExtended::CalculateForceWithParallelElement(double timeIncrement)
 
     len = m_Strap->GetLength();
 
+    // the Mathematica solutions come in +/- pairs that share the same discriminant
+    // and linear terms so these are evaluated once per branch and only when needed
+    // (the expressions are unchanged so the results are identical)
+    double root, fseRoot, denominator, rate;
+    double fpeLinear, fseLinear, lseLinear, lpeLinear;
+
+    int progress = 0;
+    while (progress == 0)
+    {
+
+        // First assume vce <= 0 (concentric)
+        root = Sqrt(4*(epe + ese)*k*(alpha*f0 + epe*(lastlpe - spe) + ese*(lastlpe - len + sse))*timeIncrement*vmax +
+                    Power(alpha*f0*k + epe*(-lastlpe + spe) - ese*(lastlpe - len + sse) + (epe + ese)*k*timeIncrement*vmax,2));
+        denominator = m_ConcentricDenominator;
+        fpeLinear = alpha*f0*k + epe*lastlpe + ese*lastlpe + ese*len - epe*spe - 2*ese*spe - ese*sse + epe*k*timeIncrement*vmax +
+                ese*k*timeIncrement*vmax;
+        fseLinear = alpha*f0*k + epe*lastlpe + ese*lastlpe - 2*epe*len - ese*len + epe*spe + 2*epe*sse + ese*sse +
+                epe*k*timeIncrement*vmax + ese*k*timeIncrement*vmax;
+        lseLinear = alpha*f0*k + epe*lastlpe + ese*lastlpe - 2*epe*len - ese*len + epe*spe - ese*sse + epe*k*timeIncrement*vmax +
+                ese*k*timeIncrement*vmax;
+
+        // Solution 1
+        fpe = (epe*(fpeLinear - root))/denominator;
+        fse = -(ese*(fseLinear - root))/denominator;
+        lse = -(lseLinear - root)/denominator;
+
+        lpe = len - lse;
+        fce = fse - fpe;
+        vce = (lpe - lastlpe) / timeIncrement;
+
+        progress = 1;
+        if (vce <= 0 + goodEnough && fce >= 0 - goodEnough && lpe >= spe - goodEnough) break; // check consistency
+
+        // Solution 2
+        fpe = (epe*(fpeLinear + root))/denominator;
+        fse = -(ese*(fseLinear + root))/denominator;
+        lse = -(lseLinear + root)/denominator;
+
+        lpe = len - lse;
+        fce = fse - fpe;
+        vce = (lpe - lastlpe) / timeIncrement;
+
+        progress = 2;
+        if (vce <= 0 + goodEnough && fce >= 0 - goodEnough && lpe >= spe - goodEnough) break; // check consistency
+
+        // Now try assuming vce > 0 (eccentric)
+        root = 0.5*timeIncrement*
+                Sqrt((10000.*Power(alpha,2)*Power(f0,2)*(17.009999590960987 + k)*(17.010000409039023 + k) +
+                      Power(epe,2)*(893025.0000000001*Power(lastlpe,2) - 1.7860500000000002e6*lastlpe*spe + 893025.0000000001*Power(spe,2)) +
+                      Power(ese,2)*(893025.0000000001*Power(lastlpe,2) - 1.7860500000000002e6*lastlpe*len + 893025.0000000001*Power(len,2) +
+                                    1.7860500000000002e6*lastlpe*sse - 1.7860500000000002e6*len*sse + 893025.0000000001*Power(sse,2)) +
+                      epe*ese*(1.7860500000000002e6*Power(lastlpe,2) + 1.7860500000000002e6*len*spe - 1.7860500000000002e6*spe*sse +
+                               lastlpe*(-1.7860500000000002e6*len - 1.7860500000000002e6*spe + 1.7860500000000002e6*sse)) -
+                      236250.*k*(Power(epe,2)*(1.*lastlpe - 1.*spe) + Power(ese,2)*(1.*lastlpe - 1.*len + 1.*sse) +
+                                 epe*ese*(2.*lastlpe - 1.*len - 1.*spe + 1.*sse))*timeIncrement*vmax +
+                      15625.*(1.*Power(epe,2) + 2.*epe*ese + 1.*Power(ese,2))*Power(k,2)*Power(timeIncrement,2)*Power(vmax,2) +
+                      alpha*f0*(epe*(m_EccentricLengthTerm*lastlpe + (-3.214890000000001e6 - 189000.00000000003*k)*spe +
+                                     k*m_EccentricRateTerm*timeIncrement*vmax) +
+                                ese*(m_EccentricLengthTerm*lastlpe - 3.214890000000001e6*len + 3.214890000000001e6*sse +
+                                     k*(-189000.00000000003*len + 189000.00000000003*sse + m_EccentricRateTerm*timeIncrement*vmax))))/
+                     Power(timeIncrement,2));
+        // the fse discriminant was generated with -47250.00000000001 rather than -47250.
+        // and keeping it separate makes the results identical to the unfactored expressions
+        fseRoot = 0.5*timeIncrement*
+                Sqrt((10000.*Power(alpha,2)*Power(f0,2)*(17.009999590960987 + k)*(17.010000409039023 + k) +
+                      Power(epe,2)*(893025.0000000001*Power(lastlpe,2) - 1.7860500000000002e6*lastlpe*spe + 893025.0000000001*Power(spe,2)) +
+                      Power(ese,2)*(893025.0000000001*Power(lastlpe,2) - 1.7860500000000002e6*lastlpe*len + 893025.0000000001*Power(len,2) +
+                                    1.7860500000000002e6*lastlpe*sse - 1.7860500000000002e6*len*sse + 893025.0000000001*Power(sse,2)) +
+                      epe*ese*(1.7860500000000002e6*Power(lastlpe,2) + 1.7860500000000002e6*len*spe - 1.7860500000000002e6*spe*sse +
+                               lastlpe*(-1.7860500000000002e6*len - 1.7860500000000002e6*spe + 1.7860500000000002e6*sse)) -
+                      236250.*k*(Power(epe,2)*(1.*lastlpe - 1.*spe) + Power(ese,2)*(1.*lastlpe - 1.*len + 1.*sse) +
+                                 epe*ese*(2.*lastlpe - 1.*len - 1.*spe + 1.*sse))*timeIncrement*vmax +
+                      15625.*(1.*Power(epe,2) + 2.*epe*ese + 1.*Power(ese,2))*Power(k,2)*Power(timeIncrement,2)*Power(vmax,2) +
+                      alpha*f0*(epe*(m_EccentricLengthTerm*lastlpe + (-3.214890000000001e6 - 189000.00000000003*k)*spe +
+                                     k*(-47250.00000000001 + 24999.999999999993*k)*timeIncrement*vmax) +
+                                ese*(m_EccentricLengthTerm*lastlpe - 3.214890000000001e6*len + 3.214890000000001e6*sse +
+                                     k*(-189000.00000000003*len + 189000.00000000003*sse + (-47250.00000000001 + 24999.999999999993*k)*timeIncrement*vmax))))/
+                     Power(timeIncrement,2));
+        denominator = m_EccentricDenominator;
+        fpeLinear = -850.5*alpha*f0 - 50.*alpha*f0*k + 472.5*epe*lastlpe + 472.5*ese*lastlpe + 472.5*ese*len - 472.5*epe*spe -
+                945.*ese*spe - 472.5*ese*sse - 62.5*epe*k*timeIncrement*vmax - 62.5*ese*k*timeIncrement*vmax;
+        fseLinear = 850.5*alpha*f0 + 50.*alpha*f0*k + epe*(-472.5*lastlpe + 945.*len - 472.5*spe - 945.*sse) +
+                ese*(-472.5*lastlpe + 472.5*len - 472.5*sse) + 62.5*epe*k*timeIncrement*vmax + 62.5*ese*k*timeIncrement*vmax;
+        lseLinear = 850.5*alpha*f0 + 50.*alpha*f0*k - 472.5*epe*lastlpe - 472.5*ese*lastlpe + 945.*epe*len + 472.5*ese*len - 472.5*epe*spe +
+                472.5*ese*sse + 62.5*epe*k*timeIncrement*vmax + 62.5*ese*k*timeIncrement*vmax;
+
+        // Solution 1
+        fpe = (epe*(fpeLinear - root))/denominator;
+        fse = (ese*(fseLinear + fseRoot))/denominator;
+        lse = (lseLinear + root)/denominator;
+
+        lpe = len - lse;
+        fce = fse - fpe;
+        vce = (lpe - lastlpe) / timeIncrement;
+
+        progress = 3;
+        if (vce >= 0 - goodEnough && fce >= 0 - goodEnough && lpe >= spe - goodEnough) break; // check consistency
+
+        // Solution 2
+        fpe = (epe*(fpeLinear + root))/denominator;
+        fse = (ese*(fseLinear - fseRoot))/denominator;
+        lse = (lseLinear - root)/denominator;
+
+        lpe = len - lse;
+        fce = fse - fpe;
+        vce = (lpe - lastlpe) / timeIncrement;
+
+        progress = 4;
+        if (vce >= 0 - goodEnough && fce >= 0 - goodEnough && lpe >= spe - goodEnough) break; // check consistency
+
+        // now consider special case if (lpe < spe) // pe slack special case
+
+        // First assume vce <= 0 (concentric)
+        root = Sqrt(4*ese*k*(alpha*f0 + ese*(lastlpe - len + sse))*timeIncrement*vmax +
+                    Power(alpha*f0*k + ese*(-lastlpe + len - sse + k*timeIncrement*vmax),2));
+        rate = k*timeIncrement*vmax;
+        lpeLinear = alpha*f0*k + ese*(lastlpe + len - sse + rate);
+        fseLinear = -(alpha*f0*k) - ese*(lastlpe - len + sse + rate);
+        fpe = 0;
+
+        // Solution 1
+        lpe = (lpeLinear - root)/(2.*ese);
+        fse = (fseLinear + root)/2.;
+
+        lse = len - lpe;
+        fce = fse - fpe;
+        vce = (lpe - lastlpe) / timeIncrement;
+
+        progress = 5;
+        if (vce <= 0 + goodEnough && fce >= 0 - goodEnough && lpe <= spe + goodEnough) break; // check consistency
+
+        // Solution 2
+        lpe = (lpeLinear + root)/(2.*ese);
+        fse = (fseLinear - root)/2.;
+
+        lse = len - lpe;
+        fce = fse - fpe;
+        vce = (lpe - lastlpe) / timeIncrement;
+
+        progress = 6;
+        if (vce <= 0 + goodEnough && fce >= 0 - goodEnough && lpe <= spe + goodEnough) break; // check consistency
+
+        // Now check if (vce > 0) (eccentric)
+        root = 0.0005291005291005291*timeIncrement*
+                Sqrt((10000.*Power(alpha,2)*Power(f0,2)*(17.009999590960987 + k)*(17.010000409039023 + k) +
+                      Power(ese,2)*(893025.0000000001*Power(lastlpe,2) + 893025.0000000005*Power(len,2) - 1.786050000000001e6*len*sse +
+                                    893025.0000000005*Power(sse,2) + 236250.00000000006*k*len*timeIncrement*vmax -
+                                    236250.00000000006*k*sse*timeIncrement*vmax + 15624.999999999998*Power(k,2)*Power(timeIncrement,2)*Power(vmax,2) +
+                                    lastlpe*(-1.786050000000001e6*len + 1.786050000000001e6*sse - 236250.00000000006*k*timeIncrement*vmax)) +
+                      alpha*ese*f0*(m_EccentricLengthTerm*lastlpe - 3.214890000000001e6*len + 3.214890000000001e6*sse +
+                                    k*(-189000.00000000003*len + 189000.00000000003*sse + (-47250.00000000001 + 25000.000000000004*k)*timeIncrement*vmax)))/
+                     Power(timeIncrement,2));
+        lpeLinear = alpha*f0*(-0.9 - 0.052910052910052914*k) + 0.5*ese*lastlpe + 0.5*ese*len - 0.5*ese*sse -
+                0.06613756613756615*ese*k*timeIncrement*vmax;
+        fseLinear = alpha*f0*(0.9 + 0.052910052910052914*k) - 0.5*ese*lastlpe + 0.5*ese*len - 0.5*ese*sse +
+                0.06613756613756615*ese*k*timeIncrement*vmax;
+        fpe = 0;
+
+        // Solution 1
+        lpe = (lpeLinear - root)/ese;
+        fse = fseLinear + root;
+
+        lse = len - lpe;
+        fce = fse - fpe;
+        vce = (lpe - lastlpe) / timeIncrement;
+
+        progress = 7;
+        if (vce >= 0 - goodEnough && fce >= 0 - goodEnough && lpe <= spe + goodEnough) break; // check consistency
+
+        // Solution 2
+        lpe = (lpeLinear + root)/ese;
+        fse = fseLinear - root;
+
+        lse = len - lpe;
+        fce = fse - fpe;
+        vce = (lpe - lastlpe) / timeIncrement;
+
+        progress = 8;
+        if (vce >= 0 - goodEnough && fce >= 0 - goodEnough && lpe <= spe + goodEnough) break; // check consistency
+
+        // no consistent result found - usually because vce is out of range
+        // we shouldn't get here too often but a few time - especially at the beginning of a simulation
+        // or after an impact should be OK
+        progress = 9;
+        if (m_Strap->GetVelocity() > vmax) vce = vmax;
+        else if (m_Strap->GetVelocity() < -vmax) vce = -vmax;
+        else vce = 0;
+        lpe = ((m_Act*f0*k*(vce+vmax)+(epe*spe+ese*(len-sse))*(vce-k*vmax))/((epe+ese)*(vce-k*vmax)));
+        if (lpe > spe) // pe not slack
+        {
+            fpe = ((epe*(m_Act*f0*k*(vce+vmax)+ese*(len-spe-sse)*(vce-k*vmax)))/((epe+ese)*(vce-k*vmax)));
+            fse = ((-(m_Act*ese*f0*k*(vce+vmax))+epe*ese*(len-spe-sse)*(vce-k*vmax))/((epe+ese)*(vce-k*vmax)));
+            /*lse = ((-(m_Act*f0*k*(vce+vmax))+(epe*(len-spe)+ese*sse)*(vce-k*vmax))/((epe+ese)*(vce-k*vmax)));
+            fce = ((m_Act*f0*k*(vce+vmax))/(-vce+k*vmax));*/
+        }
+        else
+        {
+            progress = 10;
+            lpe = (len - sse + (m_Act*f0*k*(vce + vmax))/(ese*(vce - k*vmax)));
+            fse = ((m_Act*f0*k*(vce + vmax))/(-vce + k*vmax));
+            fpe = (0);
+            /*lse = (sse - (m_Act*f0*k*(vce + vmax))/(ese*(vce - k*vmax)));
+            fce = ((m_Act*f0*k*(vce + vmax))/(-vce + k*vmax));*/
+        }
+        lse = len - lpe;
+        fce = fse - fpe;
+        if (fce < 0) fce = 0; // sanity check
+        if (fse < 0) fse = 0; // sanity check
+    }
+
+    lastlpe = lpe;
+    m_Strap->SetTension(fse);
+
+    if (gDebug == MAMuscleExtendedDebug)
+    {
+        if (DebugFilters("SetActivation", m_Name))
+        {
+            static int m_SetActivationFirstTimeFlag = true;
+            if (m_SetActivationFirstTimeFlag) // only happens once
+            {
+                m_SetActivationFirstTimeFlag = false;
+                *gDebugStream << "MAMuscleExtended::SetActivation " <<
+                        " progress " <<
+                        " m_Stim " <<
+                        " m_Act " <<
+                        " len " <<
+                        " fpe " <<
+                        " lpe " <<
+                        " lse " <<
+                        " fse " <<
+                        " fce " <<
+                        " m_Velocity " <<
+                        " m_Tension " <<
+                        " vce " <<
+                        " serialStrainEnergy " <<
+                        " parallelStrainEnergy " <<
+                        "\n";
+            }
+
+            double serialStrainEnergy = 0.5 * (lse - sse) * (lse - sse) * ese;
+            double parallelStrainEnergy = 0.5 * (lpe - spe) * (lpe - spe) * epe;
+
+            *gDebugStream << m_Name <<
+                    " " << progress <<
+                    " " << m_Stim <<
+                    " " << m_Act <<
+                    " " << len <<
+                    " " << fpe <<
+                    " " << lpe <<
+                    " " << lse <<
+                    " " << fse <<
+                    " " << fce <<
+                    " " << m_Strap->GetVelocity() <<
+                    " " << m_Strap->GetTension() <<
+                    " " << vce <<
+                    " " << serialStrainEnergy <<
+                    " " << parallelStrainEnergy <<
+                    "\n";
+        }
+    }
+}
+
+
+// the unfactored Mathematica expressions that CalculateForceWithParallelElement was derived from
+// these are only used by CheckFactoredExpressions and leave lastlpe and the strap tension unchanged
+void MAMuscleExtended::CalculateForceWithParallelElementReference(double timeIncrement)
+{
+    const double goodEnough = 1e-10; // some help for rounding errors
+
+    double alpha = m_Act;
+    double len; // total length of system
+
+    len = m_Strap->GetLength();
+
     int progress = 0;
     while (progress == 0)
     {
@@ -471,59 +773,59 @@ void MAMuscleExtended::CalculateForceWithParallelElement(double timeIncrement)
         if (fce < 0) fce = 0; // sanity check
         if (fse < 0) fse = 0; // sanity check
     }
+}
 
-    lastlpe = lpe;
-    m_Strap->SetTension(fse);
-
-    if (gDebug == MAMuscleExtendedDebug)
+// compares CalculateForceWithParallelElement with the unfactored expressions for random states
+// around the current strap length and returns the number of samples that were not bit identical
+// the muscle state is restored afterwards
+int MAMuscleExtended::CheckFactoredExpressions(int samples, double *maxRelativeError)
+{
+    double savedLastlpe = lastlpe, savedAct = m_Act, savedEpe = epe;
+    double savedLength = m_Strap->GetLength(), savedTension = m_Strap->GetTension();
+    double savedFce = fce, savedLpe = lpe, savedFpe = fpe, savedLse = lse, savedFse = fse, savedVce = vce;
+    double restLength = spe > 0 ? spe : savedLength;
+
+    std::mt19937_64 random(1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    int mismatches = 0;
+    *maxRelativeError = 0;
+    for (int i = 0; i < samples; i++)
     {
-        if (DebugFilters("SetActivation", m_Name))
+        double sampleLastlpe = restLength * (0.5 + unit(random));
+        double timeIncrement = pow(10.0, -6.0 + 4.0 * unit(random));
+        m_Act = unit(random);
+        m_Strap->SetLength(savedLength * (0.7 + 0.6 * unit(random)));
+        if (savedEpe > 0) epe = savedEpe * (0.1 + 9.9 * unit(random));
+        else epe = ese * (0.01 + 0.99 * unit(random));
+        CompileParameters();
+
+        lastlpe = sampleLastlpe;
+        CalculateForceWithParallelElementReference(timeIncrement);
+        double reference[6] = {fce, lpe, fpe, lse, fse, vce};
+        lastlpe = sampleLastlpe;
+        CalculateForceWithParallelElement(timeIncrement);
+        double factored[6] = {fce, lpe, fpe, lse, fse, vce};
+
+        if (memcmp(reference, factored, sizeof(reference)) != 0)
         {
-            static int m_SetActivationFirstTimeFlag = true;
-            if (m_SetActivationFirstTimeFlag) // only happens once
+            mismatches++;
+            for (int j = 0; j < 6; j++)
             {
-                m_SetActivationFirstTimeFlag = false;
-                *gDebugStream << "MAMuscleExtended::SetActivation " <<
-                        " progress " <<
-                        " m_Stim " <<
-                        " m_Act " <<
-                        " len " <<
-                        " fpe " <<
-                        " lpe " <<
-                        " lse " <<
-                        " fse " <<
-                        " fce " <<
-                        " m_Velocity " <<
-                        " m_Tension " <<
-                        " vce " <<
-                        " serialStrainEnergy " <<
-                        " parallelStrainEnergy " <<
-                        "\n";
+                double error = fabs(factored[j] - reference[j]) / std::max(fabs(reference[j]), DBL_MIN);
+                if (!(error <= *maxRelativeError)) *maxRelativeError = error;
             }
-
-            double serialStrainEnergy = 0.5 * (lse - sse) * (lse - sse) * ese;
-            double parallelStrainEnergy = 0.5 * (lpe - spe) * (lpe - spe) * epe;
-
-            *gDebugStream << m_Name <<
-                    " " << progress <<
-                    " " << m_Stim <<
-                    " " << m_Act <<
-                    " " << len <<
-                    " " << fpe <<
-                    " " << lpe <<
-                    " " << lse <<
-                    " " << fse <<
-                    " " << fce <<
-                    " " << m_Strap->GetVelocity() <<
-                    " " << m_Strap->GetTension() <<
-                    " " << vce <<
-                    " " << serialStrainEnergy <<
-                    " " << parallelStrainEnergy <<
-                    "\n";
         }
     }
-}
 
+    lastlpe = savedLastlpe;
+    m_Act = savedAct;
+    epe = savedEpe;
+    CompileParameters();
+    m_Strap->SetLength(savedLength);
+    m_Strap->SetTension(savedTension);
+    fce = savedFce; lpe = savedLpe; fpe = savedFpe; lse = savedLse; fse = savedFse; vce = savedVce;
+    return mismatches;
+}
 
 void MAMuscleExtended::CalculateForceWithoutParallelElement(double timeIncrement)
 {
@@ -716,14 +1018,12 @@ void MAMuscleExtended::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "NamedObject::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tstim\tact\tspe\tepe\tsse\tese\tk\tvmax\tf0\tfce\tlpe\tfpe\tlse\tfse\tvce\tvse\tense\tenpe\tpse\tppe\tpce\ttension\tlength\tvelocity\tPMECH\tPMET\n";
+            m_DumpStream->SetUnits("s\t\t\t\t\t\t\t\t\tN\tN\tm\tN\tm\tN\tm/s\tm/s\tJ\tJ\tW\tW\tW\tN\tm\tm/s\tW\tW");
         }
     }
 
@@ -740,3 +1040,32 @@ void MAMuscleExtended::Dump()
     }
 }
 
+void MAMuscleExtended::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    Muscle::WriteCheckpoint(checkpoint);
+    checkpoint->Write(m_Stim);
+    checkpoint->Write(m_Act);
+    checkpoint->Write(fce);
+    checkpoint->Write(lpe);
+    checkpoint->Write(fpe);
+    checkpoint->Write(lse);
+    checkpoint->Write(fse);
+    checkpoint->Write(vce);
+    checkpoint->Write(lastlpe);
+    checkpoint->Write(m_SetActivationFirstTimeFlag);
+}
+
+void MAMuscleExtended::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    Muscle::ReadCheckpoint(checkpoint);
+    checkpoint->Read(&m_Stim);
+    checkpoint->Read(&m_Act);
+    checkpoint->Read(&fce);
+    checkpoint->Read(&lpe);
+    checkpoint->Read(&fpe);
+    checkpoint->Read(&lse);
+    checkpoint->Read(&fse);
+    checkpoint->Read(&vce);
+    checkpoint->Read(&lastlpe);
+    checkpoint->Read(&m_SetActivationFirstTimeFlag);
+}
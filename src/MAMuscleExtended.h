@@ -64,8 +64,12 @@ public:
     double GetSPE() { return spe; }
 
     virtual void Dump();
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
     virtual void LateInitialisation();
 
+    int CheckFactoredExpressions(int samples, double *maxRelativeError);
+
 protected:
 
     double m_Stim;
@@ -92,7 +96,15 @@ protected:
 
     double lastlpe; // last parallel element length (m)
 
+    // derived parameters
+    double m_ConcentricDenominator; // 2.*(epe + ese)
+    double m_EccentricDenominator; // 945.*epe + 945.*ese
+    double m_EccentricLengthTerm; // 3.214890000000001e6 + 189000.00000000003*k
+    double m_EccentricRateTerm; // -47250. + 24999.999999999993*k
+
+    void CompileParameters();
     void CalculateForceWithParallelElement(double timeIncrement);
+    void CalculateForceWithParallelElementReference(double timeIncrement);
     void CalculateForceWithoutParallelElement(double timeIncrement);
 
     int m_SetActivationFirstTimeFlag;
@@ -250,14 +250,12 @@ void Marker::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "NamedObject::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tXP\tYP\tZP\tQW\tQX\tQY\tQZ\n";
+            m_DumpStream->SetUnits("s\tm\tm\tm\t\t\t\t");
         }
     }
 
@@ -281,7 +279,7 @@ void Marker::Draw()
     if (m_FirstDraw)
     {
         m_FirstDraw = false;
-        m_PhysRep = new FacetedSphere(mRadius, 4);
+        m_PhysRep = new FacetedSphere(mRadius, 4, true); // drawn as an instance of the shared unit sphere
         m_PhysRep->SetColour(m_Colour);
     }
 
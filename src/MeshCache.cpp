@@ -0,0 +1,226 @@
+/*
+ *  MeshCache.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Binary cache files for parsed OBJ meshes plus an in memory store
+ *  of meshes that have been loaded in parallel ahead of use
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sstream>
+#include <thread>
+
+#include "MeshCache.h"
+#include "FacetedObject.h"
+
+// the cache file is a fixed header followed by the triangle vertices exactly as FacetedObject stores them
+// the OBJ file size and modification time are stored so that a changed OBJ file is parsed again
+// the modification time is in nanoseconds where the file system provides it so that an OBJ file
+// rewritten within the same second with the same size is still noticed
+struct MeshCacheHeader
+{
+    char magic[8];
+    uint64_t objSize;
+    int64_t objModificationTimeNs;
+    double verticesAsSpheresRadius;
+    uint32_t badMesh;
+    uint32_t numVertices;
+};
+
+static const char gMeshCacheMagic[8] = {'G', 'S', 'M', 'E', 'S', 'H', '2', 0};
+
+static int64_t ModificationTimeNs(const struct stat &fileStat)
+{
+#if defined(__APPLE__)
+    return (int64_t)fileStat.st_mtimespec.tv_sec * 1000000000 + fileStat.st_mtimespec.tv_nsec;
+#elif defined(_WIN32) || defined(WIN32)
+    return (int64_t)fileStat.st_mtime * 1000000000;
+#else
+    return (int64_t)fileStat.st_mtim.tv_sec * 1000000000 + fileStat.st_mtim.tv_nsec;
+#endif
+}
+
+MeshCache::MeshCache()
+{
+    m_UseCacheFiles = true;
+}
+
+MeshCache::~MeshCache()
+{
+    Clear();
+}
+
+MeshCache *MeshCache::GetCache()
+{
+    static MeshCache cache;
+    return &cache;
+}
+
+std::string MeshCache::Key(const char *filename, bool badMesh, double verticesAsSpheresRadius)
+{
+    std::ostringstream key;
+    key.precision(17);
+    key << filename << "\t" << badMesh << "\t" << verticesAsSpheresRadius;
+    return key.str();
+}
+
+// bad meshes are stored with different triangles so they get their own cache file
+std::string MeshCache::CacheFilename(const char *filename, bool badMesh)
+{
+    return std::string(filename) + (badMesh ? ".badmesh.meshcache" : ".meshcache");
+}
+
+// meshes that have been prefetched are copied from memory otherwise the cache file is tried
+bool MeshCache::Load(const char *filename, bool badMesh, double verticesAsSpheresRadius, FacetedObject *object)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        std::map<std::string, FacetedObject *>::const_iterator iter = m_MeshList.find(Key(filename, badMesh, verticesAsSpheresRadius));
+        if (iter != m_MeshList.end())
+        {
+            object->AddTriangles(iter->second->GetVertexList(), iter->second->GetNumVertices());
+            return false;
+        }
+    }
+    return ReadCacheFile(filename, badMesh, verticesAsSpheresRadius, object);
+}
+
+bool MeshCache::ReadCacheFile(const char *filename, bool badMesh, double verticesAsSpheresRadius, FacetedObject *object)
+{
+    if (m_UseCacheFiles == false) return true;
+
+    struct stat fileStat;
+    if (stat(filename, &fileStat)) return true;
+
+    std::string cacheFilename = CacheFilename(filename, badMesh);
+    FILE *in = fopen(cacheFilename.c_str(), "rb");
+    if (in == 0) return true;
+
+    MeshCacheHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 ||
+            memcmp(header.magic, gMeshCacheMagic, sizeof(gMeshCacheMagic)) != 0 ||
+            header.objSize != (uint64_t)fileStat.st_size ||
+            header.objModificationTimeNs != ModificationTimeNs(fileStat) ||
+            header.verticesAsSpheresRadius != verticesAsSpheresRadius ||
+            header.badMesh != (uint32_t)badMesh)
+    {
+        fclose(in);
+        return true;
+    }
+
+    std::vector<double> vertexList(header.numVertices * 3);
+    if (header.numVertices && fread(&vertexList[0], sizeof(double) * 3, header.numVertices, in) != header.numVertices)
+    {
+        fclose(in);
+        return true;
+    }
+    fclose(in);
+
+    if (header.numVertices) object->AddTriangles(&vertexList[0], header.numVertices);
+    return false;
+}
+
+// the file is written under a temporary name and then renamed so that a partly written file is never read
+// failure is not an error since the cache is only an optimisation (e.g. the OBJ files may be read only)
+bool MeshCache::WriteCacheFile(const char *filename, bool badMesh, double verticesAsSpheresRadius, FacetedObject *object)
+{
+    if (m_UseCacheFiles == false) return true;
+
+    struct stat fileStat;
+    if (stat(filename, &fileStat)) return true;
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, gMeshCacheMagic, sizeof(gMeshCacheMagic));
+    header.objSize = fileStat.st_size;
+    header.objModificationTimeNs = ModificationTimeNs(fileStat);
+    header.verticesAsSpheresRadius = verticesAsSpheresRadius;
+    header.badMesh = badMesh;
+    header.numVertices = object->GetNumVertices();
+
+    std::ostringstream tempFilename;
+    std::string cacheFilename = CacheFilename(filename, badMesh);
+    tempFilename << cacheFilename << "." << std::this_thread::get_id();
+    FILE *out = fopen(tempFilename.str().c_str(), "wb");
+    if (out == 0) return true;
+    bool error = (fwrite(&header, sizeof(header), 1, out) != 1);
+    if (error == false && header.numVertices)
+        error = (fwrite(object->GetVertexList(), sizeof(double) * 3, header.numVertices, out) != header.numVertices);
+    if (fclose(out)) error = true;
+    if (error == false)
+    {
+        remove(cacheFilename.c_str()); // needed on Windows where rename will not overwrite
+        error = (rename(tempFilename.str().c_str(), cacheFilename.c_str()) != 0);
+    }
+    if (error) remove(tempFilename.str().c_str());
+    return error;
+}
+
+// the meshes that are not already in memory are loaded by a group of threads
+// each of which takes the next request from the list until there are none left
+// meshes that are drawn as spheres are skipped because FacetedSphere is not thread safe
+// and any mesh that fails to load is left for the normal load so that the error is reported there
+void MeshCache::Prefetch(const std::vector<MeshRequest> &requestList)
+{
+    std::vector<MeshRequest> loadList;
+    for (size_t i = 0; i < requestList.size(); i++)
+    {
+        if (requestList[i].verticesAsSpheresRadius > 0) continue;
+        std::string key = Key(requestList[i].filename.c_str(), requestList[i].badMesh, requestList[i].verticesAsSpheresRadius);
+        if (m_MeshList.find(key) != m_MeshList.end()) continue;
+        size_t j;
+        for (j = 0; j < loadList.size(); j++)
+            if (Key(loadList[j].filename.c_str(), loadList[j].badMesh, loadList[j].verticesAsSpheresRadius) == key) break;
+        if (j == loadList.size()) loadList.push_back(requestList[i]);
+    }
+    if (loadList.size() == 0) return;
+
+    size_t numThreads = std::thread::hardware_concurrency();
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads > loadList.size()) numThreads = loadList.size();
+
+    size_t next = 0;
+    std::vector<std::thread> threadList;
+    for (size_t i = 1; i < numThreads; i++) threadList.push_back(std::thread(&MeshCache::PrefetchWorker, this, &loadList, &next));
+    PrefetchWorker(&loadList, &next);
+    for (size_t i = 0; i < threadList.size(); i++) threadList[i].join();
+}
+
+void MeshCache::PrefetchWorker(const std::vector<MeshRequest> *requestList, size_t *next)
+{
+    while (true)
+    {
+        size_t index;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (*next >= requestList->size()) return;
+            index = (*next)++;
+        }
+        const MeshRequest &request = (*requestList)[index];
+        FacetedObject *object = new FacetedObject();
+        object->SetBadMesh(request.badMesh);
+        object->SetVerticesAsSpheresRadius(request.verticesAsSpheresRadius);
+        if (object->ParseOBJFile(request.filename.c_str()))
+        {
+            delete object;
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_MeshList[Key(request.filename.c_str(), request.badMesh, request.verticesAsSpheresRadius)] = object;
+    }
+}
+
+void MeshCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::map<std::string, FacetedObject *>::const_iterator iter;
+    for (iter = m_MeshList.begin(); iter != m_MeshList.end(); iter++) delete iter->second;
+    m_MeshList.clear();
+}
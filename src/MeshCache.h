@@ -0,0 +1,63 @@
+/*
+ *  MeshCache.h
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Binary cache files for parsed OBJ meshes plus an in memory store
+ *  of meshes that have been loaded in parallel ahead of use
+ *
+ */
+
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+class FacetedObject;
+
+struct MeshRequest
+{
+    std::string filename;
+    bool badMesh;
+    double verticesAsSpheresRadius;
+};
+
+class MeshCache
+{
+public:
+    ~MeshCache();
+
+    static MeshCache *GetCache();
+
+    // the cache files are written next to the OBJ files as filename.meshcache (filename.badmesh.meshcache for bad meshes)
+    // the GaitSymQt preferences turn this on and off
+    void SetUseCacheFiles(bool useCacheFiles) { m_UseCacheFiles = useCacheFiles; }
+    bool GetUseCacheFiles() { return m_UseCacheFiles; }
+
+    // these return false on success (like ParseOBJFile) and add the triangles to object
+    bool Load(const char *filename, bool badMesh, double verticesAsSpheresRadius, FacetedObject *object);
+    bool ReadCacheFile(const char *filename, bool badMesh, double verticesAsSpheresRadius, FacetedObject *object);
+    bool WriteCacheFile(const char *filename, bool badMesh, double verticesAsSpheresRadius, FacetedObject *object);
+
+    // loads the meshes using several threads and keeps them until Clear is called
+    void Prefetch(const std::vector<MeshRequest> &requestList);
+    void Clear();
+
+protected:
+    MeshCache();
+
+    static std::string Key(const char *filename, bool badMesh, double verticesAsSpheresRadius);
+    static std::string CacheFilename(const char *filename, bool badMesh);
+    void PrefetchWorker(const std::vector<MeshRequest> *requestList, size_t *next);
+
+    bool m_UseCacheFiles;
+    std::map<std::string, FacetedObject *> m_MeshList;
+    std::mutex m_Mutex;
+};
+
+#endif // MESHCACHE_H
@@ -18,10 +18,12 @@ extern std::string gOBJName;
 #endif
 
 #include "Muscle.h"
+#include "Checkpoint.h"
 
 Muscle::Muscle(Strap *strap)
 {
     m_Strap = strap;
+    m_SubSteps = 1;
 #ifdef USE_QT
     m_ElasticEnergyColourFullScale = 50.0;
 #endif
@@ -33,6 +35,38 @@ Muscle::~Muscle()
     delete m_Strap;
 }
 
+// there is no previous length before the first step so the first step's sub-steps
+// use the initial length throughout rather than interpolating from zero
+void Muscle::LateInitialisation()
+{
+    CalculateStrap(0);
+    m_Strap->SetLastLength(m_Strap->GetLength());
+    m_Strap->SetName(m_Name + std::string("Strap"));
+}
+
+// the strap length is linearly interpolated from its last value to its current value
+// so a stiff tendon sees the movement spread over the sub-steps rather than all at once
+// the strap velocity is already the mean value over the step so it is not changed
+void Muscle::SubStepActivation(double activation, double duration)
+{
+    if (m_SubSteps <= 1)
+    {
+        SetActivation(activation, duration);
+        return;
+    }
+
+    double length = m_Strap->GetLength();
+    double lastLength = m_Strap->GetLastLength();
+    double subStepDuration = duration / m_SubSteps;
+    for (int i = 1; i < m_SubSteps; i++)
+    {
+        m_Strap->SetLength(lastLength + (length - lastLength) * i / m_SubSteps);
+        SetActivation(activation, subStepDuration);
+    }
+    m_Strap->SetLength(length);
+    SetActivation(activation, subStepDuration);
+}
+
 #ifdef USE_QT
 void Muscle::Draw()
 {
@@ -70,3 +104,15 @@ void Muscle::Draw()
     m_Strap->Draw();
 }
 #endif
+
+void Muscle::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    Drivable::WriteCheckpoint(checkpoint);
+    m_Strap->WriteCheckpoint(checkpoint);
+}
+
+void Muscle::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    Drivable::ReadCheckpoint(checkpoint);
+    m_Strap->ReadCheckpoint(checkpoint);
+}
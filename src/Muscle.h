@@ -31,6 +31,11 @@ public:
     void CalculateStrap(double deltaT) { m_Strap->Calculate(deltaT); }
 
     virtual void SetActivation(double activation, double  duration) = 0;
+
+    // this splits duration into sub-steps for the muscle dynamics
+    void SubStepActivation(double activation, double duration);
+    void SetSubSteps(int subSteps) { m_SubSteps = subSteps; }
+    int GetSubSteps() { return m_SubSteps; }
     virtual double GetActivation() = 0;
     virtual double GetMetabolicPower() = 0;
     virtual double GetElasticEnergy() = 0;
@@ -46,7 +51,7 @@ public:
         return m_Strap->SanityCheck(otherMuscle->m_Strap, axis, sanityCheckLeft, sanityCheckRight);
     }
 
-    virtual void LateInitialisation() { CalculateStrap(0); m_Strap->SetName(m_Name + std::string("Strap")); }
+    virtual void LateInitialisation();
 
 #ifdef USE_QT
     virtual void Draw();
@@ -54,9 +59,13 @@ public:
     const Colour *GetForceColour() { return &m_ForceColour; }
 #endif
 
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
+
 protected:
 
     Strap *m_Strap;
+    int m_SubSteps;
 
 #ifdef USE_QT
     Colour m_ForceColour;
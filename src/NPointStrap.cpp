@@ -305,17 +305,12 @@ NPointStrap::Draw()
 {
     if (m_Visible == false || gDrawMuscles == false) return;
 
-    const int kSides = 128;
-    FacetedPolyline *facetedPolyline;
     unsigned int i;
 
     if (gSimulation->GetTime() != m_LastDrawTime)
     {
         m_LastDrawTime = gSimulation->GetTime();
-        std::vector<FacetedObject *>::const_iterator iterFO;
-        for (iterFO = m_DrawList.begin(); iterFO != m_DrawList.end(); iterFO++)
-            delete *iterFO;
-        m_DrawList.clear();
+        unsigned int drawIndex = 0;
 
         std::vector<pgd::Vector> polyline;
         polyline.push_back(pgd::Vector(m_PointForceList[0]->point[0], m_PointForceList[0]->point[1], m_PointForceList[0]->point[2]));
@@ -324,9 +319,7 @@ NPointStrap::Draw()
             polyline.push_back(pgd::Vector(m_PointForceList[i]->point[0], m_PointForceList[i]->point[1], m_PointForceList[i]->point[2]));
         }
         polyline.push_back(pgd::Vector(m_PointForceList[1]->point[0], m_PointForceList[1]->point[1], m_PointForceList[1]->point[2]));
-        facetedPolyline = new FacetedPolyline(&polyline, m_Radius, kSides);
-        facetedPolyline->SetColour(m_Colour);
-        m_DrawList.push_back(facetedPolyline);
+        SetDrawPolyline(drawIndex++, &polyline, m_Radius, m_Colour);
 
         if (gDrawMuscleForces)
         {
@@ -336,11 +329,11 @@ NPointStrap::Draw()
                 pgd::Vector f = pgd::Vector(m_PointForceList[i]->vector[0], m_PointForceList[i]->vector[1], m_PointForceList[i]->vector[2]) * m_Tension * m_ForceScale;
                 polyline.push_back(pgd::Vector(m_PointForceList[i]->point[0], m_PointForceList[i]->point[1], m_PointForceList[i]->point[2]));
                 polyline.push_back(pgd::Vector(m_PointForceList[i]->point[0], m_PointForceList[i]->point[1], m_PointForceList[i]->point[2]) + f);
-                facetedPolyline = new FacetedPolyline(&polyline, m_ForceRadius, kSides);
-                facetedPolyline->SetColour(m_Colour);
-                m_DrawList.push_back(facetedPolyline);
+                SetDrawPolyline(drawIndex++, &polyline, m_ForceRadius, m_Colour);
             }
         }
+
+        TrimDrawList(drawIndex);
     }
 
     for (i = 0; i < m_DrawList.size(); i++)
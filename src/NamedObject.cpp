@@ -55,14 +55,12 @@ void NamedObject::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "NamedObject::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Name\tm_Visible\n";
+            m_DumpStream->SetUnits("\t");
         }
     }
 
@@ -72,6 +70,26 @@ void NamedObject::Dump()
     }
 }
 
+// the dump output goes to a group in the dump container if one is open
+// otherwise it goes to its own text file
+AsyncOutputStream *NamedObject::NewDumpStream()
+{
+    AsyncOutputStream *dumpStream = new AsyncOutputStream();
+    AsyncOutputWriter *writer = AsyncOutputWriter::GetExistingWriter();
+    if (writer && writer->GetDumpContainerOpen())
+    {
+        dumpStream->openDumpGroup(m_Name.c_str());
+    }
+    else
+    {
+        std::string filename(m_Name);
+        filename.append(".dump");
+        dumpStream->open(filename.c_str());
+    }
+    dumpStream->precision(17);
+    return dumpStream;
+}
+
 // this function initialises the data in the object based on the contents
 // of a libxml2 node. It uses information from the simulation as required
 // to satisfy dependencies
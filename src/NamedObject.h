@@ -19,12 +19,15 @@
 #include <libxml/xmlmemory.h>
 #include <libxml/parser.h>
 
+#include "AsyncOutputStream.h"
+
 #ifdef USE_QT
 #include "GLUtils.h"
 #endif
 
 class FacetedObject;
 class Simulation;
+class Checkpoint;
 
 class NamedObject
 {
@@ -58,6 +61,10 @@ public:
     virtual int XMLLoad(xmlNodePtr node);
     virtual xmlNodePtr XMLSave();
 
+    // the state that changes during a run (the values set up from the model file are not included)
+    virtual void WriteCheckpoint(Checkpoint * /* checkpoint */) {}
+    virtual void ReadCheckpoint(Checkpoint * /* checkpoint */) {}
+
 #ifdef USE_QT
     void SetAxisSize(float axisSize[3]) {m_AxisSize[0] = axisSize[0]; m_AxisSize[1] = axisSize[1]; m_AxisSize[2] = axisSize[2]; }
     void SetColour(Colour &colour) { m_Colour = colour; }
@@ -75,6 +82,8 @@ protected:
     void RemoveXMLAttribute(xmlNode *cur, const char *name);
     xmlAttrPtr FindXMLAttribute(xmlNode *cur, const char *name);
 
+    AsyncOutputStream *NewDumpStream();
+
     std::string m_Name;
     std::string m_Message;
 
@@ -82,7 +91,7 @@ protected:
 
     bool m_Dump;
     bool m_FirstDump;
-    std::ofstream *m_DumpStream;
+    AsyncOutputStream *m_DumpStream;
 
     bool m_CaseSensitiveXMLAttributes;
 
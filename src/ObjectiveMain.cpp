@@ -17,6 +17,7 @@
 #include <fstream>
 #include <sstream>
 #include <cfloat>
+#include <cmath>
 #include <time.h>
 #include <vector>
 #include <map>
@@ -24,6 +25,10 @@
 
 #if !defined(_WIN32) && !defined(WIN32)
 #include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <errno.h>
 #endif
 
 #include <ode/ode.h>
@@ -57,8 +62,19 @@
 #include "Driver.h"
 #include "Joint.h"
 #include "Muscle.h"
+#include "DampedSpringMuscle.h"
+#include "MAMuscle.h"
+#include "MAMuscleComplete.h"
+#include "MAMuscleExtended.h"
+#include "UGMMuscle.h"
 #include "Body.h"
 #include "Geom.h"
+#include "StepThreadPool.h"
+#include "PlaneCollider.h"
+#include "AsyncOutputStream.h"
+#include "FitnessCache.h"
+#include "SimulationBatch.h"
+#include "Checkpoint.h"
 
 #ifdef USE_UDP
 #include "UDP.h"
@@ -150,6 +166,34 @@ static char *gModelConfigFile = 0;
 static double gSimulationTimeLimit = -1;
 static int gRunTimeLimit = 0;
 static double gWarehouseFailDistanceAbort = 0;
+static char *gOutputDumpContainerFilenamePtr = 0;
+static bool gDumpContainerCompress = false;
+static int gStepThreads = 0;
+static int gStepThreadBenchmarkMax = 0;
+static bool gForkServer = false;
+static bool gFitnessCacheFlag = false;
+static char *gFitnessCacheFilenamePtr = 0;
+static int gFitnessCacheSize = 100000;
+static double gFitnessCacheQuantum = 0;
+static char *gBatchListFilenamePtr = 0;
+static int gBatchSize = 8;
+static bool gBatchCheck = false;
+static char *gCheckpointFilenamePtr = 0;
+static double gCheckpointInterval = 1;
+static char *gRestartFilenamePtr = 0;
+static int gBranchCount = 0;
+static double gBranchTime = 0;
+static double gBranchPerturbation = 0;
+static bool gBranchMinimum = false;
+static bool gSubStepCheck = false;
+static int gSubStepAccuracyMultiple = 0;
+static double gCheckpointCheckTime = -1;
+static int gMuscleBenchmarkCount = 0;
+static int gMuscleExpressionCheckCount = 0;
+static int gImplicitCheckMultiple = 0;
+static int gPlaneColliderCheckSteps = 0;
+static int gLoadBenchmarkCount = 0;
+static std::string gLoadBenchmarkModel;
 
 #ifndef USE_QT
 static double gLastTime = 0;
@@ -162,6 +206,60 @@ static XMLConverter gXMLConverter;
 
 static std::vector<std::string> gOutputList;
 
+static int LoadSimulation(DataFile *myFile, void *userData);
+static int NewSimulation(char *xmlData, void *userData);
+static int InitialiseSimulation();
+
+// the result of the last run when gSimulation is not available (fork server or fitness cache)
+static SimulationResult gResult;
+
+static FitnessCache *gFitnessCache = 0;
+static uint64_t gCacheKey = 0;
+static bool gCacheHit = false;
+static uint64_t CalculateCacheKey(const char *modelText, int genomeSize, const double *genomeData);
+
+#ifndef USE_QT
+static void SetDumpFlags();
+static void RunSimulation();
+static void RunBranches();
+static void RunBranch(int branch, SimulationResult *result);
+static void GetResult(SimulationResult *result);
+static int CheckSubSteps();
+static int CheckSubStepAccuracy();
+static int CheckCheckpoint();
+static int BenchmarkStepThreads();
+static int BenchmarkMuscles();
+static int CheckMuscleExpressions();
+static int CheckImplicitMuscles();
+static int CheckPlaneCollider();
+static int BenchmarkLoad();
+static bool FilesOrChecksRequested();
+#endif
+
+#if !defined(USE_QT) && !defined(USE_SOCKETS) && !defined(USE_UDP) && !defined(USE_TCP) && !defined(USE_MPI)
+#define BATCH_MODE_AVAILABLE
+static int RunBatch();
+#endif
+
+// forking is not safe with an MPI library that has already been initialised
+#if !defined(USE_QT) && !defined(USE_MPI) && !defined(_WIN32) && !defined(WIN32)
+#define FORK_SERVER_AVAILABLE
+
+// the values a fork server child sends back to the parent
+struct ForkResult
+{
+    SimulationResult result;
+    double cpuTimeSimulation;
+};
+
+static int ForkEvaluation(DataFile *myFile);
+static Simulation *gBaseSimulation = 0;
+static bool gBaseSimulationFailed = false;
+static void ForkBranches(std::vector<SimulationResult> *resultList);
+static bool ForkedBranchesAllowed();
+static void ResetChildAfterFork(bool restartStepThreads);
+#endif
+
 // hostlist globals
 struct Hosts
 {
@@ -230,6 +328,32 @@ int GaitSymMain(int argc, char *argv[])
     OpenCLRoutines::InitCL();
 #endif
 
+    // a cache hit returns before a Simulation exists so nothing would be written or checked
+    if (gFitnessCacheFlag && FilesOrChecksRequested())
+    {
+        std::cerr << "Warning: fitness cache not used because output files, dumps, checkpoints or checks are requested\n";
+        gFitnessCacheFlag = false;
+    }
+    if (gFitnessCacheFlag)
+    {
+        gFitnessCache = new FitnessCache(gFitnessCacheSize);
+        if (gFitnessCacheFilenamePtr && gFitnessCache->Open(gFitnessCacheFilenamePtr) == false) return 1;
+    }
+
+#ifdef BATCH_MODE_AVAILABLE
+    if (gBatchListFilenamePtr) return RunBatch();
+#endif
+
+#ifdef FORK_SERVER_AVAILABLE
+    if (gForkServer)
+    {
+        // initialise the libraries once here and the children inherit them
+        // the extra dInitODE2 means that ODE stays initialised when each Simulation calls dCloseODE
+        xmlInitParser();
+        dInitODE2(0);
+    }
+#endif
+
 #if defined(USE_SOCKETS) || defined(USE_UDP) || defined(USE_TCP)
     ParseHostlistFile();
 #endif
@@ -276,17 +400,75 @@ int GaitSymMain(int argc, char *argv[])
         {
             if (ReadModel() == 0)
             {
+                if (gSimulation == 0) // the result is already known (fork server or fitness cache)
+                {
+                    if (WriteModel()) return 0;
+                    continue;
+                }
                 gFinishedFlag = false;
-
-                for (unsigned int i = 0; i < gOutputList.size(); i++)
+                SetDumpFlags();
+                if (gSubStepCheck)
+                {
+                    int err = CheckSubSteps();
+                    delete gSimulation;
+                    gSimulation = 0;
+                    return err;
+                }
+                if (gSubStepAccuracyMultiple > 0)
                 {
-                    if (gSimulation->GetBodyList()->find(gOutputList[i]) != gSimulation->GetBodyList()->end()) (*gSimulation->GetBodyList())[gOutputList[i]]->SetDump(true);
-                    if (gSimulation->GetMuscleList()->find(gOutputList[i]) != gSimulation->GetMuscleList()->end()) (*gSimulation->GetMuscleList())[gOutputList[i]]->SetDump(true);
-                    if (gSimulation->GetGeomList()->find(gOutputList[i]) != gSimulation->GetGeomList()->end()) (*gSimulation->GetGeomList())[gOutputList[i]]->SetDump(true);
-                    if (gSimulation->GetJointList()->find(gOutputList[i]) != gSimulation->GetJointList()->end()) (*gSimulation->GetJointList())[gOutputList[i]]->SetDump(true);
-                    if (gSimulation->GetDriverList()->find(gOutputList[i]) != gSimulation->GetDriverList()->end()) (*gSimulation->GetDriverList())[gOutputList[i]]->SetDump(true);
-                    if (gSimulation->GetDataTargetList()->find(gOutputList[i]) != gSimulation->GetDataTargetList()->end()) (*gSimulation->GetDataTargetList())[gOutputList[i]]->SetDump(true);
-                    if (gSimulation->GetReporterList()->find(gOutputList[i]) != gSimulation->GetReporterList()->end()) (*gSimulation->GetReporterList())[gOutputList[i]]->SetDump(true);
+                    int err = CheckSubStepAccuracy();
+                    delete gSimulation;
+                    gSimulation = 0;
+                    return err;
+                }
+                if (gStepThreadBenchmarkMax > 0)
+                {
+                    int err = BenchmarkStepThreads();
+                    delete gSimulation;
+                    gSimulation = 0;
+                    return err;
+                }
+                if (gCheckpointCheckTime >= 0)
+                {
+                    int err = CheckCheckpoint();
+                    delete gSimulation;
+                    gSimulation = 0;
+                    return err;
+                }
+                if (gMuscleBenchmarkCount > 0)
+                {
+                    int err = BenchmarkMuscles();
+                    delete gSimulation;
+                    gSimulation = 0;
+                    return err;
+                }
+                if (gMuscleExpressionCheckCount > 0)
+                {
+                    int err = CheckMuscleExpressions();
+                    delete gSimulation;
+                    gSimulation = 0;
+                    return err;
+                }
+                if (gImplicitCheckMultiple > 0)
+                {
+                    int err = CheckImplicitMuscles();
+                    delete gSimulation;
+                    gSimulation = 0;
+                    return err;
+                }
+                if (gLoadBenchmarkCount > 0)
+                {
+                    int err = BenchmarkLoad();
+                    delete gSimulation;
+                    gSimulation = 0;
+                    return err;
+                }
+                if (gPlaneColliderCheckSteps > 0)
+                {
+                    int err = CheckPlaneCollider();
+                    delete gSimulation;
+                    gSimulation = 0;
+                    return err;
                 }
             }
 #ifndef USE_MPI
@@ -298,27 +480,694 @@ int GaitSymMain(int argc, char *argv[])
         }
         else
         {
-            gCurrentTime = Util::GetTime();
-            gIOTime += (gCurrentTime - gLastTime);
-            gLastTime = gCurrentTime;
-            while (gSimulation->ShouldQuit() == false)
+            RunSimulation();
+
+            gFinishedFlag = true;
+            if (WriteModel()) return 0;
+        }
+    }
+#endif
+    return 0;
+}
+
+static void SetDumpFlags()
+{
+    for (unsigned int i = 0; i < gOutputList.size(); i++)
+    {
+        if (gSimulation->GetBodyList()->find(gOutputList[i]) != gSimulation->GetBodyList()->end()) (*gSimulation->GetBodyList())[gOutputList[i]]->SetDump(true);
+        if (gSimulation->GetMuscleList()->find(gOutputList[i]) != gSimulation->GetMuscleList()->end()) (*gSimulation->GetMuscleList())[gOutputList[i]]->SetDump(true);
+        if (gSimulation->GetGeomList()->find(gOutputList[i]) != gSimulation->GetGeomList()->end()) (*gSimulation->GetGeomList())[gOutputList[i]]->SetDump(true);
+        if (gSimulation->GetJointList()->find(gOutputList[i]) != gSimulation->GetJointList()->end()) (*gSimulation->GetJointList())[gOutputList[i]]->SetDump(true);
+        if (gSimulation->GetDriverList()->find(gOutputList[i]) != gSimulation->GetDriverList()->end()) (*gSimulation->GetDriverList())[gOutputList[i]]->SetDump(true);
+        if (gSimulation->GetDataTargetList()->find(gOutputList[i]) != gSimulation->GetDataTargetList()->end()) (*gSimulation->GetDataTargetList())[gOutputList[i]]->SetDump(true);
+        if (gSimulation->GetReporterList()->find(gOutputList[i]) != gSimulation->GetReporterList()->end()) (*gSimulation->GetReporterList())[gOutputList[i]]->SetDump(true);
+    }
+}
+
+static void RunSimulation()
+{
+    gCurrentTime = Util::GetTime();
+    gIOTime += (gCurrentTime - gLastTime);
+    gLastTime = gCurrentTime;
+    if (gBranchCount > 0)
+    {
+        RunBranches();
+    }
+    else
+    {
+        while (gSimulation->ShouldQuit() == false)
+        {
+            gSimulation->UpdateSimulation();
+
+            if (gSimulation->TestForCatastrophy()) break;
+        }
+    }
+    gCurrentTime = Util::GetTime();
+    gSimulationTime += (gCurrentTime - gLastTime);
+    gLastTime = gCurrentTime;
+}
+
+// the shared part of the run is only simulated once and each branch starts from a copy of that state
+// the branches are run in turn from an in memory checkpoint or all at once in forked children
+// the combined result is left in gResult and gSimulation is deleted
+static void RunBranches()
+{
+    bool finished = false;
+    while (gSimulation->GetTime() < gBranchTime)
+    {
+        if (gSimulation->ShouldQuit())
+        {
+            finished = true;
+            break;
+        }
+        gSimulation->UpdateSimulation();
+        if (gSimulation->TestForCatastrophy())
+        {
+            finished = true;
+            break;
+        }
+    }
+
+    std::vector<SimulationResult> resultList(gBranchCount);
+    long long prefixStepCount = gSimulation->GetStepCount();
+    int i;
+    if (finished) // the run ended before the branch point so every branch has the same result
+    {
+        for (i = 0; i < gBranchCount; i++) GetResult(&resultList[i]);
+    }
+#ifdef FORK_SERVER_AVAILABLE
+    else if (gForkServer && ForkedBranchesAllowed())
+    {
+        ForkBranches(&resultList);
+    }
+#endif
+    else
+    {
+        Checkpoint prefix;
+        gSimulation->WriteCheckpoint(&prefix);
+        for (i = 0; i < gBranchCount; i++)
+        {
+            if (i > 0)
             {
-                gSimulation->UpdateSimulation();
+                prefix.Rewind();
+                gSimulation->ReadCheckpoint(&prefix);
+            }
+            RunBranch(i, &resultList[i]);
+        }
+    }
 
-                if (gSimulation->TestForCatastrophy()) break;
+    // failed branches (score -DBL_MAX) make the whole evaluation fail
+    gResult.score = gBranchMinimum ? DBL_MAX : 0;
+    gResult.simulationTime = 0;
+    gResult.stepCount = prefixStepCount;
+    gResult.mechanicalEnergy = 0;
+    gResult.metabolicEnergy = 0;
+    bool failed = false;
+    for (i = 0; i < gBranchCount; i++)
+    {
+        std::cerr << "Branch: " << i << " Simulation Time: " << resultList[i].simulationTime << " Score: " << resultList[i].score << "\n";
+        if (resultList[i].score == -DBL_MAX) failed = true;
+        if (gBranchMinimum) gResult.score = std::min(gResult.score, resultList[i].score);
+        else gResult.score += resultList[i].score / gBranchCount;
+        gResult.simulationTime += resultList[i].simulationTime / gBranchCount;
+        if (resultList[i].stepCount > prefixStepCount) gResult.stepCount += resultList[i].stepCount - prefixStepCount;
+        gResult.mechanicalEnergy += resultList[i].mechanicalEnergy / gBranchCount;
+        gResult.metabolicEnergy += resultList[i].metabolicEnergy / gBranchCount;
+    }
+    if (failed) gResult.score = -DBL_MAX;
+
+    delete gSimulation;
+    gSimulation = 0;
+}
+
+static void RunBranch(int branch, SimulationResult *result)
+{
+    if (gBranchPerturbation > 0) gSimulation->PerturbBodyVelocities(gBranchPerturbation, branch);
+    while (gSimulation->ShouldQuit() == false)
+    {
+        gSimulation->UpdateSimulation();
+
+        if (gSimulation->TestForCatastrophy()) break;
+    }
+    GetResult(result);
+}
+
+// the first step is run once with every muscle stepped in one go and once with the
+// sub-steps from the model and the muscle tensions are compared
+// there is no earlier strap length at the first step so the sub-steps should all see the
+// initial length and the only differences come from the finer integration of the muscle state
+static int CheckSubSteps()
+{
+    const double tolerance = 1e-3;
+    std::map<std::string, Muscle *> *muscleList = gSimulation->GetMuscleList();
+    std::map<std::string, Muscle *>::const_iterator iter;
+    std::vector<int> subStepList;
+    std::vector<double> tensionList;
+    unsigned int i;
+
+    Checkpoint start;
+    gSimulation->WriteCheckpoint(&start);
+    for (iter = muscleList->begin(); iter != muscleList->end(); iter++)
+    {
+        subStepList.push_back(iter->second->GetSubSteps());
+        iter->second->SetSubSteps(1);
+    }
+    gSimulation->UpdateSimulation();
+    for (iter = muscleList->begin(); iter != muscleList->end(); iter++) tensionList.push_back(iter->second->GetTension());
+
+    start.Rewind();
+    gSimulation->ReadCheckpoint(&start);
+    for (iter = muscleList->begin(), i = 0; iter != muscleList->end(); iter++, i++) iter->second->SetSubSteps(subStepList[i]);
+    gSimulation->UpdateSimulation();
+
+    int failures = 0;
+    double difference, maxDifference = 0;
+    for (iter = muscleList->begin(), i = 0; iter != muscleList->end(); iter++, i++)
+    {
+        if (subStepList[i] <= 1) continue;
+        difference = fabs(iter->second->GetTension() - tensionList[i]) / std::max(fabs(tensionList[i]), 1.0);
+        maxDifference = std::max(maxDifference, difference);
+        if (difference > tolerance)
+        {
+            std::cerr << "Sub-step check: MUSCLE " << iter->first << " tension " << tensionList[i] << " without sub-steps and " <<
+                         iter->second->GetTension() << " with " << subStepList[i] << " sub-steps\n";
+            failures++;
+        }
+    }
+    std::cerr << "Sub-step check: largest relative difference " << maxDifference << (failures ? " FAILED\n" : " passed\n");
+    return failures ? 1 : 0;
+}
+
+// the simulation is run to the end at the model step size and then from the start again at k times
+// the step size both without sub-steps and with every muscle using k times its sub-steps
+// (so the muscles integrate at the original step size) and the muscle tensions and body positions
+// are compared at the shared times
+// this is a report rather than a pass/fail test since larger steps change the rigid body results
+// but it fails if the sub-stepped run fails earlier than the reference run
+static int CheckSubStepAccuracy()
+{
+    std::map<std::string, Muscle *> *muscleList = gSimulation->GetMuscleList();
+    std::map<std::string, Body *> *bodyList = gSimulation->GetBodyList();
+    std::map<std::string, Muscle *>::const_iterator iter;
+    std::map<std::string, Body *>::const_iterator bodyIter;
+    std::vector<int> subStepList;
+    double stepSize = gSimulation->GetTimeIncrement();
+    int k = gSubStepAccuracyMultiple;
+    unsigned int i;
+
+    Checkpoint start;
+    gSimulation->WriteCheckpoint(&start);
+    for (iter = muscleList->begin(); iter != muscleList->end(); iter++) subStepList.push_back(iter->second->GetSubSteps());
+
+    // reference values at every kth step
+    std::vector<std::vector<double> > tensionList, positionList;
+    double peakTension = 0;
+    bool referenceFailed = false;
+    while (gSimulation->ShouldQuit() == false)
+    {
+        gSimulation->UpdateSimulation();
+        if (gSimulation->TestForCatastrophy())
+        {
+            referenceFailed = true;
+            break;
+        }
+        if (gSimulation->GetStepCount() % k) continue;
+        tensionList.push_back(std::vector<double>());
+        for (iter = muscleList->begin(); iter != muscleList->end(); iter++)
+        {
+            tensionList.back().push_back(iter->second->GetTension());
+            peakTension = std::max(peakTension, fabs(iter->second->GetTension()));
+        }
+        positionList.push_back(std::vector<double>());
+        for (bodyIter = bodyList->begin(); bodyIter != bodyList->end(); bodyIter++)
+            positionList.back().insert(positionList.back().end(), bodyIter->second->GetPosition(), bodyIter->second->GetPosition() + 3);
+    }
+    double referenceEndTime = gSimulation->GetTime();
+    if (peakTension == 0) peakTension = 1;
+
+    // 0 is without sub-steps and 1 is with k times the sub-steps
+    double rmsTensionError[2], maxPositionError[2], endTime[2];
+    bool failed[2];
+    gSimulation->SetTimeIncrement(stepSize * k);
+    for (int run = 0; run < 2; run++)
+    {
+        start.Rewind();
+        gSimulation->ReadCheckpoint(&start);
+        for (iter = muscleList->begin(), i = 0; iter != muscleList->end(); iter++, i++) iter->second->SetSubSteps(run ? subStepList[i] * k : 1);
+        double sumSquares = 0;
+        size_t count = 0, sample = 0;
+        maxPositionError[run] = 0;
+        failed[run] = false;
+        while (gSimulation->ShouldQuit() == false && sample < tensionList.size())
+        {
+            gSimulation->UpdateSimulation();
+            if (gSimulation->TestForCatastrophy())
+            {
+                failed[run] = true;
+                break;
+            }
+            for (iter = muscleList->begin(), i = 0; iter != muscleList->end(); iter++, i++)
+            {
+                double error = (iter->second->GetTension() - tensionList[sample][i]) / peakTension;
+                sumSquares += error * error;
+                count++;
             }
-            gCurrentTime = Util::GetTime();
-            gSimulationTime += (gCurrentTime - gLastTime);
-            gLastTime = gCurrentTime;
+            for (bodyIter = bodyList->begin(), i = 0; bodyIter != bodyList->end(); bodyIter++, i += 3)
+            {
+                const double *p = bodyIter->second->GetPosition();
+                const double *q = &positionList[sample][i];
+                double distance = sqrt((p[0] - q[0]) * (p[0] - q[0]) + (p[1] - q[1]) * (p[1] - q[1]) + (p[2] - q[2]) * (p[2] - q[2]));
+                maxPositionError[run] = std::max(maxPositionError[run], distance);
+            }
+            sample++;
+        }
+        rmsTensionError[run] = count ? sqrt(sumSquares / count) : 0;
+        endTime[run] = gSimulation->GetTime();
+    }
 
-            gFinishedFlag = true;
-            if (WriteModel()) return 0;
+    gSimulation->SetTimeIncrement(stepSize);
+    for (iter = muscleList->begin(), i = 0; iter != muscleList->end(); iter++, i++) iter->second->SetSubSteps(subStepList[i]);
+
+    for (int run = 0; run < 2; run++)
+    {
+        std::cerr << "Sub-step accuracy check: step " << stepSize * k << (run ? " with sub-steps" : " without sub-steps") <<
+                     " RMS tension error " << rmsTensionError[run] << " of peak tension largest body position error " << maxPositionError[run] <<
+                     " m" << (failed[run] ? " failed at time " : " to time ") << endTime[run] << "\n";
+    }
+    bool fail = failed[1] && (referenceFailed == false || endTime[1] < referenceEndTime);
+    std::cerr << "Sub-step accuracy check: reference step " << stepSize << (referenceFailed ? " failed at time " : " to time ") << referenceEndTime <<
+                 (fail ? " FAILED\n" : " passed\n");
+    return fail ? 1 : 0;
+}
+
+// the simulation is run to the check time and checkpointed and then run to the end
+// the checkpoint is then restored and the simulation run to the end again and the two final states
+// have to be identical to the last bit (restoring into the same simulation means that everything
+// the first run changed after the checkpoint has to be put back by the restore)
+static int CheckCheckpoint()
+{
+    while (gSimulation->ShouldQuit() == false && gSimulation->GetTime() < gCheckpointCheckTime)
+    {
+        gSimulation->UpdateSimulation();
+        if (gSimulation->TestForCatastrophy()) break;
+    }
+    Checkpoint resume;
+    gSimulation->WriteCheckpoint(&resume);
+    long long resumeStepCount = gSimulation->GetStepCount();
+
+    Checkpoint uninterrupted;
+    while (gSimulation->ShouldQuit() == false)
+    {
+        gSimulation->UpdateSimulation();
+        if (gSimulation->TestForCatastrophy()) break;
+    }
+    gSimulation->WriteCheckpoint(&uninterrupted);
+
+    Checkpoint resumed;
+    resume.Rewind();
+    gSimulation->ReadCheckpoint(&resume);
+    while (gSimulation->ShouldQuit() == false)
+    {
+        gSimulation->UpdateSimulation();
+        if (gSimulation->TestForCatastrophy()) break;
+    }
+    gSimulation->WriteCheckpoint(&resumed);
+
+    bool same = resumed.Matches(&uninterrupted);
+    std::cerr << "Checkpoint check: resumed at step " << resumeStepCount << " and finished at step " << gSimulation->GetStepCount() <<
+                 (same ? " identical to the uninterrupted run passed\n" : " different from the uninterrupted run FAILED\n");
+    return same ? 0 : 1;
+}
+
+// the whole run is timed with the world stepped by 1, 2, 4 ... n threads starting from the same checkpoint
+// and the final state of each run has to be identical to the single threaded run
+static int BenchmarkStepThreads()
+{
+    StepThreadPool *pool = StepThreadPool::GetPool();
+    dWorldID world = gSimulation->GetWorldID();
+    int savedOverride = pool->GetThreadCountOverride();
+    Checkpoint start;
+    gSimulation->WriteCheckpoint(&start);
+
+    Checkpoint reference;
+    double referenceTime = 0;
+    int failures = 0;
+    for (int threadCount = 1; threadCount <= gStepThreadBenchmarkMax; threadCount *= 2)
+    {
+        pool->Detach(world);
+        pool->SetThreadCountOverride(threadCount);
+        pool->Attach(world, threadCount);
+        int actualThreadCount = std::max(pool->GetThreadCount(), 1);
+
+        start.Rewind();
+        gSimulation->ReadCheckpoint(&start);
+        double startTime = Util::GetTime();
+        while (gSimulation->ShouldQuit() == false)
+        {
+            gSimulation->UpdateSimulation();
+            if (gSimulation->TestForCatastrophy()) break;
         }
+        double runTime = Util::GetTime() - startTime;
+
+        bool same = true;
+        if (threadCount == 1)
+        {
+            gSimulation->WriteCheckpoint(&reference);
+            referenceTime = runTime;
+        }
+        else
+        {
+            Checkpoint finish;
+            gSimulation->WriteCheckpoint(&finish);
+            same = finish.Matches(&reference);
+            if (same == false) failures++;
+        }
+        std::cerr << "Step thread benchmark: " << threadCount << " threads (" << actualThreadCount << " running) " << gSimulation->GetStepCount() <<
+                     " steps " << runTime << " s speedup " << referenceTime / runTime << (same ? "\n" : " final state differs from 1 thread\n");
+    }
+
+    pool->Detach(world);
+    pool->SetThreadCountOverride(savedOverride);
+    pool->Attach(world, savedOverride > 0 ? savedOverride : 1);
+    std::cerr << "Step thread benchmark: " << (failures ? "results differ FAILED\n" : "results identical passed\n");
+    return failures ? 1 : 0;
+}
+
+// times SetActivation (the per step muscle calculation) for each muscle type in the model
+// the first step is run so that the straps have a length and velocity and then every muscle
+// is called count times with a range of activations so that all the branches are used
+static int BenchmarkMuscles()
+{
+    const double activationList[] = {0.0, 0.05, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 0.75, 0.25, 0.5, 0.0};
+    const int numActivations = sizeof(activationList) / sizeof(activationList[0]);
+    std::map<std::string, Muscle *> *muscleList = gSimulation->GetMuscleList();
+    std::map<std::string, Muscle *>::const_iterator iter;
+    std::map<std::string, double> timeList;
+    std::map<std::string, int> muscleCountList;
+    double stepSize = gSimulation->GetTimeIncrement();
+
+    gSimulation->UpdateSimulation();
+    for (iter = muscleList->begin(); iter != muscleList->end(); iter++)
+    {
+        Muscle *muscle = iter->second;
+        std::string type;
+        if (dynamic_cast<MAMuscle *>(muscle)) type = "MAMuscle";
+        else if (dynamic_cast<MAMuscleComplete *>(muscle)) type = "MAMuscleComplete";
+        else if (dynamic_cast<MAMuscleExtended *>(muscle)) type = "MAMuscleExtended";
+        else if (dynamic_cast<UGMMuscle *>(muscle)) type = "UGMMuscle";
+        else if (dynamic_cast<DampedSpringMuscle *>(muscle)) type = "DampedSpringMuscle";
+        else type = "Other";
+
+        double start = Util::GetTime();
+        for (int i = 0; i < gMuscleBenchmarkCount; i++) muscle->SetActivation(activationList[i % numActivations], stepSize);
+        timeList[type] += Util::GetTime() - start;
+        muscleCountList[type]++;
+    }
+
+    for (std::map<std::string, double>::const_iterator timeIter = timeList.begin(); timeIter != timeList.end(); timeIter++)
+    {
+        int calls = muscleCountList[timeIter->first] * gMuscleBenchmarkCount;
+        std::cerr << "Muscle benchmark: " << timeIter->first << " " << muscleCountList[timeIter->first] << " muscles " <<
+                     calls << " calls " << 1e9 * timeIter->second / calls << " ns per call\n";
     }
+    return 0;
+}
+
+// checks that the factored MAMuscleExtended force calculation gives bit identical results
+// to the original Mathematica expressions for every MAMuscleExtended in the model
+static int CheckMuscleExpressions()
+{
+    std::map<std::string, Muscle *> *muscleList = gSimulation->GetMuscleList();
+    std::map<std::string, Muscle *>::const_iterator iter;
+    int muscleCount = 0;
+    long long totalMismatches = 0;
+
+    gSimulation->UpdateSimulation();
+    for (iter = muscleList->begin(); iter != muscleList->end(); iter++)
+    {
+        MAMuscleExtended *muscle = dynamic_cast<MAMuscleExtended *>(iter->second);
+        if (muscle == 0) continue;
+        double maxRelativeError;
+        int mismatches = muscle->CheckFactoredExpressions(gMuscleExpressionCheckCount, &maxRelativeError);
+        if (mismatches) std::cerr << "Muscle expression check: " << iter->first << " " << mismatches << " of " << gMuscleExpressionCheckCount <<
+                                     " samples differ maximum relative error " << maxRelativeError << "\n";
+        totalMismatches += mismatches;
+        muscleCount++;
+    }
+
+    std::cerr << "Muscle expression check: " << muscleCount << " MAMuscleExtended muscles " << (long long)muscleCount * gMuscleExpressionCheckCount <<
+                 " samples " << totalMismatches << " not bit identical" << ((totalMismatches || muscleCount == 0) ? " FAILED\n" : " passed\n");
+    return (totalMismatches || muscleCount == 0) ? 1 : 0;
+}
+
+// the model is run with every UGMMuscle using the explicit integrator at the model step size
+// and the strap lengths, stimulations and tensions are recorded as the reference
+// each muscle is then replayed on its own from its starting state with the recorded lengths
+// and stimulations at k times the step size with the explicit and the implicit integrators
+// and the tension errors are given relative to the peak reference tension
+// the replay at the model step size has to reproduce the reference exactly
+static int CheckImplicitMuscles()
+{
+    const double tolerance = 0.05;
+    std::map<std::string, Muscle *> *muscleList = gSimulation->GetMuscleList();
+    std::map<std::string, Muscle *>::const_iterator iter;
+    std::vector<UGMMuscle *> ugmList;
+    std::vector<std::string> nameList;
+    std::vector<UGMMuscle::Integrator> integratorList;
+    std::vector<int> subStepList;
+    std::vector<Checkpoint *> startList;
+    double stepSize = gSimulation->GetTimeIncrement();
+    int k = gImplicitCheckMultiple;
+    unsigned int i;
+    size_t j;
+
+    for (iter = muscleList->begin(); iter != muscleList->end(); iter++)
+    {
+        UGMMuscle *muscle = dynamic_cast<UGMMuscle *>(iter->second);
+        if (muscle == 0) continue;
+        ugmList.push_back(muscle);
+        nameList.push_back(iter->first);
+        integratorList.push_back(muscle->GetIntegrator());
+        subStepList.push_back(muscle->GetSubSteps());
+        muscle->SetIntegrator(UGMMuscle::explicitEuler);
+        muscle->SetSubSteps(1);
+        startList.push_back(new Checkpoint());
+        muscle->WriteCheckpoint(startList.back());
+    }
+    if (ugmList.size() == 0)
+    {
+        std::cerr << "Implicit check: no UGMMuscle in the model FAILED\n";
+        return 1;
+    }
+
+    // the muscles use the strap length from the end of the previous step
+    std::vector<std::vector<double> > lengthList(ugmList.size()), stimList(ugmList.size()), tensionList(ugmList.size());
+    while (gSimulation->ShouldQuit() == false)
+    {
+        for (i = 0; i < ugmList.size(); i++) lengthList[i].push_back(ugmList[i]->GetLength());
+        gSimulation->UpdateSimulation();
+        for (i = 0; i < ugmList.size(); i++)
+        {
+            stimList[i].push_back(ugmList[i]->GetStimulation());
+            tensionList[i].push_back(ugmList[i]->GetTension());
+        }
+        if (gSimulation->TestForCatastrophy()) break;
+    }
+
+    int failures = 0;
+    double worstExplicit = 0, worstImplicit = 0;
+    for (i = 0; i < ugmList.size(); i++)
+    {
+        UGMMuscle *muscle = ugmList[i];
+        double peak = 0;
+        for (j = 0; j < tensionList[i].size(); j++) peak = std::max(peak, fabs(tensionList[i][j]));
+        if (peak == 0) peak = 1;
+
+        // 0 is the explicit replay at the model step size and 1 and 2 are explicit and implicit at k times the step size
+        double rmsError[3];
+        for (int run = 0; run < 3; run++)
+        {
+            int stride = run ? k : 1;
+            startList[i]->Rewind();
+            muscle->ReadCheckpoint(startList[i]);
+            muscle->SetIntegrator(run == 2 ? UGMMuscle::implicitEuler : UGMMuscle::explicitEuler);
+            double sumSquares = 0;
+            size_t count = 0;
+            for (j = stride - 1; j < tensionList[i].size(); j += stride)
+            {
+                muscle->GetStrap()->SetLength(lengthList[i][j]);
+                muscle->SetActivation(stimList[i][j], stepSize * stride);
+                double error = (muscle->GetTension() - tensionList[i][j]) / peak;
+                sumSquares += error * error;
+                count++;
+            }
+            rmsError[run] = count ? sqrt(sumSquares / count) : 0;
+        }
+
+        bool failed = rmsError[0] != 0 || !(rmsError[2] <= tolerance);
+        if (failed) failures++;
+        worstExplicit = std::max(worstExplicit, rmsError[1]);
+        if (!(rmsError[2] <= worstImplicit)) worstImplicit = rmsError[2];
+        std::cerr << "Implicit check: MUSCLE " << nameList[i] << " replay error " << rmsError[0] << " RMS error at " << k <<
+                     "x step size explicit " << rmsError[1] << " implicit " << rmsError[2] << (failed ? " FAILED\n" : "\n");
+
+        startList[i]->Rewind();
+        muscle->ReadCheckpoint(startList[i]);
+        muscle->SetIntegrator(integratorList[i]);
+        muscle->SetSubSteps(subStepList[i]);
+        delete startList[i];
+    }
+
+    std::cerr << "Implicit check: " << ugmList.size() << " UGMMuscle muscles " << tensionList[0].size() << " steps largest RMS error at " << k <<
+                 "x step size explicit " << worstExplicit << " implicit " << worstImplicit << (failures ? " FAILED\n" : " passed\n");
+    return failures ? 1 : 0;
+}
+
+static bool SameContactGeom(const dContactGeom *a, const dContactGeom *b)
+{
+    // the fourth element of the vectors is padding and is not always set
+    return memcmp(a->pos, b->pos, 3 * sizeof(dReal)) == 0 && memcmp(a->normal, b->normal, 3 * sizeof(dReal)) == 0 &&
+            memcmp(&a->depth, &b->depth, sizeof(dReal)) == 0 && a->g1 == b->g1 && a->g2 == b->g2 && a->side1 == b->side1 && a->side2 == b->side2;
+}
+
+// for the first n steps of the run every geom in the space is collided with every plane using
+// PlaneCollider::Collide and dCollide and the contacts have to be identical to the last bit
+// each collider is also called repeatedly on the same pairs to give the contacts per second
+static int CheckPlaneCollider()
+{
+    const int repeats = 100;
+    dSpaceID space = gSimulation->GetSpaceID();
+    const int maxContacts = 16; // the same as Simulation::m_MaxContacts
+    std::vector<dContactGeom> fastContacts(maxContacts), odeContacts(maxContacts);
+    long long pairCount = 0, contactCount = 0, unhandledCount = 0, differentCount = 0;
+    double fastTime = 0, odeTime = 0;
+
+    for (int step = 0; step < gPlaneColliderCheckSteps && gSimulation->ShouldQuit() == false; step++)
+    {
+        gSimulation->UpdateSimulation();
+        if (gSimulation->TestForCatastrophy()) break;
+
+        std::vector<dGeomID> planeList, geomList;
+        for (int i = 0; i < dSpaceGetNumGeoms(space); i++)
+        {
+            dGeomID geom = dSpaceGetGeom(space, i);
+            if (dGeomIsSpace(geom)) continue;
+            if (dGeomGetClass(geom) == dPlaneClass) planeList.push_back(geom);
+            else geomList.push_back(geom);
+        }
+
+        for (unsigned int p = 0; p < planeList.size(); p++)
+        {
+            for (unsigned int g = 0; g < geomList.size(); g++)
+            {
+                int fastCount = PlaneCollider::Collide(geomList[g], planeList[p], maxContacts, &fastContacts[0], sizeof(dContactGeom));
+                if (fastCount < 0)
+                {
+                    unhandledCount++;
+                    continue;
+                }
+                int odeCount = dCollide(geomList[g], planeList[p], maxContacts, &odeContacts[0], sizeof(dContactGeom));
+                bool same = (fastCount == odeCount);
+                for (int c = 0; same && c < fastCount; c++) same = SameContactGeom(&fastContacts[c], &odeContacts[c]);
+                if (same == false)
+                {
+                    if (differentCount < 10) std::cerr << "Plane collider check: step " << gSimulation->GetStepCount() << " geom class " <<
+                                                          dGeomGetClass(geomList[g]) << " " << fastCount << " contacts and dCollide " << odeCount << " contacts differ\n";
+                    differentCount++;
+                }
+                pairCount++;
+                contactCount += odeCount;
+
+                double start = Util::GetTime();
+                for (int r = 0; r < repeats; r++) PlaneCollider::Collide(geomList[g], planeList[p], maxContacts, &fastContacts[0], sizeof(dContactGeom));
+                fastTime += Util::GetTime() - start;
+                start = Util::GetTime();
+                for (int r = 0; r < repeats; r++) dCollide(geomList[g], planeList[p], maxContacts, &odeContacts[0], sizeof(dContactGeom));
+                odeTime += Util::GetTime() - start;
+            }
+        }
+    }
+
+    double calls = double(pairCount) * repeats;
+    double contacts = double(contactCount) * repeats;
+    std::cerr << "Plane collider check: " << pairCount << " pairs " << contactCount << " contacts " << unhandledCount << " pairs not handled " <<
+                 differentCount << " pairs differ\n";
+    if (pairCount)
+        std::cerr << "Plane collider check: PlaneCollider " << 1e9 * fastTime / calls << " ns per pair " << contacts / fastTime << " contacts/s dCollide " <<
+                     1e9 * odeTime / calls << " ns per pair " << contacts / odeTime << " contacts/s\n";
+    bool failed = (differentCount > 0 || pairCount == 0);
+    std::cerr << "Plane collider check: " << (failed ? "FAILED\n" : "passed\n");
+    return failed ? 1 : 0;
+}
+
+// the model that has just been loaded is deleted and loaded again n times to give the setup time
+// for each evaluation (parsing and building the model) and the peak resident set size
+// (ru_maxrss is in kB on Linux and bytes on macOS) which should not grow after the first load
+static int BenchmarkLoad()
+{
+#if !defined(_WIN32) && !defined(WIN32)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long firstPeakRSS = usage.ru_maxrss;
+#endif
+    double totalTime = 0, fastestTime = DBL_MAX, parseTime = 0;
+    std::vector<char> modelText(gLoadBenchmarkModel.size() + 1);
+    for (int i = 0; i < gLoadBenchmarkCount; i++)
+    {
+        delete gSimulation;
+        gSimulation = 0;
+        memcpy(&modelText[0], gLoadBenchmarkModel.c_str(), modelText.size());
+        double start = Util::GetTime();
+        // NewSimulation is the XML parse and InitialiseSimulation the options applied afterwards
+        int err = NewSimulation(&modelText[0], 0);
+        parseTime += Util::GetTime() - start;
+        if (err || InitialiseSimulation())
+        {
+            std::cerr << "Load benchmark: model failed to load FAILED\n";
+            return 1;
+        }
+        double loadTime = Util::GetTime() - start;
+        totalTime += loadTime;
+        fastestTime = std::min(fastestTime, loadTime);
+    }
+    std::cerr << "Load benchmark: " << gLoadBenchmarkModel.size() << " bytes " << gLoadBenchmarkCount << " loads mean " <<
+                 1e3 * totalTime / gLoadBenchmarkCount << " ms fastest " << 1e3 * fastestTime << " ms of which parsing " <<
+                 1e3 * parseTime / gLoadBenchmarkCount << " ms\n";
+    std::cerr << "Load benchmark: " << gSimulation->GetStoredModelBytes() << " bytes of element text kept for the model state output\n";
+#if !defined(_WIN32) && !defined(WIN32)
+    getrusage(RUSAGE_SELF, &usage);
+    std::cerr << "Load benchmark: peak RSS " << firstPeakRSS << " after the first load and " << usage.ru_maxrss << " after " <<
+                 gLoadBenchmarkCount << " more loads\n";
 #endif
     return 0;
 }
 
+// true if the run has to happen in this process because it writes files or runs a check
+static bool FilesOrChecksRequested()
+{
+    if (gOutputKinematicsFilenamePtr || gOutputModelStateFilenamePtr || gOutputWarehouseFilenamePtr) return true;
+    if (gOutputModelStateAtTime >= 0 || gOutputModelStateAtCycle >= 0 || gOutputModelStateAtWarehouseDistance >= 0) return true;
+    if (gOutputDumpContainerFilenamePtr || gOutputList.size() || gCheckpointFilenamePtr || gDebug != NoDebug) return true;
+    if (gSubStepCheck || gSubStepAccuracyMultiple > 0 || gCheckpointCheckTime >= 0 || gMuscleBenchmarkCount > 0) return true;
+    if (gMuscleExpressionCheckCount > 0 || gImplicitCheckMultiple > 0 || gPlaneColliderCheckSteps > 0 || gStepThreadBenchmarkMax > 0) return true;
+    if (gLoadBenchmarkCount > 0) return true;
+    return false;
+}
+
+static void GetResult(SimulationResult *result)
+{
+    if (gSimulation == 0)
+    {
+        *result = gResult;
+        return;
+    }
+    result->score = gSimulation->CalculateInstantaneousFitness();
+    result->simulationTime = gSimulation->GetTime();
+    result->stepCount = gSimulation->GetStepCount();
+    result->mechanicalEnergy = gSimulation->GetMechanicalEnergy();
+    result->metabolicEnergy = gSimulation->GetMetabolicEnergy();
+}
+
 #endif
 
 void ParseArguments(int argc, char ** argv)
@@ -344,6 +1193,33 @@ void ParseArguments(int argc, char ** argv)
     gSimulationTimeLimit = -1;
     gRunTimeLimit = 0;
     gWarehouseFailDistanceAbort = 0;
+    gOutputDumpContainerFilenamePtr = 0;
+    gDumpContainerCompress = false;
+    gStepThreads = 0;
+    gStepThreadBenchmarkMax = 0;
+    gForkServer = false;
+    gFitnessCacheFlag = false;
+    gFitnessCacheFilenamePtr = 0;
+    gFitnessCacheSize = 100000;
+    gFitnessCacheQuantum = 0;
+    gBatchListFilenamePtr = 0;
+    gBatchSize = 8;
+    gBatchCheck = false;
+    gCheckpointFilenamePtr = 0;
+    gCheckpointInterval = 1;
+    gRestartFilenamePtr = 0;
+    gBranchCount = 0;
+    gBranchTime = 0;
+    gBranchPerturbation = 0;
+    gBranchMinimum = false;
+    gSubStepCheck = false;
+    gSubStepAccuracyMultiple = 0;
+    gCheckpointCheckTime = -1;
+    gMuscleBenchmarkCount = 0;
+    gMuscleExpressionCheckCount = 0;
+    gImplicitCheckMultiple = 0;
+    gPlaneColliderCheckSteps = 0;
+    gLoadBenchmarkCount = 0;
 
     int i;
 
@@ -368,201 +1244,499 @@ void ParseArguments(int argc, char ** argv)
                 std::cerr << "Error parsing score filename\n";
                 exit(1);
             }
-            gScoreFilenamePtr = argv[i];
-        }
+            gScoreFilenamePtr = argv[i];
+        }
+        else
+            if (strcmp(argv[i], "--config") == 0 ||
+                strcmp(argv[i], "-c") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing config filename\n";
+                    exit(1);
+                }
+                gConfigFilenamePtr = argv[i];
+            }
+        else
+            if (strcmp(argv[i], "--graphicsRoot") == 0 ||
+                strcmp(argv[i], "-g") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing graphics root directory\n";
+                    exit(1);
+                }
+                gGraphicsRoot = argv[i];
+            }
+        else
+            if (strcmp(argv[i], "--debug") == 0 ||
+                strcmp(argv[i], "-d") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing debug level\n";
+                    exit(1);
+                }
+                gDebug = (DebugControl)strtol(argv[i], 0, 10);
+            }
+        else
+            if (strcmp(argv[i], "--debugFunctionFilter") == 0 ||
+                strcmp(argv[i], "-df") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing debugFunctionFilter\n";
+                    exit(1);
+                }
+                gDebugFunctionFilter = argv[i];
+            }
+        else
+            if (strcmp(argv[i], "--debugNameFilter") == 0 ||
+                strcmp(argv[i], "-dn") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing debugNameFilter\n";
+                    exit(1);
+                }
+                gDebugNameFilter = argv[i];
+            }
+        else
+            if (strcmp(argv[i], "--outputName") == 0 ||
+                strcmp(argv[i], "-on") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing debugNameFilter\n";
+                    exit(1);
+                }
+                gOutputList.push_back(std::string(argv[i]));
+            }
+        else
+            if (strcmp(argv[i], "--windowSize") == 0 ||
+                strcmp(argv[i], "-w") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing window size x\n";
+                    exit(1);
+                }
+                gWindowWidth = strtol(argv[i], 0, 10);
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing window size y\n";
+                    exit(1);
+                }
+                gWindowHeight = strtol(argv[i], 0, 10);
+            }
+        else
+            if (strcmp(argv[i], "--framGrabWindowSize") == 0 ||
+                strcmp(argv[i], "-W") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing window size x\n";
+                    exit(1);
+                }
+                gFrameGrabWindowWidth = strtol(argv[i], 0, 10);
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing window size y\n";
+                    exit(1);
+                }
+                gFrameGrabWindowHeight = strtol(argv[i], 0, 10);
+            }
+        else
+            if (strcmp(argv[i], "--displaySkip") == 0 ||
+                strcmp(argv[i], "-S") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing --displaySkip\n";
+                    exit(1);
+                }
+                gDisplaySkip = strtol(argv[i], 0, 10);
+            }
+        else
+            if (strcmp(argv[i], "--fieldOfView") == 0 ||
+                strcmp(argv[i], "-f") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing --fieldOfView\n";
+                    exit(1);
+                }
+                gFOV = strtod(argv[i], 0);
+            }
+        else
+            if (strcmp(argv[i], "--cameraDistance") == 0 ||
+                strcmp(argv[i], "-D") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing --cameraDistance\n";
+                    exit(1);
+                }
+                gCameraDistance = strtod(argv[i], 0);
+            }
+        else
+            if (strcmp(argv[i], "--hostList") == 0 ||
+                strcmp(argv[i], "-L") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing --hostList\n";
+                    exit(1);
+                }
+                gHostlistFilenamePtr = argv[i];
+            }
+        else
+            if (strcmp(argv[i], "--runTimeLimit") == 0 ||
+                strcmp(argv[i], "-r") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing --runTimeLimit\n";
+                    exit(1);
+                }
+                gRunTimeLimit = strtol(argv[i], 0, 10);
+            }
+        else
+            if (strcmp(argv[i], "--warehouseFailDistanceAbort") == 0 ||
+                strcmp(argv[i], "-WF") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing --warehouseFailDistanceAbort\n";
+                    exit(1);
+                }
+                gWarehouseFailDistanceAbort = strtod(argv[i], 0);
+            }
+        else
+            if (strcmp(argv[i], "--outputKinematics") == 0 ||
+                strcmp(argv[i], "-K") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing output kinematics filename\n";
+                    exit(1);
+                }
+                gOutputKinematicsFilenamePtr = argv[i];
+            }
+        else
+            if (strcmp(argv[i], "--outputDumpContainer") == 0 ||
+                strcmp(argv[i], "-DC") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing output dump container filename\n";
+                    exit(1);
+                }
+                gOutputDumpContainerFilenamePtr = argv[i];
+            }
+        else
+            if (strcmp(argv[i], "--compressDumpContainer") == 0 ||
+                strcmp(argv[i], "-DZ") == 0)
+            {
+                gDumpContainerCompress = true;
+            }
+        else
+            if (strcmp(argv[i], "--stepThreads") == 0 ||
+                strcmp(argv[i], "-NT") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing step threads\n";
+                    exit(1);
+                }
+                gStepThreads = strtol(argv[i], 0, 10);
+            }
+        else
+            if (strcmp(argv[i], "--stepThreadBenchmark") == 0 ||
+                strcmp(argv[i], "-NTB") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing step thread benchmark count\n";
+                    exit(1);
+                }
+                gStepThreadBenchmarkMax = strtol(argv[i], 0, 10);
+            }
+        else
+            if (strcmp(argv[i], "--forkServer") == 0 ||
+                strcmp(argv[i], "-FS") == 0)
+            {
+#ifdef FORK_SERVER_AVAILABLE
+                gForkServer = true;
+#else
+                std::cerr << "Warning: --forkServer is not available with MPI or on this platform\n";
+#endif
+            }
+        else
+            if (strcmp(argv[i], "--fitnessCache") == 0 ||
+                strcmp(argv[i], "-FC") == 0)
+            {
+                gFitnessCacheFlag = true;
+            }
+        else
+            if (strcmp(argv[i], "--fitnessCacheFile") == 0 ||
+                strcmp(argv[i], "-FCF") == 0)
+            {
+                i++;
+                if (i >= argc)
+                {
+                    std::cerr << "Error parsing fitness cache filename\n";
+                    exit(1);
+                }
+                gFitnessCacheFilenamePtr = argv[i];
+                gFitnessCacheFlag = true;
+            }
         else
-            if (strcmp(argv[i], "--config") == 0 ||
-                strcmp(argv[i], "-c") == 0)
+            if (strcmp(argv[i], "--fitnessCacheSize") == 0 ||
+                strcmp(argv[i], "-FCS") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing config filename\n";
+                    std::cerr << "Error parsing fitness cache size\n";
                     exit(1);
                 }
-                gConfigFilenamePtr = argv[i];
+                gFitnessCacheSize = strtol(argv[i], 0, 10);
             }
         else
-            if (strcmp(argv[i], "--graphicsRoot") == 0 ||
-                strcmp(argv[i], "-g") == 0)
+            if (strcmp(argv[i], "--fitnessCacheQuantum") == 0 ||
+                strcmp(argv[i], "-FCQ") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing graphics root directory\n";
+                    std::cerr << "Error parsing fitness cache quantum\n";
                     exit(1);
                 }
-                gGraphicsRoot = argv[i];
+                gFitnessCacheQuantum = strtod(argv[i], 0);
             }
         else
-            if (strcmp(argv[i], "--debug") == 0 ||
-                strcmp(argv[i], "-d") == 0)
+            if (strcmp(argv[i], "--batchList") == 0 ||
+                strcmp(argv[i], "-BL") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing debug level\n";
+                    std::cerr << "Error parsing batch list filename\n";
                     exit(1);
                 }
-                gDebug = (DebugControl)strtol(argv[i], 0, 10);
+#ifdef BATCH_MODE_AVAILABLE
+                gBatchListFilenamePtr = argv[i];
+#else
+                std::cerr << "Warning: --batchList is only available in the file based version\n";
+#endif
             }
         else
-            if (strcmp(argv[i], "--debugFunctionFilter") == 0 ||
-                strcmp(argv[i], "-df") == 0)
+            if (strcmp(argv[i], "--batchSize") == 0 ||
+                strcmp(argv[i], "-BS") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing debugFunctionFilter\n";
+                    std::cerr << "Error parsing batch size\n";
                     exit(1);
                 }
-                gDebugFunctionFilter = argv[i];
+                gBatchSize = strtol(argv[i], 0, 10);
+                if (gBatchSize < 1) gBatchSize = 1;
             }
         else
-            if (strcmp(argv[i], "--debugNameFilter") == 0 ||
-                strcmp(argv[i], "-dn") == 0)
+            if (strcmp(argv[i], "--batchCheck") == 0 ||
+                strcmp(argv[i], "-BC") == 0)
+            {
+                gBatchCheck = true;
+            }
+        else
+            if (strcmp(argv[i], "--checkpointFile") == 0 ||
+                strcmp(argv[i], "-CP") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing debugNameFilter\n";
+                    std::cerr << "Error parsing checkpoint filename\n";
                     exit(1);
                 }
-                gDebugNameFilter = argv[i];
+                gCheckpointFilenamePtr = argv[i];
             }
         else
-            if (strcmp(argv[i], "--outputName") == 0 ||
-                strcmp(argv[i], "-on") == 0)
+            if (strcmp(argv[i], "--checkpointInterval") == 0 ||
+                strcmp(argv[i], "-CI") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing debugNameFilter\n";
+                    std::cerr << "Error parsing checkpoint interval\n";
                     exit(1);
                 }
-                gOutputList.push_back(std::string(argv[i]));
+                gCheckpointInterval = strtod(argv[i], 0);
             }
         else
-            if (strcmp(argv[i], "--windowSize") == 0 ||
-                strcmp(argv[i], "-w") == 0)
+            if (strcmp(argv[i], "--restartFile") == 0 ||
+                strcmp(argv[i], "-RF") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing window size x\n";
+                    std::cerr << "Error parsing restart filename\n";
                     exit(1);
                 }
-                gWindowWidth = strtol(argv[i], 0, 10);
+                gRestartFilenamePtr = argv[i];
+            }
+        else
+            if (strcmp(argv[i], "--branches") == 0 ||
+                strcmp(argv[i], "-BN") == 0)
+            {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing window size y\n";
+                    std::cerr << "Error parsing number of branches\n";
                     exit(1);
                 }
-                gWindowHeight = strtol(argv[i], 0, 10);
+                gBranchCount = strtol(argv[i], 0, 10);
             }
         else
-            if (strcmp(argv[i], "--framGrabWindowSize") == 0 ||
-                strcmp(argv[i], "-W") == 0)
+            if (strcmp(argv[i], "--branchTime") == 0 ||
+                strcmp(argv[i], "-BT") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing window size x\n";
+                    std::cerr << "Error parsing branch time\n";
                     exit(1);
                 }
-                gFrameGrabWindowWidth = strtol(argv[i], 0, 10);
+                gBranchTime = strtod(argv[i], 0);
+            }
+        else
+            if (strcmp(argv[i], "--branchPerturbation") == 0 ||
+                strcmp(argv[i], "-BP") == 0)
+            {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing window size y\n";
+                    std::cerr << "Error parsing branch perturbation\n";
                     exit(1);
                 }
-                gFrameGrabWindowHeight = strtol(argv[i], 0, 10);
+                gBranchPerturbation = strtod(argv[i], 0);
             }
         else
-            if (strcmp(argv[i], "--displaySkip") == 0 ||
-                strcmp(argv[i], "-S") == 0)
+            if (strcmp(argv[i], "--branchMinimum") == 0 ||
+                strcmp(argv[i], "-BM") == 0)
+            {
+                gBranchMinimum = true;
+            }
+        else
+            if (strcmp(argv[i], "--subStepCheck") == 0 ||
+                strcmp(argv[i], "-SSC") == 0)
+            {
+                gSubStepCheck = true;
+            }
+        else
+            if (strcmp(argv[i], "--subStepAccuracy") == 0 ||
+                strcmp(argv[i], "-SSA") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing --displaySkip\n";
+                    std::cerr << "Error parsing sub-step accuracy step multiple\n";
                     exit(1);
                 }
-                gDisplaySkip = strtol(argv[i], 0, 10);
+                gSubStepAccuracyMultiple = (int)strtol(argv[i], 0, 10);
             }
         else
-            if (strcmp(argv[i], "--fieldOfView") == 0 ||
-                strcmp(argv[i], "-f") == 0)
+            if (strcmp(argv[i], "--checkpointCheck") == 0 ||
+                strcmp(argv[i], "-CC") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing --fieldOfView\n";
+                    std::cerr << "Error parsing checkpoint check time\n";
                     exit(1);
                 }
-                gFOV = strtod(argv[i], 0);
+                gCheckpointCheckTime = strtod(argv[i], 0);
             }
         else
-            if (strcmp(argv[i], "--cameraDistance") == 0 ||
-                strcmp(argv[i], "-D") == 0)
+            if (strcmp(argv[i], "--muscleBenchmark") == 0 ||
+                strcmp(argv[i], "-MB") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing --cameraDistance\n";
+                    std::cerr << "Error parsing muscle benchmark count\n";
                     exit(1);
                 }
-                gCameraDistance = strtod(argv[i], 0);
+                gMuscleBenchmarkCount = (int)strtol(argv[i], 0, 10);
             }
         else
-            if (strcmp(argv[i], "--hostList") == 0 ||
-                strcmp(argv[i], "-L") == 0)
+            if (strcmp(argv[i], "--muscleExpressionCheck") == 0 ||
+                strcmp(argv[i], "-MEC") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing --hostList\n";
+                    std::cerr << "Error parsing muscle expression check count\n";
                     exit(1);
                 }
-                gHostlistFilenamePtr = argv[i];
+                gMuscleExpressionCheckCount = (int)strtol(argv[i], 0, 10);
             }
         else
-            if (strcmp(argv[i], "--runTimeLimit") == 0 ||
-                strcmp(argv[i], "-r") == 0)
+            if (strcmp(argv[i], "--implicitCheck") == 0 ||
+                strcmp(argv[i], "-IC") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing --runTimeLimit\n";
+                    std::cerr << "Error parsing implicit check step multiple\n";
                     exit(1);
                 }
-                gRunTimeLimit = strtol(argv[i], 0, 10);
+                gImplicitCheckMultiple = (int)strtol(argv[i], 0, 10);
             }
         else
-            if (strcmp(argv[i], "--warehouseFailDistanceAbort") == 0 ||
-                strcmp(argv[i], "-WF") == 0)
+            if (strcmp(argv[i], "--planeColliderCheck") == 0 ||
+                strcmp(argv[i], "-PCC") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing --warehouseFailDistanceAbort\n";
+                    std::cerr << "Error parsing plane collider check steps\n";
                     exit(1);
                 }
-                gWarehouseFailDistanceAbort = strtod(argv[i], 0);
+                gPlaneColliderCheckSteps = (int)strtol(argv[i], 0, 10);
             }
         else
-            if (strcmp(argv[i], "--outputKinematics") == 0 ||
-                strcmp(argv[i], "-K") == 0)
+            if (strcmp(argv[i], "--loadBenchmark") == 0 ||
+                strcmp(argv[i], "-LB") == 0)
             {
                 i++;
                 if (i >= argc)
                 {
-                    std::cerr << "Error parsing output kinematics filename\n";
+                    std::cerr << "Error parsing load benchmark count\n";
                     exit(1);
                 }
-                gOutputKinematicsFilenamePtr = argv[i];
+                gLoadBenchmarkCount = (int)strtol(argv[i], 0, 10);
             }
         else
             if (strcmp(argv[i], "--inputKinematics") == 0 ||
@@ -806,6 +1980,64 @@ void ParseArguments(int argc, char ** argv)
                 std::cerr << "Suppresses stdout and stderr messages by redirecting to /dev/null\n\n";
                 std::cerr << "-on, --outputName\n";
                 std::cerr << "Outputs the dump file for the named object\n\n";
+                std::cerr << "-DC filename, --outputDumpContainer filename\n";
+                std::cerr << "Writes all the dump outputs to a single binary file (read with gaitsym_dumpreader)\n\n";
+                std::cerr << "-DZ, --compressDumpContainer\n";
+                std::cerr << "Compresses the data in the dump container file\n\n";
+                std::cerr << "-NT n, --stepThreads n\n";
+                std::cerr << "Steps the world using n threads (overrides StepThreads in GLOBAL)\n\n";
+                std::cerr << "-NTB n, --stepThreadBenchmark n\n";
+                std::cerr << "Times the whole run stepped with 1, 2, 4 ... n threads, checks the results are identical and exits\n\n";
+                std::cerr << "-FS, --forkServer\n";
+                std::cerr << "Runs each model in a child process forked from a loaded base model (not with MPI)\n\n";
+                std::cerr << "-FC, --fitnessCache\n";
+                std::cerr << "Returns the stored result if a model has already been run\n\n";
+                std::cerr << "-FCF filename, --fitnessCacheFile filename\n";
+                std::cerr << "Keeps the fitness cache in filename between runs (implies -FC)\n\n";
+                std::cerr << "-FCS n, --fitnessCacheSize n\n";
+                std::cerr << "Number of results kept in memory by the fitness cache (default 100000)\n\n";
+                std::cerr << "-FCQ x, --fitnessCacheQuantum x\n";
+                std::cerr << "Genes are rounded to multiples of x when looking up the fitness cache (default 0 - exact)\n\n";
+                std::cerr << "-BL filename, --batchList filename\n";
+                std::cerr << "Runs every line of filename (config file then score file) instead of a single config file\n";
+                std::cerr << "The models are stepped together in lockstep with their driver, muscle and strap state interleaved\n\n";
+                std::cerr << "-BS n, --batchSize n\n";
+                std::cerr << "Number of batch list models that are stepped together (default 8)\n\n";
+                std::cerr << "-BC, --batchCheck\n";
+                std::cerr << "Runs each batch list model again on its own and returns 1 unless the results are identical\n\n";
+                std::cerr << "-CP filename, --checkpointFile filename\n";
+                std::cerr << "Writes the complete simulation state to filename at regular intervals\n\n";
+                std::cerr << "-CI x, --checkpointInterval x\n";
+                std::cerr << "Simulation time between checkpoints (default 1)\n\n";
+                std::cerr << "-RF filename, --restartFile filename\n";
+                std::cerr << "Carries on from a checkpoint written by the same model\n\n";
+                std::cerr << "-BN n, --branches n\n";
+                std::cerr << "Runs to the branch time once and then runs n perturbed copies of the rest of the simulation\n\n";
+                std::cerr << "-BT x, --branchTime x\n";
+                std::cerr << "Simulation time where the branches start (default 0)\n\n";
+                std::cerr << "-BP x, --branchPerturbation x\n";
+                std::cerr << "Standard deviation of the noise added to the body velocities at the start of each branch (default 0)\n\n";
+                std::cerr << "-BM, --branchMinimum\n";
+                std::cerr << "Score is the minimum of the branch scores rather than the mean\n\n";
+                std::cerr << "-SSC, --subStepCheck\n";
+                std::cerr << "Checks that the first step gives the same muscle tensions with and without sub-steps and exits\n\n";
+                std::cerr << "-SSA k, --subStepAccuracy k\n";
+                std::cerr << "Runs the model at k times the step size with and without k times the muscle sub-steps and prints\n";
+                std::cerr << "the tension and body position errors against a run at the model step size and exits\n\n";
+                std::cerr << "-CC x, --checkpointCheck x\n";
+                std::cerr << "Checks that a run resumed from a checkpoint at time x finishes identical to an uninterrupted run and exits\n\n";
+                std::cerr << "-MB n, --muscleBenchmark n\n";
+                std::cerr << "Times n activation updates of every muscle and prints the time per call for each muscle type and exits\n\n";
+                std::cerr << "-MEC n, --muscleExpressionCheck n\n";
+                std::cerr << "Checks n random states of every MAMuscleExtended against the unfactored force expressions and exits\n\n";
+                std::cerr << "-IC k, --implicitCheck k\n";
+                std::cerr << "Replays every UGMMuscle at k times the step size with the explicit and implicit integrators\n";
+                std::cerr << "and prints the tension error against the explicit run at the model step size and exits\n\n";
+                std::cerr << "-PCC n, --planeColliderCheck n\n";
+                std::cerr << "Compares the FastPlaneCollider contacts with dCollide for every plane and geom pair over n steps,\n";
+                std::cerr << "prints the contacts per second for both and exits\n\n";
+                std::cerr << "-LB n, --loadBenchmark n\n";
+                std::cerr << "Loads the model n more times and prints the setup and parse time per evaluation, the element text kept and the peak RSS and exits\n\n";
                 std::cerr << "-h, -?, --help\n";
                 std::cerr << "Prints this message!\n\n";
 
@@ -857,8 +2089,9 @@ int ReadModel(void *userData)
 #endif
 
     DataFile myFile;
+    bool genomeKeyed = false;
 #if !defined(USE_SOCKETS) && !defined(USE_UDP) && !defined(USE_TCP) && !defined(USE_MPI)
-    myFile.SetExitOnError(true);
+    myFile.SetExitOnError(gBatchListFilenamePtr == 0); // a bad batch list entry is skipped
 #endif
 
     // load the config file
@@ -1052,6 +2285,11 @@ int ReadModel(void *userData)
                 if (ival == -2) genomeData.ReadNext(&val); // skip the extra parameter
             }
             gXMLConverter.ApplyGenome(genomeSize, data);
+            if (gFitnessCache)
+            {
+                gCacheKey = CalculateCacheKey(0, genomeSize, data);
+                genomeKeyed = true;
+            }
             int len;
             char *buf = (char *)gXMLConverter.GetFormattedXML(&len);
             myFile.SetRawData(buf);
@@ -1105,6 +2343,11 @@ int ReadModel(void *userData)
             else
             {
                 gXMLConverter.ApplyGenome(genomeLength, dPtr);
+                if (gFitnessCache)
+                {
+                    gCacheKey = CalculateCacheKey(0, genomeLength, dPtr);
+                    genomeKeyed = true;
+                }
                 int len;
                 char *buf = (char *)gXMLConverter.GetFormattedXML(&len);
                 myFile.SetRawData(buf);
@@ -1146,16 +2389,21 @@ int ReadModel(void *userData)
 #else
     if (gModelConfigFile == 0)
     {
-        myFile.ReadFile(gConfigFilenamePtr);
+        if (myFile.ReadFile(gConfigFilenamePtr)) return 1;
     }
     else
     {
         DataFile genomeData;
         double val;
         int ival, genomeSize;
-        genomeData.ReadFile(gConfigFilenamePtr);
-        genomeData.ReadNext(&ival);
-        genomeData.ReadNext(&genomeSize);
+        genomeData.SetExitOnError(gBatchListFilenamePtr == 0);
+        if (genomeData.ReadFile(gConfigFilenamePtr)) return 1;
+        if (genomeData.ReadNext(&ival) || genomeData.ReadNext(&genomeSize) || genomeSize < 0)
+        {
+            std::cerr << "Error: cannot read the genome in " << gConfigFilenamePtr << "\n";
+            if (gBatchListFilenamePtr == 0) exit(1);
+            return 1;
+        }
         double *data = new double[genomeSize];
         for (int i = 0; i < genomeSize; i++)
         {
@@ -1164,6 +2412,11 @@ int ReadModel(void *userData)
             genomeData.ReadNext(&val); genomeData.ReadNext(&val); genomeData.ReadNext(&val);
         }
         gXMLConverter.ApplyGenome(genomeSize, data);
+        if (gFitnessCache)
+        {
+            gCacheKey = CalculateCacheKey(0, genomeSize, data);
+            genomeKeyed = true;
+        }
         int len;
         char *buf = (char *)gXMLConverter.GetFormattedXML(&len);
         myFile.SetRawData(buf);
@@ -1172,7 +2425,39 @@ int ReadModel(void *userData)
 
 #endif
 
+    // the cache is checked before anything is loaded
+    gCacheHit = false;
+    if (gFitnessCache)
+    {
+        if (genomeKeyed == false) gCacheKey = CalculateCacheKey(myFile.GetRawData(), 0, 0);
+        if (gFitnessCache->Find(gCacheKey, &gResult))
+        {
+            gCacheHit = true;
+            return 0;
+        }
+    }
+
+#ifdef FORK_SERVER_AVAILABLE
+    if (gForkServer) return ForkEvaluation(&myFile);
+#endif
+    return LoadSimulation(&myFile, userData);
+}
+
+// creates gSimulation from the model in myFile
+static int LoadSimulation(DataFile *myFile, void *userData)
+{
+#ifndef USE_QT
+    if (gLoadBenchmarkCount > 0) gLoadBenchmarkModel = myFile->GetRawData();
+#endif
+    if (NewSimulation(myFile->GetRawData(), userData)) return 1;
+    return InitialiseSimulation();
+}
+
+// creates gSimulation and loads the model but does not start any output
+static int NewSimulation(char *xmlData, void *userData)
+{
     // create the simulation object
+    if (gStepThreads > 0) StepThreadPool::GetPool()->SetThreadCountOverride(gStepThreads);
     gSimulation = new Simulation();
     if (gOutputKinematicsFilenamePtr) gSimulation->SetOutputKinematicsFile(gOutputKinematicsFilenamePtr);
     if (gInputKinematicsFilenamePtr) gSimulation->SetInputKinematicsFile(gInputKinematicsFilenamePtr);
@@ -1190,16 +2475,32 @@ int ReadModel(void *userData)
     gSimulation->SetMainWindow(static_cast<MainWindow *>(userData));
 #endif
 
-    if (gSimulation->LoadModel(myFile.GetRawData()))
+    if (gSimulation->LoadModel(xmlData))
     {
         delete gSimulation;
         gSimulation = 0;
         return 1;
     }
+    return 0;
+}
 
-    // late initialisation options
+// the late initialisation options that have to be applied to the final model
+static int InitialiseSimulation()
+{
+    if (gOutputDumpContainerFilenamePtr) gSimulation->SetOutputDumpContainer(gOutputDumpContainerFilenamePtr, gDumpContainerCompress);
     if (gSimulationTimeLimit >= 0) gSimulation->SetTimeLimit(gSimulationTimeLimit);
     if (gWarehouseFailDistanceAbort != 0) gSimulation->SetWarehouseFailDistanceAbort(gWarehouseFailDistanceAbort);
+    if (gRestartFilenamePtr && gSimulation->ReadCheckpointFile(gRestartFilenamePtr) == false)
+    {
+        delete gSimulation;
+        gSimulation = 0;
+        return 1;
+    }
+    if (gCheckpointFilenamePtr)
+    {
+        gSimulation->SetCheckpointFile(gCheckpointFilenamePtr);
+        gSimulation->SetCheckpointInterval(gCheckpointInterval);
+    }
 
     return 0;
 }
@@ -1209,34 +2510,67 @@ int ReadModel(void *userData)
 int WriteModel()
 {
     double score;
+    double simulationTime;
+    long long stepCount;
+    double mechanicalEnergy;
+    double metabolicEnergy;
 #if defined(USE_SOCKETS)
     char buffer[kSocketMaxMessageLength];
 #endif
 
-    score = gSimulation->CalculateInstantaneousFitness();
-    // if (gSimulation->TestForCatastrophy())
-    //  score -= 100000;
+    if (gSimulation == 0) // the result came from the fork server or the fitness cache
+    {
+        score = gResult.score;
+        simulationTime = gResult.simulationTime;
+        stepCount = gResult.stepCount;
+        mechanicalEnergy = gResult.mechanicalEnergy;
+        metabolicEnergy = gResult.metabolicEnergy;
+    }
+    else
+    {
+        score = gSimulation->CalculateInstantaneousFitness();
+        // if (gSimulation->TestForCatastrophy())
+        //  score -= 100000;
+        simulationTime = gSimulation->GetTime();
+        stepCount = gSimulation->GetStepCount();
+        mechanicalEnergy = gSimulation->GetMechanicalEnergy();
+        metabolicEnergy = gSimulation->GetMetabolicEnergy();
+    }
+
+    // failed runs (score -DBL_MAX) are not stored in case the failure was not caused by the model
+    if (gFitnessCache && gCacheHit == false && score != -DBL_MAX)
+    {
+        SimulationResult result;
+        result.score = score;
+        result.simulationTime = simulationTime;
+        result.stepCount = stepCount;
+        result.mechanicalEnergy = mechanicalEnergy;
+        result.metabolicEnergy = metabolicEnergy;
+        gFitnessCache->Insert(gCacheKey, result);
+    }
 
 #ifdef USE_MPI
     int mpi_Comm_rank;
     int rc = MPI_Comm_rank(MPI_COMM_WORLD, &mpi_Comm_rank);
     std::cerr << "MPIRank: " << mpi_Comm_rank <<
-                 " Simulation Time: " << gSimulation->GetTime() <<
-                 " Steps: " << gSimulation->GetStepCount() <<
+                 " Simulation Time: " << simulationTime <<
+                 " Steps: " << stepCount <<
                  " Score: " << score <<
-                 " Mechanical Energy: " << gSimulation->GetMechanicalEnergy() <<
-                 " Metabolic Energy: " << gSimulation->GetMetabolicEnergy() <<
+                 " Mechanical Energy: " << mechanicalEnergy <<
+                 " Metabolic Energy: " << metabolicEnergy <<
                  " CPUTimeSimulation: " << gSimulationTime <<
-                 " CPUTimeIO: " << gIOTime << "\n";
+                 " CPUTimeIO: " << gIOTime;
 #else
-    std::cerr << "Simulation Time: " << gSimulation->GetTime() <<
-                 " Steps: " << gSimulation->GetStepCount() <<
+    std::cerr << "Simulation Time: " << simulationTime <<
+                 " Steps: " << stepCount <<
                  " Score: " << score <<
-                 " Mechanical Energy: " << gSimulation->GetMechanicalEnergy() <<
-                 " Metabolic Energy: " << gSimulation->GetMetabolicEnergy() <<
+                 " Mechanical Energy: " << mechanicalEnergy <<
+                 " Metabolic Energy: " << metabolicEnergy <<
                  " CPUTimeSimulation: " << gSimulationTime <<
-                 " CPUTimeIO: " << gIOTime << "\n";
+                 " CPUTimeIO: " << gIOTime;
 #endif
+    if (gFitnessCache) std::cerr << " CacheHits: " << gFitnessCache->GetHits() << " CacheMisses: " << gFitnessCache->GetMisses();
+    std::cerr << "\n";
 
 #if defined(USE_SOCKETS)
     try
@@ -1324,8 +2658,10 @@ int WriteModel()
     if (gDebug == MemoryDebug)
         *gDebugStream << "main About to delete gSimulation\n";
     delete gSimulation;
+    gSimulation = 0;
 
 #if ! defined(USE_SOCKETS) && ! defined (USE_UDP) && ! defined (USE_TCP) && ! defined(USE_MPI)
+    if (gBatchListFilenamePtr) return(0); // RunBatch carries on with the next model
     std::cerr << "exiting\n";
     return(1);
 #else
@@ -1333,6 +2669,410 @@ int WriteModel()
 #endif
 }
 
+#ifdef BATCH_MODE_AVAILABLE
+// runs the models in the batch list file gBatchSize at a time
+// each model is loaded by ReadModel and reported by WriteModel exactly as in the single file version
+// but the loaded simulations are stepped together by SimulationBatch
+static int RunBatch()
+{
+    // every copy would write to the same output files
+    if (FilesOrChecksRequested() || gBranchCount > 0 || gInputKinematicsFilenamePtr)
+    {
+        std::cerr << "Error: --batchList cannot be used with output files, dumps, checkpoints, debugging, checks, branches or input kinematics\n";
+        return 1;
+    }
+    if (gForkServer)
+    {
+        std::cerr << "Warning: fork server not used with --batchList\n";
+        gForkServer = false;
+    }
+    if (gBatchCheck && gFitnessCache) // the check has to run every model
+    {
+        std::cerr << "Warning: fitness cache not used with --batchCheck\n";
+        delete gFitnessCache;
+        gFitnessCache = 0;
+        gFitnessCacheFlag = false;
+    }
+
+    std::ifstream listFile(gBatchListFilenamePtr);
+    if (listFile.good() == false)
+    {
+        std::cerr << "Error opening batch list file " << gBatchListFilenamePtr << "\n";
+        return 1;
+    }
+    std::vector<std::string> configList;
+    std::vector<std::string> scoreList;
+    std::string line, configFilename, scoreFilename;
+    while (std::getline(listFile, line))
+    {
+        std::istringstream ss(line);
+        configFilename.clear();
+        scoreFilename.clear();
+        ss >> configFilename >> scoreFilename;
+        if (configFilename.size() == 0) continue; // blank line
+        configList.push_back(configFilename);
+        scoreList.push_back(scoreFilename);
+    }
+
+    gLastTime = Util::GetTime();
+    unsigned int first, i, j;
+    int mismatches = 0;
+    for (first = 0; first < configList.size(); first += gBatchSize)
+    {
+        SimulationBatch batch;
+        std::vector<unsigned int> batchIndexList;
+        std::vector<uint64_t> batchCacheKeyList;
+        for (i = first; i < configList.size() && i < first + gBatchSize; i++)
+        {
+            gConfigFilenamePtr = (char *)configList[i].c_str();
+            gScoreFilenamePtr = scoreList[i].size() ? (char *)scoreList[i].c_str() : 0;
+            if (ReadModel())
+            {
+                std::cerr << "Error reading " << configList[i] << "\n";
+                continue;
+            }
+            if (gSimulation == 0) // the result is already known from the fitness cache
+            {
+                WriteModel();
+                continue;
+            }
+            batch.AddSimulation(gSimulation);
+            batchIndexList.push_back(i);
+            batchCacheKeyList.push_back(gCacheKey);
+            gSimulation = 0;
+        }
+        if (batch.GetSize() == 0) continue;
+
+        bool interleaved = batch.Compile();
+        std::cerr << "Batch of " << batch.GetSize() << (interleaved ? " interleaved with " : " stepped separately with ") <<
+                     batch.GetNumBatchedMuscles() << " of " << batch.GetNumMuscles() << " muscles batched\n";
+        gCurrentTime = Util::GetTime();
+        gIOTime += (gCurrentTime - gLastTime);
+        gLastTime = gCurrentTime;
+        while (batch.Step() > 0) {}
+        gCurrentTime = Util::GetTime();
+        gSimulationTime += (gCurrentTime - gLastTime);
+        gLastTime = gCurrentTime;
+
+        // WriteModel deletes each simulation after reporting it
+        std::vector<SimulationResult> batchResultList(batch.GetSize());
+        gCacheHit = false;
+        for (j = 0; j < (unsigned int)batch.GetSize(); j++)
+        {
+            i = batchIndexList[j];
+            gConfigFilenamePtr = (char *)configList[i].c_str();
+            gScoreFilenamePtr = scoreList[i].size() ? (char *)scoreList[i].c_str() : 0;
+            gCacheKey = batchCacheKeyList[j];
+            gSimulation = batch.GetSimulation(j);
+            GetResult(&batchResultList[j]);
+            WriteModel();
+        }
+
+        if (gBatchCheck == false) continue;
+        for (j = 0; j < (unsigned int)batch.GetSize(); j++)
+        {
+            i = batchIndexList[j];
+            gConfigFilenamePtr = (char *)configList[i].c_str();
+            gScoreFilenamePtr = 0;
+            if (ReadModel() || gSimulation == 0)
+            {
+                std::cerr << "Batch check: error reading " << configList[i] << "\n";
+                mismatches++;
+                continue;
+            }
+            while (gSimulation->ShouldQuit() == false)
+            {
+                gSimulation->UpdateSimulation();
+                if (gSimulation->TestForCatastrophy()) break;
+            }
+            SimulationResult result;
+            GetResult(&result);
+            delete gSimulation;
+            gSimulation = 0;
+            if (result.score != batchResultList[j].score || result.simulationTime != batchResultList[j].simulationTime ||
+                    result.stepCount != batchResultList[j].stepCount)
+            {
+                std::cerr.precision(17);
+                std::cerr << "Batch check FAILED " << configList[i] << " batch score " << batchResultList[j].score <<
+                             " time " << batchResultList[j].simulationTime << " steps " << batchResultList[j].stepCount <<
+                             " single score " << result.score << " time " << result.simulationTime << " steps " << result.stepCount << "\n";
+                std::cerr.precision(6);
+                mismatches++;
+            }
+        }
+    }
+
+    gConfigFilenamePtr = 0;
+    gScoreFilenamePtr = 0;
+    if (gBatchCheck) std::cerr << (mismatches ? "Batch check FAILED\n" : "Batch check passed\n");
+    std::cerr << "exiting\n";
+    return mismatches ? 1 : 0;
+}
+#endif
+
+// the key covers the model (or the base model and the genome) and the command line options
+// that change the result
+// the input files are identified by name so the cache file needs deleting if they are edited
+static uint64_t CalculateCacheKey(const char *modelText, int genomeSize, const double *genomeData)
+{
+    uint64_t key = FitnessCache::Hash(&gSimulationTimeLimit, sizeof(gSimulationTimeLimit));
+    key = FitnessCache::Hash(&gWarehouseFailDistanceAbort, sizeof(gWarehouseFailDistanceAbort), key);
+    if (gInputWarehouseFilenamePtr) key = FitnessCache::Hash(gInputWarehouseFilenamePtr, strlen(gInputWarehouseFilenamePtr), key);
+    if (gInputKinematicsFilenamePtr) key = FitnessCache::Hash(gInputKinematicsFilenamePtr, strlen(gInputKinematicsFilenamePtr), key);
+    if (gRestartFilenamePtr) key = FitnessCache::Hash(gRestartFilenamePtr, strlen(gRestartFilenamePtr), key);
+    if (gBranchCount > 0) // RunSimulation always branches when this is set
+    {
+        key = FitnessCache::Hash(&gBranchCount, sizeof(gBranchCount), key);
+        key = FitnessCache::Hash(&gBranchTime, sizeof(gBranchTime), key);
+        key = FitnessCache::Hash(&gBranchPerturbation, sizeof(gBranchPerturbation), key);
+        key = FitnessCache::Hash(&gBranchMinimum, sizeof(gBranchMinimum), key);
+    }
+    if (genomeData)
+    {
+        uint64_t baseXMLHash = gXMLConverter.GetBaseXMLHash();
+        key = FitnessCache::Hash(&baseXMLHash, sizeof(baseXMLHash), key);
+        key = FitnessCache::Hash(&genomeSize, sizeof(genomeSize), key);
+        double gene;
+        for (int i = 0; i < genomeSize; i++)
+        {
+            if (gFitnessCacheQuantum > 0) gene = floor(genomeData[i] / gFitnessCacheQuantum + 0.5);
+            else gene = genomeData[i];
+            if (gene == 0) gene = 0; // so that -0 and +0 match
+            key = FitnessCache::Hash(&gene, sizeof(gene), key);
+        }
+    }
+    else
+    {
+        key = FitnessCache::Hash(modelText, strlen(modelText), key);
+    }
+    return key;
+}
+
+#ifdef FORK_SERVER_AVAILABLE
+// the model is run in a child process and the results are sent back through a pipe
+// the parent loads the first model it is sent and keeps it (never run) along with the transport
+// connection and the initialised libraries and each child gets a copy on write image of all of them
+// so the child only has to re-read the DRIVER elements that the genome has changed and a crash
+// only loses the one evaluation
+// a child only loads its model from scratch if something other than the drivers is different
+// the parent never runs a simulation so no output is ever started before a fork
+static int ForkEvaluation(DataFile *myFile)
+{
+    if (gBaseSimulation == 0 && gBaseSimulationFailed == false)
+    {
+        if (NewSimulation(myFile->GetRawData(), 0) == 0)
+        {
+            gBaseSimulation = gSimulation;
+            gSimulation = 0;
+        }
+        else
+        {
+            std::cerr << "Warning: fork server unable to load a base model so every model will be loaded in full\n";
+            gBaseSimulationFailed = true;
+        }
+    }
+
+    int fd[2];
+    if (pipe(fd) == -1)
+    {
+        std::cerr << "Error creating fork server pipe\n";
+        return 1;
+    }
+
+    gCurrentTime = Util::GetTime();
+    gIOTime += (gCurrentTime - gLastTime);
+    gLastTime = gCurrentTime;
+
+    // anything still buffered would otherwise be output by both processes
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(0);
+
+    pid_t pid = fork();
+    if (pid == -1)
+    {
+        std::cerr << "Error forking fork server child\n";
+        close(fd[0]);
+        close(fd[1]);
+        return 1;
+    }
+
+    if (pid == 0) // child
+    {
+        close(fd[0]);
+        ResetChildAfterFork(true);
+        ForkResult result;
+        int err;
+        if (gBaseSimulation && gBaseSimulation->UpdateModel(myFile->GetRawData()) == 0)
+        {
+            gSimulation = gBaseSimulation;
+            err = InitialiseSimulation();
+        }
+        else
+        {
+            err = LoadSimulation(myFile, 0);
+        }
+        if (err == 0)
+        {
+            SetDumpFlags();
+            double startSimulationTime = gSimulationTime;
+            gLastTime = Util::GetTime();
+            RunSimulation();
+            GetResult(&result.result);
+            result.cpuTimeSimulation = gSimulationTime - startSimulationTime;
+            delete gSimulation;
+            gSimulation = 0;
+            AsyncOutputWriter::Shutdown();
+            std::cout.flush();
+            std::cerr.flush();
+            fflush(0);
+            ssize_t written = write(fd[1], &result, sizeof(result));
+            if (written != sizeof(result)) std::cerr << "Error writing to fork server pipe\n";
+        }
+        close(fd[1]);
+        _exit(0);
+    }
+
+    // parent
+    close(fd[1]);
+    ForkResult forkResult;
+    char *ptr = (char *)&forkResult;
+    size_t bytesRead = 0;
+    while (bytesRead < sizeof(forkResult))
+    {
+        ssize_t n = read(fd[0], ptr + bytesRead, sizeof(forkResult) - bytesRead);
+        if (n > 0) bytesRead += n;
+        else if (n == -1 && errno == EINTR) continue;
+        else break;
+    }
+    close(fd[0]);
+    int status;
+    while (waitpid(pid, &status, 0) == -1 && errno == EINTR) {}
+
+    if (bytesRead != sizeof(forkResult))
+    {
+        if (WIFSIGNALED(status)) std::cerr << "Warning: fork server child killed by signal " << WTERMSIG(status) << "\n";
+        else std::cerr << "Warning: fork server child failed to return a result\n";
+        forkResult.result.score = -DBL_MAX;
+        forkResult.result.simulationTime = 0;
+        forkResult.result.stepCount = 0;
+        forkResult.result.mechanicalEnergy = 0;
+        forkResult.result.metabolicEnergy = 0;
+        forkResult.cpuTimeSimulation = 0;
+    }
+    gResult = forkResult.result;
+
+    // only the time spent running the simulation in the child counts as simulation time
+    gCurrentTime = Util::GetTime();
+    gSimulationTime += forkResult.cpuTimeSimulation;
+    gIOTime += (gCurrentTime - gLastTime) - forkResult.cpuTimeSimulation;
+    gLastTime = gCurrentTime;
+    return 0;
+}
+
+// the output files opened during the prefix belong to the parent's writer thread
+// and every branch would be writing to the same files so branches that produce
+// output are run in turn instead
+static bool ForkedBranchesAllowed()
+{
+    AsyncOutputWriter *writer = AsyncOutputWriter::GetExistingWriter();
+    if (writer && (writer->GetOpenStreamCount() > 0 || writer->GetDumpContainerOpen()))
+    {
+        std::cerr << "Warning: branches with output files are run in turn rather than in forked children\n";
+        return false;
+    }
+    return true;
+}
+
+// a forked child only has the thread that called fork() so the output writer and the
+// step thread pool are abandoned and the child starts its own if it needs them
+// the branches already run in parallel so they step with 1 thread each
+static void ResetChildAfterFork(bool restartStepThreads)
+{
+    AsyncOutputWriter::ResetAfterFork();
+    StepThreadPool::GetPool()->ResetAfterFork(restartStepThreads);
+}
+
+// each branch is run in its own child which starts with a copy of the prefix state
+// so no checkpoint is needed and all the branches run at the same time
+static void ForkBranches(std::vector<SimulationResult> *resultList)
+{
+    std::vector<pid_t> pidList(resultList->size(), -1);
+    std::vector<int> fdList(resultList->size(), -1);
+    unsigned int i;
+
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(0);
+
+    for (i = 0; i < resultList->size(); i++)
+    {
+        int fd[2];
+        if (pipe(fd) == -1)
+        {
+            std::cerr << "Error creating branch pipe\n";
+            break;
+        }
+        pid_t pid = fork();
+        if (pid == -1)
+        {
+            std::cerr << "Error forking branch child\n";
+            close(fd[0]);
+            close(fd[1]);
+            break;
+        }
+        if (pid == 0) // child
+        {
+            close(fd[0]);
+            for (unsigned int j = 0; j < i; j++) close(fdList[j]);
+            ResetChildAfterFork(false);
+            SimulationResult result;
+            RunBranch(i, &result);
+            AsyncOutputWriter::Shutdown();
+            std::cout.flush();
+            std::cerr.flush();
+            fflush(0);
+            ssize_t written = write(fd[1], &result, sizeof(result));
+            if (written != sizeof(result)) std::cerr << "Error writing to branch pipe\n";
+            close(fd[1]);
+            _exit(0);
+        }
+        close(fd[1]);
+        pidList[i] = pid;
+        fdList[i] = fd[0];
+    }
+
+    for (i = 0; i < resultList->size(); i++)
+    {
+        SimulationResult &result = (*resultList)[i];
+        size_t bytesRead = 0;
+        if (fdList[i] != -1)
+        {
+            char *ptr = (char *)&result;
+            while (bytesRead < sizeof(result))
+            {
+                ssize_t n = read(fdList[i], ptr + bytesRead, sizeof(result) - bytesRead);
+                if (n > 0) bytesRead += n;
+                else if (n == -1 && errno == EINTR) continue;
+                else break;
+            }
+            close(fdList[i]);
+            int status;
+            while (waitpid(pidList[i], &status, 0) == -1 && errno == EINTR) {}
+        }
+        if (bytesRead != sizeof(result))
+        {
+            std::cerr << "Warning: branch " << i << " failed to return a result\n";
+            result.score = -DBL_MAX;
+            result.simulationTime = 0;
+            result.stepCount = 0;
+            result.mechanicalEnergy = 0;
+            result.metabolicEnergy = 0;
+        }
+    }
+}
+#endif
+
 bool GetOption(char ** begin, char ** end, const std::string &option, char **ptr)
 {
     char **itr = std::find(begin, end, option);
@@ -10,6 +10,7 @@
 #include <ode/ode.h>
 
 #include "PIDMuscleLength.h"
+#include "Checkpoint.h"
 #include "Muscle.h"
 
 PIDMuscleLength::PIDMuscleLength()
@@ -56,3 +57,24 @@ void PIDMuscleLength::SetActivation(double activation, double duration)
     last_activation = activation;
 }
 
+void PIDMuscleLength::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    Drivable::WriteCheckpoint(checkpoint);
+    checkpoint->Write(previous_error);
+    checkpoint->Write(error);
+    checkpoint->Write(integral);
+    checkpoint->Write(derivative);
+    checkpoint->Write(output);
+    checkpoint->Write(last_activation);
+}
+
+void PIDMuscleLength::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    Drivable::ReadCheckpoint(checkpoint);
+    checkpoint->Read(&previous_error);
+    checkpoint->Read(&error);
+    checkpoint->Read(&integral);
+    checkpoint->Read(&derivative);
+    checkpoint->Read(&output);
+    checkpoint->Read(&last_activation);
+}
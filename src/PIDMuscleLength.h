@@ -26,6 +26,9 @@ public:
     virtual void SetActivation(double activation, double duration);
     virtual double GetActivation() { return last_activation; }
 
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
+
 protected:
     Muscle *m_Muscle;
     double Kp;
@@ -10,6 +10,7 @@
 #include <ode/ode.h>
 
 #include "PIDTargetMatch.h"
+#include "Checkpoint.h"
 #include "Muscle.h"
 #include "DataTarget.h"
 
@@ -71,3 +72,26 @@ void PIDTargetMatch::SetActivation(double activation, double duration)
     last_activation = muscleActivation;
 }
 
+void PIDTargetMatch::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    Drivable::WriteCheckpoint(checkpoint);
+    checkpoint->Write(previous_error);
+    checkpoint->Write(error);
+    checkpoint->Write(integral);
+    checkpoint->Write(derivative);
+    checkpoint->Write(output);
+    checkpoint->Write(last_activation);
+    checkpoint->Write(last_set_activation);
+}
+
+void PIDTargetMatch::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    Drivable::ReadCheckpoint(checkpoint);
+    checkpoint->Read(&previous_error);
+    checkpoint->Read(&error);
+    checkpoint->Read(&integral);
+    checkpoint->Read(&derivative);
+    checkpoint->Read(&output);
+    checkpoint->Read(&last_activation);
+    checkpoint->Read(&last_set_activation);
+}
@@ -27,6 +27,9 @@ public:
     virtual void SetActivation(double activation, double duration);
     virtual double GetActivation() { return last_activation; }
 
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
+
 protected:
     Muscle *m_Muscle;
     DataTarget *m_Target;
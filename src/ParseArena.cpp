@@ -0,0 +1,28 @@
+/*
+ *  ParseArena.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Scratch memory used when reading models that grows as needed
+ *  and is kept (one per thread) for the next model
+ *
+ */
+
+#include "ParseArena.h"
+
+// these are enough for any normal attribute so most models never grow the lists
+ParseArena::ParseArena()
+{
+    m_Buffer.resize(1 << 16);
+    m_LargeBuffer.resize(1 << 16);
+    m_PointerList.resize(1 << 12);
+    m_DoubleList.resize(1 << 12);
+}
+
+ParseArena *ParseArena::GetArena()
+{
+    static thread_local ParseArena arena;
+    return &arena;
+}
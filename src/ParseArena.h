@@ -0,0 +1,55 @@
+/*
+ *  ParseArena.h
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Scratch memory used when reading models that grows as needed
+ *  and is kept (one per thread) for the next model
+ *
+ */
+
+#ifndef PARSEARENA_H
+#define PARSEARENA_H
+
+#include <vector>
+#include <stddef.h>
+
+class ParseArena
+{
+public:
+    ParseArena();
+
+    static ParseArena *GetArena();
+
+    // these return storage for at least size elements
+    // growing keeps the existing contents but may move them so the returned pointers
+    // are only valid until the next call for the same list
+    char *GetBuffer(size_t size) { return Grow(&m_Buffer, size); }
+    char *GetLargeBuffer(size_t size) { return Grow(&m_LargeBuffer, size); }
+    char **GetPointerList(size_t size) { return Grow(&m_PointerList, size); }
+    double *GetDoubleList(size_t size) { return Grow(&m_DoubleList, size); }
+
+    size_t GetBufferSize() { return m_Buffer.size(); }
+    size_t GetPointerListSize() { return m_PointerList.size(); }
+
+protected:
+    template <typename T> static T *Grow(std::vector<T> *list, size_t size)
+    {
+        if (size > list->size())
+        {
+            size_t newSize = list->size() * 2;
+            if (newSize < size) newSize = size;
+            list->resize(newSize);
+        }
+        return &(*list)[0];
+    }
+
+    std::vector<char> m_Buffer;
+    std::vector<char> m_LargeBuffer;
+    std::vector<char *> m_PointerList;
+    std::vector<double> m_DoubleList;
+};
+
+#endif // PARSEARENA_H
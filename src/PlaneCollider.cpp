@@ -0,0 +1,233 @@
+/*
+ *  PlaneCollider.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Contact generation for sphere, capsule and box geoms against
+ *  a plane without going through the general dCollide dispatch
+ *
+ */
+
+#include <cmath>
+
+#include "PlaneCollider.h"
+
+#define CONTACT(p, skip) ((dContactGeom *)(((char *)(p)) + (skip)))
+
+// the arithmetic (including the order of the operations) follows dCollideSpherePlane,
+// dCollideCapsulePlane and dCollideBoxPlane so that the contacts are identical
+int PlaneCollider::Collide(dGeomID geom, dGeomID plane, int maxContacts, dContactGeom *contact, int skip)
+{
+    if (maxContacts < 1) return 0;
+    dVector4 n;
+    switch (dGeomGetClass(geom))
+    {
+    case dSphereClass:
+        dGeomPlaneGetParams(plane, n);
+        return CollideSphere(geom, plane, n, contact);
+    case dCapsuleClass:
+        dGeomPlaneGetParams(plane, n);
+        return CollideCapsule(geom, plane, n, maxContacts, contact, skip);
+    case dBoxClass:
+        dGeomPlaneGetParams(plane, n);
+        return CollideBox(geom, plane, n, maxContacts, contact, skip);
+    }
+    return -1;
+}
+
+int PlaneCollider::CollideSphere(dGeomID geom, dGeomID plane, const dReal *n, dContactGeom *contact)
+{
+    const dReal *pos = dGeomGetPosition(geom);
+    dReal radius = dGeomSphereGetRadius(geom);
+    dReal k = pos[0] * n[0] + pos[1] * n[1] + pos[2] * n[2];
+    dReal depth = n[3] - k + radius;
+    if (depth < 0) return 0;
+
+    contact->normal[0] = n[0];
+    contact->normal[1] = n[1];
+    contact->normal[2] = n[2];
+    contact->pos[0] = pos[0] - n[0] * radius;
+    contact->pos[1] = pos[1] - n[1] * radius;
+    contact->pos[2] = pos[2] - n[2] * radius;
+    contact->depth = depth;
+    contact->g1 = geom;
+    contact->g2 = plane;
+    contact->side1 = -1;
+    contact->side2 = -1;
+    return 1;
+}
+
+// the capsule is treated as its two end spheres with the deeper one first
+int PlaneCollider::CollideCapsule(dGeomID geom, dGeomID plane, const dReal *n, int maxContacts, dContactGeom *contact, int skip)
+{
+    const dReal *pos = dGeomGetPosition(geom);
+    const dReal *R = dGeomGetRotation(geom);
+    dReal radius, length;
+    dGeomCapsuleGetParams(geom, &radius, &length);
+    dReal halfLength = length * 0.5;
+
+    dReal sign = (n[0] * R[2] + n[1] * R[6] + n[2] * R[10] > 0) ? -1.0 : 1.0;
+    dVector3 p;
+    p[0] = pos[0] + R[2] * halfLength * sign;
+    p[1] = pos[1] + R[6] * halfLength * sign;
+    p[2] = pos[2] + R[10] * halfLength * sign;
+    dReal k = p[0] * n[0] + p[1] * n[1] + p[2] * n[2];
+    dReal depth = n[3] - k + radius;
+    if (depth < 0) return 0;
+
+    contact->pos[0] = p[0] - n[0] * radius;
+    contact->pos[1] = p[1] - n[1] * radius;
+    contact->pos[2] = p[2] - n[2] * radius;
+    contact->depth = depth;
+    int numContacts = 1;
+
+    if (maxContacts >= 2)
+    {
+        p[0] = pos[0] - R[2] * halfLength * sign;
+        p[1] = pos[1] - R[6] * halfLength * sign;
+        p[2] = pos[2] - R[10] * halfLength * sign;
+        k = p[0] * n[0] + p[1] * n[1] + p[2] * n[2];
+        depth = n[3] - k + radius;
+        if (depth >= 0)
+        {
+            dContactGeom *c2 = CONTACT(contact, skip);
+            c2->pos[0] = p[0] - n[0] * radius;
+            c2->pos[1] = p[1] - n[1] * radius;
+            c2->pos[2] = p[2] - n[2] * radius;
+            c2->depth = depth;
+            numContacts = 2;
+        }
+    }
+
+    for (int i = 0; i < numContacts; i++)
+    {
+        dContactGeom *c = CONTACT(contact, i * skip);
+        c->normal[0] = n[0];
+        c->normal[1] = n[1];
+        c->normal[2] = n[2];
+        c->g1 = geom;
+        c->g2 = plane;
+        c->side1 = -1;
+        c->side2 = -1;
+    }
+    return numContacts;
+}
+
+// the first contact is the deepest corner and the next two are the corners along the edges
+// with the smallest projected lengths and the fourth is the corner opposite the first
+int PlaneCollider::CollideBox(dGeomID geom, dGeomID plane, const dReal *n, int maxContacts, dContactGeom *contact, int skip)
+{
+    const dReal *pos = dGeomGetPosition(geom);
+    const dReal *R = dGeomGetRotation(geom);
+    dVector3 side;
+    dGeomBoxGetLengths(geom, side);
+
+    // project the sides along the normal
+    dReal A[3], B[3];
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        A[i] = side[i] * (n[0] * R[i] + n[1] * R[4 + i] + n[2] * R[8 + i]);
+        B[i] = std::fabs(A[i]);
+    }
+
+    dReal depth = n[3] + 0.5 * (B[0] + B[1] + B[2]) - (n[0] * pos[0] + n[1] * pos[1] + n[2] * pos[2]);
+    if (depth < 0) return 0;
+    if (maxContacts > 4) maxContacts = 4;
+
+    // the deepest point
+    dVector3 p;
+    p[0] = pos[0];
+    p[1] = pos[1];
+    p[2] = pos[2];
+    for (i = 0; i < 3; i++)
+    {
+        if (A[i] > 0)
+        {
+            p[0] -= 0.5 * side[i] * R[i];
+            p[1] -= 0.5 * side[i] * R[4 + i];
+            p[2] -= 0.5 * side[i] * R[8 + i];
+        }
+        else
+        {
+            p[0] += 0.5 * side[i] * R[i];
+            p[1] += 0.5 * side[i] * R[4 + i];
+            p[2] += 0.5 * side[i] * R[8 + i];
+        }
+    }
+    contact->pos[0] = p[0];
+    contact->pos[1] = p[1];
+    contact->pos[2] = p[2];
+    contact->depth = depth;
+    int numContacts = 1;
+
+    if (maxContacts > 1)
+    {
+        // the order that the sides are used in
+        int order[2];
+        if (B[0] < B[1])
+        {
+            if (B[2] < B[0]) { order[0] = 2; order[1] = 0; }
+            else { order[0] = 0; order[1] = (B[1] < B[2]) ? 1 : 2; }
+        }
+        else
+        {
+            if (B[2] < B[1]) { order[0] = 2; order[1] = 1; }
+            else { order[0] = 1; order[1] = (B[0] < B[2]) ? 0 : 2; }
+        }
+
+        int j;
+        dContactGeom *c;
+        for (int ct = 1; ct <= 2 && ct < maxContacts; ct++)
+        {
+            j = order[ct - 1];
+            if (depth - B[j] < 0) break;
+            c = CONTACT(contact, ct * skip);
+            if (A[j] > 0)
+            {
+                c->pos[0] = p[0] + side[j] * R[j];
+                c->pos[1] = p[1] + side[j] * R[4 + j];
+                c->pos[2] = p[2] + side[j] * R[8 + j];
+            }
+            else
+            {
+                c->pos[0] = p[0] - side[j] * R[j];
+                c->pos[1] = p[1] - side[j] * R[4 + j];
+                c->pos[2] = p[2] - side[j] * R[8 + j];
+            }
+            c->depth = depth - B[j];
+            numContacts++;
+        }
+
+        if (maxContacts == 4 && numContacts == 3)
+        {
+            dContactGeom *c1 = CONTACT(contact, skip);
+            dContactGeom *c2 = CONTACT(contact, 2 * skip);
+            dReal d4 = c1->depth + c2->depth - depth;
+            if (d4 > 0)
+            {
+                c = CONTACT(contact, 3 * skip);
+                c->pos[0] = c1->pos[0] + c2->pos[0] - p[0];
+                c->pos[1] = c1->pos[1] + c2->pos[1] - p[1];
+                c->pos[2] = c1->pos[2] + c2->pos[2] - p[2];
+                c->depth = d4;
+                numContacts++;
+            }
+        }
+    }
+
+    for (i = 0; i < numContacts; i++)
+    {
+        dContactGeom *c = CONTACT(contact, i * skip);
+        c->normal[0] = n[0];
+        c->normal[1] = n[1];
+        c->normal[2] = n[2];
+        c->g1 = geom;
+        c->g2 = plane;
+        c->side1 = -1;
+        c->side2 = -1;
+    }
+    return numContacts;
+}
@@ -0,0 +1,34 @@
+/*
+ *  PlaneCollider.h
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Contact generation for sphere, capsule and box geoms against
+ *  a plane without going through the general dCollide dispatch
+ *
+ */
+
+#ifndef PLANECOLLIDER_H
+#define PLANECOLLIDER_H
+
+#include <ode/ode.h>
+
+class PlaneCollider
+{
+public:
+
+    // the contacts are generated in the same way as the ODE plane colliders so the results are the same as dCollide
+    // geom is the primitive and plane is the plane and the contacts are returned in that order
+    // returns the number of contacts or -1 if the geom class is not handled here
+    static int Collide(dGeomID geom, dGeomID plane, int maxContacts, dContactGeom *contact, int skip);
+
+protected:
+
+    static int CollideSphere(dGeomID geom, dGeomID plane, const dReal *n, dContactGeom *contact);
+    static int CollideCapsule(dGeomID geom, dGeomID plane, const dReal *n, int maxContacts, dContactGeom *contact, int skip);
+    static int CollideBox(dGeomID geom, dGeomID plane, const dReal *n, int maxContacts, dContactGeom *contact, int skip);
+};
+
+#endif // PLANECOLLIDER_H
@@ -261,14 +261,12 @@ void PositionReporter::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "NamedObject::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tXP\tYP\tZP\tQW\tQX\tQY\tQZ\n";
+            m_DumpStream->SetUnits("s\tm\tm\tm\t\t\t\t");
         }
     }
 
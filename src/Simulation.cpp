@@ -61,11 +61,19 @@
 #include "PIDTargetMatch.h"
 #include "Warehouse.h"
 #include "FixedDriver.h"
+#include "DriverEngine.h"
+#include "LimitChecker.h"
+#include "PlaneCollider.h"
+#include "Checkpoint.h"
+#include "FitnessCache.h"
+#include "FastDouble.h"
+#include "ParseArena.h"
+#include "StepThreadPool.h"
 
 #ifdef USE_QT
 #include "GLUtils.h"
 #include "FacetedObject.h"
-static bool SortOnAlpha(FacetedObject* d1, FacetedObject* d2);
+#include "MeshCache.h"
 #endif
 
 #if defined(USE_QT) // && !defined(USE_WI_BB) // this is a bit odd - I'm not sure why it is here in the USE_WI_BB version
@@ -80,6 +88,7 @@ static bool SortOnAlpha(FacetedObject* d1, FacetedObject* d2);
 
 #include <libxml/xmlmemory.h>
 #include <libxml/parser.h>
+#include <libxml/xmlreader.h>
 
 #include <typeinfo>
 #include <iostream>
@@ -92,24 +101,26 @@ static bool SortOnAlpha(FacetedObject* d1, FacetedObject* d2);
 #include <ctype.h>
 #include <cmath>
 #include <cmath>
+#include <random>
 
 
 extern char *gGraphicsRoot;
 extern int gDisplaySkip;
 extern bool gDelayedDraw;
-extern std::list<FacetedObject *> gDelayedDrawList;
+extern std::vector<FacetedObject *> gDelayedDrawList;
 
 #define _I(i,j) I[(i)*4+(j)]
 
+// the parse arena is shared by all the simulations on a thread and its lists move when they grow
+// so the scratch storage is fetched from the arena at each use rather than kept
+static inline char *ArenaBuffer() { return ParseArena::GetArena()->GetBuffer(0); }
+static inline char **ArenaPointerList() { return ParseArena::GetArena()->GetPointerList(0); }
+static inline double *ArenaDoubleList() { return ParseArena::GetArena()->GetDoubleList(0); }
+
 Simulation::Simulation()
 {
-    // allocate some general purpose memory
-    // this is assumed to be big enough!
-    m_BufferSize = 1000000;
-    m_Buffer = new char[m_BufferSize];
-    m_LargeBuffer = new char[m_BufferSize * 10];
-    m_BufferPtrs = new char *[m_BufferSize];
-    m_DoubleList = new double[m_BufferSize];
+    m_AttributeIndexNode = 0;
+    m_AttributeIndexProperties = 0;
 
     // initialise the ODE world
     dInitODE();
@@ -119,6 +130,12 @@ Simulation::Simulation()
 
     m_Environment = new Environment();
     m_MaxContacts = 16;
+    m_ContactGeomList.resize(m_MaxContacts);
+    m_FastPlaneCollider = false; // only on when requested until it has been checked against the ODE in use (-PCC)
+    m_NumContactMaterials = 0;
+    m_DriverEngine = 0;
+    m_LimitChecker = 0;
+    m_CatastropheCheckInterval = 1;
 
     // set some variables
     m_SimulationTime = 0;
@@ -150,6 +167,7 @@ Simulation::Simulation()
     m_AllowInternalCollisions = true;
     m_AllowConnectedCollisions = false;
     m_StepType = WorldStep;
+    m_MuscleSubSteps = 1;
     m_ContactAbort = false;
     m_SimulationError = 0;
     m_DataTargetAbort = false;
@@ -163,6 +181,9 @@ Simulation::Simulation()
     m_WarehouseDecreaseThresholdFactor = 0;
     m_OutputKinematicsFirstTimeFlag = true;
     m_OutputWarehouseLastTime = -DBL_MAX;
+    m_CheckpointInterval = 0;
+    m_NextCheckpointTime = 0;
+    m_ModelHash = 0;
     m_OutputModelStateAtWarehouseDistance = 0;
     m_OutputWarehouseAsText = true;
     m_WarehouseFailDistanceAbort = 0;
@@ -253,6 +274,8 @@ Simulation::~Simulation()
     for (std::map<std::string, Warehouse *>::const_iterator iter = m_WarehouseList.begin(); iter != m_WarehouseList.end(); iter++) delete iter->second;
 
     delete m_Environment;
+    if (m_DriverEngine) delete m_DriverEngine;
+    if (m_LimitChecker) delete m_LimitChecker;
 
     // destroy the ODE world
 #ifdef OPENGL
@@ -260,34 +283,54 @@ Simulation::~Simulation()
 #endif
     dJointGroupDestroy(m_ContactGroup);
     dSpaceDestroy(m_SpaceID);
+    StepThreadPool::GetPool()->Detach(m_WorldID);
     dWorldDestroy(m_WorldID);
     dCloseODE();
 
-    // clear the stored xml data
-    std::vector<xmlNodePtr>::const_iterator iter0;
-    for (iter0 = m_TagContentsList.begin(); iter0 != m_TagContentsList.end(); iter0++)
-        xmlFreeNode(*iter0);
-
     // delete the rest of the allocated memory
     for (unsigned int c = 0; c < m_ContactList.size(); c++) delete m_ContactList[c];
 
     // close any open files
     if (m_OutputWarehouseFlag) m_OutputWarehouseFile.close();
     if (m_OutputKinematicsFlag) m_OutputKinematicsFile.close();
+    // and wait for the writer thread to finish all the queued output
+    // (nothing to do if no output was ever opened)
+    AsyncOutputWriter *writer = AsyncOutputWriter::GetExistingWriter();
+    if (writer)
+    {
+        writer->CloseDumpContainer();
+        writer->Flush();
+    }
+
 
-    delete [] m_Buffer;
-    delete [] m_LargeBuffer;
-    delete [] m_BufferPtrs;
-    delete [] m_DoubleList;
+}
+
+//----------------------------------------------------------------------------
+// the stored elements are written without any added formatting so that the same element always gives the same text
+static void SerialiseXmlNode(xmlNodePtr node, std::string *text)
+{
+    xmlBufferPtr buffer = xmlBufferCreate();
+    xmlNodeDump(buffer, node->doc, node, 0, 0);
+    text->assign((const char *)xmlBufferContent(buffer), xmlBufferLength(buffer));
+    xmlBufferFree(buffer);
+}
 
+static xmlDocPtr ParseXmlElement(const std::string &text)
+{
+    return xmlReadMemory(text.data(), int(text.size()), 0, 0, XML_PARSE_HUGE);
 }
 
 //----------------------------------------------------------------------------
 int Simulation::LoadModel(char *xmlDataBuffer)
 {
-    xmlDocPtr doc;
-    xmlNodePtr cur, nodeCopy;
+    xmlTextReaderPtr reader;
+    xmlNodePtr cur = 0, expanded;
+    char *buf;
     int size = strlen(xmlDataBuffer);
+    int ret;
+
+    // checkpoints can only be restored into the model that wrote them
+    m_ModelHash = FitnessCache::Hash(xmlDataBuffer, size);
 
     if (gDebug == SimulationDebug)
     {
@@ -295,11 +338,12 @@ int Simulation::LoadModel(char *xmlDataBuffer)
                 xmlDataBuffer << "\n";
     }
 
-    // do the basic XML parsing
+    // the file is read as a stream so that only one top level element at a time is ever expanded
+    // and the elements are parsed in place with only their text kept in m_TagContentsList
 
-    doc = xmlReadMemory(xmlDataBuffer, size, 0, 0, XML_PARSE_HUGE);
+    reader = xmlReaderForMemory(xmlDataBuffer, size, 0, 0, XML_PARSE_HUGE);
 
-    if (doc == NULL )
+    if (reader == NULL )
     {
 #if defined(USE_QT) && !defined(USE_WI_BB)
         m_MainWindow->log("Document not parsed successfully");
@@ -312,38 +356,62 @@ int Simulation::LoadModel(char *xmlDataBuffer)
     m_MainWindow->log("Valid XML Document found");
 #endif
 
-    cur = xmlDocGetRootElement(doc);
+    while ((ret = xmlTextReaderRead(reader)) == 1 && xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {}
 
-    if (cur == NULL)
+    if (ret != 1)
     {
 #if defined(USE_QT) && !defined(USE_WI_BB)
         m_MainWindow->log("Document empty error");
 #endif
         fprintf(stderr,"Empty document\n");
-        xmlFreeDoc(doc);
+        xmlFreeTextReader(reader);
         return 1;
     }
 
-    if (xmlStrcmp(cur->name, (const xmlChar *) "GAITSYMODE"))
+    if (xmlStrcmp(xmlTextReaderConstName(reader), (const xmlChar *) "GAITSYMODE"))
     {
 #if defined(USE_QT) && !defined(USE_WI_BB)
         m_MainWindow->log("Document of the wrong type, root node != GAITSYMODE");
 #endif
         fprintf(stderr,"Document of the wrong type, root node != GAITSYMODE\n");
-        xmlFreeDoc(doc);
+        xmlFreeTextReader(reader);
         return 1;
     }
 
+#ifdef USE_QT
+    // load all the body meshes in parallel before they are needed
+    PrefetchMeshes(xmlDataBuffer, size);
+#endif
+
     // now parse the elements in the file
 
     try
     {
-        cur = cur->xmlChildrenNode;
+        if (xmlTextReaderIsEmptyElement(reader)) ret = 0;
+        else ret = xmlTextReaderRead(reader);
 
-        while (cur != NULL)
+        while (ret == 1 && xmlTextReaderDepth(reader) > 0)
         {
-            nodeCopy = xmlCopyNode(cur, 1);
-            m_TagContentsList.push_back(nodeCopy);
+            // only the top level elements are needed (comments and white space are ignored)
+            if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT || xmlTextReaderDepth(reader) != 1)
+            {
+                ret = xmlTextReaderRead(reader);
+                continue;
+            }
+
+            expanded = xmlTextReaderExpand(reader);
+            if (expanded == 0)
+            {
+                ret = -1;
+                break;
+            }
+            cur = expanded;
+            m_TagContentsList.push_back(TagContents());
+            m_TagContentsList.back().name = (const char *)cur->name;
+            SerialiseXmlNode(cur, &m_TagContentsList.back().xml);
+            m_AttributeIndexNode = 0;
+            buf = DoXmlGetProp(cur, (const xmlChar *)"ID");
+            if (buf) m_TagContentsList.back().ID = buf;
 
             if (gDebug == XMLDebug)
             {
@@ -382,9 +450,25 @@ int Simulation::LoadModel(char *xmlDataBuffer)
 #endif
             }
 
-            cur = cur->next;
+            // this skips the rest of the element and frees the expanded nodes
+            ret = xmlTextReaderNext(reader);
         }
 
+        if (ret == -1)
+        {
+#if defined(USE_QT) && !defined(USE_WI_BB)
+            m_MainWindow->log("Document not parsed successfully");
+#endif
+            fprintf(stderr,"Document not parsed successfully.\n");
+            cur = 0;
+            throw __LINE__;
+        }
+        xmlFreeTextReader(reader);
+        reader = 0;
+        cur = 0; // the expanded nodes have gone with the reader
+#ifdef USE_QT
+        MeshCache::GetCache()->Clear();
+#endif
 
         // and do the late initialisation
         std::map<std::string, Muscle *>::const_iterator iter2;
@@ -397,6 +481,20 @@ int Simulation::LoadModel(char *xmlDataBuffer)
             iter2->second->LateInitialisation();
         }
 
+        // set the collision filters now that all the geoms and joints exist
+        AssignCollisionBits();
+
+        // and build the contact surface for every pair of geom contact parameters
+        CompileContactMaterials();
+
+        // compile the drivers into the lookup tables used by UpdateSimulation
+        m_DriverEngine = new DriverEngine();
+        m_DriverEngine->Compile(&m_DriverList);
+
+        // and the body bounds into the arrays used by TestForCatastrophy
+        m_LimitChecker = new LimitChecker();
+        m_LimitChecker->Compile(&m_BodyList, &m_JointList);
+
         m_DistanceTravelledBodyID = m_BodyList[m_DistanceTravelledBodyIDName];
         if (m_DistanceTravelledBodyID == 0)
         {
@@ -502,7 +600,7 @@ int Simulation::LoadModel(char *xmlDataBuffer)
             m_MainWindow->log(ss.str().c_str());
     #endif
         }
-        xmlFreeDoc(doc);
+        if (reader) xmlFreeTextReader(reader);
         return 1;
     }
 
@@ -515,11 +613,146 @@ int Simulation::LoadModel(char *xmlDataBuffer)
     }
 #endif
 
-    xmlFreeDoc(doc);
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// this is used by the fork server so that a child can start from a copy of a model that
+// has already been loaded and only re-read the elements that the genome has changed
+// only DRIVER elements can be re-read because nothing else refers to them and
+// 1 is returned if anything else has changed (or the model has been run) so that the
+// model has to be loaded again
+int Simulation::UpdateModel(char *xmlDataBuffer)
+{
+    if (m_StepCount != 0) return 1;
+
+    xmlTextReaderPtr reader;
+    xmlNodePtr expanded;
+    xmlDocPtr doc = 0;
+    int size = strlen(xmlDataBuffer);
+    int ret;
+    bool match = true;
+    unsigned int index = 0, i;
+    char *buf;
+    std::string text;
+    std::vector<unsigned int> changedIndexList;
+    std::vector<std::string> changedTextList;
+
+    reader = xmlReaderForMemory(xmlDataBuffer, size, 0, 0, XML_PARSE_HUGE);
+    if (reader == NULL) return 1;
+
+    // the top level elements are compared in order with the text of the ones that were loaded
+    while ((ret = xmlTextReaderRead(reader)) == 1 && xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {}
+    if (ret != 1 || xmlStrcmp(xmlTextReaderConstName(reader), (const xmlChar *) "GAITSYMODE")) match = false;
+    else
+    {
+        if (xmlTextReaderIsEmptyElement(reader)) ret = 0;
+        else ret = xmlTextReaderRead(reader);
+
+        while (ret == 1 && xmlTextReaderDepth(reader) > 0)
+        {
+            if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT || xmlTextReaderDepth(reader) != 1)
+            {
+                ret = xmlTextReaderRead(reader);
+                continue;
+            }
+
+            expanded = xmlTextReaderExpand(reader);
+            if (expanded == 0 || index >= m_TagContentsList.size())
+            {
+                match = false;
+                break;
+            }
+            SerialiseXmlNode(expanded, &text);
+            if (text != m_TagContentsList[index].xml)
+            {
+                if (xmlStrcmp(expanded->name, (const xmlChar *)"DRIVER") || m_TagContentsList[index].name != "DRIVER")
+                {
+                    match = false;
+                    break;
+                }
+                // the changed drivers must keep their IDs otherwise they could replace a different driver
+                m_AttributeIndexNode = 0;
+                buf = DoXmlGetProp(expanded, (const xmlChar *)"ID");
+                if (buf == 0 || m_TagContentsList[index].ID != buf || m_DriverList.find(m_TagContentsList[index].ID) == m_DriverList.end())
+                {
+                    match = false;
+                    break;
+                }
+                changedIndexList.push_back(index);
+                changedTextList.push_back(text);
+            }
+            index++;
+            ret = xmlTextReaderNext(reader);
+        }
+        if (ret == -1 || index != m_TagContentsList.size()) match = false;
+    }
+    xmlFreeTextReader(reader);
+    m_AttributeIndexNode = 0;
+
+    if (match == false) return 1;
+    if (changedIndexList.size() == 0) return 0;
+
+    try
+    {
+        for (i = 0; i < changedIndexList.size(); i++)
+        {
+            TagContents *tag = &m_TagContentsList[changedIndexList[i]];
+            Driver *oldDriver = m_DriverList[tag->ID];
+            m_DriverList.erase(tag->ID);
+
+            tag->xml = changedTextList[i];
+            THROWIFZERO(doc = ParseXmlElement(tag->xml));
+            m_AttributeIndexNode = 0;
+            ParseDriver(xmlDocGetRootElement(doc));
+            xmlFreeDoc(doc);
+            doc = 0;
+            m_AttributeIndexNode = 0;
+
+            Driver *newDriver = m_DriverList[tag->ID];
+            Drivable *oldTarget = oldDriver->GetTarget();
+            if (oldTarget)
+            {
+                if (newDriver->GetTarget() == oldTarget) oldTarget->ReplaceDriver(oldDriver, newDriver);
+                else oldTarget->RemoveDriver(oldDriver);
+            }
+            delete oldDriver;
+        }
+
+        // LoadModel takes the cycle time from the last cyclic driver in the file
+        for (i = 0; i < m_TagContentsList.size(); i++)
+        {
+            if (m_TagContentsList[i].name != "DRIVER") continue;
+            Driver *driver = m_DriverList[m_TagContentsList[i].ID];
+            if (dynamic_cast<CyclicDriver *>(driver)) m_CycleTime = dynamic_cast<CyclicDriver *>(driver)->GetCycleTime();
+            else if (dynamic_cast<BoxCarDriver *>(driver)) m_CycleTime = dynamic_cast<BoxCarDriver *>(driver)->GetCycleTime();
+            else if (dynamic_cast<StackedBoxCarDriver *>(driver)) m_CycleTime = dynamic_cast<StackedBoxCarDriver *>(driver)->GetCycleTimes()->at(0);
+        }
+    }
+
+    catch (int e)
+    {
+        std::cerr << "Error updating DRIVER on line: " << e << "\n";
+        if (doc) xmlFreeDoc(doc);
+        m_AttributeIndexNode = 0;
+        return 1;
+    }
+
+    m_DriverEngine->Compile(&m_DriverList);
+    m_ModelHash = FitnessCache::Hash(xmlDataBuffer, size);
     return 0;
 }
 
 
+//----------------------------------------------------------------------------
+size_t Simulation::GetStoredModelBytes()
+{
+    size_t bytes = m_TagContentsList.capacity() * sizeof(TagContents);
+    for (size_t i = 0; i < m_TagContentsList.size(); i++)
+        bytes += m_TagContentsList[i].name.capacity() + m_TagContentsList[i].ID.capacity() + m_TagContentsList[i].xml.capacity();
+    return bytes;
+}
+
 //----------------------------------------------------------------------------
 void Simulation::UpdateSimulation()
 {
@@ -534,6 +767,14 @@ void Simulation::UpdateSimulation()
         return;
     }
 
+    UpdateCollisions();
+    UpdateMuscles();
+    UpdateWorld();
+}
+
+// the fitness matching and the collision detection at the start of each step
+void Simulation::UpdateCollisions()
+{
     // calculate the warehouse and position matching fitnesses before we move to a new location
     if (m_FitnessType != DistanceTravelled)
     {
@@ -579,7 +820,12 @@ void Simulation::UpdateSimulation()
     std::map<std::string, Geom *>::const_iterator GeomIter;
     for (GeomIter = m_GeomList.begin(); GeomIter != m_GeomList.end(); GeomIter++) GeomIter->second->ClearContacts();
     dSpaceCollide(m_SpaceID, this, &NearCallback);
+}
 
+// the driver values and the muscle forces
+// SimulationBatch replaces this with its own interleaved version so the two need to be kept in step
+void Simulation::UpdateMuscles()
+{
     bool activationsDone = false;
 
 //    if (activationsDone == false)
@@ -594,6 +840,13 @@ void Simulation::UpdateSimulation()
 //        }
 //    }
 
+    // evaluate all the drivers in one pass and set the driver sums directly
+    if (m_DriverEngine)
+    {
+        m_DriverEngine->Evaluate(m_SimulationTime);
+        activationsDone = true;
+    }
+
     // update the muscles
     double tension;
     std::vector<PointForce *> *pointForceList;
@@ -602,7 +855,7 @@ void Simulation::UpdateSimulation()
     for (iter1 = m_MuscleList.begin(); iter1 != m_MuscleList.end(); iter1++)
     {
         if (activationsDone == false) iter1->second->SumDrivers(m_SimulationTime);
-        iter1->second->SetActivation(iter1->second->GetCurrentDriverSum(), m_StepSize);
+        iter1->second->SubStepActivation(iter1->second->GetCurrentDriverSum(), m_StepSize);
         iter1->second->CalculateStrap(m_StepSize);
 
         pointForceList = iter1->second->GetPointForceList();
@@ -626,10 +879,15 @@ void Simulation::UpdateSimulation()
         std::cerr.unsetf(std::ios::floatfield);
 #endif
     }
+}
+
+// the joints, the outputs, the world step and everything that is reported after the step
+void Simulation::UpdateWorld()
+{
+    std::map<std::string, Muscle *>::const_iterator iter1;
 
     // update the joints (needed for motors, end stops and stress calculations)
-    std::map<std::string, Joint *>::const_iterator jointIter;
-    for (jointIter = m_JointList.begin(); jointIter != m_JointList.end(); jointIter++) jointIter->second->Update();
+    m_LimitChecker->UpdateJoints();
 
 
 #ifndef OUTPUTS_AFTER_SIMULATION_STEP
@@ -1097,6 +1355,13 @@ void Simulation::UpdateSimulation()
         m_OutputModelStateAtWarehouseDistance = 0;
     }
 #endif
+
+    if (m_CheckpointInterval > 0 && m_SimulationTime >= m_NextCheckpointTime)
+    {
+        WriteCheckpointFile(m_CheckpointFilename.c_str());
+        m_NextCheckpointTime += m_CheckpointInterval;
+        if (m_NextCheckpointTime <= m_SimulationTime) m_NextCheckpointTime = (floor(m_SimulationTime / m_CheckpointInterval) + 1) * m_CheckpointInterval;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -1153,134 +1418,143 @@ bool Simulation::TestForCatastrophy()
         return true;
     }
 
-    // check that all bodies meet velocity and stop conditions
+    // check that all bodies, joints and reporters are within their limits
+    if (m_CatastropheCheckInterval <= 1 || m_StepCount % m_CatastropheCheckInterval == 0)
+    {
+        if (TestObjectLimits()) return true;
+    }
 
-    std::map<std::string, Body *>::const_iterator iter1;
-    LimitTestResult p;
-    for (iter1 = m_BodyList.begin(); iter1 != m_BodyList.end(); iter1++)
+    // test for WarehouseFailDistanceAbort if set
+    if (m_WarehouseFailDistanceAbort > 0 && m_WarehouseList.size() > 0 && m_FitnessType != ClosestWarehouse)
     {
-        p = iter1->second->TestLimits();
-        switch (p)
+        if (m_WarehouseDistance > m_WarehouseFailDistanceAbort)
         {
-        case WithinLimits:
-            break;
-
-        case XPosError:
-        case YPosError:
-        case ZPosError:
 #if defined(USE_QT) && !defined(USE_WI_BB)
-            ss << "Failed due to position error " << p << " in: " << *iter1->second->GetName();
+            ss << __FILE__ << "Failed due to >WarehouseFailDistanceAbort. m_WarehouseFailDistanceAbort=" << m_WarehouseFailDistanceAbort << " WarehouseDistance = " << m_WarehouseDistance;
             m_MainWindow->log(ss.str().c_str());
 #endif
-            std::cerr << "Failed due to position error " << p << " in: " << *iter1->second->GetName() << "\n";
+            std::cerr << "Failed due to >WarehouseFailDistanceAbort. m_WarehouseFailDistanceAbort=" << m_WarehouseFailDistanceAbort << " WarehouseDistance = " << m_WarehouseDistance << "\n";
             return true;
-
-        case XVelError:
-        case YVelError:
-        case ZVelError:
+        }
+    }
+    else if (m_WarehouseFailDistanceAbort < 0 && m_WarehouseList.size() > 0 && m_FitnessType != ClosestWarehouse && m_SimulationTime > 0)
+    {
+        if (m_WarehouseDistance < std::fabs(m_WarehouseFailDistanceAbort))
+        {
 #if defined(USE_QT) && !defined(USE_WI_BB)
-            ss << "Failed due to velocity error " << p << " in: " << *iter1->second->GetName();
+            ss << __FILE__ << "Failed due to <WarehouseFailDistanceAbort. m_WarehouseFailDistanceAbort=" << m_WarehouseFailDistanceAbort << " WarehouseDistance = " << m_WarehouseDistance;
             m_MainWindow->log(ss.str().c_str());
 #endif
-            std::cerr << "Failed due to velocity error " << p << " in: " << *iter1->second->GetName() << "\n";
+            std::cerr << "Failed due to <WarehouseFailDistanceAbort. m_WarehouseFailDistanceAbort=" << m_WarehouseFailDistanceAbort << " WarehouseDistance = " << m_WarehouseDistance << "\n";
             return true;
+        }
+    }
 
-        case NumericalError:
+    if (m_OutputModelStateOccured && m_AbortAfterModelStateOutput)
+    {
 #if defined(USE_QT) && !defined(USE_WI_BB)
-            ss << "Failed due to numerical error " << p << " in: " << *iter1->second->GetName();
-            m_MainWindow->log(ss.str().c_str());
+        ss << __FILE__ << "Abort because ModelState successfully written";
+        m_MainWindow->log(ss.str().c_str());
 #endif
-            std::cerr << "Failed due to numerical error " << p << " in: " << *iter1->second->GetName() << "\n";
-            return true;
-        }
+        std::cerr << "Abort because ModelState successfully written\n";
+        return true;
     }
 
-    std::map<std::string, Joint *>::const_iterator iter3;
-    HingeJoint *j;
-    FixedJoint *f;
-    int t;
-    for (iter3 = m_JointList.begin(); iter3 != m_JointList.end(); iter3++)
+    return false;
+}
+
+// the limit tests for the individual objects
+bool Simulation::TestObjectLimits()
+{
+#if defined(USE_QT) && !defined(USE_WI_BB)
+    std::stringstream ss;
+#endif
+
+    // check that all bodies meet velocity and stop conditions
+    // the individual bodies are only tested to find the one that failed
+    if (m_LimitChecker->BodiesOutsideLimits())
     {
-        j = dynamic_cast<HingeJoint *>(iter3->second);
-        if (j)
+        std::map<std::string, Body *>::const_iterator iter1;
+        LimitTestResult p;
+        for (iter1 = m_BodyList.begin(); iter1 != m_BodyList.end(); iter1++)
         {
-            t = j->TestLimits();
-            if (t < 0)
+            p = iter1->second->TestLimits();
+            switch (p)
             {
+            case WithinLimits:
+                break;
+
+            case XPosError:
+            case YPosError:
+            case ZPosError:
 #if defined(USE_QT) && !defined(USE_WI_BB)
-                ss << __FILE__ << "Failed due to LoStopTorqueLimit error in: " << *iter3->second->GetName();
+                ss << "Failed due to position error " << p << " in: " << *iter1->second->GetName();
                 m_MainWindow->log(ss.str().c_str());
 #endif
-                std::cerr << "Failed due to LoStopTorqueLimit error in: " << *iter3->second->GetName() << "\n";
+                std::cerr << "Failed due to position error " << p << " in: " << *iter1->second->GetName() << "\n";
                 return true;
-            }
-            else if (t > 0)
-            {
+
+            case XVelError:
+            case YVelError:
+            case ZVelError:
+#if defined(USE_QT) && !defined(USE_WI_BB)
+                ss << "Failed due to velocity error " << p << " in: " << *iter1->second->GetName();
+                m_MainWindow->log(ss.str().c_str());
+#endif
+                std::cerr << "Failed due to velocity error " << p << " in: " << *iter1->second->GetName() << "\n";
+                return true;
+
+            case NumericalError:
 #if defined(USE_QT) && !defined(USE_WI_BB)
-                ss << __FILE__ << "Failed due to HiStopTorqueLimit error in: " << *iter3->second->GetName();
+                ss << "Failed due to numerical error " << p << " in: " << *iter1->second->GetName();
                 m_MainWindow->log(ss.str().c_str());
 #endif
-                std::cerr << "Failed due to HiStopTorqueLimit error in: " << *iter3->second->GetName() << "\n";
+                std::cerr << "Failed due to numerical error " << p << " in: " << *iter1->second->GetName() << "\n";
                 return true;
             }
         }
     }
 
-    // and test the reporters for stop conditions
-    std::map<std::string, Reporter *>::const_iterator ReporterIter;
-    for (ReporterIter = m_ReporterList.begin(); ReporterIter != m_ReporterList.end(); ReporterIter++)
+    // the hinge torque limits were tested when the stop torques were calculated
+    HingeJoint *j;
+    int t = m_LimitChecker->HingeJointsOutsideLimits(&j);
+    if (t < 0)
     {
-        if (ReporterIter->second->ShouldAbort())
-        {
 #if defined(USE_QT) && !defined(USE_WI_BB)
-            ss << __FILE__ << "Failed due to Reporter Abort in: " << *ReporterIter->second->GetName();
-            m_MainWindow->log(ss.str().c_str());
+        ss << __FILE__ << "Failed due to LoStopTorqueLimit error in: " << *j->GetName();
+        m_MainWindow->log(ss.str().c_str());
 #endif
-            std::cerr << "Failed due to Reporter Abort in: " << *ReporterIter->second->GetName() << "\n";
-            return true;
-        }
+        std::cerr << "Failed due to LoStopTorqueLimit error in: " << *j->GetName() << "\n";
+        return true;
     }
-
-    // test for WarehouseFailDistanceAbort if set
-    if (m_WarehouseFailDistanceAbort > 0 && m_WarehouseList.size() > 0 && m_FitnessType != ClosestWarehouse)
+    else if (t > 0)
     {
-        if (m_WarehouseDistance > m_WarehouseFailDistanceAbort)
-        {
 #if defined(USE_QT) && !defined(USE_WI_BB)
-            ss << __FILE__ << "Failed due to >WarehouseFailDistanceAbort. m_WarehouseFailDistanceAbort=" << m_WarehouseFailDistanceAbort << " WarehouseDistance = " << m_WarehouseDistance;
-            m_MainWindow->log(ss.str().c_str());
+        ss << __FILE__ << "Failed due to HiStopTorqueLimit error in: " << *j->GetName();
+        m_MainWindow->log(ss.str().c_str());
 #endif
-            std::cerr << "Failed due to >WarehouseFailDistanceAbort. m_WarehouseFailDistanceAbort=" << m_WarehouseFailDistanceAbort << " WarehouseDistance = " << m_WarehouseDistance << "\n";
-            return true;
-        }
+        std::cerr << "Failed due to HiStopTorqueLimit error in: " << *j->GetName() << "\n";
+        return true;
     }
-    else if (m_WarehouseFailDistanceAbort < 0 && m_WarehouseList.size() > 0 && m_FitnessType != ClosestWarehouse && m_SimulationTime > 0)
+
+    // and test the reporters for stop conditions
+    std::map<std::string, Reporter *>::const_iterator ReporterIter;
+    for (ReporterIter = m_ReporterList.begin(); ReporterIter != m_ReporterList.end(); ReporterIter++)
     {
-        if (m_WarehouseDistance < std::fabs(m_WarehouseFailDistanceAbort))
+        if (ReporterIter->second->ShouldAbort())
         {
 #if defined(USE_QT) && !defined(USE_WI_BB)
-            ss << __FILE__ << "Failed due to <WarehouseFailDistanceAbort. m_WarehouseFailDistanceAbort=" << m_WarehouseFailDistanceAbort << " WarehouseDistance = " << m_WarehouseDistance;
+            ss << __FILE__ << "Failed due to Reporter Abort in: " << *ReporterIter->second->GetName();
             m_MainWindow->log(ss.str().c_str());
 #endif
-            std::cerr << "Failed due to <WarehouseFailDistanceAbort. m_WarehouseFailDistanceAbort=" << m_WarehouseFailDistanceAbort << " WarehouseDistance = " << m_WarehouseDistance << "\n";
+            std::cerr << "Failed due to Reporter Abort in: " << *ReporterIter->second->GetName() << "\n";
             return true;
         }
     }
 
-    if (m_OutputModelStateOccured && m_AbortAfterModelStateOutput)
-    {
-#if defined(USE_QT) && !defined(USE_WI_BB)
-        ss << __FILE__ << "Abort because ModelState successfully written";
-        m_MainWindow->log(ss.str().c_str());
-#endif
-        std::cerr << "Abort because ModelState successfully written\n";
-        return true;
-    }
-
     return false;
 }
 
-
 //----------------------------------------------------------------------------
 double Simulation::CalculateInstantaneousFitness()
 {
@@ -1323,10 +1597,10 @@ void Simulation::ParseGlobal(xmlNodePtr cur)
     // gravity
     buf = DoXmlGetProp(cur, (const xmlChar *)"GravityVector");
     if (buf == 0) throw __LINE__;
-    Util::Double(buf, 3, m_DoubleList);
-    gravity[0] = m_DoubleList[0];
-    gravity[1] = m_DoubleList[1];
-    gravity[2] = m_DoubleList[2];
+    Util::Double(buf, 3, ArenaDoubleList());
+    gravity[0] = ArenaDoubleList()[0];
+    gravity[1] = ArenaDoubleList()[1];
+    gravity[2] = ArenaDoubleList()[2];
 
     // set the simulation integration step size
     buf = DoXmlGetProp(cur, (const xmlChar *)"IntegrationStepSize");
@@ -1391,6 +1665,71 @@ void Simulation::ParseGlobal(xmlNodePtr cur)
         else throw __LINE__;
     }
 
+    // get the collision space required
+    // Simple, tests every pair of geoms
+    // Hash, multi-resolution hash table, good for lots of geoms of similar sizes
+    // SweepAndPrune, sorted bounding boxes, good for lots of geoms spread along one axis
+    // this has to be set before any geoms are created
+    buf = DoXmlGetProp(cur, (const xmlChar *)"SpaceType");
+    if (buf)
+    {
+        if (dSpaceGetNumGeoms(m_SpaceID) != 0) throw __LINE__;
+        dSpaceID space;
+        if (strcmp((char *)buf, "Simple") == 0)
+        {
+            space = dSimpleSpaceCreate(0);
+        }
+        else if (strcmp((char *)buf, "Hash") == 0)
+        {
+            space = dHashSpaceCreate(0);
+            buf = DoXmlGetProp(cur, (const xmlChar *)"HashSpaceLevels");
+            if (buf)
+            {
+                Util::Double(buf, 2, ArenaDoubleList());
+                dHashSpaceSetLevels(space, (int)ArenaDoubleList()[0], (int)ArenaDoubleList()[1]);
+            }
+        }
+        else if (strcmp((char *)buf, "SweepAndPrune") == 0)
+        {
+            // the first axis is the one used for the sort so it should be the direction of travel
+            int axisOrder = dSAP_AXES_XYZ;
+            buf = DoXmlGetProp(cur, (const xmlChar *)"SweepAndPruneAxes");
+            if (buf)
+            {
+                if (strcmp((char *)buf, "XYZ") == 0) axisOrder = dSAP_AXES_XYZ;
+                else if (strcmp((char *)buf, "XZY") == 0) axisOrder = dSAP_AXES_XZY;
+                else if (strcmp((char *)buf, "YXZ") == 0) axisOrder = dSAP_AXES_YXZ;
+                else if (strcmp((char *)buf, "YZX") == 0) axisOrder = dSAP_AXES_YZX;
+                else if (strcmp((char *)buf, "ZXY") == 0) axisOrder = dSAP_AXES_ZXY;
+                else if (strcmp((char *)buf, "ZYX") == 0) axisOrder = dSAP_AXES_ZYX;
+                else throw __LINE__;
+            }
+            space = dSweepAndPruneSpaceCreate(0, axisOrder);
+        }
+        else throw __LINE__;
+        dSpaceDestroy(m_SpaceID);
+        m_SpaceID = space;
+    }
+
+    // the muscle dynamics can be sub-stepped so that the world step can be larger than a stiff tendon would allow
+    // this is the default for all muscles and can be set for individual muscles with SubSteps
+    buf = DoXmlGetProp(cur, (const xmlChar *)"MuscleSubSteps");
+    if (buf) m_MuscleSubSteps = Util::Int(buf);
+
+    // number of threads used to step the world (can be overridden from the command line)
+    buf = DoXmlGetProp(cur, (const xmlChar *)"StepThreads");
+    if (buf) StepThreadPool::GetPool()->Attach(m_WorldID, Util::Int(buf));
+    else StepThreadPool::GetPool()->Attach(m_WorldID, 1);
+
+    // the body, joint and reporter limits are only tested every CatastropheCheckInterval steps
+    // (the ODE and abort flags are still tested every step)
+    buf = DoXmlGetProp(cur, (const xmlChar *)"CatastropheCheckInterval");
+    if (buf)
+    {
+        m_CatastropheCheckInterval = Util::Int(buf);
+        if (m_CatastropheCheckInterval < 1) m_CatastropheCheckInterval = 1;
+    }
+
     // allow internal collisions
     buf = DoXmlGetProp(cur, (const xmlChar *)"AllowInternalCollisions");
     if (buf == 0) throw __LINE__;
@@ -1400,6 +1739,10 @@ void Simulation::ParseGlobal(xmlNodePtr cur)
     buf = DoXmlGetProp(cur, (const xmlChar *)"AllowConnectedCollisions");
     if (buf) m_AllowConnectedCollisions = Util::Bool(buf);
 
+    // sphere, capsule and box contacts with planes are generated directly rather than with dCollide (default false)
+    buf = DoXmlGetProp(cur, (const xmlChar *)"FastPlaneCollider");
+    if (buf) m_FastPlaneCollider = Util::Bool(buf);
+
     // now some run parameters
 
     buf = DoXmlGetProp(cur, (const xmlChar *)"BMR");
@@ -1469,8 +1812,8 @@ void Simulation::ParseEnvironment(xmlNodePtr cur)
 
     // planes
     THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"Plane"));
-    Util::Double(buf, 4, m_DoubleList);
-    PlaneGeom *plane = new PlaneGeom(m_SpaceID, m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+    Util::Double(buf, 4, ArenaDoubleList());
+    PlaneGeom *plane = new PlaneGeom(m_SpaceID, ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
     plane->SetGeomLocation(Geom::environment);
     m_Environment->AddGeom(plane);
 
@@ -1478,9 +1821,9 @@ void Simulation::ParseEnvironment(xmlNodePtr cur)
     buf = DoXmlGetProp(cur, (const xmlChar *)"TrackSensitivity");
     if (buf)
     {
-        Util::Double(buf, 2, m_DoubleList);
+        Util::Double(buf, 2, ArenaDoubleList());
         // list is lowRange, highRange
-        plane->SetTrackSensitivity(m_DoubleList[0], m_DoubleList[1]);
+        plane->SetTrackSensitivity(ArenaDoubleList()[0], ArenaDoubleList()[1]);
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"CheckerboardLow"); // these need to be set before SetTrackPatch
         if (buf) plane->SetCheckerboardLow(Util::Double(buf));
@@ -1488,9 +1831,9 @@ void Simulation::ParseEnvironment(xmlNodePtr cur)
         if (buf) plane->SetCheckerboardHigh(Util::Double(buf));
 
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"TrackPatch"));
-        Util::Double(buf, 6, m_DoubleList);
+        Util::Double(buf, 6, ArenaDoubleList());
         // list is trackPatchStartX, trackPatchStartY, trackPatchEndX, trackPatchEndY, trackPatchResolutionX, trackPatchResolutionY
-        plane->SetTrackPatch(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3], m_DoubleList[4], m_DoubleList[5]);
+        plane->SetTrackPatch(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3], ArenaDoubleList()[4], ArenaDoubleList()[5]);
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"TrackDrawThreshold");
         if (buf) plane->SetTrackDrawThreshold(Util::Double(buf));
@@ -1534,18 +1877,18 @@ void Simulation::ParseBody(xmlNodePtr cur)
     theMass = Util::Double(buf);
 
     THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"MOI"));
-    Util::Double(buf, 6, m_DoubleList);
+    Util::Double(buf, 6, ArenaDoubleList());
 
     // note: inertial matrix is as follows
     // [ I11 I12 I13 ]
     // [ I12 I22 I23 ]
     // [ I13 I23 I33 ]
-    I11 = m_DoubleList[0];
-    I22 = m_DoubleList[1];
-    I33 = m_DoubleList[2];
-    I12 = m_DoubleList[3];
-    I13 = m_DoubleList[4];
-    I23 = m_DoubleList[5];
+    I11 = ArenaDoubleList()[0];
+    I22 = ArenaDoubleList()[1];
+    I33 = ArenaDoubleList()[2];
+    I12 = ArenaDoubleList()[3];
+    I13 = ArenaDoubleList()[4];
+    I23 = ArenaDoubleList()[5];
     dMassSetParameters(&mass, theMass, 0, 0, 0, I11, I22, I33, I12, I13, I23);
     theBody->SetMass(&mass);
 
@@ -1553,26 +1896,26 @@ void Simulation::ParseBody(xmlNodePtr cur)
     buf = DoXmlGetProp(cur, (const xmlChar *)"PositionLowBound");
     if (buf)
     {
-        Util::Double(buf, 3, m_DoubleList);
-        theBody->SetPositionLowBound(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2]);
+        Util::Double(buf, 3, ArenaDoubleList());
+        theBody->SetPositionLowBound(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2]);
     }
     buf = DoXmlGetProp(cur, (const xmlChar *)"PositionHighBound");
     if (buf)
     {
-        Util::Double(buf, 3, m_DoubleList);
-        theBody->SetPositionHighBound(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2]);
+        Util::Double(buf, 3, ArenaDoubleList());
+        theBody->SetPositionHighBound(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2]);
     }
     buf = DoXmlGetProp(cur, (const xmlChar *)"LinearVelocityLowBound");
     if (buf)
     {
-        Util::Double(buf, 3, m_DoubleList);
-        theBody->SetLinearVelocityLowBound(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2]);
+        Util::Double(buf, 3, ArenaDoubleList());
+        theBody->SetLinearVelocityLowBound(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2]);
     }
     buf = DoXmlGetProp(cur, (const xmlChar *)"LinearVelocityHighBound");
     if (buf)
     {
-        Util::Double(buf, 3, m_DoubleList);
-        theBody->SetLinearVelocityHighBound(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2]);
+        Util::Double(buf, 3, ArenaDoubleList());
+        theBody->SetLinearVelocityHighBound(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2]);
     }
 
     // set damping if necessary
@@ -1604,13 +1947,7 @@ void Simulation::ParseBody(xmlNodePtr cur)
     }
 
     THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"GraphicFile"));
-    std::string filename;
-    if (gGraphicsRoot)
-    {
-        if (strlen(gGraphicsRoot) > 0)
-            filename = std::string(gGraphicsRoot) + std::string("/");
-    }
-    filename += std::string((const char *)buf);
+    std::string filename = GraphicFilename(buf);
     facetedObject->ParseOBJFile(filename.c_str());
 
     // parameters for altering mesh after it has been read
@@ -1628,9 +1965,9 @@ void Simulation::ParseBody(xmlNodePtr cur)
         {
             if (nTokens == 3)
             {
-                Util::Double(buf, 3, m_DoubleList);
-                if (m_DoubleList[0] != 1.0 || m_DoubleList[1] != 1.0 || m_DoubleList[2] != 1.0)
-                    facetedObject->Scale(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2]);
+                Util::Double(buf, 3, ArenaDoubleList());
+                if (ArenaDoubleList()[0] != 1.0 || ArenaDoubleList()[1] != 1.0 || ArenaDoubleList()[2] != 1.0)
+                    facetedObject->Scale(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2]);
             }
             else
             {
@@ -1649,9 +1986,9 @@ void Simulation::ParseBody(xmlNodePtr cur)
         buf = DoXmlGetProp(cur, (const xmlChar *)"Offset");
         if (buf)
         {
-            Util::Double(buf, 3, m_DoubleList);
-            theBody->SetOffset(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2]);
-            facetedObject->Move(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2]);
+            Util::Double(buf, 3, ArenaDoubleList());
+            theBody->SetOffset(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2]);
+            facetedObject->Move(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2]);
         }
     }
 
@@ -1706,6 +2043,71 @@ void Simulation::ParseBody(xmlNodePtr cur)
 }
 
 
+#ifdef USE_QT
+std::string Simulation::GraphicFilename(const char *graphicFile)
+{
+    std::string filename;
+    if (gGraphicsRoot)
+    {
+        if (strlen(gGraphicsRoot) > 0)
+            filename = std::string(gGraphicsRoot) + std::string("/");
+    }
+    filename += std::string(graphicFile);
+    return filename;
+}
+
+// reading the body meshes is the slowest part of loading a model so the BODY elements are scanned
+// first and all the meshes are loaded in parallel. ParseBody then gets them from the mesh cache
+// this only needs to find the common cases since anything missed is just loaded by ParseBody
+void Simulation::PrefetchMeshes(char *xmlDataBuffer, int size)
+{
+    std::vector<MeshRequest> requestList;
+    MeshRequest request;
+    xmlChar *value;
+
+    MeshCache::GetCache()->Clear();
+    xmlTextReaderPtr reader = xmlReaderForMemory(xmlDataBuffer, size, 0, 0, XML_PARSE_HUGE);
+    if (reader == 0) return;
+    int ret = xmlTextReaderRead(reader);
+    while (ret == 1)
+    {
+        if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT || xmlTextReaderDepth(reader) != 1)
+        {
+            ret = xmlTextReaderRead(reader);
+            continue;
+        }
+        if (xmlStrcmp(xmlTextReaderConstName(reader), (const xmlChar *)"BODY") == 0)
+        {
+            value = xmlTextReaderGetAttribute(reader, (const xmlChar *)"GraphicFile");
+            if (value)
+            {
+                request.filename = GraphicFilename((const char *)value);
+                xmlFree(value);
+                request.badMesh = false;
+                value = xmlTextReaderGetAttribute(reader, (const xmlChar *)"BadMesh");
+                if (value)
+                {
+                    request.badMesh = Util::Bool((char *)value);
+                    xmlFree(value);
+                }
+                request.verticesAsSpheresRadius = 0;
+                value = xmlTextReaderGetAttribute(reader, (const xmlChar *)"VerticesAsSpheresRadius");
+                if (value)
+                {
+                    request.verticesAsSpheresRadius = Util::Double((char *)value);
+                    xmlFree(value);
+                }
+                requestList.push_back(request);
+            }
+        }
+        ret = xmlTextReaderNext(reader);
+    }
+    xmlFreeTextReader(reader);
+
+    MeshCache::GetCache()->Prefetch(requestList);
+}
+#endif
+
 void Simulation::ParseJoint(xmlNodePtr cur)
 {
     char *buf;
@@ -1864,17 +2266,17 @@ void Simulation::ParseJoint(xmlNodePtr cur)
         if (mode != -99)
         {
             THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"Axis0"));
-            Util::Double(buf, 3, m_DoubleList);
-            pgd::Vector a0(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2]);
+            Util::Double(buf, 3, ArenaDoubleList());
+            pgd::Vector a0(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2]);
             if (mode == dAMotorUser)
             {
                 THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"Axis1"));
-                Util::Double(buf, 3, m_DoubleList);
+                Util::Double(buf, 3, ArenaDoubleList());
             }
-            pgd::Vector a1(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2]);
+            pgd::Vector a1(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2]);
             THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"Axis2"));
-            Util::Double(buf, 3, m_DoubleList);
-            pgd::Vector a2(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2]);
+            Util::Double(buf, 3, ArenaDoubleList());
+            pgd::Vector a2(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2]);
 /*
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"Angle0"));
         double angle0 = Util::GetAngle(buf);
@@ -1905,10 +2307,10 @@ void Simulation::ParseJoint(xmlNodePtr cur)
             buf = DoXmlGetProp(cur, (const xmlChar *)"EulerReferenceVectors");
             if (buf)
             {
-                Util::Double(buf, 6, m_DoubleList);
+                Util::Double(buf, 6, ArenaDoubleList());
                 dVector3 reference1, reference2;
-                reference1[0] = m_DoubleList[0]; reference1[1] = m_DoubleList[1]; reference1[2] = m_DoubleList[2];
-                reference2[0] = m_DoubleList[3]; reference2[1] = m_DoubleList[4]; reference2[2] = m_DoubleList[5];
+                reference1[0] = ArenaDoubleList()[0]; reference1[1] = ArenaDoubleList()[1]; reference1[2] = ArenaDoubleList()[2];
+                reference2[0] = ArenaDoubleList()[3]; reference2[1] = ArenaDoubleList()[4]; reference2[2] = ArenaDoubleList()[5];
                 ballJoint->SetEulerReferenceVectors(reference1, reference2);
             }
         }
@@ -2116,9 +2518,9 @@ void Simulation::ParseGeom(xmlNodePtr cur)
     {
 
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"Dimensions"));
-        Util::Double(buf, 3, m_DoubleList);
+        Util::Double(buf, 3, ArenaDoubleList());
 
-        BoxGeom *boxGeom = new BoxGeom(m_SpaceID, m_DoubleList[0], m_DoubleList[1], m_DoubleList[2]);
+        BoxGeom *boxGeom = new BoxGeom(m_SpaceID, ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2]);
         geom = boxGeom;
     }
 
@@ -2276,17 +2678,17 @@ void Simulation::ParseMuscle(xmlNodePtr cur)
         std::vector<std::string *> pointList;
         while (1)
         {
-            sprintf(m_Buffer, "ViaPoint%d", viaCount);
-            buf = DoXmlGetProp(cur, (const xmlChar *)m_Buffer);
+            sprintf(ArenaBuffer(), "ViaPoint%d", viaCount);
+            buf = DoXmlGetProp(cur, (const xmlChar *)ArenaBuffer());
             if (buf == 0) break;
             std::string *tempP = new std::string((const char *)buf);
             pointList.push_back(tempP);
-            sprintf(m_Buffer, "ViaPointBody%d", viaCount);
-            buf = DoXmlGetProp(cur, (const xmlChar *)m_Buffer);
+            sprintf(ArenaBuffer(), "ViaPointBody%d", viaCount);
+            buf = DoXmlGetProp(cur, (const xmlChar *)ArenaBuffer());
             if (buf == 0)
             {
-                sprintf(m_Buffer, "ViaPoint%dBodyID", viaCount);
-                THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)m_Buffer));
+                sprintf(ArenaBuffer(), "ViaPoint%dBodyID", viaCount);
+                THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)ArenaBuffer()));
             }
             THROWIFZERO(theBody = m_BodyList[(const char *)buf]);
             bodyList.push_back(theBody);
@@ -2602,6 +3004,16 @@ void Simulation::ParseMuscle(xmlNodePtr cur)
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"AllowReverseWork"));
         ((UGMMuscle *)muscle)->AllowReverseWork(Util::Bool(buf));
 
+        buf = DoXmlGetProp(cur, (const xmlChar *)"Integrator");
+        if (buf)
+        {
+            if (strcmp((const char *)buf, "ExplicitEuler") == 0)
+                ((UGMMuscle *)muscle)->SetIntegrator(UGMMuscle::explicitEuler);
+            else if (strcmp((const char *)buf, "ImplicitEuler") == 0)
+                ((UGMMuscle *)muscle)->SetIntegrator(UGMMuscle::implicitEuler);
+            else throw __LINE__;
+        }
+
     }
     else
     {
@@ -2609,6 +3021,10 @@ void Simulation::ParseMuscle(xmlNodePtr cur)
         throw __LINE__;
     }
 
+    muscle->SetSubSteps(m_MuscleSubSteps);
+    buf = DoXmlGetProp(cur, (const xmlChar *)"SubSteps");
+    if (buf) muscle->SetSubSteps(Util::Int(buf));
+
 #ifdef USE_QT
     muscle->SetColour(m_Interface.StrapColour);
     muscle->SetForceColour(m_Interface.StrapForceColour);
@@ -2633,8 +3049,8 @@ void Simulation::ParseDriver(xmlNodePtr cur)
         cyclicDriver->SetName((const char *)buf);
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"DurationValuePairs"));
         count = DataFile::CountTokens((char *)buf);
-        Util::Double(buf, count, m_DoubleList);
-        cyclicDriver->SetValueDurationPairs(count, m_DoubleList);
+        Util::Double(buf, count, ArenaDoubleList());
+        cyclicDriver->SetValueDurationPairs(count, ArenaDoubleList());
         buf = DoXmlGetProp(cur, (const xmlChar *)"Target");
         if (buf == 0) THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"TargetID"));
         if (m_MuscleList.find((const char *)buf) != m_MuscleList.end()) cyclicDriver->SetTarget(m_MuscleList[(const char *)buf]);
@@ -2653,8 +3069,8 @@ void Simulation::ParseDriver(xmlNodePtr cur)
             count = DataFile::CountTokens((char *)buf);
             if (count >= 2)
             {
-                Util::Double(buf, count, m_DoubleList);
-                cyclicDriver->SetMinMax(m_DoubleList[0],m_DoubleList[1]);
+                Util::Double(buf, count, ArenaDoubleList());
+                cyclicDriver->SetMinMax(ArenaDoubleList()[0],ArenaDoubleList()[1]);
             }
         }
 
@@ -2675,8 +3091,8 @@ void Simulation::ParseDriver(xmlNodePtr cur)
         stepDriver->SetName((const char *)buf);
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"DurationValuePairs"));
         count = DataFile::CountTokens((char *)buf);
-        Util::Double(buf, count, m_DoubleList);
-        stepDriver->SetValueDurationPairs(count, m_DoubleList);
+        Util::Double(buf, count, ArenaDoubleList());
+        stepDriver->SetValueDurationPairs(count, ArenaDoubleList());
         buf = DoXmlGetProp(cur, (const xmlChar *)"Target");
         if (buf == 0) THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"TargetID"));
         if (m_MuscleList.find((const char *)buf) != m_MuscleList.end()) stepDriver->SetTarget(m_MuscleList[(const char *)buf]);
@@ -2689,8 +3105,8 @@ void Simulation::ParseDriver(xmlNodePtr cur)
             count = DataFile::CountTokens((char *)buf);
             if (count >= 2)
             {
-                Util::Double(buf, count, m_DoubleList);
-                stepDriver->SetMinMax(m_DoubleList[0],m_DoubleList[1]);
+                Util::Double(buf, count, ArenaDoubleList());
+                stepDriver->SetMinMax(ArenaDoubleList()[0],ArenaDoubleList()[1]);
             }
         }
 
@@ -2730,8 +3146,8 @@ void Simulation::ParseDriver(xmlNodePtr cur)
             count = DataFile::CountTokens((char *)buf);
             if (count >= 2)
             {
-                Util::Double(buf, count, m_DoubleList);
-                BoxCarDriver1->SetMinMax(m_DoubleList[0],m_DoubleList[1]);
+                Util::Double(buf, count, ArenaDoubleList());
+                BoxCarDriver1->SetMinMax(ArenaDoubleList()[0],ArenaDoubleList()[1]);
             }
         }
 
@@ -2756,20 +3172,20 @@ void Simulation::ParseDriver(xmlNodePtr cur)
         StackedBoxCarDriver1->SetStackSize(StackSize);
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"CycleTimes"));
         if (DataFile::CountTokens((char *)buf) != StackSize) throw __LINE__;
-        Util::Double(buf, StackSize, m_DoubleList);
-        StackedBoxCarDriver1->SetCycleTimes(m_DoubleList);
+        Util::Double(buf, StackSize, ArenaDoubleList());
+        StackedBoxCarDriver1->SetCycleTimes(ArenaDoubleList());
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"Delays"));
         if (DataFile::CountTokens((char *)buf) != StackSize) throw __LINE__;
-        Util::Double(buf, StackSize, m_DoubleList);
-        StackedBoxCarDriver1->SetDelays(m_DoubleList);
+        Util::Double(buf, StackSize, ArenaDoubleList());
+        StackedBoxCarDriver1->SetDelays(ArenaDoubleList());
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"Widths"));
         if (DataFile::CountTokens((char *)buf) != StackSize) throw __LINE__;
-        Util::Double(buf, StackSize, m_DoubleList);
-        StackedBoxCarDriver1->SetWidths(m_DoubleList);
+        Util::Double(buf, StackSize, ArenaDoubleList());
+        StackedBoxCarDriver1->SetWidths(ArenaDoubleList());
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"Heights"));
         if (DataFile::CountTokens((char *)buf) != StackSize) throw __LINE__;
-        Util::Double(buf, StackSize, m_DoubleList);
-        StackedBoxCarDriver1->SetHeights(m_DoubleList);
+        Util::Double(buf, StackSize, ArenaDoubleList());
+        StackedBoxCarDriver1->SetHeights(ArenaDoubleList());
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"DriverRange");
         if (buf)
@@ -2777,8 +3193,8 @@ void Simulation::ParseDriver(xmlNodePtr cur)
             count = DataFile::CountTokens((char *)buf);
             if (count >= 2)
             {
-                Util::Double(buf, count, m_DoubleList);
-                StackedBoxCarDriver1->SetMinMax(m_DoubleList[0],m_DoubleList[1]);
+                Util::Double(buf, count, ArenaDoubleList());
+                StackedBoxCarDriver1->SetMinMax(ArenaDoubleList()[0],ArenaDoubleList()[1]);
             }
         }
 
@@ -2887,19 +3303,19 @@ void Simulation::ParseDataTarget(xmlNodePtr cur)
         buf = DoXmlGetProp(cur, (const xmlChar *)"DurationValuePairs");
         if (buf)
         {
-            count = DataFile::ReturnTokens(buf, m_BufferPtrs, m_BufferSize);
+            count = DataFile::ReturnTokens(buf, ArenaPointerList(), ParseArena::GetArena()->GetPointerListSize());
 
-            Util::Double(buf, count, m_DoubleList);
+            Util::Double(buf, count, ArenaDoubleList());
             count = count / 2;
             double *times = new double[count];
             double *values = new double[count];
             for (i = 0; i < count; i++)
             {
-                times[i] = Util::Double(m_BufferPtrs[i * 2]);
+                times[i] = Util::Double(ArenaPointerList()[i * 2]);
                 if (dataTargetScalar->GetDataType() == DataTargetScalar::Angle)
-                    values[i] = Util::GetAngle(m_BufferPtrs[i * 2 + 1]);
+                    values[i] = Util::GetAngle(ArenaPointerList()[i * 2 + 1]);
                 else
-                    values[i] = Util::Double(m_BufferPtrs[i * 2 + 1]);
+                    values[i] = Util::Double(ArenaPointerList()[i * 2 + 1]);
             }
             dataTargetScalar->SetTargetTimes(count, times);
             dataTargetScalar->SetTargetValues(count, values);
@@ -2910,12 +3326,12 @@ void Simulation::ParseDataTarget(xmlNodePtr cur)
         {
             THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"TargetTimes"));
             count = DataFile::CountTokens((char *)buf);
-            Util::Double(buf, count, m_DoubleList);
-            dataTargetScalar->SetTargetTimes(count, m_DoubleList);
+            Util::Double(buf, count, ArenaDoubleList());
+            dataTargetScalar->SetTargetTimes(count, ArenaDoubleList());
             THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"TargetValues"));
             count = DataFile::CountTokens((char *)buf);
-            Util::Double(buf, count, m_DoubleList);
-            dataTargetScalar->SetTargetValues(count, m_DoubleList);
+            Util::Double(buf, count, ArenaDoubleList());
+            dataTargetScalar->SetTargetValues(count, ArenaDoubleList());
         }
         dataTarget = dataTargetScalar;
     }
@@ -2964,8 +3380,8 @@ void Simulation::ParseDataTarget(xmlNodePtr cur)
 
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"TargetTimes"));
         int timeCount = DataFile::CountTokens((char *)buf);
-        Util::Double(buf, timeCount, m_DoubleList);
-        dataTargetQuaternion->SetTargetTimes(timeCount, m_DoubleList);
+        Util::Double(buf, timeCount, ArenaDoubleList());
+        dataTargetQuaternion->SetTargetTimes(timeCount, ArenaDoubleList());
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"TargetValues"));
         dataTargetQuaternion->SetTargetValues((char *)buf);
 
@@ -3018,8 +3434,8 @@ void Simulation::ParseDataTarget(xmlNodePtr cur)
 
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"TargetTimes"));
         int timeCount = DataFile::CountTokens((char *)buf);
-        Util::Double(buf, timeCount, m_DoubleList);
-        dataTargetVector->SetTargetTimes(timeCount, m_DoubleList);
+        Util::Double(buf, timeCount, ArenaDoubleList());
+        dataTargetVector->SetTargetTimes(timeCount, ArenaDoubleList());
         THROWIFZERO(buf = DoXmlGetProp(cur, (const xmlChar *)"TargetValues"));
         dataTargetVector->SetTargetValues((char *)buf);
 
@@ -3324,63 +3740,63 @@ void Simulation::ParseInterface(xmlNodePtr cur)
         buf = DoXmlGetProp(cur, (const xmlChar *)"EnvironmentAxisSize");
         if (buf)
         {
-            Util::Double(buf, 3, m_DoubleList);
-            m_Interface.EnvironmentAxisSize[0] = m_DoubleList[0];
-            m_Interface.EnvironmentAxisSize[1] = m_DoubleList[1];
-            m_Interface.EnvironmentAxisSize[2] = m_DoubleList[2];
+            Util::Double(buf, 3, ArenaDoubleList());
+            m_Interface.EnvironmentAxisSize[0] = ArenaDoubleList()[0];
+            m_Interface.EnvironmentAxisSize[1] = ArenaDoubleList()[1];
+            m_Interface.EnvironmentAxisSize[2] = ArenaDoubleList()[2];
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"EnvironmentColour");
         if (buf)
         {
-            Util::Double(buf, 4, m_DoubleList);
-            m_Interface.EnvironmentColour.SetColour(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+            Util::Double(buf, 4, ArenaDoubleList());
+            m_Interface.EnvironmentColour.SetColour(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"BodyAxisSize");
         if (buf)
         {
-            Util::Double(buf, 3, m_DoubleList);
-            m_Interface.BodyAxisSize[0] = m_DoubleList[0];
-            m_Interface.BodyAxisSize[1] = m_DoubleList[1];
-            m_Interface.BodyAxisSize[2] = m_DoubleList[2];
+            Util::Double(buf, 3, ArenaDoubleList());
+            m_Interface.BodyAxisSize[0] = ArenaDoubleList()[0];
+            m_Interface.BodyAxisSize[1] = ArenaDoubleList()[1];
+            m_Interface.BodyAxisSize[2] = ArenaDoubleList()[2];
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"BodyColour");
         if (buf)
         {
-            Util::Double(buf, 4, m_DoubleList);
-            m_Interface.BodyColour.SetColour(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+            Util::Double(buf, 4, ArenaDoubleList());
+            m_Interface.BodyColour.SetColour(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"JointAxisSize");
         if (buf)
         {
-            Util::Double(buf, 3, m_DoubleList);
-            m_Interface.JointAxisSize[0] = m_DoubleList[0];
-            m_Interface.JointAxisSize[1] = m_DoubleList[1];
-            m_Interface.JointAxisSize[2] = m_DoubleList[2];
+            Util::Double(buf, 3, ArenaDoubleList());
+            m_Interface.JointAxisSize[0] = ArenaDoubleList()[0];
+            m_Interface.JointAxisSize[1] = ArenaDoubleList()[1];
+            m_Interface.JointAxisSize[2] = ArenaDoubleList()[2];
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"JointColour");
         if (buf)
         {
-            Util::Double(buf, 4, m_DoubleList);
-            m_Interface.JointColour.SetColour(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+            Util::Double(buf, 4, ArenaDoubleList());
+            m_Interface.JointColour.SetColour(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"GeomColour");
         if (buf)
         {
-            Util::Double(buf, 4, m_DoubleList);
-            m_Interface.GeomColour.SetColour(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+            Util::Double(buf, 4, ArenaDoubleList());
+            m_Interface.GeomColour.SetColour(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"StrapColour");
         if (buf)
         {
-            Util::Double(buf, 4, m_DoubleList);
-            m_Interface.StrapColour.SetColour(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+            Util::Double(buf, 4, ArenaDoubleList());
+            m_Interface.StrapColour.SetColour(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"StrapRadius");
@@ -3392,8 +3808,8 @@ void Simulation::ParseInterface(xmlNodePtr cur)
         buf = DoXmlGetProp(cur, (const xmlChar *)"StrapForceColour");
         if (buf)
         {
-            Util::Double(buf, 4, m_DoubleList);
-            m_Interface.StrapForceColour.SetColour(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+            Util::Double(buf, 4, ArenaDoubleList());
+            m_Interface.StrapForceColour.SetColour(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"StrapForceRadius");
@@ -3411,8 +3827,8 @@ void Simulation::ParseInterface(xmlNodePtr cur)
         buf = DoXmlGetProp(cur, (const xmlChar *)"StrapCylinderColour");
         if (buf)
         {
-            Util::Double(buf, 4, m_DoubleList);
-            m_Interface.StrapCylinderColour.SetColour(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+            Util::Double(buf, 4, ArenaDoubleList());
+            m_Interface.StrapCylinderColour.SetColour(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"StrapCylinderLength");
@@ -3424,24 +3840,24 @@ void Simulation::ParseInterface(xmlNodePtr cur)
         buf = DoXmlGetProp(cur, (const xmlChar *)"GeomAxisSize");
         if (buf)
         {
-            Util::Double(buf, 3, m_DoubleList);
-            m_Interface.GeomAxisSize[0] = m_DoubleList[0];
-            m_Interface.GeomAxisSize[1] = m_DoubleList[1];
-            m_Interface.GeomAxisSize[2] = m_DoubleList[2];
+            Util::Double(buf, 3, ArenaDoubleList());
+            m_Interface.GeomAxisSize[0] = ArenaDoubleList()[0];
+            m_Interface.GeomAxisSize[1] = ArenaDoubleList()[1];
+            m_Interface.GeomAxisSize[2] = ArenaDoubleList()[2];
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"ContactColour");
         if (buf)
         {
-            Util::Double(buf, 4, m_DoubleList);
-            m_Interface.GeomColour.SetColour(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+            Util::Double(buf, 4, ArenaDoubleList());
+            m_Interface.GeomColour.SetColour(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"ContactForceColour");
         if (buf)
         {
-            Util::Double(buf, 4, m_DoubleList);
-            m_Interface.GeomForceColour.SetColour(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+            Util::Double(buf, 4, ArenaDoubleList());
+            m_Interface.GeomForceColour.SetColour(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"ContactForceRadius");
@@ -3459,8 +3875,8 @@ void Simulation::ParseInterface(xmlNodePtr cur)
         buf = DoXmlGetProp(cur, (const xmlChar *)"MarkerColour");
         if (buf)
         {
-            Util::Double(buf, 4, m_DoubleList);
-            m_Interface.MarkerColour.SetColour(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+            Util::Double(buf, 4, ArenaDoubleList());
+            m_Interface.MarkerColour.SetColour(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"MarkerRadius");
@@ -3472,8 +3888,8 @@ void Simulation::ParseInterface(xmlNodePtr cur)
         buf = DoXmlGetProp(cur, (const xmlChar *)"ReporterColour");
         if (buf)
         {
-            Util::Double(buf, 4, m_DoubleList);
-            m_Interface.ReporterColour.SetColour(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+            Util::Double(buf, 4, ArenaDoubleList());
+            m_Interface.ReporterColour.SetColour(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"ReporterRadius");
@@ -3485,8 +3901,8 @@ void Simulation::ParseInterface(xmlNodePtr cur)
         buf = DoXmlGetProp(cur, (const xmlChar *)"DataTargetColour");
         if (buf)
         {
-            Util::Double(buf, 4, m_DoubleList);
-            m_Interface.DataTargetColour.SetColour(m_DoubleList[0], m_DoubleList[1], m_DoubleList[2], m_DoubleList[3]);
+            Util::Double(buf, 4, ArenaDoubleList());
+            m_Interface.DataTargetColour.SetColour(ArenaDoubleList()[0], ArenaDoubleList()[1], ArenaDoubleList()[2], ArenaDoubleList()[3]);
         }
 
         buf = DoXmlGetProp(cur, (const xmlChar *)"DataTargetRadius");
@@ -3667,20 +4083,20 @@ void Simulation::OutputWarehouse()
         if (m_OutputWarehouseLastTime < 0)
         {
             m_OutputWarehouseFile.open(m_OutputWarehouseFilename.c_str(), std::ios::binary);
-            Util::BinaryOutput(m_OutputWarehouseFile, (uint32_t)0);
-            Util::BinaryOutput(m_OutputWarehouseFile, (uint32_t)m_DriverList.size());
-            for (std::map<std::string, Driver *>::const_iterator iter = m_DriverList.begin(); iter != m_DriverList.end(); iter++) Util::BinaryOutput(m_OutputWarehouseFile, *iter->second->GetName());
-            Util::BinaryOutput(m_OutputWarehouseFile, (uint32_t)m_BodyList.size());
-            Util::BinaryOutput(m_OutputWarehouseFile, *m_BodyList[m_DistanceTravelledBodyIDName]->GetName());
+            m_OutputWarehouseFile.BinaryOutput((uint32_t)0);
+            m_OutputWarehouseFile.BinaryOutput((uint32_t)m_DriverList.size());
+            for (std::map<std::string, Driver *>::const_iterator iter = m_DriverList.begin(); iter != m_DriverList.end(); iter++) m_OutputWarehouseFile.BinaryOutput(*iter->second->GetName());
+            m_OutputWarehouseFile.BinaryOutput((uint32_t)m_BodyList.size());
+            m_OutputWarehouseFile.BinaryOutput(*m_BodyList[m_DistanceTravelledBodyIDName]->GetName());
             for (std::map<std::string, Body *>::const_iterator iter = m_BodyList.begin(); iter != m_BodyList.end(); iter++)
-                if (*iter->second->GetName() != m_DistanceTravelledBodyIDName) Util::BinaryOutput(m_OutputWarehouseFile, *iter->second->GetName());
+                if (*iter->second->GetName() != m_DistanceTravelledBodyIDName) m_OutputWarehouseFile.BinaryOutput(*iter->second->GetName());
         }
 
         m_OutputWarehouseLastTime = m_SimulationTime;
         // simulation time
-        Util::BinaryOutput(m_OutputWarehouseFile, m_SimulationTime);
+        m_OutputWarehouseFile.BinaryOutput(m_SimulationTime);
         // driver activations
-        for (std::map<std::string, Driver *>::const_iterator iter = m_DriverList.begin(); iter != m_DriverList.end(); iter++) Util::BinaryOutput(m_OutputWarehouseFile, iter->second->GetValue(m_SimulationTime));
+        for (std::map<std::string, Driver *>::const_iterator iter = m_DriverList.begin(); iter != m_DriverList.end(); iter++) m_OutputWarehouseFile.BinaryOutput(iter->second->GetValue(m_SimulationTime));
         // output the root body (m_DistanceTravelledBodyIDName)
         Body *rootBody = m_BodyList[m_DistanceTravelledBodyIDName];
         pgd::Vector pos, vel, avel;
@@ -3691,10 +4107,10 @@ void Simulation::OutputWarehouse()
         rootBody->GetRelativeAngularVelocity(0, &avel);
         double angle = QGetAngle(quat);
         pgd::Vector axis = QGetAxis(quat);
-        Util::BinaryOutput(m_OutputWarehouseFile, pos.x); Util::BinaryOutput(m_OutputWarehouseFile, pos.y); Util::BinaryOutput(m_OutputWarehouseFile, pos.z);
-        Util::BinaryOutput(m_OutputWarehouseFile, angle); Util::BinaryOutput(m_OutputWarehouseFile, axis.x); Util::BinaryOutput(m_OutputWarehouseFile, axis.y); Util::BinaryOutput(m_OutputWarehouseFile, axis.z);
-        Util::BinaryOutput(m_OutputWarehouseFile, vel.x); Util::BinaryOutput(m_OutputWarehouseFile, vel.y); Util::BinaryOutput(m_OutputWarehouseFile, vel.z);
-        Util::BinaryOutput(m_OutputWarehouseFile, avel.x); Util::BinaryOutput(m_OutputWarehouseFile, avel.y); Util::BinaryOutput(m_OutputWarehouseFile, avel.z);
+        m_OutputWarehouseFile.BinaryOutput(pos.x); m_OutputWarehouseFile.BinaryOutput(pos.y); m_OutputWarehouseFile.BinaryOutput(pos.z);
+        m_OutputWarehouseFile.BinaryOutput(angle); m_OutputWarehouseFile.BinaryOutput(axis.x); m_OutputWarehouseFile.BinaryOutput(axis.y); m_OutputWarehouseFile.BinaryOutput(axis.z);
+        m_OutputWarehouseFile.BinaryOutput(vel.x); m_OutputWarehouseFile.BinaryOutput(vel.y); m_OutputWarehouseFile.BinaryOutput(vel.z);
+        m_OutputWarehouseFile.BinaryOutput(avel.x); m_OutputWarehouseFile.BinaryOutput(avel.y); m_OutputWarehouseFile.BinaryOutput(avel.z);
         // and now the rest of the bodies
         for (std::map<std::string, Body *>::const_iterator iter = m_BodyList.begin(); iter != m_BodyList.end(); iter++)
         {
@@ -3706,10 +4122,10 @@ void Simulation::OutputWarehouse()
                 iter->second->GetRelativeAngularVelocity(rootBody, &avel);
                 angle = QGetAngle(quat);
                 axis = QGetAxis(quat);
-                Util::BinaryOutput(m_OutputWarehouseFile, pos.x); Util::BinaryOutput(m_OutputWarehouseFile, pos.y); Util::BinaryOutput(m_OutputWarehouseFile, pos.z);
-                Util::BinaryOutput(m_OutputWarehouseFile, angle); Util::BinaryOutput(m_OutputWarehouseFile, axis.x); Util::BinaryOutput(m_OutputWarehouseFile, axis.y); Util::BinaryOutput(m_OutputWarehouseFile, axis.z);
-                Util::BinaryOutput(m_OutputWarehouseFile, vel.x); Util::BinaryOutput(m_OutputWarehouseFile, vel.y); Util::BinaryOutput(m_OutputWarehouseFile, vel.z);
-                Util::BinaryOutput(m_OutputWarehouseFile, avel.x); Util::BinaryOutput(m_OutputWarehouseFile, avel.y); Util::BinaryOutput(m_OutputWarehouseFile, avel.z);
+                m_OutputWarehouseFile.BinaryOutput(pos.x); m_OutputWarehouseFile.BinaryOutput(pos.y); m_OutputWarehouseFile.BinaryOutput(pos.z);
+                m_OutputWarehouseFile.BinaryOutput(angle); m_OutputWarehouseFile.BinaryOutput(axis.x); m_OutputWarehouseFile.BinaryOutput(axis.y); m_OutputWarehouseFile.BinaryOutput(axis.z);
+                m_OutputWarehouseFile.BinaryOutput(vel.x); m_OutputWarehouseFile.BinaryOutput(vel.y); m_OutputWarehouseFile.BinaryOutput(vel.z);
+                m_OutputWarehouseFile.BinaryOutput(avel.x); m_OutputWarehouseFile.BinaryOutput(avel.y); m_OutputWarehouseFile.BinaryOutput(avel.z);
             }
         }
     }
@@ -3729,18 +4145,19 @@ void Simulation::OutputProgramState()
 
     doc = xmlNewDoc((xmlChar *)"1.0");
     if (doc == 0) return;
+    m_AttributeIndexNode = 0;
 
     rootNode = xmlNewDocNode(doc, 0, (xmlChar *)"GAITSYMODE", 0);
     xmlDocSetRootElement(doc, rootNode);
     xmlAddChild(rootNode, xmlNewText((const xmlChar *)"\n" )); // add a line feed for formatting
 
-    sprintf(m_Buffer, "%.17e", m_SimulationTime);
+    FastDouble::FormatList(ArenaBuffer(), 0, m_SimulationTime);
     newNode = xmlNewTextChild(rootNode, 0, (xmlChar *)"STATE", 0);
-    newAttr = xmlNewProp(newNode, (xmlChar *)"SimulationTime", (xmlChar *)m_Buffer);
+    newAttr = xmlNewProp(newNode, (xmlChar *)"SimulationTime", (xmlChar *)ArenaBuffer());
     if (m_OutputModelStateAtCycle >= 0)
     {
-        sprintf(m_Buffer, "%.17e", m_OutputModelStateAtCycle);
-        newAttr = xmlNewProp(newNode, (xmlChar *)"CycleFraction", (xmlChar *)m_Buffer);
+        FastDouble::FormatList(ArenaBuffer(), 0, m_OutputModelStateAtCycle);
+        newAttr = xmlNewProp(newNode, (xmlChar *)"CycleFraction", (xmlChar *)ArenaBuffer());
     }
     xmlAddChild(rootNode, xmlNewText((const xmlChar *)"\n" )); // add a line feed for formatting
 
@@ -3796,10 +4213,15 @@ void Simulation::OutputProgramState()
     }
     xmlAddChild(rootNode, xmlNewText((const xmlChar *)"\n" )); // add a line feed for formatting
 
-    std::vector<xmlNodePtr>::const_iterator iter0;
+    xmlDocPtr elementDoc;
+    std::vector<TagContents>::const_iterator iter0;
     for (iter0 = m_TagContentsList.begin(); iter0 != m_TagContentsList.end(); iter0++)
     {
-        cur = *iter0;
+        // the stored text is only turned back into nodes here
+        elementDoc = ParseXmlElement(iter0->xml);
+        if (elementDoc == 0) continue;
+        cur = xmlDocGetRootElement(elementDoc);
+        m_AttributeIndexNode = 0;
         if (xmlStrcmp(cur->name, (const xmlChar *)"GLOBAL") == 0 ||
                 xmlStrcmp(cur->name, (const xmlChar *)"ENVIRONMENT") == 0 ||
                 xmlStrcmp(cur->name, (const xmlChar *)"INTERFACE") == 0 ||
@@ -3824,60 +4246,59 @@ void Simulation::OutputProgramState()
 
 #ifdef USE_QT
             p = body->GetOffset();
-            sprintf(m_Buffer, "%.17e %.17e %.17e", p[0], p[1], p[2]);
-            newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Offset", (xmlChar *)m_Buffer);
+            FastDouble::FormatList(ArenaBuffer(), 0, p[0], p[1], p[2]);
+            newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Offset", (xmlChar *)ArenaBuffer());
 #endif
 
             dMass mass;
             dBodyGetMass(body->GetBodyID(), &mass);
-            sprintf(m_Buffer, "%.17e", mass.mass);
-            newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Mass", (xmlChar *)m_Buffer);
-            sprintf(m_Buffer, "%.17e %.17e %.17e %.17e %.17e %.17e", mass._I(0,0), mass._I(1,1), mass._I(2,2),
-                    mass._I(0,1), mass._I(0,2), mass._I(1,2));
-            newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"MOI", (xmlChar *)m_Buffer);
+            FastDouble::FormatList(ArenaBuffer(), 0, mass.mass);
+            newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Mass", (xmlChar *)ArenaBuffer());
+            FastDouble::FormatList(ArenaBuffer(), 0, mass._I(0,0), mass._I(1,1), mass._I(2,2), mass._I(0,1), mass._I(0,2), mass._I(1,2));
+            newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"MOI", (xmlChar *)ArenaBuffer());
 
-            sprintf(m_Buffer, "-1");
-            newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Density", (xmlChar *)m_Buffer);
+            sprintf(ArenaBuffer(), "-1");
+            newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Density", (xmlChar *)ArenaBuffer());
 
             if (m_MungeModelStateFlag)
             {
                 p = body->GetPosition();
                 pgd::Vector v1(p[0] - munge[0], p[1] - munge[1], p[2] - munge[2]);
                 pgd::Vector v2 = pgd::QVRotate(mungeRotation, v1);
-                sprintf(m_Buffer, "World %.17e %.17e %.17e", v2.x, v2.y, v2.z);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Position", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), "World", v2.x, v2.y, v2.z);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Position", (xmlChar *)ArenaBuffer());
                 p = body->GetQuaternion();
                 pgd::Quaternion qBody1(p[0], p[1], p[2], p[3]);
                 pgd::Quaternion qBody2 = mungeRotation * qBody1;
-                sprintf(m_Buffer, "World %.17e %.17e %.17e %.17e", qBody2.n, qBody2.v.x, qBody2.v.y, qBody2.v.z);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Quaternion", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), "World", qBody2.n, qBody2.v.x, qBody2.v.y, qBody2.v.z);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Quaternion", (xmlChar *)ArenaBuffer());
                 p = body->GetLinearVelocity();
                 v1.x = p[0]; v1.y = p[1]; v1.z = p[2];
                 v2 = pgd::QVRotate(mungeRotation, v1);
-                sprintf(m_Buffer, "%.17e %.17e %.17e", v2.x, v2.y, v2.z);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"LinearVelocity", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), 0, v2.x, v2.y, v2.z);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"LinearVelocity", (xmlChar *)ArenaBuffer());
                 p = body->GetAngularVelocity();
                 v1.x = p[0]; v1.y = p[1]; v1.z = p[2];
                 v2 = pgd::QVRotate(mungeRotation, v1);
-                sprintf(m_Buffer, "%.17e %.17e %.17e", v2.x, v2.y, v2.z);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"AngularVelocity", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), 0, v2.x, v2.y, v2.z);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"AngularVelocity", (xmlChar *)ArenaBuffer());
             }
             else
             {
                 if (m_ModelStateRelative == false)
                 {
                     p = body->GetPosition();
-                    sprintf(m_Buffer, "World %.17e %.17e %.17e", p[0], p[1], p[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Position", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", p[0], p[1], p[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Position", (xmlChar *)ArenaBuffer());
                     p = body->GetQuaternion();
-                    sprintf(m_Buffer, "World %.17e %.17e %.17e %.17e", p[0], p[1], p[2], p[3]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Quaternion", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", p[0], p[1], p[2], p[3]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Quaternion", (xmlChar *)ArenaBuffer());
                     p = body->GetLinearVelocity();
-                    sprintf(m_Buffer, "%.17e %.17e %.17e", p[0], p[1], p[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"LinearVelocity", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), 0, p[0], p[1], p[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"LinearVelocity", (xmlChar *)ArenaBuffer());
                     p = body->GetAngularVelocity();
-                    sprintf(m_Buffer, "%.17e %.17e %.17e", p[0], p[1], p[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"AngularVelocity", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), 0, p[0], p[1], p[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"AngularVelocity", (xmlChar *)ArenaBuffer());
                 }
                 else
                 {
@@ -3899,12 +4320,12 @@ void Simulation::OutputProgramState()
                     {
                         if (definedList.find(*parent->GetName()) == definedList.end())
                         {
-                            sprintf(m_Buffer, "Warning: %s, parent of %s, is not yet defined so using World\n", parent->GetName()->c_str(), body->GetName()->c_str());
+                            sprintf(ArenaBuffer(), "Warning: %s, parent of %s, is not yet defined so using World\n", parent->GetName()->c_str(), body->GetName()->c_str());
                             parent = 0;
 #if defined(USE_QT) && !defined(USE_WI_BB)
-                            m_MainWindow->log(m_Buffer);
+                            m_MainWindow->log(ArenaBuffer());
 #endif
-                            fprintf(stderr, "%s", m_Buffer);
+                            fprintf(stderr, "%s", ArenaBuffer());
                         }
                         else parentName = *parent->GetName();
                     }
@@ -3919,29 +4340,32 @@ void Simulation::OutputProgramState()
                         else if (uj) uj->GetUniversalAnchor(v);
                         dBodyGetPosRelPoint(linkingJoint->GetBody1()->GetBodyID(), v[0], v[1], v[2], r1);
                         dBodyGetPosRelPoint(linkingJoint->GetBody2()->GetBodyID(), v[0], v[1], v[2], r2);
-                        sprintf(m_Buffer, "%s %.17e %.17e %.17e %.17e %.17e %.17e", parentName.c_str(), r1[0], r1[1], r1[2], r2[0], r2[1], r2[2]);
+                        FastDouble::FormatList(ArenaBuffer(), parentName.c_str(), r1[0], r1[1], r1[2], r2[0], r2[1], r2[2]);
                     }
                     else
                     {
                         pgd::Vector rpos;
                         body->GetRelativePosition(parent, &rpos);
-                        sprintf(m_Buffer, "%s %.17e %.17e %.17e", parentName.c_str(), rpos.x, rpos.y, rpos.z);
+                        FastDouble::FormatList(ArenaBuffer(), parentName.c_str(), rpos.x, rpos.y, rpos.z);
                     }
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Position", (xmlChar *)m_Buffer);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Position", (xmlChar *)ArenaBuffer());
                     pgd::Quaternion rquat;
                     body->GetRelativeQuaternion(parent, &rquat);
                     pgd::Vector axis = pgd::QGetAxis(rquat);
                     double angle = pgd::QGetAngle(rquat) * 180 / M_PI;
-                    sprintf(m_Buffer, "%s %.17ed %.17e %.17e %.17e", parentName.c_str(), angle, axis.x, axis.y, axis.z);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Quaternion", (xmlChar *)m_Buffer);
+                    char *ptr = ArenaBuffer() + FastDouble::FormatList(ArenaBuffer(), parentName.c_str(), angle);
+                    *ptr++ = 'd';
+                    *ptr++ = ' ';
+                    FastDouble::FormatList(ptr, 0, axis.x, axis.y, axis.z);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Quaternion", (xmlChar *)ArenaBuffer());
                     pgd::Vector rvel;
                     body->GetRelativeLinearVelocity(parent, &rvel);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", parentName.c_str(), rvel.x, rvel.y, rvel.z);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"LinearVelocity", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), parentName.c_str(), rvel.x, rvel.y, rvel.z);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"LinearVelocity", (xmlChar *)ArenaBuffer());
                     pgd::Vector ravel;
                     body->GetRelativeAngularVelocity(parent, &ravel);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", parentName.c_str(), ravel.x, ravel.y, ravel.z);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"AngularVelocity", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), parentName.c_str(), ravel.x, ravel.y, ravel.z);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"AngularVelocity", (xmlChar *)ArenaBuffer());
                     definedList.insert(*body->GetName());
                 }
             }
@@ -3965,33 +4389,33 @@ void Simulation::OutputProgramState()
                     if (m_ModelStateRelative)
                     {
                         dBodyGetPosRelPoint(jp->GetBody1()->GetBodyID(), v[0], v[1], v[2], result);
-                        sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
+                        FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
                     }
                     else
                     {
-                        sprintf(m_Buffer, "%s %.17e %.17e %.17e","World" , v[0], v[1], v[2]);
+                        FastDouble::FormatList(ArenaBuffer(), "World", v[0], v[1], v[2]);
                     }
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"HingeAnchor", (xmlChar *)m_Buffer);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"HingeAnchor", (xmlChar *)ArenaBuffer());
                     jp->GetHingeAxis(v);
                     if (m_ModelStateRelative)
                     {
                         dBodyVectorFromWorld(jp->GetBody1()->GetBodyID(), v[0], v[1], v[2], result);
-                        sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
+                        FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
                     }
                     else
                     {
-                        sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World" , v[0], v[1], v[2]);
+                        FastDouble::FormatList(ArenaBuffer(), "World", v[0], v[1], v[2]);
                     }
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"HingeAxis", (xmlChar *)m_Buffer);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"HingeAxis", (xmlChar *)ArenaBuffer());
                 }
                 else
                 {
                     jp->GetHingeAnchor(v);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e","World" , v[0], v[1], v[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"HingeAnchor", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", v[0], v[1], v[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"HingeAnchor", (xmlChar *)ArenaBuffer());
                     jp->GetHingeAxis(v);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World" , v[0], v[1], v[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"HingeAxis", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", v[0], v[1], v[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"HingeAxis", (xmlChar *)ArenaBuffer());
                 }
 
                 // always output the extra joint data - it's very useful
@@ -4000,25 +4424,25 @@ void Simulation::OutputProgramState()
                 {
                     jp->GetHingeAnchor(v);
                     dBodyGetPosRelPoint(body->GetBodyID(), v[0], v[1], v[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Body2HingeAnchor", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Body2HingeAnchor", (xmlChar *)ArenaBuffer());
                     jp->GetHingeAxis(v);
                     dBodyVectorFromWorld(jp->GetBody2()->GetBodyID(), v[0], v[1], v[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Body2HingeAxis", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Body2HingeAxis", (xmlChar *)ArenaBuffer());
                 }
                 else
                 {
                     jp->GetHingeAnchor(v);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e","World" , v[0], v[1], v[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Body2HingeAnchor", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", v[0], v[1], v[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Body2HingeAnchor", (xmlChar *)ArenaBuffer());
                     jp->GetHingeAxis(v);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World" , v[0], v[1], v[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Body2HingeAxis", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", v[0], v[1], v[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Body2HingeAxis", (xmlChar *)ArenaBuffer());
                 }
 
-                sprintf(m_Buffer, "%.17e", jp->GetHingeAngle());
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"StartAngleReference", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), 0, jp->GetHingeAngle());
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"StartAngleReference", (xmlChar *)ArenaBuffer());
             }
 
             BallJoint *jpb = dynamic_cast<BallJoint *>(joint);
@@ -4029,26 +4453,26 @@ void Simulation::OutputProgramState()
                 if (m_ModelStateRelative)
                 {
                     dBodyGetPosRelPoint(jpb->GetBody1()->GetBodyID(), v[0], v[1], v[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
                 }
                 else
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World" , v[0], v[1], v[2]);
+                    FastDouble::FormatList(ArenaBuffer(), "World", v[0], v[1], v[2]);
                 }
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"BallAnchor", (xmlChar *)m_Buffer);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"BallAnchor", (xmlChar *)ArenaBuffer());
 
                 // always output the extra joint data - it's very useful
                 body = jpb->GetBody2();
                 jpb->GetBallAnchor(v);
                 dBodyGetPosRelPoint(body->GetBodyID(), v[0], v[1], v[2], result);
-                sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Body2BallAnchor", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Body2BallAnchor", (xmlChar *)ArenaBuffer());
 
                 // and output the reference vectors
                 dVector3 reference1, reference2;
                 jpb->GetEulerReferenceVectors(reference1, reference2);
-                sprintf(m_Buffer, "%.17e %.17e %.17e %.17e %.17e %.17e", reference1[0], reference1[1], reference1[2], reference2[0], reference2[1], reference2[2]);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"EulerReferenceVectors", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), 0, reference1[0], reference1[1], reference1[2], reference2[0], reference2[1], reference2[2]);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"EulerReferenceVectors", (xmlChar *)ArenaBuffer());
             }
 
             UniversalJoint *jpu = dynamic_cast<UniversalJoint *>(joint);
@@ -4059,44 +4483,44 @@ void Simulation::OutputProgramState()
                 {
                     jpu->GetUniversalAnchor(v);
                     dBodyGetPosRelPoint(body->GetBodyID(), v[0], v[1], v[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAnchor", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAnchor", (xmlChar *)ArenaBuffer());
                     jpu->GetUniversalAxis1(v);
                     dBodyVectorFromWorld(body->GetBodyID(), v[0], v[1], v[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAxis1", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAxis1", (xmlChar *)ArenaBuffer());
                     jpu->GetUniversalAxis2(v);
                     dBodyVectorFromWorld(body->GetBodyID(), v[0], v[1], v[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAxis2", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAxis2", (xmlChar *)ArenaBuffer());
                 }
                 else
                 {
                     jpu->GetUniversalAnchor(v);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e","World" , v[0], v[1], v[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAnchor", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", v[0], v[1], v[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAnchor", (xmlChar *)ArenaBuffer());
                     jpu->GetUniversalAxis1(v);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World" , v[0], v[1], v[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAxis1", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", v[0], v[1], v[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAxis1", (xmlChar *)ArenaBuffer());
                     jpu->GetUniversalAxis2(v);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World" , v[0], v[1], v[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAxis2", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", v[0], v[1], v[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAxis2", (xmlChar *)ArenaBuffer());
                 }
 
                 // always output the extra joint data - it's very useful
                 body = jpu->GetBody2();
                 jpu->GetUniversalAnchor(v);
                 dBodyGetPosRelPoint(body->GetBodyID(), v[0], v[1], v[2], result);
-                sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAnchor", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAnchor", (xmlChar *)ArenaBuffer());
                 jpu->GetUniversalAxis1(v);
                 dBodyVectorFromWorld(body->GetBodyID(), v[0], v[1], v[2], result);
-                sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAxis1", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAxis1", (xmlChar *)ArenaBuffer());
                 jpu->GetUniversalAxis2(v);
                 dBodyVectorFromWorld(body->GetBodyID(), v[0], v[1], v[2], result);
-                sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAxis2", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"UniversalAxis2", (xmlChar *)ArenaBuffer());
             }
 
             FixedJoint *jpf = dynamic_cast<FixedJoint *>(joint);
@@ -4114,23 +4538,23 @@ void Simulation::OutputProgramState()
                     if (m_ModelStateRelative)
                     {
                         dBodyVectorFromWorld(body->GetBodyID(), v[0], v[1], v[2], result);
-                        sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), result[0], result[1], result[2]);
+                        FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), result[0], result[1], result[2]);
                     }
                     else
                     {
-                        sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World" , v[0], v[1], v[2]);
+                        FastDouble::FormatList(ArenaBuffer(), "World", v[0], v[1], v[2]);
                     }
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"SliderAxis", (xmlChar *)m_Buffer);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"SliderAxis", (xmlChar *)ArenaBuffer());
                 }
                 else
                 {
                     jps->GetSliderAxis(v);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World" , v[0], v[1], v[2]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"SliderAxis", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", v[0], v[1], v[2]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"SliderAxis", (xmlChar *)ArenaBuffer());
                 }
 
-                sprintf(m_Buffer, "%.17e", jps->GetSliderDistance());
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"StartDistanceReference", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), 0, jps->GetSliderDistance());
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"StartDistanceReference", (xmlChar *)ArenaBuffer());
             }
 
         }
@@ -4149,18 +4573,18 @@ void Simulation::OutputProgramState()
                 const double *p = geom->GetPosition();
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(),  p[0], p[1], p[2]);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), p[0], p[1], p[2]);
                 }
                 else
                 {
                     dBodyGetRelPointPos (geom->GetBody(), p[0], p[1], p[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", result[0], result[1], result[2]);
+                    FastDouble::FormatList(ArenaBuffer(), "World", result[0], result[1], result[2]);
                 }
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Position", (xmlChar *)m_Buffer);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Position", (xmlChar *)ArenaBuffer());
                 dQuaternion q;
                 geom->GetQuaternion(q);
-                sprintf(m_Buffer, "%s %.17e %.17e %.17e %.17e", body->GetName()->c_str(), q[0], q[1], q[2], q[3]);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Quaternion", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), q[0], q[1], q[2], q[3]);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Quaternion", (xmlChar *)ArenaBuffer());
             }
         }
 
@@ -4179,20 +4603,20 @@ void Simulation::OutputProgramState()
                 {
                     Body *body = positionReporter->GetBody();
                     pgd::Vector p = positionReporter->GetPosition();
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(), p.x, p.y, p.z);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Position", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), p.x, p.y, p.z);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Position", (xmlChar *)ArenaBuffer());
                     pgd::Quaternion q = positionReporter->GetQuaternion();
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e %.17e", body->GetName()->c_str(), q.n, q.v.x, q.v.y, q.v.z);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Quaternion", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), q.n, q.v.x, q.v.y, q.v.z);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Quaternion", (xmlChar *)ArenaBuffer());
                 }
                 else
                 {
                     pgd::Vector p = positionReporter->GetWorldPosition();
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", p.x, p.y, p.z);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Position", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", p.x, p.y, p.z);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Position", (xmlChar *)ArenaBuffer());
                     pgd::Quaternion q = positionReporter->GetWorldQuaternion();
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e %.17e", "World", q.n, q.v.x, q.v.y, q.v.z);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Quaternion", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", q.n, q.v.x, q.v.y, q.v.z);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Quaternion", (xmlChar *)ArenaBuffer());
                 }
             }
         }
@@ -4208,21 +4632,21 @@ void Simulation::OutputProgramState()
             MAMuscleExtended *mam = dynamic_cast<MAMuscleExtended *>(muscle);
             if (mam)
             {
-                sprintf(m_Buffer, "%.17e", mam->GetSSE());
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"TendonLength", (xmlChar *)m_Buffer);
-                sprintf(m_Buffer, "%.17e", mam->GetLPE());
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"InitialFibreLength", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), 0, mam->GetSSE());
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"TendonLength", (xmlChar *)ArenaBuffer());
+                FastDouble::FormatList(ArenaBuffer(), 0, mam->GetLPE());
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"InitialFibreLength", (xmlChar *)ArenaBuffer());
             }
 
             MAMuscleComplete *mamc = dynamic_cast<MAMuscleComplete *>(muscle);
             if (mamc)
             {
-                sprintf(m_Buffer, "%.17e", mamc->GetSSE());
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"TendonLength", (xmlChar *)m_Buffer);
-                sprintf(m_Buffer, "%.17e", mamc->GetLPE());
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"InitialFibreLength", (xmlChar *)m_Buffer);
-                sprintf(m_Buffer, "%.17e", mamc->GetActivation());
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"StartActivation", (xmlChar *)m_Buffer);
+                FastDouble::FormatList(ArenaBuffer(), 0, mamc->GetSSE());
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"TendonLength", (xmlChar *)ArenaBuffer());
+                FastDouble::FormatList(ArenaBuffer(), 0, mamc->GetLPE());
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"InitialFibreLength", (xmlChar *)ArenaBuffer());
+                FastDouble::FormatList(ArenaBuffer(), 0, mamc->GetActivation());
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"StartActivation", (xmlChar *)ArenaBuffer());
             }
 
             TwoPointStrap *twoPointStrap = dynamic_cast<TwoPointStrap *>(muscle->GetStrap());
@@ -4233,25 +4657,25 @@ void Simulation::OutputProgramState()
                 twoPointStrap->GetOrigin(&body, &p);
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(),  p[0], p[1], p[2]);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), p[0], p[1], p[2]);
                 }
                 else
                 {
                     dBodyGetRelPointPos (body->GetBodyID(), p[0], p[1], p[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", result[0], result[1], result[2]);
+                    FastDouble::FormatList(ArenaBuffer(), "World", result[0], result[1], result[2]);
                 }
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Origin", (xmlChar *)m_Buffer);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Origin", (xmlChar *)ArenaBuffer());
                 twoPointStrap->GetInsertion(&body,&p);
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(),  p[0], p[1], p[2]);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), p[0], p[1], p[2]);
                 }
                 else
                 {
                     dBodyGetRelPointPos (body->GetBodyID(), p[0], p[1], p[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", result[0], result[1], result[2]);
+                    FastDouble::FormatList(ArenaBuffer(), "World", result[0], result[1], result[2]);
                 }
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Insertion", (xmlChar *)m_Buffer);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Insertion", (xmlChar *)ArenaBuffer());
             }
             ThreePointStrap *threePointStrap = dynamic_cast<ThreePointStrap *>(muscle->GetStrap());
             if (threePointStrap)
@@ -4261,14 +4685,14 @@ void Simulation::OutputProgramState()
                 threePointStrap->GetMidpoint(&body, &p);
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(),  p[0], p[1], p[2]);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), p[0], p[1], p[2]);
                 }
                 else
                 {
                     dBodyGetRelPointPos (body->GetBodyID(), p[0], p[1], p[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", result[0], result[1], result[2]);
+                    FastDouble::FormatList(ArenaBuffer(), "World", result[0], result[1], result[2]);
                 }
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"MidPoint", (xmlChar *)m_Buffer);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"MidPoint", (xmlChar *)ArenaBuffer());
             }
             CylinderWrapStrap *cylinderWrapStrap = dynamic_cast<CylinderWrapStrap *>(muscle->GetStrap());
             if (cylinderWrapStrap)
@@ -4280,42 +4704,42 @@ void Simulation::OutputProgramState()
                 cylinderWrapStrap->GetOrigin(&body, p);
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(),  p[0], p[1], p[2]);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), p[0], p[1], p[2]);
                 }
                 else
                 {
                     dBodyGetRelPointPos (body->GetBodyID(), p[0], p[1], p[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", result[0], result[1], result[2]);
+                    FastDouble::FormatList(ArenaBuffer(), "World", result[0], result[1], result[2]);
                 }
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Origin", (xmlChar *)m_Buffer);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Origin", (xmlChar *)ArenaBuffer());
                 cylinderWrapStrap->GetInsertion(&body,p);
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(),  p[0], p[1], p[2]);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), p[0], p[1], p[2]);
                 }
                 else
                 {
                     dBodyGetRelPointPos (body->GetBodyID(), p[0], p[1], p[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", result[0], result[1], result[2]);
+                    FastDouble::FormatList(ArenaBuffer(), "World", result[0], result[1], result[2]);
                 }
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Insertion", (xmlChar *)m_Buffer);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Insertion", (xmlChar *)ArenaBuffer());
                 cylinderWrapStrap->GetCylinder(&body, p, &radius, q);
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(),  p[0], p[1], p[2]);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), p[0], p[1], p[2]);
                 }
                 else
                 {
                     dBodyGetRelPointPos (body->GetBodyID(), p[0], p[1], p[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", result[0], result[1], result[2]);
+                    FastDouble::FormatList(ArenaBuffer(), "World", result[0], result[1], result[2]);
                 }
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"CylinderPosition", (xmlChar *)m_Buffer);
-                sprintf(m_Buffer, "%.17e", radius);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"CylinderRadius", (xmlChar *)m_Buffer);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"CylinderPosition", (xmlChar *)ArenaBuffer());
+                FastDouble::FormatList(ArenaBuffer(), 0, radius);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"CylinderRadius", (xmlChar *)ArenaBuffer());
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e %.17e", body->GetName()->c_str(),  q[0], q[1], q[2], q[3]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"CylinderQuaternion", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), q[0], q[1], q[2], q[3]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"CylinderQuaternion", (xmlChar *)ArenaBuffer());
                 }
                 else
                 {
@@ -4323,8 +4747,8 @@ void Simulation::OutputProgramState()
                     pgd::Quaternion qLocal(q[0], q[1], q[2], q[3]);
                     pgd::Quaternion qBody(bq[0], bq[1], bq[2], bq[3]);
                     pgd::Quaternion qWorld = qBody * qLocal;
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e %.17e", "World",  qWorld.n, qWorld.v.x, qWorld.v.y, qWorld.v.z);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"CylinderQuaternion", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", qWorld.n, qWorld.v.x, qWorld.v.y, qWorld.v.z);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"CylinderQuaternion", (xmlChar *)ArenaBuffer());
                 }
 
                 DoXmlRemoveProp(newNode, (xmlChar *)"CylinderAxis");
@@ -4340,55 +4764,55 @@ void Simulation::OutputProgramState()
                 twoCylinderWrapStrap->GetOrigin(&body, p);
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(),  p[0], p[1], p[2]);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), p[0], p[1], p[2]);
                 }
                 else
                 {
                     dBodyGetRelPointPos (body->GetBodyID(), p[0], p[1], p[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", result[0], result[1], result[2]);
+                    FastDouble::FormatList(ArenaBuffer(), "World", result[0], result[1], result[2]);
                 }
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Origin", (xmlChar *)m_Buffer);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Origin", (xmlChar *)ArenaBuffer());
                 twoCylinderWrapStrap->GetInsertion(&body,p);
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(),  p[0], p[1], p[2]);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), p[0], p[1], p[2]);
                 }
                 else
                 {
                     dBodyGetRelPointPos (body->GetBodyID(), p[0], p[1], p[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", result[0], result[1], result[2]);
+                    FastDouble::FormatList(ArenaBuffer(), "World", result[0], result[1], result[2]);
                 }
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Insertion", (xmlChar *)m_Buffer);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Insertion", (xmlChar *)ArenaBuffer());
                 twoCylinderWrapStrap->GetCylinder1(&body, p, &radius, q);
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(),  p[0], p[1], p[2]);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), p[0], p[1], p[2]);
                 }
                 else
                 {
                     dBodyGetRelPointPos (body->GetBodyID(), p[0], p[1], p[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", result[0], result[1], result[2]);
+                    FastDouble::FormatList(ArenaBuffer(), "World", result[0], result[1], result[2]);
                 }
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Cylinder1Position", (xmlChar *)m_Buffer);
-                sprintf(m_Buffer, "%.17e", radius);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Cylinder1Radius", (xmlChar *)m_Buffer);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Cylinder1Position", (xmlChar *)ArenaBuffer());
+                FastDouble::FormatList(ArenaBuffer(), 0, radius);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Cylinder1Radius", (xmlChar *)ArenaBuffer());
                 twoCylinderWrapStrap->GetCylinder2(&body, p, &radius, q);
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", body->GetName()->c_str(),  p[0], p[1], p[2]);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), p[0], p[1], p[2]);
                 }
                 else
                 {
                     dBodyGetRelPointPos (body->GetBodyID(), p[0], p[1], p[2], result);
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", result[0], result[1], result[2]);
+                    FastDouble::FormatList(ArenaBuffer(), "World", result[0], result[1], result[2]);
                 }
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Cylinder2Position", (xmlChar *)m_Buffer);
-                sprintf(m_Buffer, "%.17e", radius);
-                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Cylinder2Radius", (xmlChar *)m_Buffer);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Cylinder2Position", (xmlChar *)ArenaBuffer());
+                FastDouble::FormatList(ArenaBuffer(), 0, radius);
+                newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"Cylinder2Radius", (xmlChar *)ArenaBuffer());
                 if (m_ModelStateRelative)
                 {
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e %.17e", body->GetName()->c_str(),  q[0], q[1], q[2], q[3]);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"CylinderQuaternion", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), body->GetName()->c_str(), q[0], q[1], q[2], q[3]);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"CylinderQuaternion", (xmlChar *)ArenaBuffer());
                 }
                 else
                 {
@@ -4396,8 +4820,8 @@ void Simulation::OutputProgramState()
                     pgd::Quaternion qLocal(q[0], q[1], q[2], q[3]);
                     pgd::Quaternion qBody(bq[0], bq[1], bq[2], bq[3]);
                     pgd::Quaternion qWorld = qBody * qLocal;
-                    sprintf(m_Buffer, "%s %.17e %.17e %.17e %.17e", "World",  qWorld.n, qWorld.v.x, qWorld.v.y, qWorld.v.z);
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"CylinderQuaternion", (xmlChar *)m_Buffer);
+                    FastDouble::FormatList(ArenaBuffer(), "World", qWorld.n, qWorld.v.x, qWorld.v.y, qWorld.v.z);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)"CylinderQuaternion", (xmlChar *)ArenaBuffer());
                 }
 
                 DoXmlRemoveProp(newNode, (xmlChar *)"CylinderAxis");
@@ -4416,17 +4840,20 @@ void Simulation::OutputProgramState()
                     sprintf(viaPointName, "ViaPoint%d", i);
                     if (m_ModelStateRelative)
                     {
-                        sprintf(m_Buffer, "%s %.17e %.17e %.17e", (*viaPointBodies)[i]->GetName()->c_str(),  p[0], p[1], p[2]);
+                        FastDouble::FormatList(ArenaBuffer(), (*viaPointBodies)[i]->GetName()->c_str(), p[0], p[1], p[2]);
                     }
                     else
                     {
                         dBodyGetRelPointPos ((*viaPointBodies)[i]->GetBodyID(), p[0], p[1], p[2], result);
-                        sprintf(m_Buffer, "%s %.17e %.17e %.17e", "World", result[0], result[1], result[2]);
+                        FastDouble::FormatList(ArenaBuffer(), "World", result[0], result[1], result[2]);
                     }
-                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)viaPointName, (xmlChar *)m_Buffer);
+                    newAttr = DoXmlReplaceProp(newNode, (xmlChar *)viaPointName, (xmlChar *)ArenaBuffer());
                 }
             }
         }
+
+        xmlFreeDoc(elementDoc);
+        m_AttributeIndexNode = 0;
     }
 
 
@@ -4437,6 +4864,215 @@ void Simulation::OutputProgramState()
     m_OutputModelStateOccured = true;
 }
 
+// checkpoint lists are written in map order with the names so that a checkpoint
+// from a different model is detected rather than silently misread
+template <typename T> static void WriteCheckpointList(Checkpoint *checkpoint, std::map<std::string, T *> *list)
+{
+    uint64_t count = list->size();
+    checkpoint->Write(count);
+    typename std::map<std::string, T *>::const_iterator iter;
+    for (iter = list->begin(); iter != list->end(); iter++)
+    {
+        checkpoint->WriteString(iter->first);
+        size_t start = checkpoint->BeginBlock();
+        iter->second->WriteCheckpoint(checkpoint);
+        checkpoint->EndBlock(start);
+    }
+}
+
+template <typename T> static void ReadCheckpointList(Checkpoint *checkpoint, std::map<std::string, T *> *list)
+{
+    uint64_t count;
+    checkpoint->Read(&count);
+    if (count != list->size()) throw __LINE__;
+    typename std::map<std::string, T *>::const_iterator iter;
+    for (iter = list->begin(); iter != list->end(); iter++)
+    {
+        if (checkpoint->ReadString() != iter->first) throw __LINE__;
+        size_t end = checkpoint->BeginReadBlock();
+        iter->second->ReadCheckpoint(checkpoint);
+        checkpoint->EndReadBlock(end);
+    }
+}
+
+// this is everything that UpdateSimulation changes so that restoring it into a newly loaded copy
+// of the same model and carrying on gives exactly the same values as the original run
+// (the -CC option in ObjectiveMain checks this)
+// the contacts are not needed because they are recreated at the start of every step
+void Simulation::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Write(m_ModelHash);
+    checkpoint->Write(m_SimulationTime);
+    checkpoint->Write(m_StepCount);
+    checkpoint->Write(m_MechanicalEnergy);
+    checkpoint->Write(m_MetabolicEnergy);
+    checkpoint->Write(m_KinematicMatchFitness);
+    checkpoint->Write(m_KinematicMatchMiniMaxFitness);
+    checkpoint->Write(m_ClosestWarehouseFitness);
+    checkpoint->Write(m_WarehouseDistance);
+    checkpoint->WriteString(m_CurrentWarehouse);
+    checkpoint->Write(m_ContactAbort);
+    checkpoint->Write(m_DataTargetAbort);
+    checkpoint->Write(m_SimulationError);
+    checkpoint->Write(m_PositiveMechanicalWork);
+    checkpoint->Write(m_NegativeMechanicalWork);
+    checkpoint->Write(m_PositiveContractileWork);
+    checkpoint->Write(m_NegativeContractileWork);
+    checkpoint->Write(m_PositiveSerialElasticWork);
+    checkpoint->Write(m_NegativeSerialElasticWork);
+    checkpoint->Write(m_PositiveParallelElasticWork);
+    checkpoint->Write(m_NegativeParallelElasticWork);
+
+    // QuickStep uses the ODE random number generator to reorder the constraints
+    unsigned long seed = dRandGetSeed();
+    checkpoint->Write(seed);
+
+    // the outputs that only happen once need to know whether they have already happened
+    checkpoint->Write(m_OutputModelStateOccured);
+    checkpoint->Write(m_OutputKinematicsFirstTimeFlag);
+    checkpoint->Write(m_OutputWarehouseLastTime);
+
+    // ODE moves geoms to the front of the space when their bodies move and the order the pairs
+    // are collided in sets the order of the contact joints which changes the rounding in the solver
+    int numGeoms = dSpaceGetNumGeoms(m_SpaceID);
+    checkpoint->Write(numGeoms);
+    for (int i = 0; i < numGeoms; i++)
+    {
+        Geom *geom = (Geom *)dGeomGetData(dSpaceGetGeom(m_SpaceID, i));
+        checkpoint->WriteString(geom ? *geom->GetName() : std::string());
+    }
+
+    WriteCheckpointList(checkpoint, &m_BodyList);
+    WriteCheckpointList(checkpoint, &m_JointList);
+    WriteCheckpointList(checkpoint, &m_MuscleList);
+    WriteCheckpointList(checkpoint, &m_DriverList);
+    WriteCheckpointList(checkpoint, &m_DataTargetList);
+    WriteCheckpointList(checkpoint, &m_ReporterList);
+    WriteCheckpointList(checkpoint, &m_ControllerList);
+}
+
+// throws if the checkpoint does not match the model
+void Simulation::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    uint64_t modelHash;
+    checkpoint->Read(&modelHash);
+    if (modelHash != m_ModelHash) throw __LINE__;
+    checkpoint->Read(&m_SimulationTime);
+    checkpoint->Read(&m_StepCount);
+    checkpoint->Read(&m_MechanicalEnergy);
+    checkpoint->Read(&m_MetabolicEnergy);
+    checkpoint->Read(&m_KinematicMatchFitness);
+    checkpoint->Read(&m_KinematicMatchMiniMaxFitness);
+    checkpoint->Read(&m_ClosestWarehouseFitness);
+    checkpoint->Read(&m_WarehouseDistance);
+    m_CurrentWarehouse = checkpoint->ReadString();
+    checkpoint->Read(&m_ContactAbort);
+    checkpoint->Read(&m_DataTargetAbort);
+    checkpoint->Read(&m_SimulationError);
+    checkpoint->Read(&m_PositiveMechanicalWork);
+    checkpoint->Read(&m_NegativeMechanicalWork);
+    checkpoint->Read(&m_PositiveContractileWork);
+    checkpoint->Read(&m_NegativeContractileWork);
+    checkpoint->Read(&m_PositiveSerialElasticWork);
+    checkpoint->Read(&m_NegativeSerialElasticWork);
+    checkpoint->Read(&m_PositiveParallelElasticWork);
+    checkpoint->Read(&m_NegativeParallelElasticWork);
+
+    unsigned long seed;
+    checkpoint->Read(&seed);
+    dRandSetSeed(seed);
+
+    // the output files belong to the process so if they have not been opened in this one
+    // they need to be opened again with their headings
+    bool outputKinematicsFirstTimeFlag;
+    double outputWarehouseLastTime;
+    checkpoint->Read(&m_OutputModelStateOccured);
+    checkpoint->Read(&outputKinematicsFirstTimeFlag);
+    checkpoint->Read(&outputWarehouseLastTime);
+    m_OutputKinematicsFirstTimeFlag = outputKinematicsFirstTimeFlag || m_OutputKinematicsFile.is_open() == false;
+    m_OutputWarehouseLastTime = m_OutputWarehouseFile.is_open() ? outputWarehouseLastTime : -DBL_MAX;
+
+    // the geoms are taken out and put back in reverse order because ODE adds them to the front of the space
+    int numGeoms;
+    checkpoint->Read(&numGeoms);
+    if (numGeoms != dSpaceGetNumGeoms(m_SpaceID)) throw __LINE__;
+    std::map<std::string, dGeomID> geomIDList;
+    for (int i = 0; i < numGeoms; i++)
+    {
+        dGeomID geomID = dSpaceGetGeom(m_SpaceID, i);
+        Geom *geom = (Geom *)dGeomGetData(geomID);
+        geomIDList[geom ? *geom->GetName() : std::string()] = geomID;
+    }
+    if ((int)geomIDList.size() != numGeoms) throw __LINE__;
+    std::vector<dGeomID> geomOrder(numGeoms);
+    for (int i = 0; i < numGeoms; i++)
+    {
+        std::map<std::string, dGeomID>::const_iterator iter = geomIDList.find(checkpoint->ReadString());
+        if (iter == geomIDList.end()) throw __LINE__;
+        geomOrder[i] = iter->second;
+    }
+    for (int i = numGeoms - 1; i >= 0; i--)
+    {
+        dSpaceRemove(m_SpaceID, geomOrder[i]);
+        dSpaceAdd(m_SpaceID, geomOrder[i]);
+    }
+
+    ReadCheckpointList(checkpoint, &m_BodyList);
+    ReadCheckpointList(checkpoint, &m_JointList);
+    ReadCheckpointList(checkpoint, &m_MuscleList);
+    ReadCheckpointList(checkpoint, &m_DriverList);
+    ReadCheckpointList(checkpoint, &m_DataTargetList);
+    ReadCheckpointList(checkpoint, &m_ReporterList);
+    ReadCheckpointList(checkpoint, &m_ControllerList);
+
+    if (m_CheckpointInterval > 0) m_NextCheckpointTime = (floor(m_SimulationTime / m_CheckpointInterval) + 1) * m_CheckpointInterval;
+}
+
+bool Simulation::WriteCheckpointFile(const char *filename)
+{
+    Checkpoint checkpoint;
+    WriteCheckpoint(&checkpoint);
+    return checkpoint.WriteFile(filename);
+}
+
+bool Simulation::ReadCheckpointFile(const char *filename)
+{
+    Checkpoint checkpoint;
+    if (checkpoint.ReadFile(filename) == false) return false;
+    try
+    {
+        ReadCheckpoint(&checkpoint);
+    }
+    catch (int e)
+    {
+        std::cerr << "Error reading checkpoint \"" << filename << "\": does not match the model (line " << e << ")\n";
+        return false;
+    }
+    return true;
+}
+
+void Simulation::SetCheckpointInterval(double checkpointInterval)
+{
+    m_CheckpointInterval = checkpointInterval;
+    if (m_CheckpointInterval > 0) m_NextCheckpointTime = (floor(m_SimulationTime / m_CheckpointInterval) + 1) * m_CheckpointInterval;
+}
+
+void Simulation::PerturbBodyVelocities(double standardDeviation, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::normal_distribution<double> distribution(0, standardDeviation);
+    std::map<std::string, Body *>::const_iterator iter;
+    double v[3];
+    for (iter = m_BodyList.begin(); iter != m_BodyList.end(); iter++)
+    {
+        const double *lv = dBodyGetLinearVel(iter->second->GetBodyID());
+        v[0] = lv[0] + distribution(generator);
+        v[1] = lv[1] + distribution(generator);
+        v[2] = lv[2] + distribution(generator);
+        dBodySetLinearVel(iter->second->GetBodyID(), v[0], v[1], v[2]);
+    }
+}
+
 void Simulation::SetOutputKinematicsFile(const char *filename)
 {
     if (filename)
@@ -4457,7 +5093,8 @@ void Simulation::SetInputKinematicsFile(const char *filename)
         m_InputKinematicsFile.SetExitOnError(true);
         m_InputKinematicsFile.ReadFile(filename);
         // and skip first line
-        m_InputKinematicsFile.ReadNextLine(m_Buffer, m_BufferSize, false);
+        char *buffer = ParseArena::GetArena()->GetBuffer(m_InputKinematicsFile.GetSize() + 1);
+        m_InputKinematicsFile.ReadNextLine(buffer, ParseArena::GetArena()->GetBufferSize(), false);
         m_InputKinematicsFlag = true;
     }
     else
@@ -4505,8 +5142,135 @@ bool Simulation::ShouldQuit()
     return false;
 }
 
+// this sets the ODE category and collide bits of all the geoms in the space so that
+// the pairs that NearCallback would reject are never passed to it
+// bit 0 is the environment and each body gets one of the other bits
+// bodies have to share bits if there are more bodies than bits so a bit is only removed
+// from a geom's collide bits if every body with that bit is excluded and NearCallback
+// still does its own tests for anything that gets through
+void Simulation::AssignCollisionBits()
+{
+    const int numBits = sizeof(unsigned long) * 8;
+    const unsigned long environmentBit = 1;
+    std::vector<std::vector<dBodyID> > bitBodyList(numBits);
+    std::map<dBodyID, unsigned long> bodyCategoryBits;
+    std::map<dBodyID, unsigned long> bodyCollideBits;
+    unsigned long allBodyBits = 0;
+    unsigned long bit;
+    int i, k;
+
+    i = 0;
+    std::map<std::string, Body *>::const_iterator iter;
+    for (iter = m_BodyList.begin(); iter != m_BodyList.end(); iter++)
+    {
+        k = 1 + (i % (numBits - 1));
+        bitBodyList[k].push_back(iter->second->GetBodyID());
+        bodyCategoryBits[iter->second->GetBodyID()] = 1UL << k;
+        allBodyBits |= 1UL << k;
+        i++;
+    }
+
+    for (iter = m_BodyList.begin(); iter != m_BodyList.end(); iter++)
+    {
+        dBodyID b1 = iter->second->GetBodyID();
+        unsigned long collideBits = environmentBit;
+        if (m_AllowInternalCollisions)
+        {
+            for (k = 1; k < numBits; k++)
+            {
+                if (bitBodyList[k].size() == 0) continue;
+                bool excluded = (m_AllowConnectedCollisions == false);
+                for (unsigned int j = 0; j < bitBodyList[k].size() && excluded; j++)
+                {
+                    dBodyID b2 = bitBodyList[k][j];
+                    // ODE never tests geoms on the same body against each other
+                    if (b2 != b1 && dAreConnectedExcluding(b1, b2, dJointTypeContact) == 0) excluded = false;
+                }
+                if (excluded == false) collideBits |= 1UL << k;
+            }
+        }
+        bodyCollideBits[b1] = collideBits;
+    }
+
+    for (i = 0; i < dSpaceGetNumGeoms(m_SpaceID); i++)
+    {
+        dGeomID geomID = dSpaceGetGeom(m_SpaceID, i);
+        Geom *geom = (Geom *)dGeomGetData(geomID);
+        dBodyID body = dGeomGetBody(geomID);
+        if (geom == 0) continue;
+        if (geom->GetGeomLocation() == Geom::environment || body == 0)
+        {
+            bit = geom->GetGeomLocation() == Geom::environment ? environmentBit : allBodyBits;
+            dGeomSetCategoryBits(geomID, bit);
+            if (m_AllowInternalCollisions) dGeomSetCollideBits(geomID, environmentBit | allBodyBits);
+            else dGeomSetCollideBits(geomID, ~bit);
+        }
+        else
+        {
+            dGeomSetCategoryBits(geomID, bodyCategoryBits[body]);
+            dGeomSetCollideBits(geomID, bodyCollideBits[body]);
+        }
+    }
+}
+
+// geoms with the same contact parameters share a material and the surface parameters for every
+// pair of materials are worked out here so that NearCallback only has to copy them
+// this needs calling again if the contact parameters of any geom are changed
+void Simulation::CompileContactMaterials()
+{
+    std::vector<Geom *> materialList;
+    int i, j, k;
+    for (i = 0; i < dSpaceGetNumGeoms(m_SpaceID); i++)
+    {
+        Geom *geom = (Geom *)dGeomGetData(dSpaceGetGeom(m_SpaceID, i));
+        if (geom == 0) continue;
+        for (k = 0; k < (int)materialList.size(); k++)
+        {
+            if (materialList[k]->GetContactSoftCFM() == geom->GetContactSoftCFM() &&
+                    materialList[k]->GetContactSoftERP() == geom->GetContactSoftERP() &&
+                    materialList[k]->GetContactMu() == geom->GetContactMu() &&
+                    materialList[k]->GetContactBounce() == geom->GetContactBounce()) break;
+        }
+        if (k == (int)materialList.size()) materialList.push_back(geom);
+        geom->SetMaterialID(k);
+    }
+
+    m_NumContactMaterials = materialList.size();
+    m_ContactSurfaceList.resize(m_NumContactMaterials * m_NumContactMaterials);
+    for (i = 0; i < m_NumContactMaterials; i++)
+    {
+        for (j = 0; j < m_NumContactMaterials; j++)
+        {
+            dSurfaceParameters *surface = &m_ContactSurfaceList[i * m_NumContactMaterials + j];
+            memset(surface, 0, sizeof(dSurfaceParameters));
+            double cfm = MAX(materialList[i]->GetContactSoftCFM(), materialList[j]->GetContactSoftCFM());
+            double erp = MIN(materialList[i]->GetContactSoftERP(), materialList[j]->GetContactSoftERP());
+            double mu = MIN(materialList[i]->GetContactMu(), materialList[j]->GetContactMu());
+            double bounce = MAX(materialList[i]->GetContactBounce(), materialList[j]->GetContactBounce());
+            surface->mode = dContactApprox1;
+            surface->mu = mu;
+            if (bounce >= 0)
+            {
+                surface->bounce = bounce;
+                surface->mode += dContactBounce;
+            }
+            if (cfm >= 0)
+            {
+                surface->soft_cfm = cfm;
+                surface->mode += dContactSoftCFM;
+            }
+            if (erp <= 1)
+            {
+                surface->soft_erp = erp;
+                surface->mode += dContactSoftERP;
+            }
+        }
+    }
+}
+
 // this is called by dSpaceCollide when two objects in space are
 // potentially colliding.
+// most of the rejected pairs are already filtered out by the bits set in AssignCollisionBits
 
 void Simulation::NearCallback(void *data, dGeomID o1, dGeomID o2)
 {
@@ -4529,41 +5293,40 @@ void Simulation::NearCallback(void *data, dGeomID o1, dGeomID o2)
         if (((Geom *)dGeomGetData(o1))->GetGeomLocation() == ((Geom *)dGeomGetData(o2))->GetGeomLocation()) return;
     }
 
-    dContact *contact = new dContact[s->m_MaxContacts];   // up to m_MaxContacts contacts per box-box
-    double cfm = MAX(((Geom *)dGeomGetData(o1))->GetContactSoftCFM(),
-                    ((Geom *)dGeomGetData(o2))->GetContactSoftCFM());
-    double erp = MIN(((Geom *)dGeomGetData(o1))->GetContactSoftERP(),
-                    ((Geom *)dGeomGetData(o2))->GetContactSoftERP());
-    double mu = MIN(((Geom *)dGeomGetData(o1))->GetContactMu(),
-                   ((Geom *)dGeomGetData(o2))->GetContactMu());
-    double bounce = MAX(((Geom *)dGeomGetData(o1))->GetContactBounce(),
-                       ((Geom *)dGeomGetData(o2))->GetContactBounce());
-    for (i = 0; i < s->m_MaxContacts; i++)
+    // the contact geometry is found first so that the surface only needs setting up when there are contacts
+    // the plane collider gives the same contacts as dCollide and the swapped case is handled the same way
+    dContactGeom *contactGeom = &s->m_ContactGeomList[0];   // up to m_MaxContacts contacts per box-box
+    numc = -1;
+    if (s->m_FastPlaneCollider)
     {
-        contact[i].surface.mode = dContactApprox1;
-        contact[i].surface.mu = mu;
-        if (bounce >= 0)
+        if (dGeomGetClass(o2) == dPlaneClass)
         {
-            contact[i].surface.bounce = bounce;
-            contact[i].surface.mode += dContactBounce;
+            numc = PlaneCollider::Collide(o1, o2, s->m_MaxContacts, contactGeom, sizeof(dContactGeom));
         }
-        if (cfm >= 0)
+        else if (dGeomGetClass(o1) == dPlaneClass)
         {
-            contact[i].surface.soft_cfm = cfm;
-            contact[i].surface.mode += dContactSoftCFM;
-        }
-        if (erp <= 1)
-        {
-            contact[i].surface.soft_erp = erp;
-            contact[i].surface.mode += dContactSoftERP;
+            numc = PlaneCollider::Collide(o2, o1, s->m_MaxContacts, contactGeom, sizeof(dContactGeom));
+            for (i = 0; i < numc; i++)
+            {
+                contactGeom[i].normal[0] = -contactGeom[i].normal[0];
+                contactGeom[i].normal[1] = -contactGeom[i].normal[1];
+                contactGeom[i].normal[2] = -contactGeom[i].normal[2];
+                contactGeom[i].g1 = o1;
+                contactGeom[i].g2 = o2;
+            }
         }
     }
-    numc = dCollide(o1, o2, s->m_MaxContacts, &contact[0].geom, sizeof(dContact));
+    if (numc < 0) numc = dCollide(o1, o2, s->m_MaxContacts, contactGeom, sizeof(dContactGeom));
     if (numc)
     {
+        dContact contact;
+        contact.surface = s->m_ContactSurfaceList[((Geom *)dGeomGetData(o1))->GetMaterialID() * s->m_NumContactMaterials +
+                ((Geom *)dGeomGetData(o2))->GetMaterialID()];
+
         for (i = 0; i < numc; i++)
         {
-            dJointID c = dJointCreateContact(s->m_WorldID, s->m_ContactGroup, contact + i);
+            contact.geom = contactGeom[i];
+            dJointID c = dJointCreateContact(s->m_WorldID, s->m_ContactGroup, &contact);
             dJointAttach(c, b1, b2);
 
             if (((Geom *)dGeomGetData(o1))->GetAbort()) s->SetContactAbort(true);
@@ -4576,7 +5339,7 @@ void Simulation::NearCallback(void *data, dGeomID o1, dGeomID o2)
                 myContact = new Contact();
                 dJointSetFeedback(c, myContact->GetJointFeedback());
                 myContact->SetJointID(c);
-                memcpy(myContact->GetContactPosition(), contact[i].geom.pos, sizeof(dVector3));
+                memcpy(myContact->GetContactPosition(), contactGeom[i].pos, sizeof(dVector3));
                 s->m_ContactList.push_back(myContact);
                 // only add the contact information once
                 // and add it to the non-environment geom
@@ -4593,7 +5356,6 @@ void Simulation::NearCallback(void *data, dGeomID o1, dGeomID o2)
             }
         }
     }
-    delete [] contact;
 }
 
 Body *Simulation::GetBody(const char *name)
@@ -4626,15 +5388,8 @@ char *Simulation::DoXmlGetProp(xmlNode *cur, const xmlChar *name)
 #ifdef USE_CASE_SENSITIVE_XML_ATTRIBUTES
     buf = xmlGetProp(cur, name);
 #else
-    for (xmlAttrPtr attr = cur->properties; attr != 0; attr = attr->next)
-    {
-        if (strcasecmp((const char *)attr->name, (const char *)name) == 0)
-        {
-            buf = attr->children->content;
-            // std::cerr << attr->name << " " << buf << "\n";
-            break;
-        }
-    }
+    xmlAttrPtr attr = FindXmlAttribute(cur, name);
+    if (attr) buf = attr->children ? attr->children->content : (const xmlChar *)"";
 #endif
 
     if (gDebug == XMLDebug)
@@ -4655,11 +5410,17 @@ char *Simulation::DoXmlGetProp(xmlNode *cur, const xmlChar *name)
 
     if (buf)
     {
-        strcpy(m_LargeBuffer, (char *)buf);
+        // a value of n characters can never hold more than n / 2 + 1 tokens
+        size_t length = strlen((char *)buf);
+        ParseArena *arena = ParseArena::GetArena();
+        char *largeBuffer = arena->GetLargeBuffer(length + 1);
+        arena->GetPointerList(length / 2 + 1);
+        arena->GetDoubleList(length / 2 + 1);
+        memcpy(largeBuffer, buf, length + 1);
 #ifdef USE_CASE_SENSITIVE_XML_ATTRIBUTES
         xmlFree(buf);
 #endif
-        return m_LargeBuffer;
+        return largeBuffer;
     }
     else return 0;
 }
@@ -4670,17 +5431,12 @@ xmlAttr *Simulation::DoXmlReplaceProp(xmlNode *cur, const xmlChar *name, const x
 #ifdef USE_CASE_SENSITIVE_XML_ATTRIBUTES
     ptr = xmlHasProp(cur, name);
 #else
-    for (ptr = cur->properties; ptr != 0; ptr = ptr->next)
-    {
-        if (strcasecmp((const char *)ptr->name, (const char *)name) == 0)
-        {
-            break;
-        }
-    }
+    ptr = FindXmlAttribute(cur, name);
 #endif
     if (ptr) xmlRemoveProp(ptr);
 
     ptr = xmlNewProp(cur, name, newValue);
+    if (cur == m_AttributeIndexNode) m_AttributeIndexNode = 0;
     return ptr;
 }
 
@@ -4690,15 +5446,10 @@ void Simulation::DoXmlRemoveProp(xmlNode *cur, const xmlChar *name)
 #ifdef USE_CASE_SENSITIVE_XML_ATTRIBUTES
     ptr = xmlHasProp(cur, name);
 #else
-    for (ptr = cur->properties; ptr != 0; ptr = ptr->next)
-    {
-        if (strcasecmp((const char *)ptr->name, (const char *)name) == 0)
-        {
-            break;
-        }
-    }
+    ptr = FindXmlAttribute(cur, name);
 #endif
     if (ptr) xmlRemoveProp(ptr);
+    if (cur == m_AttributeIndexNode) m_AttributeIndexNode = 0;
 }
 
 xmlAttr *Simulation::DoXmlHasProp(xmlNode *cur, const xmlChar *name)
@@ -4707,15 +5458,69 @@ xmlAttr *Simulation::DoXmlHasProp(xmlNode *cur, const xmlChar *name)
 #ifdef USE_CASE_SENSITIVE_XML_ATTRIBUTES
     ptr = xmlHasProp(cur, name);
 #else
-    for (ptr = cur->properties; ptr != 0; ptr = ptr->next)
+    ptr = FindXmlAttribute(cur, name);
+#endif
+    return ptr;
+}
+
+static uint32_t HashXmlAttributeName(const xmlChar *name)
+{
+    uint32_t hash = 2166136261u; // FNV-1a on the lower case name
+    for (; *name; name++)
     {
-        if (strcasecmp((const char *)ptr->name, (const char *)name) == 0)
+        hash ^= (uint32_t)tolower(*name);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// the Parse functions look up every attribute of an element by name so a hash table
+// of the attributes is built the first time an element is queried
+// but only for elements with enough attributes for the table to pay for itself
+// (the first match wins to keep the behaviour of a linear search)
+xmlAttr *Simulation::FindXmlAttribute(xmlNode *cur, const xmlChar *name)
+{
+    const size_t linearSearchLimit = 24; // a table is slower to build than it saves below this
+    xmlAttrPtr attr;
+    uint32_t mask, index;
+    if (cur != m_AttributeIndexNode || cur->properties != m_AttributeIndexProperties)
+    {
+        size_t count = 0;
+        for (attr = cur->properties; attr != 0; attr = attr->next) count++;
+        m_AttributeIndexTable.clear();
+        if (count > linearSearchLimit)
         {
-            break;
+            size_t size = 8;
+            while (size < count * 2) size *= 2;
+            m_AttributeIndexTable.resize(size, (xmlAttr *)0);
+            mask = size - 1;
+            for (attr = cur->properties; attr != 0; attr = attr->next)
+            {
+                index = HashXmlAttributeName(attr->name) & mask;
+                while (m_AttributeIndexTable[index] && strcasecmp((const char *)m_AttributeIndexTable[index]->name, (const char *)attr->name) != 0)
+                    index = (index + 1) & mask;
+                if (m_AttributeIndexTable[index] == 0) m_AttributeIndexTable[index] = attr;
+            }
         }
+        m_AttributeIndexNode = cur;
+        m_AttributeIndexProperties = cur->properties;
     }
-#endif
-    return ptr;
+
+    if (m_AttributeIndexTable.size() == 0)
+    {
+        for (attr = cur->properties; attr != 0; attr = attr->next)
+            if (strcasecmp((const char *)attr->name, (const char *)name) == 0) return attr;
+        return 0;
+    }
+
+    mask = m_AttributeIndexTable.size() - 1;
+    index = HashXmlAttributeName(name) & mask;
+    while ((attr = m_AttributeIndexTable[index]) != 0)
+    {
+        if (strcasecmp((const char *)attr->name, (const char *)name) == 0) return attr;
+        index = (index + 1) & mask;
+    }
+    return 0;
 }
 
 // this version of the dump routine simply calls the dump functions of the embedded objects
@@ -4752,8 +5557,8 @@ void Simulation::Dump()
 void
         Simulation::Draw(GLWidget *glWidget)
 {
-    // draw the most opaque objects first and the least opaque obejects last
-    // this isn't the best way - I should distacne sort and/or depth peel but these are quite slow
+    // draw the opaque objects first and the transparent objects last sorted by distance
+    // this isn't perfect for intersecting transparent objects but depth peeling is quite slow
 
     std::map<std::string, Body *>::const_iterator iter1;
     std::map<std::string, Joint *>::const_iterator iter2;
@@ -4775,30 +5580,14 @@ void
     for (MarkerIter = m_MarkerList.begin(); MarkerIter != m_MarkerList.end(); MarkerIter++) MarkerIter->second->Draw();
     for (DataTargetIter = m_DataTargetList.begin(); DataTargetIter != m_DataTargetList.end(); DataTargetIter++) DataTargetIter->second->Draw();
 
-    // sort on alpha
-    gDelayedDrawList.sort(SortOnAlpha);
-
-    // and draw in alpha order (highest alpha first)
+    // and draw them sorted (opaque objects first and then transparent objects back to front)
     gDelayedDraw = false;
-    std::list<FacetedObject *>::const_iterator FacetedObjectIter;
-    for (FacetedObjectIter = gDelayedDrawList.begin(); FacetedObjectIter != gDelayedDrawList.end(); FacetedObjectIter++)
-    {
-        // std::cerr << (*FacetedObjectIter)->GetColour()->alpha << "\n";
-        (*FacetedObjectIter)->setGlWidget(glWidget);
-        (*FacetedObjectIter)->Draw();
-    }
-    gDelayedDrawList.clear();
+    FacetedObject::DrawDelayedDrawList(glWidget);
 
     for (iter2 = m_JointList.begin(); iter2 != m_JointList.end(); iter2++) if (iter2->second->GetPhysRep() == 0) iter2->second->Draw();  // draw the non-facetted object joints
     m_Environment->Draw(); // and the environment currently doesn't use faceted objects either
 }
 
-// this sorts so that the largest value of alpha is first
-bool SortOnAlpha(FacetedObject* d1, FacetedObject* d2)
-{
-  return d1->GetColour()->alpha > d2->GetColour()->alpha;
-}
-
 #endif
 
 
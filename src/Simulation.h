@@ -15,12 +15,15 @@
 
 #include "Environment.h"
 #include "DataFile.h"
+#include "AsyncOutputStream.h"
 
 #include <ode/ode.h>
 
 #include <map>
 #include <string>
+#include <vector>
 #include <fstream>
+#include <stdint.h>
 #include <libxml/xmlmemory.h>
 #include <libxml/parser.h>
 
@@ -36,6 +39,9 @@ class Reporter;
 class Controller;
 class FixedJoint;
 class Warehouse;
+class DriverEngine;
+class LimitChecker;
+class Checkpoint;
 
 #ifdef USE_QT
 class GLWidget;
@@ -108,8 +114,14 @@ public:
     static void NearCallback(void *data, dGeomID o1, dGeomID o2);
 
     int LoadModel(char *buffer);  // load parameters from the XML configuration file
+    int UpdateModel(char *buffer); // apply changed DRIVER elements to a model that has not been run
     void UpdateSimulation(void);     // called at each iteration through simulation
 
+    // the three parts of UpdateSimulation (SimulationBatch calls these separately)
+    void UpdateCollisions();
+    void UpdateMuscles();
+    void UpdateWorld();
+
     // get hold of various variables
 
     double GetTime(void) { return m_SimulationTime; }
@@ -127,6 +139,7 @@ public:
     Environment *GetEnvironment() { return m_Environment; }
 
     void SetTimeLimit(double timeLimit) { m_TimeLimit = timeLimit; }
+    void SetTimeIncrement(double stepSize) { m_StepSize = stepSize; } // only used by the step size checks
     void SetMetabolicEnergyLimit(double energyLimit) { m_MetabolicEnergyLimit = energyLimit; }
     void SetMechanicalEnergyLimit(double energyLimit) { m_MechanicalEnergyLimit = energyLimit; }
     void SetOutputModelStateAtTime(double outputModelStateAtTime) { m_OutputModelStateAtTime = outputModelStateAtTime; }
@@ -136,6 +149,7 @@ public:
     void SetInputKinematicsFile(const char *filename);
     void SetOutputModelStateFile(const char *filename);
     void SetOutputWarehouseFile(const char *filename);
+    void SetOutputDumpContainer(const char *filename, bool compress) { AsyncOutputWriter::GetWriter()->OpenDumpContainer(filename, compress); }
     void SetMungeModelStateFlag(bool f) { m_MungeModelStateFlag = f; }
     void SetMungeRotationFlag(bool f) { m_MungeRotationFlag = f; }
     void SetModelStateRelative(bool f) { m_ModelStateRelative = f; }
@@ -145,6 +159,10 @@ public:
     void AddWarehouse(const char *filename);
 
     // get hold of the internal lists (HANDLE WITH CARE)
+    dWorldID GetWorldID() { return m_WorldID; }
+    dSpaceID GetSpaceID() { return m_SpaceID; }
+    DriverEngine *GetDriverEngine() { return m_DriverEngine; }
+    size_t GetStoredModelBytes(); // the element text kept for OutputProgramState and UpdateModel
     std::map<std::string, Body *> *GetBodyList() { return &m_BodyList; }
     std::map<std::string, Joint *> *GetJointList() { return &m_JointList; }
     std::map<std::string, Geom *> *GetGeomList() { return &m_GeomList; }
@@ -173,6 +191,17 @@ public:
 
     virtual void Dump();
 
+    // the complete run state for restarting from the same model file
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
+    bool WriteCheckpointFile(const char *filename);
+    bool ReadCheckpointFile(const char *filename);
+    void SetCheckpointFile(const char *filename) { m_CheckpointFilename = filename; }
+    void SetCheckpointInterval(double checkpointInterval);
+
+    // adds normally distributed noise to the body linear velocities (the same seed gives the same noise)
+    void PerturbBodyVelocities(double standardDeviation, unsigned int seed);
+
     // draw the simulation
 #ifdef USE_QT
     void Draw(GLWidget *glWidget);
@@ -197,12 +226,35 @@ protected:
     void ParseController(xmlNodePtr cur);
     void ParseWarehouse(xmlNodePtr cur);
 
-    std::vector<xmlNodePtr> m_TagContentsList;
+    void AssignCollisionBits();
+    void CompileContactMaterials();
+#ifdef USE_QT
+    void PrefetchMeshes(char *xmlDataBuffer, int size);
+    static std::string GraphicFilename(const char *graphicFile);
+#endif
+    bool TestObjectLimits();
+
+    // the top level elements are kept as their text rather than as DOM copies
+    // because only OutputProgramState and UpdateModel ever need them again
+    struct TagContents
+    {
+        std::string name;
+        std::string ID;
+        std::string xml;
+    };
+    std::vector<TagContents> m_TagContentsList;
 
     char *DoXmlGetProp(xmlNode *cur, const xmlChar *name);
     xmlAttr *DoXmlReplaceProp(xmlNode *cur, const xmlChar *name, const xmlChar *newValue);
     void DoXmlRemoveProp(xmlNode *cur, const xmlChar *name);
     xmlAttr *DoXmlHasProp(xmlNode *cur, const xmlChar *name);
+    xmlAttr *FindXmlAttribute(xmlNode *cur, const xmlChar *name);
+
+    // case insensitive hash table of the attributes of the element currently being read
+    // (empty when the element has few enough attributes to search linearly)
+    xmlNode *m_AttributeIndexNode;
+    xmlAttr *m_AttributeIndexProperties;
+    std::vector<xmlAttr *> m_AttributeIndexTable;
 
     std::map<std::string, Body *>m_BodyList;
     std::map<std::string, Joint *>m_JointList;
@@ -215,6 +267,9 @@ protected:
     std::map<std::string, Controller *>m_ControllerList;
     std::map<std::string, FixedJoint *>m_JointStressList;
     std::map<std::string, Warehouse *>m_WarehouseList;
+    DriverEngine *m_DriverEngine;
+    LimitChecker *m_LimitChecker;
+    int m_CatastropheCheckInterval;
     bool m_DataTargetAbort;
 
     // Simulation variables
@@ -223,9 +278,14 @@ protected:
     dJointGroupID m_ContactGroup;
     Environment *m_Environment;
     int m_MaxContacts;
+    std::vector<dContactGeom> m_ContactGeomList;
+    std::vector<dSurfaceParameters> m_ContactSurfaceList;
+    int m_NumContactMaterials;
+    bool m_FastPlaneCollider;
     bool m_AllowInternalCollisions;
     bool m_AllowConnectedCollisions;
     WorldStepType m_StepType;
+    int m_MuscleSubSteps;
 
     // keep track of simulation time
 
@@ -254,10 +314,10 @@ protected:
     bool m_OutputKinematicsFlag;
     bool m_OutputWarehouseFlag;
     std::string m_OutputKinematicsFilename;
-    std::ofstream m_OutputKinematicsFile;
+    AsyncOutputStream m_OutputKinematicsFile;
     std::string m_OutputModelStateFilename;
     std::string m_OutputWarehouseFilename;
-    std::ofstream m_OutputWarehouseFile;
+    AsyncOutputStream m_OutputWarehouseFile;
     bool m_OutputModelStateOccured;
     bool m_AbortAfterModelStateOutput;
     bool m_OutputWarehouseAsText;
@@ -277,17 +337,13 @@ protected:
     double m_OutputWarehouseLastTime;
     double m_WarehouseFailDistanceAbort;
     double m_OutputModelStateAtWarehouseDistance;
+    std::string m_CheckpointFilename;
+    double m_CheckpointInterval;
+    double m_NextCheckpointTime;
+    uint64_t m_ModelHash;
     std::string m_CurrentWarehouse;
     bool m_WarehouseUsePCA;
 
-    // internal memory allocations
-    // it will crash if these are exceeded but they should be plenty big enough
-    int m_BufferSize;
-    char *m_Buffer;
-    char *m_LargeBuffer;
-    char **m_BufferPtrs;
-    double *m_DoubleList;
-
     // for fitness calculations
     double m_KinematicMatchFitness;
     std::string m_DistanceTravelledBodyIDName;
@@ -0,0 +1,614 @@
+/*
+ *  SimulationBatch.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Advances several copies of the same model (with different genomes)
+ *  in lockstep with the driver, muscle and strap state of all the copies
+ *  interleaved so that each calculation is a loop across the copies
+ *
+ */
+
+#include <cmath>
+#include <map>
+#include <typeinfo>
+
+#include <ode/ode.h>
+
+#include "SimulationBatch.h"
+#include "Simulation.h"
+#include "Muscle.h"
+#include "MAMuscle.h"
+#include "DampedSpringMuscle.h"
+#include "MAMuscleComplete.h"
+#include "TwoPointStrap.h"
+#include "Body.h"
+#include "ErrorHandler.h"
+#include "DebugControl.h"
+
+extern Simulation *gSimulation;
+
+SimulationBatch::SimulationBatch()
+{
+    m_NumCopies = 0;
+    m_NumActive = 0;
+    m_Compiled = false;
+    m_StepSize = 0;
+}
+
+SimulationBatch::~SimulationBatch()
+{
+}
+
+void SimulationBatch::AddSimulation(Simulation *simulation)
+{
+    m_SimulationList.push_back(simulation);
+    m_ActiveList.push_back(1);
+    m_NumCopies = m_SimulationList.size();
+    m_NumActive++;
+    m_Compiled = false;
+}
+
+// the copies have to have the same muscles, straps and bodies (by name and type) and compiled drivers with
+// the same structure but all the values can be different
+// a muscle is batched if it is one of the kernel types and has a TwoPointStrap in every copy
+// anything else (and everything when debugging output is on) is stepped by the muscle itself one copy at a time
+bool SimulationBatch::Compile()
+{
+    int n = m_NumCopies;
+    int k;
+    m_Compiled = false;
+    m_MessagePending.assign(n, 0);
+    m_PendingMessageNumber.assign(n, 0);
+    m_PendingMessageText.assign(n, std::string());
+    m_MuscleList.clear();
+    m_MuscleKernel.clear();
+    m_MuscleStrap.clear();
+    m_StrapMuscle.clear();
+    m_StrapTarget.clear();
+    m_StrapOriginBody.clear();
+    m_StrapInsertionBody.clear();
+    m_BodyNameList.clear();
+    m_BodyIDList.clear();
+    m_MAStrap.clear();
+    m_DSStrap.clear();
+    m_MCStrap.clear();
+    if (n == 0) return false;
+
+    Simulation *first = m_SimulationList[0];
+    m_StepSize = first->GetTimeIncrement();
+    std::vector<DriverEngine *> engineList;
+    std::vector<std::map<std::string, Muscle *>::const_iterator> muscleIterList;
+    for (k = 0; k < n; k++)
+    {
+        Simulation *simulation = m_SimulationList[k];
+        if (simulation->GetTimeIncrement() != m_StepSize || simulation->GetTime() != first->GetTime()) return false;
+        if (simulation->GetMuscleList()->size() != first->GetMuscleList()->size()) return false;
+        if (simulation->GetDriverEngine() == 0) return false;
+        engineList.push_back(simulation->GetDriverEngine());
+        muscleIterList.push_back(simulation->GetMuscleList()->begin());
+    }
+    if (m_DriverEngine.CompileBatch(&engineList) == false) return false;
+
+    // choose the kernels
+    int numMuscles = first->GetMuscleList()->size();
+    m_MuscleList.resize(numMuscles * n);
+    int m, kernel;
+    for (m = 0; m < numMuscles; m++)
+    {
+        for (k = 0; k < n; k++)
+        {
+            if (muscleIterList[k]->first != muscleIterList[0]->first) return false;
+            m_MuscleList[m * n + k] = muscleIterList[k]->second;
+            muscleIterList[k]++;
+        }
+        Muscle *muscle = m_MuscleList[m * n];
+        kernel = FallbackKernel;
+        if (typeid(*muscle) == typeid(MAMuscle)) kernel = MAMuscleKernel;
+        else if (typeid(*muscle) == typeid(DampedSpringMuscle)) kernel = DampedSpringMuscleKernel;
+        else if (typeid(*muscle) == typeid(MAMuscleComplete)) kernel = MAMuscleCompleteKernel;
+        if (gDebug != NoDebug) kernel = FallbackKernel;
+        for (k = 0; k < n; k++)
+        {
+            Muscle *copyMuscle = m_MuscleList[m * n + k];
+            if (typeid(*copyMuscle) != typeid(*muscle)) return false;
+            if (typeid(*copyMuscle->GetStrap()) != typeid(TwoPointStrap)) kernel = FallbackKernel;
+            // MAMuscleComplete has a state that depends on the sub-steps but the others only use the last sub-step
+            if (kernel == MAMuscleCompleteKernel && copyMuscle->GetSubSteps() != 1) kernel = FallbackKernel;
+        }
+        m_MuscleKernel.push_back(kernel);
+        if (kernel == FallbackKernel)
+        {
+            m_MuscleStrap.push_back(-1);
+            continue;
+        }
+        m_MuscleStrap.push_back(m_StrapMuscle.size());
+        m_StrapMuscle.push_back(m);
+        m_StrapTarget.push_back(m_DriverEngine.FindTarget(muscle));
+        if (kernel == MAMuscleKernel) m_MAStrap.push_back(m_MuscleStrap.back());
+        if (kernel == DampedSpringMuscleKernel) m_DSStrap.push_back(m_MuscleStrap.back());
+        if (kernel == MAMuscleCompleteKernel) m_MCStrap.push_back(m_MuscleStrap.back());
+    }
+
+    // fill the strap tables and find the bodies
+    int numStraps = m_StrapMuscle.size();
+    m_StrapOrigin.resize(numStraps * 3 * n);
+    m_StrapInsertion.resize(numStraps * 3 * n);
+    m_StrapOriginPoint.assign(numStraps * 3 * n, 0);
+    m_StrapInsertionPoint.assign(numStraps * 3 * n, 0);
+    m_StrapDirection.assign(numStraps * 3 * n, 0);
+    m_StrapLength.resize(numStraps * n);
+    m_StrapLastLength.resize(numStraps * n);
+    m_StrapVelocity.resize(numStraps * n);
+    m_Activation.resize(numStraps * n);
+    m_Tension.resize(numStraps * n);
+    int s, i, b;
+    for (s = 0; s < numStraps; s++)
+    {
+        for (int end = 0; end < 2; end++)
+        {
+            Body *body;
+            double *point;
+            TwoPointStrap *strap = static_cast<TwoPointStrap *>(m_MuscleList[m_StrapMuscle[s] * n]->GetStrap());
+            if (end == 0) strap->GetOrigin(&body, &point);
+            else strap->GetInsertion(&body, &point);
+            for (b = 0; b < int(m_BodyNameList.size()); b++) if (m_BodyNameList[b] == *body->GetName()) break;
+            if (b == int(m_BodyNameList.size()))
+            {
+                m_BodyNameList.push_back(*body->GetName());
+                m_BodyIDList.resize(m_BodyNameList.size() * n);
+            }
+            if (end == 0) m_StrapOriginBody.push_back(b);
+            else m_StrapInsertionBody.push_back(b);
+
+            for (k = 0; k < n; k++)
+            {
+                strap = static_cast<TwoPointStrap *>(m_MuscleList[m_StrapMuscle[s] * n + k]->GetStrap());
+                if (end == 0) strap->GetOrigin(&body, &point);
+                else strap->GetInsertion(&body, &point);
+                if (*body->GetName() != m_BodyNameList[b]) return false;
+                m_BodyIDList[b * n + k] = body->GetBodyID();
+                for (i = 0; i < 3; i++)
+                {
+                    if (end == 0) m_StrapOrigin[(s * 3 + i) * n + k] = point[i];
+                    else m_StrapInsertion[(s * 3 + i) * n + k] = point[i];
+                }
+            }
+        }
+        for (k = 0; k < n; k++)
+        {
+            Muscle *muscle = m_MuscleList[m_StrapMuscle[s] * n + k];
+            m_StrapLength[s * n + k] = muscle->GetStrap()->GetLength();
+            m_StrapLastLength[s * n + k] = muscle->GetStrap()->GetLastLength();
+            m_StrapVelocity[s * n + k] = muscle->GetStrap()->GetVelocity();
+            m_Activation[s * n + k] = muscle->GetCurrentDriverSum();
+            m_Tension[s * n + k] = muscle->GetStrap()->GetTension();
+        }
+    }
+    m_BodyState.assign(m_BodyNameList.size() * 12 * n, 0);
+
+    // and the muscle parameters
+    m_MAVMax.resize(m_MAStrap.size() * n);
+    m_MAF0.resize(m_MAStrap.size() * n);
+    m_MAK.resize(m_MAStrap.size() * n);
+    m_MAEccentricSlope.resize(m_MAStrap.size() * n);
+    m_MAAlpha.resize(m_MAStrap.size() * n);
+    for (i = 0; i < int(m_MAStrap.size()); i++)
+    {
+        for (k = 0; k < n; k++)
+        {
+            MAMuscle *muscle = static_cast<MAMuscle *>(m_MuscleList[m_StrapMuscle[m_MAStrap[i]] * n + k]);
+            m_MAVMax[i * n + k] = muscle->GetVMax();
+            m_MAF0[i * n + k] = muscle->GetF0();
+            m_MAK[i * n + k] = muscle->GetK();
+            m_MAEccentricSlope[i * n + k] = muscle->GetEccentricSlope();
+            m_MAAlpha[i * n + k] = muscle->GetActivation();
+        }
+    }
+
+    m_DSDamping.resize(m_DSStrap.size() * n);
+    m_DSSpringConstant.resize(m_DSStrap.size() * n);
+    m_DSUnloadedLength.resize(m_DSStrap.size() * n);
+    m_DSArea.resize(m_DSStrap.size() * n);
+    for (i = 0; i < int(m_DSStrap.size()); i++)
+    {
+        for (k = 0; k < n; k++)
+        {
+            DampedSpringMuscle *muscle = static_cast<DampedSpringMuscle *>(m_MuscleList[m_StrapMuscle[m_DSStrap[i]] * n + k]);
+            m_DSDamping[i * n + k] = muscle->GetDamping();
+            m_DSSpringConstant[i * n + k] = muscle->GetSpringConstant();
+            m_DSUnloadedLength[i * n + k] = muscle->GetUnloadedLength();
+            m_DSArea[i * n + k] = muscle->GetArea();
+        }
+    }
+
+    m_MCMode.resize(m_MCStrap.size() * n);
+    m_MCMinimumActivation.resize(m_MCStrap.size() * n);
+    m_MCActivationRate.resize(m_MCStrap.size() * n);
+    m_MCT1.resize(m_MCStrap.size() * n);
+    m_MCT2.resize(m_MCStrap.size() * n);
+    m_MCStim.resize(m_MCStrap.size() * n);
+    m_MCAlpha.resize(m_MCStrap.size() * n);
+    for (i = 0; i < int(m_MCStrap.size()); i++)
+    {
+        for (k = 0; k < n; k++)
+        {
+            MAMuscleComplete *muscle = static_cast<MAMuscleComplete *>(m_MuscleList[m_StrapMuscle[m_MCStrap[i]] * n + k]);
+            if (muscle->GetActivationKinetics()) m_MCMode[i * n + k] = 1;
+            else if (muscle->GetActivationRate() != 0) m_MCMode[i * n + k] = 2;
+            else m_MCMode[i * n + k] = 0;
+            m_MCMinimumActivation[i * n + k] = muscle->GetMinimumActivation();
+            m_MCActivationRate[i * n + k] = muscle->GetActivationRate();
+            m_MCT1[i * n + k] = muscle->GetActivationKineticsT1();
+            m_MCT2[i * n + k] = muscle->GetActivationKineticsT2();
+            m_MCStim[i * n + k] = muscle->GetStimulation();
+            m_MCAlpha[i * n + k] = muscle->GetActivation();
+        }
+    }
+
+    m_Compiled = true;
+    return true;
+}
+
+// this follows Simulation::UpdateSimulation and the single copy loop in ObjectiveMain
+// so each copy gets exactly the same result as it would if it were run on its own
+int SimulationBatch::Step()
+{
+    if (m_Compiled == false)
+    {
+        StepEachCopy();
+        return m_NumActive;
+    }
+
+    int k, m;
+    int n = m_NumCopies;
+    Simulation *simulation;
+    double time = 0;
+    for (k = 0; k < n; k++)
+    {
+        if (m_ActiveList[k] == 0) continue;
+        simulation = m_SimulationList[k];
+        gSimulation = simulation;
+        if (simulation->ShouldQuit())
+        {
+            Retire(k);
+            continue;
+        }
+        time = simulation->GetTime();
+        simulation->UpdateCollisions();
+        if (IsMessage())
+        {
+            m_MessagePending[k] = 1;
+            m_PendingMessageText[k] = GetLastMessage(&m_PendingMessageNumber[k]);
+        }
+    }
+    if (m_NumActive == 0)
+    {
+        gSimulation = 0;
+        return 0;
+    }
+
+    m_DriverEngine.EvaluateBatch(time, &m_ActiveList[0]);
+
+    // the order that the muscles are calculated does not matter because they only interact through the forces
+    for (k = 0; k < n; k++)
+    {
+        if (m_ActiveList[k] == 0) continue;
+        gSimulation = m_SimulationList[k];
+        for (m = 0; m < int(m_MuscleKernel.size()); m++)
+        {
+            if (m_MuscleKernel[m] != FallbackKernel) continue;
+            Muscle *muscle = m_MuscleList[m * n + k];
+            muscle->SubStepActivation(muscle->GetCurrentDriverSum(), m_StepSize);
+            muscle->CalculateStrap(m_StepSize);
+        }
+    }
+    CalculateActivations();
+    CalculateMAMuscles();
+    CalculateDampedSpringMuscles();
+    CalculateMAMuscleCompletes();
+    CalculateStraps();
+    ApplyForces();
+
+    for (k = 0; k < n; k++)
+    {
+        if (m_ActiveList[k] == 0) continue;
+        simulation = m_SimulationList[k];
+        gSimulation = simulation;
+        if (m_MessagePending[k])
+        {
+            SetMessage(m_PendingMessageNumber[k], m_PendingMessageText[k].c_str());
+            m_MessagePending[k] = 0;
+        }
+        simulation->UpdateWorld();
+        if (simulation->TestForCatastrophy()) Retire(k);
+    }
+    gSimulation = 0;
+    return m_NumActive;
+}
+
+// used when the copies cannot be interleaved
+void SimulationBatch::StepEachCopy()
+{
+    for (int k = 0; k < m_NumCopies; k++)
+    {
+        if (m_ActiveList[k] == 0) continue;
+        Simulation *simulation = m_SimulationList[k];
+        gSimulation = simulation;
+        if (simulation->ShouldQuit())
+        {
+            Retire(k);
+            continue;
+        }
+        simulation->UpdateSimulation();
+        if (simulation->TestForCatastrophy()) Retire(k);
+    }
+    gSimulation = 0;
+}
+
+// a retired copy keeps its slot in the tables and is calculated with everything else
+// but its bodies and model objects are no longer read or written
+void SimulationBatch::Retire(int copy)
+{
+    if (m_ActiveList[copy] == 0) return;
+    m_ActiveList[copy] = 0;
+    m_NumActive--;
+}
+
+// the driver sums come straight from the batch driver engine
+void SimulationBatch::CalculateActivations()
+{
+    int n = m_NumCopies;
+    int k;
+    for (unsigned int s = 0; s < m_StrapMuscle.size(); s++)
+    {
+        double *activation = &m_Activation[s * n];
+        if (m_StrapTarget[s] >= 0)
+        {
+            const double *sum = m_DriverEngine.GetTargetSums(m_StrapTarget[s]);
+            for (k = 0; k < n; k++) activation[k] = sum[k];
+        }
+        else
+        {
+            for (k = 0; k < n; k++) activation[k] = m_MuscleList[m_StrapMuscle[s] * n + k]->GetCurrentDriverSum();
+        }
+    }
+}
+
+// MAMuscle::SetAlpha without the branches
+void SimulationBatch::CalculateMAMuscles()
+{
+    int n = m_NumCopies;
+    int k;
+    for (unsigned int i = 0; i < m_MAStrap.size(); i++)
+    {
+        int s = m_MAStrap[i];
+        const double *activation = &m_Activation[s * n];
+        const double *velocity = &m_StrapVelocity[s * n];
+        const double *vMax = &m_MAVMax[i * n];
+        const double *f0 = &m_MAF0[i * n];
+        const double *K = &m_MAK[i * n];
+        const double *eccentricSlope = &m_MAEccentricSlope[i * n];
+        double *alpha = &m_MAAlpha[i * n];
+        double *tension = &m_Tension[s * n];
+        for (k = 0; k < n; k++)
+        {
+            double a = activation[k] < 0 ? 0 : (activation[k] > 1.0 ? 1.0 : activation[k]);
+            double v = -velocity[k];
+            v = v > vMax[k] ? vMax[k] : (v < -vMax[k] ? -vMax[k] : v);
+            double eccentric = f0[k] * (1.8 - 0.8 * ((vMax[k] + v) / (vMax[k] - eccentricSlope[k] * v)));
+            double concentric = f0[k] * (vMax[k] - v) / (vMax[k] + (v / K[k]));
+            alpha[k] = a;
+            tension[k] = a * (v < 0 ? eccentric : concentric);
+        }
+        for (k = 0; k < n; k++)
+        {
+            if (m_ActiveList[k] == 0) continue;
+            MAMuscle *muscle = static_cast<MAMuscle *>(m_MuscleList[m_StrapMuscle[s] * n + k]);
+            muscle->SetAlphaValue(alpha[k]);
+            muscle->GetStrap()->SetTension(tension[k]);
+        }
+    }
+}
+
+// DampedSpringMuscle::SetActivation without the branches
+void SimulationBatch::CalculateDampedSpringMuscles()
+{
+    int n = m_NumCopies;
+    int k;
+    for (unsigned int i = 0; i < m_DSStrap.size(); i++)
+    {
+        int s = m_DSStrap[i];
+        const double *activation = &m_Activation[s * n];
+        const double *length = &m_StrapLength[s * n];
+        const double *velocity = &m_StrapVelocity[s * n];
+        const double *damping = &m_DSDamping[i * n];
+        const double *springConstant = &m_DSSpringConstant[i * n];
+        const double *unloadedLength = &m_DSUnloadedLength[i * n];
+        const double *area = &m_DSArea[i * n];
+        double *tension = &m_Tension[s * n];
+        for (k = 0; k < n; k++)
+        {
+            double elasticStress = ((length[k] - unloadedLength[k]) / unloadedLength[k]) * springConstant[k];
+            double t = (elasticStress + (velocity[k] / unloadedLength[k]) * damping[k]) * area[k] * activation[k];
+            t = t < 0 ? 0 : t;
+            tension[k] = elasticStress <= 0 ? 0 : t;
+        }
+        for (k = 0; k < n; k++)
+        {
+            if (m_ActiveList[k] == 0) continue;
+            DampedSpringMuscle *muscle = static_cast<DampedSpringMuscle *>(m_MuscleList[m_StrapMuscle[s] * n + k]);
+            muscle->SetActivationValue(activation[k]);
+            muscle->GetStrap()->SetTension(tension[k]);
+        }
+    }
+}
+
+// the activation part of MAMuscleComplete::SetActivation without the branches
+// the tension needs an iterative root search with a different number of iterations for
+// each copy so MAMuscleComplete::CalculateTension does that one copy at a time
+void SimulationBatch::CalculateMAMuscleCompletes()
+{
+    int n = m_NumCopies;
+    int k;
+    double dt = m_StepSize;
+    for (unsigned int i = 0; i < m_MCStrap.size(); i++)
+    {
+        int s = m_MCStrap[i];
+        const double *activation = &m_Activation[s * n];
+        const int *mode = &m_MCMode[i * n];
+        const double *minimumActivation = &m_MCMinimumActivation[i * n];
+        const double *activationRate = &m_MCActivationRate[i * n];
+        const double *t1 = &m_MCT1[i * n];
+        const double *t2 = &m_MCT2[i * n];
+        double *stim = &m_MCStim[i * n];
+        double *alpha = &m_MCAlpha[i * n];
+        double *tension = &m_Tension[s * n];
+        for (k = 0; k < n; k++)
+        {
+            double st = activation[k] < minimumActivation[k] ? minimumActivation[k] : (activation[k] > 1 ? 1 : activation[k]);
+            double kinetics = alpha[k] + ((st - alpha[k]) * (t1[k] * st + t2[k])) * dt;
+            double up = alpha[k] + activationRate[k] * dt;
+            up = up > st ? st : up;
+            double down = alpha[k] - activationRate[k] * dt;
+            down = down < st ? st : down;
+            double limited = st > alpha[k] ? up : (st < alpha[k] ? down : alpha[k]);
+            double a = mode[k] == 1 ? kinetics : (mode[k] == 2 ? limited : st);
+            alpha[k] = (mode[k] != 0 && alpha[k] == -1) ? st : a; // -1 is the first step with no rate limit
+            stim[k] = st;
+        }
+        for (k = 0; k < n; k++)
+        {
+            if (m_ActiveList[k] == 0) continue;
+            gSimulation = m_SimulationList[k];
+            MAMuscleComplete *muscle = static_cast<MAMuscleComplete *>(m_MuscleList[m_StrapMuscle[s] * n + k]);
+            muscle->SetActivationValues(stim[k], alpha[k], dt);
+            muscle->CalculateTension();
+            tension[k] = muscle->GetStrap()->GetTension();
+        }
+    }
+}
+
+// local to world as dBodyGetRelPointPos with the same order of operations
+static void TransformPoints(const double *bodyState, const double *local, double *world, int n)
+{
+    const double *px = bodyState, *py = bodyState + n, *pz = bodyState + 2 * n;
+    const double *r = bodyState + 3 * n;
+    const double *lx = local, *ly = local + n, *lz = local + 2 * n;
+    double *wx = world, *wy = world + n, *wz = world + 2 * n;
+    for (int k = 0; k < n; k++)
+    {
+        wx[k] = (r[0 * n + k] * lx[k] + r[1 * n + k] * ly[k] + r[2 * n + k] * lz[k]) + px[k];
+        wy[k] = (r[3 * n + k] * lx[k] + r[4 * n + k] * ly[k] + r[5 * n + k] * lz[k]) + py[k];
+        wz[k] = (r[6 * n + k] * lx[k] + r[7 * n + k] * ly[k] + r[8 * n + k] * lz[k]) + pz[k];
+    }
+}
+
+// TwoPointStrap::Calculate for all the batched straps
+void SimulationBatch::CalculateStraps()
+{
+    int n = m_NumCopies;
+    int k, i;
+    unsigned int b, s;
+    for (b = 0; b < m_BodyNameList.size(); b++)
+    {
+        double *state = &m_BodyState[b * 12 * n];
+        for (k = 0; k < n; k++)
+        {
+            if (m_ActiveList[k] == 0) continue;
+            const dReal *p = dBodyGetPosition(m_BodyIDList[b * n + k]);
+            const dReal *R = dBodyGetRotation(m_BodyIDList[b * n + k]);
+            for (i = 0; i < 3; i++) state[i * n + k] = p[i];
+            for (i = 0; i < 3; i++)
+            {
+                state[(3 + i * 3 + 0) * n + k] = R[i * 4 + 0];
+                state[(3 + i * 3 + 1) * n + k] = R[i * 4 + 1];
+                state[(3 + i * 3 + 2) * n + k] = R[i * 4 + 2];
+            }
+        }
+    }
+
+    for (s = 0; s < m_StrapMuscle.size(); s++)
+    {
+        double *originPoint = &m_StrapOriginPoint[s * 3 * n];
+        double *insertionPoint = &m_StrapInsertionPoint[s * 3 * n];
+        double *direction = &m_StrapDirection[s * 3 * n];
+        double *length = &m_StrapLength[s * n];
+        double *lastLength = &m_StrapLastLength[s * n];
+        double *velocity = &m_StrapVelocity[s * n];
+        TransformPoints(&m_BodyState[m_StrapOriginBody[s] * 12 * n], &m_StrapOrigin[s * 3 * n], originPoint, n);
+        TransformPoints(&m_BodyState[m_StrapInsertionBody[s] * 12 * n], &m_StrapInsertion[s * 3 * n], insertionPoint, n);
+        for (k = 0; k < n; k++)
+        {
+            double x = insertionPoint[k] - originPoint[k];
+            double y = insertionPoint[n + k] - originPoint[n + k];
+            double z = insertionPoint[2 * n + k] - originPoint[2 * n + k];
+            lastLength[k] = length[k];
+            length[k] = sqrt(x * x + y * y + z * z);
+            velocity[k] = (length[k] - lastLength[k]) / m_StepSize;
+            direction[k] = x / length[k];
+            direction[n + k] = y / length[k];
+            direction[2 * n + k] = z / length[k];
+        }
+
+        // the model objects are kept up to date for the energies, the fitness and any reporting
+        for (k = 0; k < n; k++)
+        {
+            if (m_ActiveList[k] == 0) continue;
+            Strap *strap = m_MuscleList[m_StrapMuscle[s] * n + k]->GetStrap();
+            strap->SetLastLength(lastLength[k]);
+            strap->SetLength(length[k]);
+            strap->SetVelocity(velocity[k]);
+            std::vector<PointForce *> *pointForceList = strap->GetPointForceList();
+            for (i = 0; i < 3; i++)
+            {
+                (*pointForceList)[0]->point[i] = originPoint[i * n + k];
+                (*pointForceList)[0]->vector[i] = direction[i * n + k];
+                (*pointForceList)[1]->point[i] = insertionPoint[i * n + k];
+                (*pointForceList)[1]->vector[i] = -direction[i * n + k];
+            }
+        }
+    }
+}
+
+// the forces are added in the same order as Simulation::UpdateMuscles because the order changes the sums in ODE
+void SimulationBatch::ApplyForces()
+{
+    int n = m_NumCopies;
+    int k, m, s;
+    double tension;
+    for (k = 0; k < n; k++)
+    {
+        if (m_ActiveList[k] == 0) continue;
+        for (m = 0; m < int(m_MuscleKernel.size()); m++)
+        {
+            s = m_MuscleStrap[m];
+            if (s < 0)
+            {
+                Muscle *muscle = m_MuscleList[m * n + k];
+                std::vector<PointForce *> *pointForceList = muscle->GetPointForceList();
+                tension = muscle->GetTension();
+                for (unsigned int i = 0; i < pointForceList->size(); i++)
+                {
+                    PointForce *pointForce = (*pointForceList)[i];
+                    dBodyAddForceAtPos(pointForce->body->GetBodyID(),
+                                       pointForce->vector[0] * tension, pointForce->vector[1] * tension, pointForce->vector[2] * tension,
+                                       pointForce->point[0], pointForce->point[1], pointForce->point[2]);
+                }
+                continue;
+            }
+            tension = m_Tension[s * n + k];
+            const double *originPoint = &m_StrapOriginPoint[s * 3 * n];
+            const double *insertionPoint = &m_StrapInsertionPoint[s * 3 * n];
+            const double *direction = &m_StrapDirection[s * 3 * n];
+            dBodyAddForceAtPos(m_BodyIDList[m_StrapOriginBody[s] * n + k],
+                               direction[k] * tension, direction[n + k] * tension, direction[2 * n + k] * tension,
+                               originPoint[k], originPoint[n + k], originPoint[2 * n + k]);
+            dBodyAddForceAtPos(m_BodyIDList[m_StrapInsertionBody[s] * n + k],
+                               -direction[k] * tension, -direction[n + k] * tension, -direction[2 * n + k] * tension,
+                               insertionPoint[k], insertionPoint[n + k], insertionPoint[2 * n + k]);
+        }
+    }
+}
@@ -0,0 +1,138 @@
+/*
+ *  SimulationBatch.h
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  Advances several copies of the same model (with different genomes)
+ *  in lockstep with the driver, muscle and strap state of all the copies
+ *  interleaved so that each calculation is a loop across the copies
+ *
+ */
+
+#ifndef SIMULATIONBATCH_H
+#define SIMULATIONBATCH_H
+
+#include <vector>
+#include <string>
+
+#include <ode/ode.h>
+
+#include "DriverEngine.h"
+
+class Simulation;
+class Muscle;
+
+class SimulationBatch
+{
+public:
+    SimulationBatch();
+    ~SimulationBatch();
+
+    // the caller keeps ownership of the simulations
+    void AddSimulation(Simulation *simulation);
+
+    // builds the interleaved tables once all the simulations have been added
+    // returns false if the copies do not have the same topology, step size and start time
+    // and Step then falls back to stepping each copy with UpdateSimulation
+    bool Compile();
+
+    // steps every active copy once and returns the number still active
+    // copies are retired when ShouldQuit or TestForCatastrophy report that they are done
+    int Step();
+
+    int GetSize() { return m_SimulationList.size(); }
+    int GetNumActive() { return m_NumActive; }
+    int GetNumMuscles() { return m_MuscleKernel.size(); }
+    int GetNumBatchedMuscles() { return m_StrapMuscle.size(); }
+    Simulation *GetSimulation(int i) { return m_SimulationList[i]; }
+
+protected:
+
+    enum MuscleKernel
+    {
+        FallbackKernel = 0, // stepped one copy at a time by the muscle itself
+        MAMuscleKernel = 1,
+        DampedSpringMuscleKernel = 2,
+        MAMuscleCompleteKernel = 3 // activation kinetics interleaved, tension solved one copy at a time
+    };
+
+    void StepEachCopy();
+    void CalculateActivations();
+    void CalculateMAMuscles();
+    void CalculateDampedSpringMuscles();
+    void CalculateMAMuscleCompletes();
+    void CalculateStraps();
+    void ApplyForces();
+    void Retire(int copy);
+
+    int m_NumCopies;
+    std::vector<Simulation *> m_SimulationList;
+    std::vector<char> m_ActiveList;
+    int m_NumActive;
+    bool m_Compiled;
+    double m_StepSize;
+
+    DriverEngine m_DriverEngine;
+
+    // ODE messages raised before the muscles are held until the copy's own world step
+    std::vector<char> m_MessagePending;
+    std::vector<int> m_PendingMessageNumber;
+    std::vector<std::string> m_PendingMessageText;
+
+    // all the muscles in the order that Simulation::UpdateMuscles steps them
+    // per copy values are at [muscle * m_NumCopies + copy] and the same for the other tables
+    std::vector<Muscle *> m_MuscleList;
+    std::vector<int> m_MuscleKernel;
+    std::vector<int> m_MuscleStrap; // index into the strap tables or -1 for fallback muscles
+
+    // the batched muscles all have a TwoPointStrap
+    std::vector<int> m_StrapMuscle;
+    std::vector<int> m_StrapTarget; // DriverEngine target or -1 if the muscle has no drivers
+    std::vector<int> m_StrapOriginBody;
+    std::vector<int> m_StrapInsertionBody;
+    std::vector<double> m_StrapOrigin; // local coordinates [(strap * 3 + axis) * m_NumCopies + copy]
+    std::vector<double> m_StrapInsertion;
+    std::vector<double> m_StrapOriginPoint; // world coordinates
+    std::vector<double> m_StrapInsertionPoint;
+    std::vector<double> m_StrapDirection; // unit vector from the origin to the insertion
+    std::vector<double> m_StrapLength;
+    std::vector<double> m_StrapLastLength;
+    std::vector<double> m_StrapVelocity;
+    std::vector<double> m_Activation;
+    std::vector<double> m_Tension;
+
+    // the bodies used by the batched straps
+    // position then the 3x3 rotation matrix [(body * 12 + element) * m_NumCopies + copy]
+    std::vector<std::string> m_BodyNameList;
+    std::vector<dBodyID> m_BodyIDList;
+    std::vector<double> m_BodyState;
+
+    // MAMuscle
+    std::vector<int> m_MAStrap;
+    std::vector<double> m_MAVMax;
+    std::vector<double> m_MAF0;
+    std::vector<double> m_MAK;
+    std::vector<double> m_MAEccentricSlope;
+    std::vector<double> m_MAAlpha;
+
+    // DampedSpringMuscle
+    std::vector<int> m_DSStrap;
+    std::vector<double> m_DSDamping;
+    std::vector<double> m_DSSpringConstant;
+    std::vector<double> m_DSUnloadedLength;
+    std::vector<double> m_DSArea;
+
+    // MAMuscleComplete
+    std::vector<int> m_MCStrap;
+    std::vector<int> m_MCMode; // 0 activation follows the stimulation, 1 activation kinetics, 2 activation rate
+    std::vector<double> m_MCMinimumActivation;
+    std::vector<double> m_MCActivationRate;
+    std::vector<double> m_MCT1;
+    std::vector<double> m_MCT2;
+    std::vector<double> m_MCStim;
+    std::vector<double> m_MCAlpha;
+};
+
+#endif // SIMULATIONBATCH_H
@@ -14,6 +14,7 @@
 #include <ode/ode.h>
 
 #include "StepDriver.h"
+#include "Checkpoint.h"
 #include "Util.h"
 
 StepDriver::StepDriver()
@@ -138,4 +139,16 @@ double StepDriver::GetValue(double time)
     return m_lastValue;
 }
 
+void StepDriver::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Write(m_LastIndex);
+    checkpoint->Write(m_lastTime);
+    checkpoint->Write(m_lastValue);
+}
 
+void StepDriver::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Read(&m_LastIndex);
+    checkpoint->Read(&m_lastTime);
+    checkpoint->Read(&m_lastValue);
+}
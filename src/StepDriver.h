@@ -22,6 +22,13 @@ public:
     
     void SetValueDurationPairs(int size, double *valueDurationPairs);
     double GetValue(double time);
+
+    double *GetValueList() { return m_ValueList; }
+    double *GetDurationList() { return m_DurationList; }
+    int GetListLength() { return m_ListLength; }
+
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
     
 protected:
     double *m_ValueList;
@@ -0,0 +1,119 @@
+/*
+ *  StepThreadPool.cpp
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  A single pool of ODE worker threads that the simulation
+ *  worlds share for stepping while any of them are alive
+ *
+ */
+
+#include <iostream>
+
+#include "StepThreadPool.h"
+
+StepThreadPool::StepThreadPool()
+{
+    m_Implementation = 0;
+    m_Pool = 0;
+    m_ThreadCount = 0;
+    m_ThreadCountOverride = 0;
+    m_Unavailable = false;
+}
+
+StepThreadPool::~StepThreadPool()
+{
+    std::map<dWorldID, int>::const_iterator iter;
+    for (iter = m_WorldList.begin(); iter != m_WorldList.end(); iter++) dWorldSetStepThreadingImplementation(iter->first, 0, 0);
+    m_WorldList.clear();
+    Stop();
+}
+
+// the pool object is created the first time it is needed and the threads
+// only run while at least one world is attached
+StepThreadPool *StepThreadPool::GetPool()
+{
+    static StepThreadPool pool;
+    return &pool;
+}
+
+// independent islands are stepped in parallel and recent versions of ODE
+// also share the rows of large islands between the threads
+void StepThreadPool::Attach(dWorldID world, int threadCount)
+{
+    if (m_ThreadCountOverride > 0) threadCount = m_ThreadCountOverride;
+    if (threadCount <= 1 || m_Unavailable) return;
+    int requestedThreadCount = threadCount;
+
+    // the pool can only be resized when no world is using it
+    if (m_Pool && threadCount > m_ThreadCount && m_WorldList.size() == 0) Stop();
+    if (m_Pool == 0 && Start(threadCount) == false) return;
+    if (threadCount > m_ThreadCount) threadCount = m_ThreadCount;
+
+    dWorldSetStepThreadingImplementation(world, dThreadingImplementationGetFunctions(m_Implementation), m_Implementation);
+    dWorldSetStepIslandsProcessingMaxThreadCount(world, threadCount);
+    m_WorldList[world] = requestedThreadCount;
+}
+
+// this must be called before the world is destroyed
+// the threads hold per thread ODE data so they are stopped when the last world
+// is detached which means they never outlive the dCloseODE() that follows
+void StepThreadPool::Detach(dWorldID world)
+{
+    std::map<dWorldID, int>::iterator iter = m_WorldList.find(world);
+    if (iter == m_WorldList.end()) return;
+    dWorldSetStepThreadingImplementation(world, 0, 0);
+    m_WorldList.erase(iter);
+    if (m_WorldList.size() == 0) Stop();
+}
+
+// the copied pool has no threads in the child so it cannot be shut down and is simply abandoned
+// the worlds are either left stepping with 1 thread or attached to a new pool for this process
+void StepThreadPool::ResetAfterFork(bool restartThreads)
+{
+    std::map<dWorldID, int> worldList = m_WorldList;
+    std::map<dWorldID, int>::const_iterator iter;
+    for (iter = worldList.begin(); iter != worldList.end(); iter++) dWorldSetStepThreadingImplementation(iter->first, 0, 0);
+    m_WorldList.clear();
+    m_Implementation = 0;
+    m_Pool = 0;
+    m_ThreadCount = 0;
+    if (restartThreads == false) return;
+    for (iter = worldList.begin(); iter != worldList.end(); iter++) Attach(iter->first, iter->second);
+}
+
+bool StepThreadPool::Start(int threadCount)
+{
+    // this returns 0 if ODE was built without the built in threading implementation
+    m_Implementation = dThreadingAllocateMultiThreadedImplementation();
+    if (m_Implementation == 0)
+    {
+        std::cerr << "Warning: ODE library has no threading support so stepping with 1 thread\n";
+        m_Unavailable = true;
+        return false;
+    }
+    m_Pool = dThreadingAllocateThreadPool(threadCount, 0, dAllocateFlagBasicData, 0);
+    if (m_Pool == 0)
+    {
+        std::cerr << "Warning: unable to start " << threadCount << " ODE threads so stepping with 1 thread\n";
+        dThreadingFreeImplementation(m_Implementation);
+        m_Implementation = 0;
+        m_Unavailable = true;
+        return false;
+    }
+    dThreadingThreadPoolServeMultiThreadedImplementation(m_Pool, m_Implementation);
+    m_ThreadCount = threadCount;
+    return true;
+}
+
+void StepThreadPool::Stop()
+{
+    if (m_Implementation) dThreadingImplementationShutdownProcessing(m_Implementation);
+    if (m_Pool) dThreadingFreeThreadPool(m_Pool);
+    if (m_Implementation) dThreadingFreeImplementation(m_Implementation);
+    m_Implementation = 0;
+    m_Pool = 0;
+    m_ThreadCount = 0;
+}
@@ -0,0 +1,54 @@
+/*
+ *  StepThreadPool.h
+ *  GaitSymODE
+ *
+ *  Created by Bill Sellers on 18/10/2016.
+ *  Copyright (c) 2016 Bill Sellers. All rights reserved.
+ *
+ *  A single pool of ODE worker threads that the simulation
+ *  worlds share for stepping while any of them are alive
+ *
+ */
+
+#ifndef STEPTHREADPOOL_H
+#define STEPTHREADPOOL_H
+
+#include <map>
+
+#include <ode/ode.h>
+
+class StepThreadPool
+{
+public:
+    ~StepThreadPool();
+
+    static StepThreadPool *GetPool();
+
+    // a value from the command line overrides the value in the model file
+    void SetThreadCountOverride(int threadCount) { m_ThreadCountOverride = threadCount; }
+    int GetThreadCountOverride() { return m_ThreadCountOverride; }
+
+    // a world stepped with 1 thread (or fewer) is left with ODE's default self threading
+    void Attach(dWorldID world, int threadCount);
+    void Detach(dWorldID world);
+
+    // a child process created with fork() does not get the pool threads
+    void ResetAfterFork(bool restartThreads);
+
+    int GetThreadCount() { return m_ThreadCount; }
+
+protected:
+    StepThreadPool();
+
+    bool Start(int threadCount);
+    void Stop();
+
+    dThreadingImplementationID m_Implementation;
+    dThreadingThreadPoolID m_Pool;
+    int m_ThreadCount;
+    int m_ThreadCountOverride;
+    bool m_Unavailable;
+    std::map<dWorldID, int> m_WorldList; // the thread count requested by each world
+};
+
+#endif // STEPTHREADPOOL_H
@@ -10,11 +10,12 @@
 #include <ode/ode.h>
 
 #include "Strap.h"
+#include "Checkpoint.h"
 #include "Body.h"
 #include "Simulation.h"
 
 #ifdef USE_QT
-#include "FacetedObject.h"
+#include "FacetedPolyline.h"
 #endif
 
 // Simulation global
@@ -41,7 +42,7 @@ Strap::~Strap()
         delete *iter1;
 
 #ifdef USE_QT
-    std::vector<FacetedObject *>::const_iterator iterFO;
+    std::vector<FacetedPolyline *>::const_iterator iterFO;
     for (iterFO = m_DrawList.begin(); iterFO != m_DrawList.end(); iterFO++)
         delete *iterFO;
 #endif
@@ -57,14 +58,12 @@ void Strap::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "Strap::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tBody\tXP\tYP\tZP\tFX\tFY\tFZ\n";
+            m_DumpStream->SetUnits("s\t\tm\tm\tm\tN\tN\tN");
         }
     }
 
@@ -81,3 +80,46 @@ void Strap::Dump()
     }
 }
 
+void Strap::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Write(m_Length);
+    checkpoint->Write(m_LastLength);
+    checkpoint->Write(m_Velocity);
+    checkpoint->Write(m_Tension);
+}
+
+void Strap::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    checkpoint->Read(&m_Length);
+    checkpoint->Read(&m_LastLength);
+    checkpoint->Read(&m_Velocity);
+    checkpoint->Read(&m_Tension);
+}
+
+#ifdef USE_QT
+// the draw list objects are kept from frame to frame and the tubes are regenerated in place
+// which reuses both the vertex memory and the vertex buffer objects
+void Strap::SetDrawPolyline(unsigned int index, std::vector<pgd::Vector> *polyline, double radius, Colour &colour)
+{
+    const int kSides = 128;
+    FacetedPolyline *facetedPolyline;
+    if (index < m_DrawList.size())
+    {
+        facetedPolyline = m_DrawList[index];
+        facetedPolyline->SetPolyline(polyline, radius, kSides);
+    }
+    else
+    {
+        facetedPolyline = new FacetedPolyline(polyline, radius, kSides);
+        m_DrawList.push_back(facetedPolyline);
+    }
+    facetedPolyline->SetColour(colour);
+}
+
+// this gets rid of any objects that are no longer needed (e.g. when the force display is turned off)
+void Strap::TrimDrawList(unsigned int size)
+{
+    for (unsigned int i = size; i < m_DrawList.size(); i++) delete m_DrawList[i];
+    if (size < m_DrawList.size()) m_DrawList.resize(size);
+}
+#endif
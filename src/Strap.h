@@ -12,10 +12,11 @@
 
 #include "NamedObject.h"
 #include "Simulation.h"
+#include "PGDMath.h"
 #include <vector>
 
 class Body;
-class FacetedObject;
+class FacetedPolyline;
 
 struct PointForce
 {
@@ -33,6 +34,13 @@ public:
 
     double GetLength() { return m_Length; };
     double GetVelocity() { return m_Velocity; };
+    double GetLastLength() { return m_LastLength; };
+    void SetLastLength(double lastLength) { m_LastLength = lastLength; };
+
+    // only used to override the calculated length temporarily when sub-stepping the muscle
+    // and by SimulationBatch which calculates the strap values itself
+    void SetLength(double length) { m_Length = length; };
+    void SetVelocity(double velocity) { m_Velocity = velocity; };
 
     void SetTension(double tension) { m_Tension = tension; };
     double GetTension() { return m_Tension; };
@@ -44,6 +52,8 @@ public:
     virtual int SanityCheck(Strap *otherStrap, AxisType axis, const std::string &sanityCheckLeft, const std::string &sanityCheckRight) = 0;
 
     virtual void Dump();
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
 
 #ifdef USE_QT
     virtual void Draw() = 0;
@@ -60,6 +70,11 @@ public:
 
 protected:
 
+#ifdef USE_QT
+    void SetDrawPolyline(unsigned int index, std::vector<pgd::Vector> *polyline, double radius, Colour &colour);
+    void TrimDrawList(unsigned int size);
+#endif
+
     double m_Length;
     double m_LastLength;
     double m_Velocity;
@@ -73,7 +88,7 @@ protected:
     float m_ForceScale;
     float m_Radius;
 
-    std::vector<FacetedObject *> m_DrawList;
+    std::vector<FacetedPolyline *> m_DrawList;
     double m_LastDrawTime;
 #endif
 };
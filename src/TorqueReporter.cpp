@@ -161,14 +161,12 @@ void TorqueReporter::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "NamedObject::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tTension\tWorldTorqueX\tWorldTorqueY\tWorldTorqueZ\tBodyTorqueX\tBodyTorqueY\tBodyTorqueZ\tAxisTorqueX\tAxisTorqueY\tAxisTorqueZ\tWorldMAX\tWorldMAY\tWorldMAZ\tBodyMAX\tBodyMAY\tBodyMAZ\tAxisMAX\tAxisMAY\tAxisMAZ\n";
+            m_DumpStream->SetUnits("s\tN\tNm\tNm\tNm\tNm\tNm\tNm\tNm\tNm\tNm\tm\tm\tm\tm\tm\tm\tm\tm\tm");
         }
     }
 
@@ -38,7 +38,7 @@ protected:
 #endif
     int m_NumVertices;
     int m_VertexStride;
-    int *m_TriIndexes;
+    dTriIndex *m_TriIndexes;
     int m_NumTriIndexes;
     int m_TriStride;
     dTriMeshDataID m_TriMeshDataID;
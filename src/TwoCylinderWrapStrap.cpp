@@ -1280,26 +1280,19 @@ void TwoCylinderWrapStrap::Draw()
 {
     if (m_Visible == false || gDrawMuscles == false || m_NumPathCoordinates == 0) return;
 
-    const int kSides = 128;
-    FacetedPolyline *facetedPolyline;
     unsigned int i;
 
     if (gSimulation->GetTime() != m_LastDrawTime)
     {
         m_LastDrawTime = gSimulation->GetTime();
-        std::vector<FacetedObject *>::const_iterator iterFO;
-        for (iterFO = m_DrawList.begin(); iterFO != m_DrawList.end(); iterFO++)
-            delete *iterFO;
-        m_DrawList.clear();
+        unsigned int drawIndex = 0;
 
         std::vector<pgd::Vector> polyline;
         for (i = 0; i < (unsigned int)m_NumPathCoordinates; i++)
         {
             polyline.push_back(m_PathCoordinates[i]);
         }
-        facetedPolyline = new FacetedPolyline(&polyline, m_Radius, kSides);
-        facetedPolyline->SetColour(m_Colour);
-        m_DrawList.push_back(facetedPolyline);
+        SetDrawPolyline(drawIndex++, &polyline, m_Radius, m_Colour);
 
         // calculate the quaternion that rotates from cylinder coordinates to world coordinates
         const double *q = dBodyGetQuaternion(m_Cylinder1Body->GetBodyID());
@@ -1313,18 +1306,14 @@ void TwoCylinderWrapStrap::Draw()
         polyline.clear();
         polyline.push_back(pgd::Vector(position[0] - cylinderVecWorld.x, position[1] - cylinderVecWorld.y, position[2] - cylinderVecWorld.z));
         polyline.push_back(pgd::Vector(position[0] + cylinderVecWorld.x, position[1] + cylinderVecWorld.y, position[2] + cylinderVecWorld.z));
-        facetedPolyline = new FacetedPolyline(&polyline, m_Cylinder1Radius, kSides);
-        facetedPolyline->SetColour(m_CylinderColour);
-        m_DrawList.push_back(facetedPolyline);
+        SetDrawPolyline(drawIndex++, &polyline, m_Cylinder1Radius, m_CylinderColour);
 
         dBodyGetRelPointPos(m_Cylinder2Body->GetBodyID(), m_Cylinder2Position.x, m_Cylinder2Position.y, m_Cylinder2Position.z, position);
         // and draw it
         polyline.clear();
         polyline.push_back(pgd::Vector(position[0] - cylinderVecWorld.x, position[1] - cylinderVecWorld.y, position[2] - cylinderVecWorld.z));
         polyline.push_back(pgd::Vector(position[0] + cylinderVecWorld.x, position[1] + cylinderVecWorld.y, position[2] + cylinderVecWorld.z));
-        facetedPolyline = new FacetedPolyline(&polyline, m_Cylinder2Radius, kSides);
-        facetedPolyline->SetColour(m_CylinderColour);
-        m_DrawList.push_back(facetedPolyline);
+        SetDrawPolyline(drawIndex++, &polyline, m_Cylinder2Radius, m_CylinderColour);
 
         if (gDrawMuscleForces)
         {
@@ -1334,11 +1323,11 @@ void TwoCylinderWrapStrap::Draw()
                 pgd::Vector f = pgd::Vector(m_PointForceList[i]->vector[0], m_PointForceList[i]->vector[1], m_PointForceList[i]->vector[2]) * m_Tension * m_ForceScale;
                 polyline.push_back(pgd::Vector(m_PointForceList[i]->point[0], m_PointForceList[i]->point[1], m_PointForceList[i]->point[2]));
                 polyline.push_back(pgd::Vector(m_PointForceList[i]->point[0], m_PointForceList[i]->point[1], m_PointForceList[i]->point[2]) + f);
-                facetedPolyline = new FacetedPolyline(&polyline, m_ForceRadius, kSides);
-                facetedPolyline->SetColour(m_Colour);
-                m_DrawList.push_back(facetedPolyline);
+                SetDrawPolyline(drawIndex++, &polyline, m_ForceRadius, m_Colour);
             }
         }
+
+        TrimDrawList(drawIndex);
     }
 
     for (i = 0; i < m_DrawList.size(); i++)
@@ -18,6 +18,7 @@
 #include "Util.h"
 #include "DebugControl.h"
 #include "UGMMuscle.h"
+#include "Checkpoint.h"
 #include "Simulation.h"
 
 // Simulation global
@@ -47,6 +48,19 @@ UGMMuscle::UGMMuscle(Strap *strap): Muscle(strap)
 
     // and flag that we have just been created
     m_newObject = true;
+
+    // these are set properly by SetFibreComposition and SetMuscleGeometry
+    m_ft = 0;
+    m_tact = 0;
+    m_tdeact = 0;
+    m_amh = 0;
+    m_vmaxst = 0;
+    m_shst = 0;
+    m_lceopt = 0;
+    m_width = 0;
+
+    // original explicit Euler integration by default
+    m_integrator = explicitEuler;
 }
 
 // destructor
@@ -78,6 +92,8 @@ void UGMMuscle::SetFibreComposition(double fastTwitchFraction)
     //c--- lengthening heat rate coefficient
     //c    4.0 x sh (approximates constable et al. and hawkins & mole)
     m_lh = 4.0 * m_shst;
+
+    CompileParameters();
 }
 
 // set the muscle geometry
@@ -118,6 +134,8 @@ void UGMMuscle::SetMuscleGeometry(double pcsa, double optimumFibreLength, double
         case square:
             m_kse = m_fmax/(SQUARE(m_tendonlength*m_serialStrainAtFmax));
     }
+
+    CompileParameters();
 }
 
 // return the serial elastic energy storage
@@ -163,6 +181,30 @@ void UGMMuscle::SetModellingConstants(double specificTension, double relativeCon
     m_specifictension = specificTension;
     m_vmaxft = relativeContractionVelocity;
     m_density = muscleDensity;
+
+    CompileParameters();
+}
+
+// values that only depend on the parameters are calculated here rather than every step
+// and this needs calling whenever one of the parameters changes
+void UGMMuscle::CompileParameters()
+{
+    // Umberger et al 2003 eq 3
+    m_t2 = 1 / m_tdeact;
+    m_t1 = 1 / m_tact - m_t2;
+
+    // Nagano & Gerritsen 2001 A5 & A6
+    m_c0 = -1 / SQUARE(m_width);
+    m_twoC0 = 2 * m_c0;
+
+    m_speedLimit = m_vmaxft * m_lceopt;
+
+    // heat rate terms from GetMetabolicPower
+    m_amhIsometric = 0.4*m_amh;
+    m_amhLength = 0.6*m_amh;
+    m_shstLimit = m_shst*m_vmaxst;
+    m_stFraction = 1.0-m_ft/100.0;
+    m_ftFraction = m_ft/100.0;
 }
 
 // set the activation level
@@ -173,16 +215,24 @@ void UGMMuscle::SetStim(double stim, double timeIncrement)
     // set the internal activation level
     m_stim = MAX(stim, 0.00001); // modified from Fortran
                                  // Umberger et al 2003 eq 3
-    double t2 = 1 / m_tdeact;
-    double t1 = 1 / m_tact - t2;
     // Nagano & Gerritsen 2001 A2
-    double qdot = (m_stim - m_act) * (t1 * m_stim + t2);
-    m_act += qdot * timeIncrement;
+    if (m_integrator == implicitEuler)
+    {
+        // m_stim is constant over the step so this is a first order linear equation
+        // and the exact solution is stable at any step size
+        double rate = m_t1 * m_stim + m_t2;
+        m_act = m_stim + (m_act - m_stim) * exp(-rate * timeIncrement);
+    }
+    else
+    {
+        double qdot = (m_stim - m_act) * (m_t1 * m_stim + m_t2);
+        m_act += qdot * timeIncrement;
+    }
     // minimum value for m_ACT now needed
     m_act = MAX(m_act, 0.0001);
 
     // late initialisation
-    double peext = 0, seext = 0, fse;
+    double peext = 0, seext = 0;
     if (m_newObject)
     {
         m_newObject = false;
@@ -232,74 +282,154 @@ void UGMMuscle::SetStim(double stim, double timeIncrement)
         }
     }
 
+    double fse, fpe;
+    bool concentricFlag;
+    if (m_integrator == implicitEuler)
+    {
+        // backward Euler for the fibre length which means solving lce = m_lce + vce(lce) * timeIncrement
+        // the speed limit always brackets the solution so regula falsi (Illinois variant) converges
+        // even across the kinks where the tendon goes slack or the velocity limits are applied
+        double lce0 = m_lce;
+        double tolerance = 1e-10 * m_lceopt;
+        double lower = lce0 - m_speedLimit * timeIncrement;
+        double upper = lce0 + m_speedLimit * timeIncrement;
+        double gLower = lower - lce0 - CalculateVCE(lower, &fse, &fpe, &concentricFlag, true) * timeIncrement;
+        double gUpper = upper - lce0 - CalculateVCE(upper, &fse, &fpe, &concentricFlag, true) * timeIncrement;
+        double lce = lower, g;
+        int lastMoved = 0;
+        if (gLower < 0 && gUpper > 0)
+        {
+            for (int i = 0; i < 100; i++)
+            {
+                lce = (lower * gUpper - upper * gLower) / (gUpper - gLower);
+                g = lce - lce0 - CalculateVCE(lce, &fse, &fpe, &concentricFlag, true) * timeIncrement;
+                if (fabs(g) <= tolerance || upper - lower <= tolerance) break;
+                if (g > 0)
+                {
+                    upper = lce;
+                    gUpper = g;
+                    if (lastMoved == 1) gLower *= 0.5;
+                    lastMoved = 1;
+                }
+                else
+                {
+                    lower = lce;
+                    gLower = g;
+                    if (lastMoved == -1) gUpper *= 0.5;
+                    lastMoved = -1;
+                }
+            }
+        }
+        else if (gUpper <= 0) lce = upper;
+        // this also leaves the element forces matching the new fibre length
+        m_vce = CalculateVCE(lce, &fse, &fpe, &concentricFlag, false);
+    }
+    else
+    {
+        m_vce = CalculateVCE(m_lce, &fse, &fpe, &concentricFlag, false);
+    }
+    m_Strap->SetTension(fse); // tension in unit is same as tension in serial elastic element
+
+    m_lce += m_vce * timeIncrement;
+    if (m_lce < 0)
+    {
+        if (gDebug == UGMMuscleDebug) *gDebugStream << "m_vce < 0 fix applied\n";
+        m_lce = 0;
+    }
+
+    if (gDebug == UGMMuscleDebug)
+    {
+        *gDebugStream << "MAMuscle::SetStim " << m_Name << " "
+        << "m_act " << m_act << " "
+        << "m_stim " << m_stim << " "
+        << "m_fiso " << m_fiso << " "
+        << "m_lce " << m_lce << " "
+        << "m_vce " << m_vce << " "
+        << "concentricFlag " << concentricFlag << " "
+        << "m_fce " << m_fce << " "
+        << "fse " << fse << " "
+        << "fpe " << fpe << " "
+        << "m_Tension " << m_Strap->GetTension() << " "
+        << "m_Length " << m_Strap->GetLength() << " "
+        << "m_Velocity " << m_Strap->GetVelocity() << "\n";
+    }
+}
+
+// calculates the element forces and the contractile element velocity for a given fibre length
+// also sets m_fce and m_fiso
+// probe is set for the trial lengths of the implicit solve so that the fixup messages
+// are only printed for the fibre length that is actually used
+double UGMMuscle::CalculateVCE(double lce, double *fse, double *fpe, bool *concentricFlag, bool probe)
+{
     // Note removing pennation angle effects
     // c--- Series elastic element force
-    seext = MAX(m_Strap->GetLength() - m_lce - m_tendonlength, 0);
+    double seext = MAX(m_Strap->GetLength() - lce - m_tendonlength, 0);
     switch (m_serialStrainModel)
     {
         case linear:
-            fse = m_kse * seext;
+            *fse = m_kse * seext;
             break;
         case square:
-            fse = m_kse * SQUARE(seext);
+            *fse = m_kse * SQUARE(seext);
     }
-    m_Strap->SetTension(fse); // tension in unit is same as tension in serial elastic element
-                     // c--- Parallel elastic element force
-    peext = MAX(m_lce - m_lceopt, 0);
-    double fpe;
+    // c--- Parallel elastic element force
+    double peext = MAX(lce - m_lceopt, 0);
     switch (m_parallelStrainModel)
     {
         case linear:
-            fpe = m_kpe * peext;
+            *fpe = m_kpe * peext;
             break;
         case square:
-            fpe = m_kpe * SQUARE(peext);
+            *fpe = m_kpe * SQUARE(peext);
     }
     // c--- Contractile element force
-    m_fce = fse - fpe;
+    m_fce = *fse - *fpe;
 
     // calculate isometric force
     // Nagano & Gerritsen 2001 A5 & A6
     // c--- Normalized contractile element force-length curve
     //double lce = m_Length - m_tendonLength;
-    double c0 = -1 / SQUARE(m_width);
-    double relLen = m_lce / m_lceopt;
-    m_fiso = c0 * SQUARE(relLen) - 2 * c0 * relLen + c0 + 1;
+    double relLen = lce / m_lceopt;
+    m_fiso = m_c0 * SQUARE(relLen) - m_twoC0 * relLen + m_c0 + 1;
     m_fiso = MAX(m_fiso, 1e-5);
 
     // Contracile element velocity
     // this is the modified version after email 3
     double Afact = pow(m_act, -0.3);
     double arel = Afact * m_arel;
-    if (m_lce >= m_lceopt)
+    if (lce >= m_lceopt)
         arel = arel * m_fiso;
 
-    bool concentricFlag = false;
+    double vce;
+    *concentricFlag = false;
     double num, den;
     // c    concentric
     if (m_fce <= (m_fiso*m_fmax*m_act))
     {
-        concentricFlag = true;
+        *concentricFlag = true;
         /* this is the original code but it is sensitive to out of range values
-        m_vce = -1*m_lceopt*((((m_fiso+arel)*m_brel)/(m_fce/(m_fmax*m_act)+arel))-m_brel);
+        vce = -1*m_lceopt*((((m_fiso+arel)*m_brel)/(m_fce/(m_fmax*m_act)+arel))-m_brel);
         */
         /* However this is just a rearrangement that is easier to check (see mathematica file) */
         num = m_brel*(m_fce - m_act*m_fiso*m_fmax)*m_lceopt;
         den = m_fce + arel*m_act*m_fmax;
         if (num >= 0)
         {
-            m_vce = 0;
-            std::cerr << "Should never get here\n";
-            std::cerr << "Applying concentric m_vce = 0 fixup to " << m_Name << "\n";
+            vce = 0;
+            if (probe == false)
+            {
+                std::cerr << "Should never get here\n";
+                std::cerr << "Applying concentric m_vce = 0 fixup to " << m_Name << "\n";
+            }
         }
         else if (den <= 0)
         {
-            m_vce = -m_vmaxft * m_lceopt;
-            if (gDebug == UGMMuscleDebug) *gDebugStream << "Applying concentric m_vce = -m_vmaxft * m_lceopt fixup to " << m_Name << "\n";
+            vce = -m_vmaxft * m_lceopt;
+            if (gDebug == UGMMuscleDebug && probe == false) *gDebugStream << "Applying concentric m_vce = -m_vmaxft * m_lceopt fixup to " << m_Name << "\n";
         }
         else
         {
-            m_vce = num / den;
+            vce = num / den;
         }
     }
     // c    eccentric
@@ -313,12 +443,12 @@ void UGMMuscle::SetStim(double stim, double timeIncrement)
         // c    hyperbolic formula
         if ((m_fce/(m_fmax*m_act)) <= (-1*sqrt(c1/sloplin)-c2))
     {
-            m_vce = -1*m_lceopt*(c1/(m_fce/(m_fmax*m_act)+c2)+c3);
+            vce = -1*m_lceopt*(c1/(m_fce/(m_fmax*m_act)+c2)+c3);
     }
         else
     {
             // c    linear asymptote
-            m_vce = m_lceopt*sloplin*(m_fce/(m_fmax*m_act)+sqrt(c1/sloplin)+c2)+m_lceopt*(sqrt(c1*sloplin)-c3);
+            vce = m_lceopt*sloplin*(m_fce/(m_fmax*m_act)+sqrt(c1/sloplin)+c2)+m_lceopt*(sqrt(c1*sloplin)-c3);
     }
         */
         /* However this is just a rearrangement that is easier to check (see mathematica file) */
@@ -326,56 +456,36 @@ void UGMMuscle::SetStim(double stim, double timeIncrement)
         den = (arel + m_fiso)*(m_fce - m_act*m_fiso*m_fmax*m_fmaxecc)*m_slopfac;
         if (num >= 0)
         {
-            m_vce = 0;
-            std::cerr << "Should never get here\n";
-            std::cerr << "Applying eccentric m_vce = 0 fixup to " << m_Name << "\n";;
+            vce = 0;
+            if (probe == false)
+            {
+                std::cerr << "Should never get here\n";
+                std::cerr << "Applying eccentric m_vce = 0 fixup to " << m_Name << "\n";
+            }
         }
         else if (den >= 0)
         {
-            m_vce = m_vmaxft * m_lceopt;
-            if (gDebug == UGMMuscleDebug) *gDebugStream << "Applying eccentric m_vce = m_vmaxft * m_lceopt fixup to " << m_Name << "\n";
+            vce = m_vmaxft * m_lceopt;
+            if (gDebug == UGMMuscleDebug && probe == false) *gDebugStream << "Applying eccentric m_vce = m_vmaxft * m_lceopt fixup to " << m_Name << "\n";
         }
         else
         {
-            m_vce = num / den;
+            vce = num / den;
         }
     }
 
-    // adjust muscle length
-    double speedLimit = m_vmaxft * m_lceopt;
-    if (m_vce < -speedLimit)
+    // apply the speed limits
+    if (vce < -m_speedLimit)
     {
-        if (gDebug == UGMMuscleDebug) *gDebugStream << "Negative speed limit fix applied\n";
-        m_vce = -speedLimit;
+        if (gDebug == UGMMuscleDebug && probe == false) *gDebugStream << "Negative speed limit fix applied\n";
+        vce = -m_speedLimit;
     }
-    else if (m_vce > speedLimit)
+    else if (vce > m_speedLimit)
     {
-        if (gDebug == UGMMuscleDebug) *gDebugStream << "Positive speed limit fix applied\n";
-        m_vce = speedLimit;
-    }
-    m_lce += m_vce * timeIncrement;
-    if (m_lce < 0)
-    {
-        if (gDebug == UGMMuscleDebug) *gDebugStream << "m_vce < 0 fix applied\n";
-        m_lce = 0;
-    }
-
-    if (gDebug == UGMMuscleDebug)
-    {
-        *gDebugStream << "MAMuscle::SetStim " << m_Name << " "
-        << "m_act " << m_act << " "
-        << "m_stim " << m_stim << " "
-        << "m_fiso " << m_fiso << " "
-        << "m_lce " << m_lce << " "
-        << "m_vce " << m_vce << " "
-        << "concentricFlag " << concentricFlag << " "
-        << "m_fce " << m_fce << " "
-        << "fse " << fse << " "
-        << "fpe " << fpe << " "
-        << "m_Tension " << m_Strap->GetTension() << " "
-        << "m_Length " << m_Strap->GetLength() << " "
-        << "m_Velocity " << m_Strap->GetVelocity() << "\n";
+        if (gDebug == UGMMuscleDebug && probe == false) *gDebugStream << "Positive speed limit fix applied\n";
+        vce = m_speedLimit;
     }
+    return vce;
 }
 
 double UGMMuscle::GetMetabolicPower()
@@ -406,22 +516,22 @@ double UGMMuscle::GetMetabolicPower()
     {
         if (lcerel > 1.0)
         {
-            amhdot = (0.4*m_amh + 0.6*m_amh*m_fiso)*eamh;
+            amhdot = (m_amhIsometric + m_amhLength*m_fiso)*eamh;
             slhdtst = -1.0*m_shst*vcerel*m_fiso*eash;
-            if (slhdtst > m_shst*m_vmaxst*eash)
-                slhdtst = m_shst*m_vmaxst*eash;
-            slhdtst = slhdtst*(1.0-m_ft/100.0);
-            slhdtft = -1.0*(m_shft*vcerel*m_fiso*eash)*(m_ft/100.0);
+            if (slhdtst > m_shstLimit*eash)
+                slhdtst = m_shstLimit*eash;
+            slhdtst = slhdtst*m_stFraction;
+            slhdtft = -1.0*(m_shft*vcerel*m_fiso*eash)*m_ftFraction;
             slhdot = slhdtst + slhdtft;
         }
         else // if (lcerel <= 1.0)
         {
             amhdot = m_amh*eamh;
             slhdtst = -1.0*m_shst*vcerel*eash;
-            if (slhdtst > m_shst*m_vmaxst*eash)
-                slhdtst = m_shst*m_vmaxst*eash;
-            slhdtst = slhdtst*(1.0-m_ft/100.0);
-            slhdtft = -1.0*(m_shft*vcerel*eash)*(m_ft/100.0);
+            if (slhdtst > m_shstLimit*eash)
+                slhdtst = m_shstLimit*eash;
+            slhdtst = slhdtst*m_stFraction;
+            slhdtft = -1.0*(m_shft*vcerel*eash)*m_ftFraction;
             slhdot = slhdtst + slhdtft;
         }
     }
@@ -430,7 +540,7 @@ double UGMMuscle::GetMetabolicPower()
     {
         if (lcerel > 1.0)
         {
-            amhdot = (0.4*m_amh + 0.6*m_amh*m_fiso)*eamh;
+            amhdot = (m_amhIsometric + m_amhLength*m_fiso)*eamh;
             slhdot = (m_lh*vcerel)*m_fiso*ea;
         }
         else // if (lcerel <= 1.0)
@@ -694,14 +804,12 @@ void UGMMuscle::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "NamedObject::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tstim\tact\tspe\tepe\tsse\tese\tfce\tlpe\tfpe\tlse\tfse\tvce\tvse\tense\tenpe\tpse\tppe\tpce\ttension\tlength\tvelocity\tPMECH\tPMET\n";
+            m_DumpStream->SetUnits("s\t\t\t\t\t\t\tN\tm\tN\tm\tN\tm/s\tm/s\tJ\tJ\tW\tW\tW\tN\tm\tm/s\tW\tW");
         }
     }
 
@@ -718,3 +826,26 @@ void UGMMuscle::Dump()
     }
 }
 
+void UGMMuscle::WriteCheckpoint(Checkpoint *checkpoint)
+{
+    Muscle::WriteCheckpoint(checkpoint);
+    checkpoint->Write(m_stim);
+    checkpoint->Write(m_act);
+    checkpoint->Write(m_lce);
+    checkpoint->Write(m_vce);
+    checkpoint->Write(m_fce);
+    checkpoint->Write(m_fiso);
+    checkpoint->Write(m_newObject);
+}
+
+void UGMMuscle::ReadCheckpoint(Checkpoint *checkpoint)
+{
+    Muscle::ReadCheckpoint(checkpoint);
+    checkpoint->Read(&m_stim);
+    checkpoint->Read(&m_act);
+    checkpoint->Read(&m_lce);
+    checkpoint->Read(&m_vce);
+    checkpoint->Read(&m_fce);
+    checkpoint->Read(&m_fiso);
+    checkpoint->Read(&m_newObject);
+}
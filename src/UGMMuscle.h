@@ -31,6 +31,12 @@ public:
         square
     };
 
+    enum Integrator
+    {
+        explicitEuler = 0,
+        implicitEuler
+    };
+
     void SetStim(double stim, double timeIncrement);
     void SetFibreComposition(double fastTwitchFraction);
     void SetMuscleGeometry(double pcsa, double optimumFibreLength, double relativeWidth, double tendonLength,
@@ -39,6 +45,8 @@ public:
     void SetModellingConstants(double specificTension, double relativeContractionVelocity, double muscleDensity);
     void SetAerobic(bool f) { if (f) m_s = 1.5; else m_s = 1.0; }
     void AllowReverseWork(bool f) { m_allowReverseWork = f; }
+    void SetIntegrator(Integrator integrator) { m_integrator = integrator; }
+    Integrator GetIntegrator() { return m_integrator; }
 
     virtual double GetMetabolicPower();
     virtual double GetElasticEnergy() { return GetESE(); }
@@ -67,9 +75,14 @@ public:
     double GetStimulation() { return m_stim; }
 
     virtual void Dump();
+    virtual void WriteCheckpoint(Checkpoint *checkpoint);
+    virtual void ReadCheckpoint(Checkpoint *checkpoint);
 
 protected:
 
+    double CalculateVCE(double lce, double *fse, double *fpe, bool *concentricFlag, bool probe);
+    void CompileParameters();
+
     double m_specifictension;
     double m_density;
     double m_act;
@@ -106,6 +119,19 @@ protected:
     double m_serialStrainAtFmax;
     bool m_allowReverseWork;
     bool m_newObject;
+    Integrator m_integrator;
+
+    // derived parameters
+    double m_t1;
+    double m_t2;
+    double m_c0;
+    double m_twoC0;
+    double m_speedLimit;
+    double m_amhIsometric;
+    double m_amhLength;
+    double m_shstLimit;
+    double m_stFraction;
+    double m_ftFraction;
 };
 
 #endif
@@ -278,14 +278,12 @@ void UniversalJoint::Dump()
         if (m_DumpStream == 0)
         {
             if (m_Name.size() == 0) std::cerr << "NamedObject::Dump error: can only dump a named object\n";
-            std::string filename(m_Name);
-            filename.append(".dump");
-            m_DumpStream = new std::ofstream(filename.c_str());
-            m_DumpStream->precision(17);
+            m_DumpStream = NewDumpStream();
         }
         if (m_DumpStream)
         {
             *m_DumpStream << "Time\tXP\tYP\tZP\tXA1\tYA1\tZA1\tAngle1\tAngleRate1\tXA2\tYA2\tZA2\tAngle2\tAngleRate2\tFX1\tFY1\tFZ1\tTX1\tTY1\tTZ1\tFX2\tFY2\tFZ2\tTX2\tTY2\tTZ2\n";
+            m_DumpStream->SetUnits("s\tm\tm\tm\t\t\t\trad\trad/s\t\t\t\trad\trad/s\tN\tN\tN\tNm\tNm\tNm\tN\tN\tN\tNm\tNm\tNm");
         }
     }
 
@@ -317,9 +315,9 @@ void UniversalJoint::Draw()
     if (m_FirstDraw)
     {
         m_FirstDraw = false;
-        m_PhysRep = new FacetedConicSegment(m_AxisSize[0] * 2, m_AxisSize[0] / 10, m_AxisSize[0] / 10, 128, 0, 0, -m_AxisSize[0]);
+        m_PhysRep = new FacetedConicSegment(m_AxisSize[0] * 2, m_AxisSize[0] / 10, m_AxisSize[0] / 10, 128, 0, 0, -m_AxisSize[0], true); // drawn as an instance of a shared segment
         m_PhysRep->SetColour(m_Colour);
-        m_PhysRep2 = new FacetedConicSegment(m_AxisSize[0] * 2, m_AxisSize[0] / 10, m_AxisSize[0] / 10, 128, 0, 0, -m_AxisSize[0]);
+        m_PhysRep2 = new FacetedConicSegment(m_AxisSize[0] * 2, m_AxisSize[0] / 10, m_AxisSize[0] / 10, 128, 0, 0, -m_AxisSize[0], true); // drawn as an instance of a shared segment
         m_PhysRep2->SetColour(m_Colour);
     }
 
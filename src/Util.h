@@ -13,6 +13,7 @@
 #define __UTIL_H__
 
 #include "PGDMath.h"
+#include "FastDouble.h"
 
 #include <ode/ode.h>
 
@@ -150,12 +151,12 @@ inline static bool OutRange(double v, double l, double h)
 
 inline static double Double(const char *buf)
 {
-    return strtod(buf, 0);
+    return FastDouble::Parse(buf);
 }
 
 inline static double Double(const unsigned char *buf)
 {
-    return strtod((char *)buf, 0);
+    return FastDouble::Parse((const char *)buf);
 }
 
 inline static void Double(const char *buf, int n, double *d)
@@ -164,7 +165,7 @@ inline static void Double(const char *buf, int n, double *d)
     char *ptr;
     for (int i = 0; i < n; i++)
     {
-        d[i] = strtod(cptr, &ptr);
+        d[i] = FastDouble::Parse(cptr, &ptr);
         cptr = ptr;
     }
 }
@@ -175,7 +176,7 @@ inline static void Double(const unsigned char *buf, int n, double *d)
     char *ptr;
     for (int i = 0; i < n; i++)
     {
-        d[i] = strtod(cptr, &ptr);
+        d[i] = FastDouble::Parse(cptr, &ptr);
         cptr = ptr;
     }
 }
@@ -11,7 +11,6 @@
 #include <string.h>
 #include <libxml/xmlmemory.h>
 #include <libxml/parser.h>
-#include <sstream>
 #include <cfloat>
 #include <cmath>
 #include <assert.h>
@@ -20,6 +19,8 @@
 #include "XMLConverter.h"
 #include "DataFile.h"
 #include "ExpressionParser.h"
+#include "FastDouble.h"
+#include "FitnessCache.h"
 
 XMLConverter::XMLConverter()
 {
@@ -29,6 +30,7 @@ XMLConverter::XMLConverter()
     m_ConversionType = SmartSubstitution;
     m_SmartSubstitutionTextBuffer = 0;
     m_SmartSubstitutionFlag = false;
+    m_BaseXMLHash = 0;
 }
 
 XMLConverter::XMLConverter(XMLConverter &converter)
@@ -42,6 +44,7 @@ XMLConverter::XMLConverter(XMLConverter &converter)
 
     m_DTDValidateFlag = converter.m_DTDValidateFlag;
     m_ConversionType = converter.m_ConversionType;
+    m_BaseXMLHash = converter.m_BaseXMLHash;
 
     unsigned int i;
     unsigned int len = 0;
@@ -137,7 +140,7 @@ xmlChar *XMLConverter::GetFormattedXML(int *docTxtLen)
         {
             chars = sprintf(ptr, "%s", m_SmartSubstitutionTextComponents[i]->c_str());
             ptr += chars;
-            chars = sprintf(ptr, "%.17e", m_SmartSubstitutionValues[i]);
+            chars = FastDouble::Format(m_SmartSubstitutionValues[i], ptr);
             ptr += chars;
         }
         chars = sprintf(ptr, "%s", m_SmartSubstitutionTextComponents[i]->c_str());
@@ -179,16 +182,23 @@ int XMLConverter::ApplyGenome(int genomeSize, double *genomeData)
     return 0;
 }
 
+static void AppendDurationValuePair(std::string *out, double d, double v)
+{
+    char buffer[32];
+    out->append(buffer, FastDouble::Format(d, buffer));
+    out->push_back(' ');
+    out->append(buffer, FastDouble::Format(v, buffer));
+    out->push_back(' ');
+}
+
 void XMLConverter::NewCyclicDriver(xmlNodePtr parent, char *target,
                      int n, double *d, double *v, double phase)
 {
     xmlNodePtr newNode;
     xmlAttrPtr newAttr;
     char buffer[256];
-    std::ostringstream out;
+    std::string out;
     int i;
-    out.precision(17);
-    out.setf( std::ios::scientific );
     assert(phase >= 0 && phase <= 1);
 
     newNode = xmlNewTextChild(parent, 0, (xmlChar *)"CYCLIC_DRIVER", 0);
@@ -230,17 +240,17 @@ void XMLConverter::NewCyclicDriver(xmlNodePtr parent, char *target,
         d2[index] = d[split] - d2[0];
         v2[index] = v[split];
 
-        for (i = 0; i < n + 1; i++) out << d2[i] << " " << v2[i] << " ";
+        for (i = 0; i < n + 1; i++) AppendDurationValuePair(&out, d2[i], v2[i]);
 
         delete [] d2;
         delete [] v2;
     }
     else
     {
-        for (i = 0; i < n; i++) out << d[i] << " " << v[i] << " ";
+        for (i = 0; i < n; i++) AppendDurationValuePair(&out, d[i], v[i]);
     }
 
-    newAttr = xmlNewProp(newNode, (xmlChar *)"DurationValuePairs", (xmlChar *)out.str().c_str());
+    newAttr = xmlNewProp(newNode, (xmlChar *)"DurationValuePairs", (xmlChar *)out.c_str());
 }
 
 void XMLConverter::NewStepDriver(xmlNodePtr parent, char *target,
@@ -249,10 +259,8 @@ void XMLConverter::NewStepDriver(xmlNodePtr parent, char *target,
     xmlNodePtr newNode;
     xmlAttrPtr newAttr;
     char buffer[256];
-    std::ostringstream out;
+    std::string out;
     int i;
-    out.precision(17);
-    out.setf( std::ios::scientific );
 
     newNode = xmlNewTextChild(parent, 0, (xmlChar *)"STEP_DRIVER", 0);
     strncpy(buffer, target, 200);
@@ -260,9 +268,9 @@ void XMLConverter::NewStepDriver(xmlNodePtr parent, char *target,
     newAttr = xmlNewProp(newNode, (xmlChar *)"Name", (xmlChar *)buffer);
     newAttr = xmlNewProp(newNode, (xmlChar *)"Target", (xmlChar *)target);
 
-    for (i = 0; i < n; i++) out << d[i] << " " << v[i] << " ";
+    for (i = 0; i < n; i++) AppendDurationValuePair(&out, d[i], v[i]);
 
-    newAttr = xmlNewProp(newNode, (xmlChar *)"DurationValuePairs", (xmlChar *)out.str().c_str());
+    newAttr = xmlNewProp(newNode, (xmlChar *)"DurationValuePairs", (xmlChar *)out.c_str());
 }
 
 void XMLConverter::FlexorEncode(double *in, int n, double *out)
@@ -285,6 +293,7 @@ void XMLConverter::DoSmartSubstitution(char *dataPtr)
     std::string *s;
     ExpressionParser *expressionParser;
     int length = strlen(dataPtr);
+    m_BaseXMLHash = FitnessCache::Hash(dataPtr, length);
 
     char *ptr2 = strstr(ptr1, "[[");
     while (ptr2)
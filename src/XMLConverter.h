@@ -14,6 +14,7 @@
 #include <libxml/parser.h>
 #include <vector>
 #include <string>
+#include <stdint.h>
 
 class Genome;
 class DataFile;
@@ -40,6 +41,9 @@ public:
 
     bool GetSmartSubstitutionFlag() { return m_SmartSubstitutionFlag; }
 
+    // identifies the base XML so that results can be cached
+    uint64_t GetBaseXMLHash() { return m_BaseXMLHash; }
+
 protected:
 
     void NewCyclicDriver(xmlNodePtr parent, char *target,
@@ -65,6 +69,7 @@ protected:
     char *m_SmartSubstitutionTextBuffer;
 
     ConversionType m_ConversionType;
+    uint64_t m_BaseXMLHash;
 };
 
 